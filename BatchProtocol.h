@@ -0,0 +1,115 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Batched-ack upload protocol - framing shared by the logger and the
+// receiver (host/batchrecv.cpp)
+//----------------------------------------------------------------------------
+// One TCP connection, no separate data connection and no per-command round
+// trips.  Records are the lines of the location log, numbered from 0 (the
+// sequence number is the line number), so nothing needs to be remembered
+// on the logger between connections - the receiver says where to resume.
+//
+//   logger                         receiver
+//   HELLO  device id        ->
+//                           <-     RESUME next seq wanted (= records stored)
+//   DATA   seq, records     ->     (up to BATCH_WINDOW DATA frames in flight)
+//   DATA   seq, records     ->
+//                           <-     ACK next seq wanted
+//   ...                            ...
+//
+// The receiver only stores a record whose seq is the next one it wants, so
+// a batch sent again after a reconnect is never stored twice, and a DATA
+// frame cut off by a disconnect is simply thrown away.
+//
+// If the receiver wants a seq past the end of the logger's log (the log was
+// deleted or cut short, the receiver's file kept), the logger answers the
+// RESUME with NEWFILE.  The receiver puts its file aside as a numbered
+// generation, starts an empty one and sends RESUME 0.
+//
+// Frame:   type (1 byte), payload length (2 bytes, big endian), payload
+//   HELLO   device id, ASCII
+//   RESUME  u32 next seq
+//   DATA    u32 seq of the first record, then per record: length (1 byte), bytes
+//   ACK     u32 next seq
+//   NEWFILE u32 records in the logger's log
+//
+// Plain C, no Arduino calls, so the host tools can include it too.
+
+#define BATCH_PORT_DEFAULT (5005)
+
+#define BATCH_HELLO  (1)
+#define BATCH_RESUME (2)
+#define BATCH_DATA   (3)
+#define BATCH_ACK    (4)
+#define BATCH_NEWFILE (5)
+
+#define BATCH_HDRLEN (3)
+#define BATCH_MAXPAYLOAD (1400)  /* DATA frame fits one TCP segment */
+#define BATCH_MAXRECORD (255)
+#define BATCH_WINDOW (8)         /* DATA frames in flight before waiting for an ACK */
+
+//----------------------------------------------------------
+// big endian 32 bit
+void batchPutU32(uint8_t* p, uint32_t v)
+{
+  p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+uint32_t batchGetU32(const uint8_t* p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+//----------------------------------------------------------
+// fill in a frame header, return the total frame length
+int batchFrame(uint8_t* buf, int type, int payloadLen)
+{
+  buf[0] = type;
+  buf[1] = payloadLen >> 8;
+  buf[2] = payloadLen;
+  return BATCH_HDRLEN + payloadLen;
+}
+
+// 4 byte seq frame - RESUME, ACK or NEWFILE
+int batchSeqFrame(uint8_t* buf, int type, uint32_t seq)
+{
+  batchPutU32(&buf[BATCH_HDRLEN], seq);
+  return batchFrame(buf, type, 4);
+}
+
+//----------------------------------------------------------
+// incremental frame receiver - push bytes in as they arrive
+typedef struct
+{
+  uint8_t buf[BATCH_HDRLEN + BATCH_MAXPAYLOAD];
+  int have;
+} BatchRx;
+
+void batchRxInit(BatchRx* rx)
+{
+  rx->have = 0;
+}
+
+int batchRxType(BatchRx* rx) { return rx->buf[0]; }
+int batchRxLen(BatchRx* rx) { return (rx->buf[1] << 8) | rx->buf[2]; }
+uint8_t* batchRxPayload(BatchRx* rx) { return &rx->buf[BATCH_HDRLEN]; }
+
+// add one byte, return true when a whole frame is in rx (the next push
+// starts a new frame), -1 if the frame is too long to be valid
+int batchRxPush(BatchRx* rx, uint8_t c)
+{
+  if (rx->have >= BATCH_HDRLEN + BATCH_MAXPAYLOAD) rx->have = 0; // previous frame done
+  rx->buf[rx->have++] = c;
+  if (rx->have < BATCH_HDRLEN) return false;
+  int len = batchRxLen(rx);
+  if (len > BATCH_MAXPAYLOAD)
+  {
+    rx->have = 0;
+    return -1;
+  }
+  if (rx->have == BATCH_HDRLEN + len)
+  {
+    rx->have = BATCH_HDRLEN + BATCH_MAXPAYLOAD; // mark done, payload stays readable
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,282 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Batched-ack upload of the location log (protocol in BatchProtocol.h)
+//----------------------------------------------------------------------------
+// Call batchStart() to begin an upload and batchService() from the high
+// rate part of loop().  Nothing waits for the server: DATA frames go out
+// while fewer than BATCH_WINDOW are unacknowledged, and ACKs are read as
+// they come in.
+//
+// If the connection drops (WiFi gone, server gone, no ACK for
+// BATCH_TIMEOUT_MS) the upload stays wanted, and batchService() connects
+// again every BATCH_RETRY_MS while WiFi is up.  The receiver's RESUME
+// says which record it needs next, so nothing is lost or sent twice.  If
+// it wants a record past the end of the log, the log was replaced and the
+// receiver is told to start a new file (NEWFILE).
+//
+// Needs batchServer, batchPort, batchDeviceId, fileSystem, readln(),
+// wifiIsConnected(), logMessage()
+
+#define BATCHSTATE_IDLE      (0)
+#define BATCHSTATE_HELLOWAIT (1)
+#define BATCHSTATE_SENDING   (2)
+
+#define BATCH_CONNECT_MS (3000)  /* TCP connect timeout */
+#define BATCH_TIMEOUT_MS (15000) /* no RESUME/ACK for this long - drop the connection */
+#define BATCH_RETRY_MS   (10000) /* reconnect interval while the upload is wanted */
+
+typedef struct
+{
+  uint32_t endSeq;    // seq after the last record in the frame
+  uint32_t endOffset; // file offset after the last record in the frame
+} BatchInflight;
+
+WiFiClient batchClient;
+File batchFile;
+char batchFileName[64];
+BatchRx batchRx;
+int batchState = BATCHSTATE_IDLE;
+int batchWanted = false;          // upload requested and not finished
+unsigned long batchTimer = 0;     // millis() of the last progress / attempt
+uint32_t batchNextSeq = 0;        // next record to send
+uint32_t batchAckedSeq = 0;       // receiver has every record before this
+uint32_t batchAckedOffset = 0;    // file offset of record batchAckedSeq
+BatchInflight batchInflight[BATCH_WINDOW];
+int batchInflightCount = 0;
+int batchEof = false;
+
+// statistics
+unsigned long batchSessions = 0;
+unsigned long batchRecordsSent = 0;
+unsigned long batchBytesSent = 0;
+
+//----------------------------------------------------------
+// drop the connection, the upload stays wanted
+void batchDisconnect(const char* why)
+{
+  char msg[96];
+  if (batchState != BATCHSTATE_IDLE)
+  {
+    snprintf(msg, sizeof(msg), "Batch upload %s at record %lu", why, (unsigned long)batchAckedSeq);
+    logMessage(msg);
+  }
+  batchClient.stop();
+  if (batchFile) batchFile.close();
+  batchState = BATCHSTATE_IDLE;
+  batchTimer = millis();
+}
+
+//----------------------------------------------------------
+// connect and say hello, return true if connected
+int batchConnect()
+{
+  batchTimer = millis();
+  if (!batchClient.connect(batchServer, batchPort, BATCH_CONNECT_MS)) return false;
+  batchFile = fileSystem.open(batchFileName, FILE_READ);
+  if (!batchFile)
+  {
+    batchClient.stop();
+    return false;
+  }
+  uint8_t frame[BATCH_HDRLEN + 64];
+  int len = strlen(batchDeviceId);
+  if (len > 64) len = 64;
+  memcpy(&frame[BATCH_HDRLEN], batchDeviceId, len);
+  batchClient.write(frame, batchFrame(frame, BATCH_HELLO, len));
+  batchRxInit(&batchRx);
+  batchSessions++;
+  batchState = BATCHSTATE_HELLOWAIT;
+  return true;
+}
+
+//----------------------------------------------------------
+// start uploading fn, return true if the first connection worked
+int batchStart(char* fn)
+{
+  strncpy(batchFileName, fn, sizeof(batchFileName)-1);
+  batchAckedSeq = 0;
+  batchAckedOffset = 0;
+  batchWanted = true;
+  return batchConnect();
+}
+
+int batchIsActive()
+{
+  return batchWanted;
+}
+
+//----------------------------------------------------------
+// receiver wants record seq next - position the file there, return false
+// if the log has fewer records than that (deleted or cut short since)
+int batchResume(uint32_t seq)
+{
+  char line[BATCH_MAXRECORD+1];
+  uint32_t at = 0;
+  batchFile.seek(0);
+  if (seq >= batchAckedSeq)
+  {
+    // everything up to our last ACK is known, skip straight there
+    batchFile.seek(batchAckedOffset);
+    at = batchAckedSeq;
+  }
+  batchEof = false;
+  while (at < seq)
+  {
+    if (!readln(batchFile, (uint8_t*)line, sizeof(line)) && (line[0] == 0)) break;
+    at++;
+  }
+  batchInflightCount = 0;
+  if (at < seq)
+  {
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Batch upload: receiver has %lu records, log only %lu - new file there",
+      (unsigned long)seq, (unsigned long)at);
+    logMessage(msg);
+    batchNextSeq = at;
+    batchAckedSeq = 0;
+    batchAckedOffset = 0;
+    return false;
+  }
+  batchNextSeq = at;
+  batchAckedSeq = at;
+  batchAckedOffset = batchFile.position();
+  return true;
+}
+
+//----------------------------------------------------------
+// receiver has everything before seq
+void batchAck(uint32_t seq)
+{
+  int done = 0;
+  while ((done < batchInflightCount) && (batchInflight[done].endSeq <= seq))
+  {
+    batchAckedSeq = batchInflight[done].endSeq;
+    batchAckedOffset = batchInflight[done].endOffset;
+    done++;
+  }
+  for (int i = done; i < batchInflightCount; i++) batchInflight[i-done] = batchInflight[i];
+  batchInflightCount -= done;
+  if (done) batchTimer = millis();
+}
+
+//----------------------------------------------------------
+// read records into one DATA frame and send it
+void batchSendFrame()
+{
+  uint8_t frame[BATCH_HDRLEN + BATCH_MAXPAYLOAD];
+  char line[BATCH_MAXRECORD+1];
+  int len = 4;
+  uint32_t seq = batchNextSeq;
+
+  batchPutU32(&frame[BATCH_HDRLEN], seq);
+  for (;;)
+  {
+    uint32_t pos = batchFile.position();
+    int more = readln(batchFile, (uint8_t*)line, sizeof(line));
+    int n = strlen(line);
+    if (!more && (n == 0))
+    {
+      batchEof = true;
+      break;
+    }
+    if (len + 1 + n > BATCH_MAXPAYLOAD)
+    {
+      batchFile.seek(pos); // doesn't fit, next frame
+      break;
+    }
+    frame[BATCH_HDRLEN + len++] = n;
+    memcpy(&frame[BATCH_HDRLEN + len], line, n);
+    len += n;
+    seq++;
+    if (!more)
+    {
+      batchEof = true;
+      break;
+    }
+  }
+  if (seq == batchNextSeq) return; // nothing to send
+
+  int flen = batchFrame(frame, BATCH_DATA, len);
+  if (batchClient.write(frame, flen) != (size_t)flen)
+  {
+    batchDisconnect("write failed");
+    return;
+  }
+  batchInflight[batchInflightCount].endSeq = seq;
+  batchInflight[batchInflightCount].endOffset = batchFile.position();
+  batchInflightCount++;
+  batchRecordsSent += seq - batchNextSeq;
+  batchBytesSent += flen;
+  batchNextSeq = seq;
+}
+
+//----------------------------------------------------------
+void batchService()
+{
+  if (!batchWanted) return;
+
+  if (batchState == BATCHSTATE_IDLE)
+  {
+    if (wifiIsConnected() && (millis() - batchTimer >= BATCH_RETRY_MS)) batchConnect();
+    return;
+  }
+
+  if (!batchClient.connected() && !batchClient.available())
+  {
+    batchDisconnect("disconnected");
+    return;
+  }
+  if (millis() - batchTimer >= BATCH_TIMEOUT_MS)
+  {
+    batchDisconnect("timed out");
+    return;
+  }
+
+  // whatever the receiver has sent
+  while (batchClient.available())
+  {
+    int got = batchRxPush(&batchRx, batchClient.read());
+    if (got < 0)
+    {
+      batchDisconnect("bad frame");
+      return;
+    }
+    if (!got || (batchRxLen(&batchRx) < 4)) continue;
+    uint32_t seq = batchGetU32(batchRxPayload(&batchRx));
+    if ((batchRxType(&batchRx) == BATCH_RESUME) && (batchState == BATCHSTATE_HELLOWAIT))
+    {
+      batchTimer = millis();
+      if (batchResume(seq))
+      {
+        batchState = BATCHSTATE_SENDING;
+      }
+      else
+      {
+        // receiver starts a new file and says RESUME 0
+        uint8_t frame[BATCH_HDRLEN + 4];
+        batchClient.write(frame, batchSeqFrame(frame, BATCH_NEWFILE, batchNextSeq));
+      }
+    }
+    else if (batchRxType(&batchRx) == BATCH_ACK)
+    {
+      batchAck(seq);
+    }
+  }
+
+  if (batchState != BATCHSTATE_SENDING) return;
+
+  // keep the window full
+  while (!batchEof && (batchInflightCount < BATCH_WINDOW) && (batchState == BATCHSTATE_SENDING))
+    batchSendFrame();
+
+  if (batchEof && (batchInflightCount == 0) && (batchState == BATCHSTATE_SENDING))
+  {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Batch upload completed, %lu records", (unsigned long)batchAckedSeq);
+    logMessage(msg);
+    batchClient.stop();
+    batchFile.close();
+    batchState = BATCHSTATE_IDLE;
+    batchWanted = false;
+  }
+}
@@ -0,0 +1,423 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Raw capture - every line and binary frame from the receiver, timed to
+// the microsecond, into a fixed size ring in flash
+//----------------------------------------------------------------------------
+// For looking at what a receiver really sends.  capStart() runs for a
+// given number of minutes (or until capStop()), capService() gets each
+// line from gpsService() and picks up each binary frame (gpsBinFrames
+// going up), so nothing else on the input path changes.
+//
+// Records go into a CAP_BLOCK sized block in RAM:
+//   varint   microseconds since the record before (the block's first:
+//            since startUs in its header)
+//   byte     bits 0-4 slot, CAP_CSUM checksum kept, CAP_RAW, CAP_BIN
+//   line     field by field against the previous line in the same slot
+//            (a slot per sentence type, by hash):  n fields in a row the
+//            same as before are one byte CAP_RUN | n, a field starting
+//            the same (time, lat, lon) is a byte 2..31 for that many
+//            characters then the rest, any other field its text - the
+//            last character with CAP_LAST set (NMEA is 7 bit), or
+//            CAP_EMPTY;  0 at the end.  A good *hh is dropped and worked
+//            out again when decoding, a bad one is kept (CAP_CSUM).
+//   raw      lines with control characters or too long for a slot, and
+//            binary frames (CAP_BIN):  varint length and the bytes
+// The slots start empty in every block, so each block decodes on its own.
+// A full block is written to slot seq % capBlocks of CAPFN, so once the
+// CAPTUREKB= size is reached the oldest block is the one overwritten.
+//
+// capDump() decodes the ring oldest first, a line of text per record:
+//   1234567 $GNRMC,095100.00,A,4745.12360,N,12212.56760,W,0.1,,151123,,,A*6B
+//   1234890 !b562010224...       (binary frame, or a raw line with its CR LF, in hex)
+// microseconds from the capture start, then the record - ReplayService.h
+// plays that back with its own timing, so a telnet log of the dump goes
+// straight into "replay" and host/replay.cpp.
+//
+// Needs gpsBinFrame/gpsBinLen/gpsBinFrames (GpsService.h), fileSystem, CAPFN
+
+#define CAP_BLOCK (4096)
+#define CAP_SLOTS (32)
+#define CAP_SLOTLEN (100)
+#define CAP_MAGIC (0x50414352UL)     /* "RCAP" */
+#define CAP_CSUM (0x20)
+#define CAP_RAW (0x40)
+#define CAP_BIN (0x80)
+#define CAP_EMPTY (0x01)             /* an empty field */
+#define CAP_PREFIXMAX (0x1f)         /* 2..31 = that many characters as before */
+#define CAP_RUN (0x80)               /* | n = n fields as before */
+#define CAP_RUNMAX (0x1f)
+#define CAP_LAST (0x80)              /* on the last character of a field */
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t seq;                      // block number since capStart()
+  uint64_t startUs;                  // from capStart() to the block's first record
+  uint16_t used;                     // bytes of records after the header
+  uint16_t records;
+  uint32_t reserved;
+} CapHeader;
+
+int capActive = false;
+int capMinutes = 10;                 // CAPTUREMIN
+long capKb = 256;                    // CAPTUREKB
+int capBlocks = 0;                   // ring size this capture
+File capFile;
+
+uint8_t capBlock[CAP_BLOCK];
+CapHeader* capHdr = (CapHeader*)capBlock;
+char capSlot[CAP_SLOTS][CAP_SLOTLEN];
+uint32_t capMicros = 0;              // micros() at the last record
+uint64_t capUs = 0;                  // from capStart() to the last record
+uint64_t capLastUs = 0;              // the record before, from capStart()
+unsigned long capStartMs = 0;
+unsigned long capLastFrame = 0;
+
+// statistics
+unsigned long capLines = 0, capFrames = 0, capInBytes = 0, capOutBytes = 0, capSeq = 0;
+
+//----------------------------------------------------------
+int capPutVarint(uint8_t* p, uint64_t v)
+{
+  int n = 0;
+  while (v >= 0x80)
+  {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+uint64_t capGetVarint(const uint8_t** pp, const uint8_t* end)
+{
+  const uint8_t* p = *pp;
+  uint64_t v = 0;
+  int shift = 0;
+  while ((p < end) && (shift < 64))
+  {
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7f) << shift;
+    shift += 7;
+    if (!(b & 0x80)) break;
+  }
+  *pp = p;
+  return v;
+}
+
+// by talker and type - GSV by its message number too (the same part of
+// the sky), $GNGSA by its system id (the last field)
+int capSlotOf(const char* line, int len)
+{
+  uint8_t h = 0;
+  for (int i = 1; (i < 6) && line[i]; i++) h = h * 31 + line[i];
+  if ((line[3] == 'G') && (line[4] == 'S') && (line[5] == 'V') && (line[6] == ',') && line[7] && (line[8] == ','))
+    h = h * 31 + line[9];
+  if ((line[3] == 'G') && (line[4] == 'S') && (line[5] == 'A') && (len > 4) && (line[len - 3] == '*'))
+    h = h * 31 + line[len - 4];
+  return h % CAP_SLOTS;
+}
+
+void capNewBlock(uint64_t us)
+{
+  memset(capBlock, 0, sizeof(CapHeader));
+  capHdr->magic = CAP_MAGIC;
+  capHdr->seq = capSeq;
+  capHdr->startUs = us;
+  capLastUs = us;
+  memset(capSlot, 0, sizeof(capSlot));
+}
+
+void capWriteBlock()
+{
+  if (capHdr->records == 0) return;
+  capFile.seek((capSeq % capBlocks) * (unsigned long)CAP_BLOCK);
+  capFile.write(capBlock, CAP_BLOCK);
+  capFile.flush();
+  capOutBytes += sizeof(CapHeader) + capHdr->used;
+  capSeq++;
+}
+
+// room for a record of up to len bytes, a new block if it doesn't fit
+uint8_t* capRoom(int len, uint64_t us)
+{
+  if (sizeof(CapHeader) + capHdr->used + len > CAP_BLOCK)
+  {
+    capWriteBlock();
+    capNewBlock(us);
+  }
+  return capBlock + sizeof(CapHeader) + capHdr->used;
+}
+
+//----------------------------------------------------------
+// the next field of a slot's line, NULL past the last one
+const char* capNextField(const char* q, int* len)
+{
+  const char* g = q;
+  while (*q && (*q != ',')) q++;
+  *len = q - g;
+  return (*q == ',') ? q + 1 : NULL;
+}
+
+// a line, field by field against its slot
+int capEncodeLine(uint8_t* out, const char* line, int len, char* prev)
+{
+  int n = 0;
+  int run = 0;
+  const char* p = line;
+  const char* q = prev;
+  const char* end = line + len;
+  for (;;)
+  {
+    const char* f = p;
+    while ((p < end) && (*p != ',')) p++;
+    int flen = p - f;
+    const char* g = q;
+    int glen = -1;
+    if (q != NULL) q = capNextField(q, &glen);
+    if ((glen == flen) && (memcmp(f, g, flen) == 0))
+    {
+      if (++run == CAP_RUNMAX) { out[n++] = CAP_RUN | run; run = 0; }
+    }
+    else
+    {
+      if (run > 0) { out[n++] = CAP_RUN | run; run = 0; }
+      int common = 0;
+      while ((common < flen - 1) && (common < glen) && (common < CAP_PREFIXMAX) && (f[common] == g[common])) common++;
+      if (flen == 0) out[n++] = CAP_EMPTY;
+      else
+      {
+        if (common >= 2) out[n++] = common; // the first common characters as before, then the rest
+        else common = 0;
+        memcpy(out + n, f + common, flen - common);
+        n += flen - common;
+        out[n - 1] |= CAP_LAST;
+      }
+    }
+    if (p >= end) break;
+    p++;
+  }
+  if (run > 0) out[n++] = CAP_RUN | run;
+  out[n++] = 0;
+  memcpy(prev, line, len);
+  prev[len] = 0;
+  return n;
+}
+
+// and back, into line (CAP_SLOTLEN), the slot updated;  the bytes used
+int capDecodeLine(const uint8_t* p, const uint8_t* end, char* prev, char* line)
+{
+  const uint8_t* start = p;
+  const char* q = prev;
+  int len = 0;
+  int fields = 0;
+  while ((p < end) && *p)
+  {
+    int literal = (*p < CAP_RUN) || (*p > (CAP_RUN | CAP_RUNMAX));
+    int count = literal ? 1 : (*p++ & CAP_RUNMAX);
+    for (int i = 0; i < count; i++)
+    {
+      if ((fields++ > 0) && (len < CAP_SLOTLEN - 1)) line[len++] = ',';
+      const char* g = q;
+      int glen = 0;
+      if (q != NULL) q = capNextField(q, &glen);
+      int copy = glen;
+      if (literal) copy = ((*p >= 2) && (*p <= CAP_PREFIXMAX)) ? *p++ : 0;
+      for (int k = 0; (k < copy) && (k < glen) && (len < CAP_SLOTLEN - 1); k++) line[len++] = g[k];
+    }
+    if (!literal) continue;
+    if (*p == CAP_EMPTY) { p++; continue; }
+    while (p < end)
+    {
+      uint8_t c = *p++;
+      if (len < CAP_SLOTLEN - 1) line[len++] = c & ~CAP_LAST;
+      if (c & CAP_LAST) break;
+    }
+  }
+  if (p < end) p++; // the 0
+  line[len] = 0;
+  memcpy(prev, line, len + 1);
+  return p - start;
+}
+
+// the *hh exactly as it would be written again
+int capSumOk(const char* line, int len)
+{
+  if ((len < 4) || (line[len - 3] != '*')) return false;
+  uint8_t sum = 0;
+  for (int i = 1; i < len - 3; i++) sum ^= line[i];
+  const char* hex = "0123456789ABCDEF";
+  return (line[len - 2] == hex[sum >> 4]) && (line[len - 1] == hex[sum & 15]);
+}
+
+void capRecord(uint8_t flags, const uint8_t* data, int len)
+{
+  uint32_t now = micros();
+  capUs += (uint32_t)(now - capMicros);
+  capMicros = now;
+  uint64_t us = capUs;
+  uint8_t* out = capRoom(len + 20, us); // varint, flags, length or the 0
+  int n = capPutVarint(out, us - capLastUs);
+  capLastUs = us;
+  const char* line = (const char*)data;
+  if (!(flags & CAP_BIN))
+  {
+    int ok = (len < CAP_SLOTLEN) && (line[0] == '$');
+    for (int i = 0; ok && (i < len); i++) ok = (line[i] >= 0x20) && (line[i] < 0x7f);
+    if (ok)
+    {
+      int slot = capSlotOf(line, len);
+      if (capSumOk(line, len)) len -= 3;
+      else flags |= CAP_CSUM;
+      out[n++] = flags | slot;
+      n += capEncodeLine(out + n, line, len, capSlot[slot]);
+      capHdr->used += n;
+      capHdr->records++;
+      return;
+    }
+    flags |= CAP_RAW;
+  }
+  if (len > GPSBUFLEN) len = GPSBUFLEN;
+  out[n++] = flags;
+  n += capPutVarint(out + n, len);
+  memcpy(out + n, data, len);
+  n += len;
+  capHdr->used += n;
+  capHdr->records++;
+}
+
+//----------------------------------------------------------
+void capStop()
+{
+  if (!capActive) return;
+  capWriteBlock();
+  capFile.close();
+  capActive = false;
+}
+
+int capStart(int minutes, long kb)
+{
+  capStop();
+  long room = (long)(fileSystem.totalBytes() - fileSystem.usedBytes()) - 16 * 1024; // leave the logs some
+  if (fileSystem.exists(CAPFN))
+  {
+    File old = fileSystem.open(CAPFN, FILE_READ);
+    room += old.size();
+    old.close();
+  }
+  if (kb * 1024 > room) kb = room / 1024;
+  capBlocks = kb * 1024 / CAP_BLOCK;
+  if (capBlocks < 2) return false;
+  fileSystem.remove(CAPFN);
+  capFile = fileSystem.open(CAPFN, FILE_WRITE);
+  if (!capFile) return false;
+  capFile.close();
+  capFile = fileSystem.open(CAPFN, "r+");
+  if (!capFile) return false;
+  capMinutes = minutes;
+  capLines = capFrames = capInBytes = capOutBytes = capSeq = 0;
+  capMicros = micros();
+  capUs = 0;
+  capStartMs = millis();
+  capLastFrame = gpsBinFrames;
+  capNewBlock(0);
+  capActive = true;
+  return true;
+}
+
+// from the high rate part of loop(), line from gpsService() or NULL
+void capService(const char* line)
+{
+  if (!capActive) return;
+  if (line != NULL)
+  {
+    int len = strlen(line);
+    capRecord(0, (const uint8_t*)line, len);
+    capLines++;
+    capInBytes += len + 2;
+  }
+  if (gpsBinFrames != capLastFrame)
+  {
+    capLastFrame = gpsBinFrames;
+    if (gpsBinLen > 0)
+    {
+      capRecord(CAP_BIN, gpsBinFrame, gpsBinLen);
+      capFrames++;
+      capInBytes += gpsBinLen;
+    }
+  }
+  if ((millis() - capStartMs) >= (unsigned long)capMinutes * 60000UL) capStop();
+}
+
+//----------------------------------------------------------
+// a block back into text, each record to emit()
+int capDecodeBlock(const uint8_t* block, void (*emit)(const char* text))
+{
+  const CapHeader* h = (const CapHeader*)block;
+  if ((h->magic != CAP_MAGIC) || (sizeof(CapHeader) + h->used > CAP_BLOCK)) return false;
+  static char slot[CAP_SLOTS][CAP_SLOTLEN];
+  static char text[24 + 2 * (GPSBUFLEN + 2)];
+  memset(slot, 0, sizeof(slot));
+  const uint8_t* p = block + sizeof(CapHeader);
+  const uint8_t* end = p + h->used;
+  uint64_t us = h->startUs;
+  for (int r = 0; (r < h->records) && (p < end); r++)
+  {
+    us += capGetVarint(&p, end);
+    if (p >= end) return false;
+    uint8_t flags = *p++;
+    int n = snprintf(text, sizeof(text), "%llu ", (unsigned long long)us);
+    if (flags & (CAP_RAW | CAP_BIN))
+    {
+      int len = capGetVarint(&p, end);
+      if ((len > GPSBUFLEN) || (p + len > end)) return false;
+      text[n++] = '!';
+      for (int i = 0; i < len; i++) n += sprintf(text + n, "%02x", p[i]);
+      if (flags & CAP_RAW) n += sprintf(text + n, "0d0a");
+      p += len;
+    }
+    else
+    {
+      char* line = text + n;
+      p += capDecodeLine(p, end, slot[flags & (CAP_SLOTS - 1)], line);
+      int len = strlen(line);
+      if (!(flags & CAP_CSUM))
+      {
+        uint8_t sum = 0;
+        for (int i = 1; i < len; i++) sum ^= line[i];
+        sprintf(line + len, "*%02X", sum);
+      }
+    }
+    emit(text);
+  }
+  return true;
+}
+
+// the whole ring, oldest block first;  returns the records
+unsigned long capDump(void (*emit)(const char* text))
+{
+  if (capActive) return 0;
+  File file = fileSystem.open(CAPFN, FILE_READ);
+  if (!file) return 0;
+  int blocks = file.size() / CAP_BLOCK;
+  uint32_t first = 0xffffffffUL, last = 0;
+  for (int i = 0; i < blocks; i++)
+  {
+    CapHeader h;
+    file.seek((unsigned long)i * CAP_BLOCK);
+    if ((file.read((uint8_t*)&h, sizeof(h)) != sizeof(h)) || (h.magic != CAP_MAGIC)) continue;
+    if (h.seq < first) first = h.seq;
+    if (h.seq > last) last = h.seq;
+  }
+  unsigned long records = 0;
+  for (uint32_t seq = first; (blocks > 0) && (first <= last) && (seq <= last); seq++)
+  {
+    file.seek((seq % blocks) * (unsigned long)CAP_BLOCK);
+    if (file.read(capBlock, CAP_BLOCK) != CAP_BLOCK) break;
+    if (capHdr->seq != seq) continue;
+    records += capHdr->records;
+    capDecodeBlock(capBlock, emit);
+  }
+  file.close();
+  return records;
+}
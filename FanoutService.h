@@ -0,0 +1,286 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// NMEA fan-out server - the live GPS feed to several TCP clients
+//----------------------------------------------------------------------------
+// Two listening ports:
+//   FAN_GPSD_PORT (2947)   gpsd protocol subset - VERSION banner on connect,
+//                          then ?WATCH={"enable":true,"json":true}; for TPV
+//                          reports, or ?WATCH={"enable":true,"nmea":true};
+//                          (or "raw":1) for the NMEA sentences
+//   FAN_NMEA_PORT (10110)  plain NMEA over TCP, sentences from the moment
+//                          of connecting (what most nav apps call "TCP")
+//
+// Every line from gpsService() is appended once to fanRaw, and every RMC
+// once (as a TPV report) to fanJson.  The rings are never copied per
+// client:  each client has a cursor (total bytes written when it last
+// caught up), and is sent straight out of the ring from its cursor to the
+// head.  Sends use MSG_DONTWAIT, so a client that isn't reading just takes
+// what fits in its socket buffer;  once the head is more than
+// FAN_RINGSIZE ahead of its cursor the data it needed is gone, and it is
+// cut off.  Nothing here ever waits on a client, so gpsService() is never
+// held up.
+//
+// Call fanoutInit() once WiFi is up, fanoutLine() with each line from
+// gpsService(), fanoutService() from the high rate part of loop().
+//
+// Needs rmcParse() (NmeaService.h), logMessage()
+
+#define FAN_GPSD_PORT (2947)
+#define FAN_NMEA_PORT (10110)
+#define FAN_MAXCLIENTS (6)
+#define FAN_RINGSIZE (8192)    /* power of 2, about 8s of 9600 baud NMEA */
+#define FAN_CMDLEN (128)
+#define FAN_ACCEPT_MS (100)    /* how often to look for new connections */
+
+#define FANMODE_NONE (0)       /* gpsd client that hasn't sent ?WATCH yet */
+#define FANMODE_RAW  (1)
+#define FANMODE_JSON (2)
+
+#define FAN_VERSION "{\"class\":\"VERSION\",\"release\":\"3.17\",\"rev\":\"GpsLogger\",\"proto_major\":3,\"proto_minor\":12}\r\n"
+
+typedef struct
+{
+  char buf[FAN_RINGSIZE];
+  uint32_t head;               // total bytes ever written
+} FanRing;
+
+typedef struct
+{
+  WiFiClient client;
+  int inUse;
+  int mode;
+  uint32_t cursor;             // next byte to send, same count as ring head
+  uint32_t sent;
+  char cmd[FAN_CMDLEN];        // gpsd command being received
+  int cmdLen;
+} FanClient;
+
+WiFiServer fanGpsdServer(FAN_GPSD_PORT);
+WiFiServer fanNmeaServer(FAN_NMEA_PORT);
+FanRing fanRaw;
+FanRing fanJson;
+FanClient fanClients[FAN_MAXCLIENTS];
+int fanStarted = false;
+int fanRawClients = 0;         // clients in each mode, so we skip
+int fanJsonClients = 0;        //  filling a ring nobody reads
+unsigned long fanAcceptTimer = 0;
+
+// statistics
+unsigned long fanAccepted = 0;
+unsigned long fanRefused = 0;
+unsigned long fanCutOff = 0;
+
+//----------------------------------------------------------
+void fanoutInit()
+{
+  if (fanStarted) return;
+  fanGpsdServer.begin();
+  fanGpsdServer.setNoDelay(true);
+  fanNmeaServer.begin();
+  fanNmeaServer.setNoDelay(true);
+  fanStarted = true;
+}
+
+//----------------------------------------------------------
+// append to a ring, overwriting whatever is oldest
+void fanRingPut(FanRing* r, const char* p, int len)
+{
+  while (len > 0)
+  {
+    int off = r->head & (FAN_RINGSIZE-1);
+    int n = FAN_RINGSIZE - off;
+    if (n > len) n = len;
+    memcpy(&r->buf[off], p, n);
+    r->head += n;
+    p += n;
+    len -= n;
+  }
+}
+
+void fanCountModes()
+{
+  fanRawClients = fanJsonClients = 0;
+  for (int i = 0; i < FAN_MAXCLIENTS; i++)
+  {
+    if (!fanClients[i].inUse) continue;
+    if (fanClients[i].mode == FANMODE_RAW) fanRawClients++;
+    if (fanClients[i].mode == FANMODE_JSON) fanJsonClients++;
+  }
+}
+
+void fanSetMode(FanClient* fc, int mode)
+{
+  fc->mode = mode;
+  fc->cursor = (mode == FANMODE_JSON) ? fanJson.head : fanRaw.head; // from now on
+  fanCountModes();
+}
+
+//----------------------------------------------------------
+// with each line from gpsService()
+void fanoutLine(const char* line)
+{
+  if (fanRawClients > 0)
+  {
+    fanRingPut(&fanRaw, line, strlen(line));
+    fanRingPut(&fanRaw, "\r\n", 2);
+  }
+  GpsFix fix;
+  if ((fanJsonClients > 0) && rmcParse(line, &fix))
+  {
+    char tpv[256];
+    int len = snprintf(tpv, sizeof(tpv),
+      "{\"class\":\"TPV\",\"device\":\"gps0\",\"mode\":%d,"
+      "\"time\":\"%04d-%02d-%02dT%02d:%02d:%06.3fZ\",",
+      fix.valid ? 2 : 1, fix.year, fix.month, fix.day, fix.hour, fix.minute, fix.second);
+    if (fix.valid)
+      len += snprintf(&tpv[len], sizeof(tpv)-len, "\"lat\":%.7f,\"lon\":%.7f,\"track\":%.1f,\"speed\":%.2f,",
+        fix.lat, fix.lon, fix.course, fix.speedKts * 0.514444);
+    len--; // drop the last comma
+    len += snprintf(&tpv[len], sizeof(tpv)-len, "}\r\n");
+    fanRingPut(&fanJson, tpv, len);
+  }
+}
+
+//----------------------------------------------------------
+// send without waiting, return bytes taken or -1 if the connection is dead
+int fanSend(FanClient* fc, const char* p, int len)
+{
+  int n = send(fc->client.fd(), p, len, MSG_DONTWAIT);
+  if (n >= 0) return n;
+  return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+}
+
+void fanDrop(FanClient* fc, const char* why)
+{
+  if (why != NULL)
+  {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "NMEA client cut off, %s", why);
+    logMessage(msg);
+  }
+  fc->client.stop();
+  fc->inUse = false;
+  fanCountModes();
+}
+
+//----------------------------------------------------------
+// the gpsd commands we understand
+void fanCommand(FanClient* fc)
+{
+  char reply[320];
+  char* cmd = fc->cmd;
+  while ((*cmd == ' ') || (*cmd == '\r')) cmd++;
+  if (*cmd == 0) return;
+
+  if (strncmp(cmd, "?WATCH", 6) == 0)
+  {
+    int enable = strstr(cmd, "\"enable\":false") == NULL;
+    int nmea = (strstr(cmd, "\"nmea\":true") != NULL) || (strstr(cmd, "\"raw\":1") != NULL) ||
+               (strstr(cmd, "\"raw\":2") != NULL);
+    int mode = !enable ? FANMODE_NONE : nmea ? FANMODE_RAW : FANMODE_JSON;
+    snprintf(reply, sizeof(reply),
+      "{\"class\":\"DEVICES\",\"devices\":[{\"class\":\"DEVICE\",\"path\":\"gps0\",\"driver\":\"NMEA0183\",\"activated\":\"%s\"}]}\r\n"
+      "{\"class\":\"WATCH\",\"enable\":%s,\"json\":%s,\"nmea\":%s,\"raw\":0,\"scaled\":false,\"timing\":false}\r\n",
+      rtc.getTime("%Y-%m-%dT%H:%M:%S.000Z").c_str(),
+      enable ? "true" : "false", (mode == FANMODE_JSON) ? "true" : "false", (mode == FANMODE_RAW) ? "true" : "false");
+    fanSend(fc, reply, strlen(reply));
+    fanSetMode(fc, mode);
+  }
+  else if (strncmp(cmd, "?VERSION", 8) == 0)
+  {
+    fanSend(fc, FAN_VERSION, strlen(FAN_VERSION));
+  }
+  else
+  {
+    snprintf(reply, sizeof(reply), "{\"class\":\"ERROR\",\"message\":\"Unrecognized request '%.40s'\"}\r\n", cmd);
+    fanSend(fc, reply, strlen(reply));
+  }
+}
+
+//----------------------------------------------------------
+void fanAccept(WiFiServer& server, int gpsd)
+{
+  WiFiClient nc = server.available();
+  if (!nc) return;
+  for (int i = 0; i < FAN_MAXCLIENTS; i++)
+  {
+    FanClient* fc = &fanClients[i];
+    if (fc->inUse) continue;
+    fc->client = nc;
+    fc->inUse = true;
+    fc->sent = 0;
+    fc->cmdLen = 0;
+    fanAccepted++;
+    if (gpsd)
+    {
+      fanSend(fc, FAN_VERSION, strlen(FAN_VERSION));
+      fanSetMode(fc, FANMODE_NONE);
+    }
+    else fanSetMode(fc, FANMODE_RAW);
+    return;
+  }
+  nc.stop(); // full up
+  fanRefused++;
+}
+
+//----------------------------------------------------------
+void fanoutService()
+{
+  if (!fanStarted) return;
+  if (millis() - fanAcceptTimer >= FAN_ACCEPT_MS)
+  {
+    fanAcceptTimer = millis();
+    fanAccept(fanGpsdServer, true);
+    fanAccept(fanNmeaServer, false);
+  }
+
+  for (int i = 0; i < FAN_MAXCLIENTS; i++)
+  {
+    FanClient* fc = &fanClients[i];
+    if (!fc->inUse) continue;
+    if (!fc->client.connected())
+    {
+      fanDrop(fc, NULL);
+      continue;
+    }
+
+    // commands, a line or ';' at a time
+    while (fc->client.available())
+    {
+      char c = fc->client.read();
+      if ((c == '\n') || (c == ';'))
+      {
+        fc->cmd[fc->cmdLen] = 0;
+        fanCommand(fc);
+        fc->cmdLen = 0;
+      }
+      else if (fc->cmdLen < FAN_CMDLEN-1) fc->cmd[fc->cmdLen++] = c;
+    }
+
+    if (fc->mode == FANMODE_NONE) continue;
+    FanRing* r = (fc->mode == FANMODE_JSON) ? &fanJson : &fanRaw;
+    uint32_t behind = r->head - fc->cursor;
+    if (behind > FAN_RINGSIZE)
+    {
+      fanCutOff++;
+      fanDrop(fc, "too slow");
+      continue;
+    }
+    while (behind > 0)
+    {
+      int off = fc->cursor & (FAN_RINGSIZE-1);
+      int chunk = FAN_RINGSIZE - off;
+      if ((uint32_t)chunk > behind) chunk = behind;
+      int n = fanSend(fc, &r->buf[off], chunk);
+      if (n < 0)
+      {
+        fanDrop(fc, NULL);
+        break;
+      }
+      fc->cursor += n;
+      fc->sent += n;
+      behind -= n;
+      if (n < chunk) break; // socket buffer full, the rest next time
+    }
+  }
+}
@@ -0,0 +1,46 @@
+// Initial version 18-Oct-2026, split out of GpsLogger.ino
+//----------------------------------------------------------------------------
+// FTP upload of the location log to a remote server
+//----------------------------------------------------------------------------
+// Call ftpPut() with WiFi connected, e.g. from the "ftp" shell command.
+// The whole log file is sent as gpslog_YYYYMMDD-HHMMSS.log into FTPFOLDER.
+//
+// Needs ftpServer, ftpUser, ftpPwd, ftpUploadFolder from the config file,
+// plus rtc, fileSystem, readln() and zprint()/zprintln().
+//
+// Kept in its own file so the host network simulator (host/netsim.cpp)
+// can run the same uploader against a simulated link.
+
+#define FTP_LINELEN (256)  /* on loop()'s stack, a log line and its CRLF */
+
+void ftpPut(char* fn)
+{
+  char linebuf[FTP_LINELEN];
+
+  String targetfn = rtc.getTime("gpslog_%Y%m%d-%H%M%S.log"); // "20221116-182201"
+  zprint("FTP to "); zprintln(targetfn);
+  ESP32_FTPClient ftp (ftpServer,ftpUser,ftpPwd, 5000, 1); // 50 sec timeout, verbose=1
+  ftp.OpenConnection();
+  ftp.InitFile("Type I");
+  ftp.ChangeWorkDir(ftpUploadFolder);
+  ftp.NewFile(targetfn.c_str());
+
+  // open file and read each line - send to FTP
+  File finp = fileSystem.open(LOGFN, FILE_READ);
+  if (!finp)
+  {
+    zprintln("Unable to read log file");
+    return;
+  }
+
+  while (readln(finp, (uint8_t*)linebuf, FTP_LINELEN-6))
+  {
+    strcat(linebuf,"\n");
+    ftp.WriteData( (unsigned char*)linebuf, strlen(linebuf) );
+  }
+  finp.close();
+  zprintln("FTP upload completed.");
+  ftp.CloseFile();
+  ftp.CloseConnection();  
+
+}
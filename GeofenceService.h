@@ -0,0 +1,148 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Geofence - only look for WiFi where there is a known access point
+//----------------------------------------------------------------------------
+// Up to GEOFENCE_MAX zones, each a circle around a known AP (config.ini
+// ZONE1= .. ZONE4=  lat,lon,radius in metres).  geofenceUpdate() takes the
+// latest RMC line and works out whether we are inside a zone, close enough
+// to reach one within GEOFENCE_LEAD_SEC at the current speed, or away.
+//
+// geofenceWantWifi() is what the sketch switches the radio with:
+//   no zones configured            - always (the old behaviour)
+//   no fix since boot              - yes, we are most likely parked at home
+//   inside or approaching a zone   - yes
+//   away from every zone           - only for a GEOFENCE_WINDOW_SEC window
+//                                    every geofenceFallbackMin minutes
+//                                    (0 = never)
+// With the fix lost (garage, tunnel) the last known state is kept.
+//
+// geofenceArrived() returns true once for each entry into a zone, so the
+// sketch can upload as soon as WiFi connects.
+//
+// Call geofenceUpdate() once per second.
+// Needs rmcParse() (NmeaService.h) and WIFIWAIT_MAX (WiFiService.h)
+
+#define GEOFENCE_MAX (4)
+#define GEOFENCE_APPROACH_M (300)  /* this close to the edge counts as approaching at any speed */
+#define GEOFENCE_LEAD_SEC (45)     /* start WiFi this long before reaching a zone */
+#define GEOFENCE_HYST_M (50)       /* must get this far outside to have left a zone */
+#define GEOFENCE_WINDOW_SEC (WIFIWAIT_MAX+15) /* fallback WiFi window when away */
+#define GEOFENCE_FALLBACK_DEFAULT (60)        /* minutes between fallback windows */
+
+#define GEOSTATE_UNKNOWN     (0)
+#define GEOSTATE_AWAY        (1)
+#define GEOSTATE_APPROACHING (2)
+#define GEOSTATE_INSIDE      (3)
+
+typedef struct
+{
+  double lat, lon; // degrees
+  float radiusM;
+} GeofenceZone;
+
+GeofenceZone geofenceZones[GEOFENCE_MAX];
+int geofenceCount = 0;
+int geofenceState = GEOSTATE_UNKNOWN;
+int geofenceNearest = -1;       // zone closest to the last fix
+float geofenceEdgeM = 0;        // distance to its edge, 0 when inside
+int geofenceFallbackMin = GEOFENCE_FALLBACK_DEFAULT;
+unsigned long geofenceAwaySec = 0;  // seconds away since the last zone
+unsigned long geofenceEntries = 0;
+int geofenceArrival = false;
+
+//----------------------------------------------------------
+// add a zone from "lat,lon,radius", return true if it parsed
+int geofenceAddZone(const char* spec)
+{
+  char* p;
+  if (geofenceCount >= GEOFENCE_MAX) return false;
+  GeofenceZone* z = &geofenceZones[geofenceCount];
+  z->lat = strtod(spec, &p);
+  if (*p++ != ',') return false;
+  z->lon = strtod(p, &p);
+  if (*p++ != ',') return false;
+  z->radiusM = strtod(p, &p);
+  if ((z->radiusM <= 0) || (fabs(z->lat) > 90) || (fabs(z->lon) > 180)) return false;
+  geofenceCount++;
+  return true;
+}
+
+//----------------------------------------------------------
+// metres between a point and a zone centre - flat earth is
+// plenty at the few km where it matters
+float geofenceDistance(double lat, double lon, GeofenceZone* z)
+{
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  double dy = (lat - z->lat) * mPerDeg;
+  double dx = (lon - z->lon) * mPerDeg * cos(z->lat * M_PI / 180.0);
+  return sqrt(dx*dx + dy*dy);
+}
+
+//----------------------------------------------------------
+// once per second, with the latest $GxRMC line (may be stale or empty)
+void geofenceUpdate(const char* rmcline)
+{
+  GpsFix fix;
+  if (geofenceCount == 0) return;
+  if (geofenceState == GEOSTATE_AWAY) geofenceAwaySec++;
+  if (!rmcParse(rmcline, &fix) || !fix.valid) return; // keep what we had
+
+  float edge = 0;
+  for (int i = 0; i < geofenceCount; i++)
+  {
+    float d = geofenceDistance(fix.lat, fix.lon, &geofenceZones[i]) - geofenceZones[i].radiusM;
+    if ((i == 0) || (d < edge))
+    {
+      edge = d;
+      geofenceNearest = i;
+    }
+  }
+  geofenceEdgeM = (edge > 0) ? edge : 0;
+
+  float lead = fix.speedKts * 0.5144 * GEOFENCE_LEAD_SEC; // knots to m/s
+  if (lead < GEOFENCE_APPROACH_M) lead = GEOFENCE_APPROACH_M;
+
+  int was = geofenceState;
+  if ((edge <= 0) || ((was == GEOSTATE_INSIDE) && (edge <= GEOFENCE_HYST_M)))
+    geofenceState = GEOSTATE_INSIDE;
+  else if (edge <= lead)
+    geofenceState = GEOSTATE_APPROACHING;
+  else
+    geofenceState = GEOSTATE_AWAY;
+
+  if ((geofenceState == GEOSTATE_INSIDE) && (was != GEOSTATE_INSIDE))
+  {
+    geofenceArrival = true;
+    geofenceEntries++;
+  }
+  if (geofenceState != GEOSTATE_AWAY) geofenceAwaySec = 0;
+}
+
+//----------------------------------------------------------
+int geofenceWantWifi()
+{
+  if ((geofenceCount == 0) || (geofenceState != GEOSTATE_AWAY)) return true;
+  if (geofenceFallbackMin <= 0) return false;
+  unsigned long period = geofenceFallbackMin * 60UL;
+  return (geofenceAwaySec % period) >= period - GEOFENCE_WINDOW_SEC;
+}
+
+//----------------------------------------------------------
+// true once per entry into a zone
+int geofenceArrived()
+{
+  int arrived = geofenceArrival;
+  geofenceArrival = false;
+  return arrived;
+}
+
+const char* geofenceStateName()
+{
+  switch (geofenceState)
+  {
+    case GEOSTATE_AWAY:        return "away";
+    case GEOSTATE_APPROACHING: return "approaching";
+    case GEOSTATE_INSIDE:      return "inside";
+  }
+  return "no fix yet";
+}
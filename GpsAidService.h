@@ -0,0 +1,467 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Receiver hot-start aiding - last position, time, and (u-blox) the
+// navigation database, given back to the receiver at boot
+//----------------------------------------------------------------------------
+// GPSTYPE in the config says what the receiver speaks:
+//   UBX    u-blox M8 and later - UBX-MGA-INI-POS_LLH, UBX-MGA-INI-TIME_UTC,
+//          and the UBX-MGA-DBD dump (ephemeris, almanac, ionosphere)
+//   CASIC  AT6558 / ATGM336H and relatives - AID-INI (position and time)
+//   PMTK   MediaTek - $PMTK741 (position and time together) or $PMTK740
+//   empty  no aiding, TTFF is still measured
+//
+// While the receiver has a fix, the position (and GGA altitude) is saved
+// to NVS (Preferences "gpsaid") every AID_SAVE_MIN minutes if it has
+// moved, so the flash isn't worn by a parked logger.  For UBX the
+// receiver's navigation database is polled every AID_DBD_MIN minutes and
+// the MGA-DBD frames it answers with are written to AID_DBDFN - a dump is
+// several KB, too big for the NVS partition.
+//
+// At boot, AID_BOOT_MS after gpsInit(), the saved position goes to the
+// receiver (with a generous accuracy, the logger may have been moved),
+// then the database dump.  Time is only given once it is known - the RTC
+// starts at 2023 after a power cycle - so it goes when NTP completes, if
+// there's no fix by then.  PMTK can't take a position without a time, so
+// it waits for NTP altogether.  Everything is written in pieces no bigger
+// than GPSPORT.availableForWrite(), a dump takes several seconds at 9600
+// baud and the loop must not wait for it.  The port is held (gpsTxClaim())
+// only while a frame is part way out, so motion settings can go in
+// between the dump's frames but never inside one.
+//
+// Time to first fix (gpsInit() to the first valid RMC) is logged to the
+// event log on each boot with what aiding went in, and the last
+// AID_HISTORY of them are kept in NVS for the "aid" command.
+//
+// Call aidInit() from setup() after gpsInit(), aidLine() with each line
+// from gpsService(), aidService() from the high rate part of loop().
+//
+// Needs GPSPORT, gpsBinFrame/gpsBinLen/gpsTxClaim() (GpsService.h), rmcParse()/
+// fixEpoch()/nmeaField() (NmeaService.h), ntpComplete(), rtc, fileSystem,
+// logMessage()
+
+#define AIDTYPE_NONE  (0)
+#define AIDTYPE_UBX   (1)
+#define AIDTYPE_CASIC (2)
+#define AIDTYPE_PMTK  (3)
+
+#define AID_BOOT_MS (1000)        /* give the receiver time to start talking */
+#define AID_SAVE_MIN (10)
+#define AID_SAVE_MOVED_M (200)    /* ...and only if it has moved this far */
+#define AID_DBD_MIN (60)
+#define AID_DBD_QUIET_MS (2000)   /* dump is over after this long without a frame */
+#define AID_DBD_MAX (16384)
+#define AID_POSACC_M (50000)      /* how far we may have been carried since */
+#define AID_TIMEACC_S (2)         /* NTP, a second or two at worst */
+#define AID_HISTORY (8)
+#define AID_DBDFN "/gpsaid.dbd"
+#define AID_DBDTMPFN "/gpsaid.tmp"
+#define AID_LEAPSECONDS (18)      /* GPS - UTC since 2017 */
+
+// what went in this boot, bits
+#define AIDED_POS  (1)
+#define AIDED_TIME (2)
+#define AIDED_DBD  (4)
+
+typedef struct
+{
+  uint16_t ttffSec[AID_HISTORY];   // newest first
+  uint8_t aided[AID_HISTORY];
+  uint8_t count;
+} AidHistory;
+
+int aidType = AIDTYPE_NONE;
+unsigned long aidBootMs = 0;
+int aidBootSent = false;
+int aidTimeSent = false;
+int aidDone = 0;                   // AIDED_ bits for this boot
+long aidTtff = -1;                 // seconds, -1 until the first fix
+
+// saved state
+int aidHavePos = false;
+double aidLat = 0, aidLon = 0;
+float aidAlt = 0;
+unsigned long aidSavedEpoch = 0;
+unsigned long aidSaveTimer = 0;
+AidHistory aidHistory;
+
+// transmit - a small buffer for generated messages, then a file
+uint8_t aidTx[128];
+int aidTxLen = 0;
+int aidTxPos = 0;
+File aidTxFile;
+int aidTxFileOpen = false;
+int aidTxFileLeft = 0;             // bytes of the dump frame part way out
+
+// UBX database dump being received
+File aidDbdFile;
+int aidDbdActive = false;
+unsigned long aidDbdTimer = 0;
+unsigned long aidDbdPollTimer = 0;
+int aidDbdBytes = 0;
+int aidDbdFrames = 0;
+
+//----------------------------------------------------------
+int aidTypeFromName(const char* name)
+{
+  if (strcasecmp(name, "UBX") == 0) return AIDTYPE_UBX;
+  if (strcasecmp(name, "CASIC") == 0) return AIDTYPE_CASIC;
+  if (strcasecmp(name, "PMTK") == 0) return AIDTYPE_PMTK;
+  return AIDTYPE_NONE;
+}
+
+const char* aidTypeName()
+{
+  const char* names[] = { "none", "UBX", "CASIC", "PMTK" };
+  return names[aidType];
+}
+
+//----------------------------------------------------------
+// NVS
+void aidLoad()
+{
+  Preferences prefs;
+  prefs.begin("gpsaid", true);
+  aidHavePos = prefs.getBool("have", false);
+  aidLat = prefs.getDouble("lat", 0);
+  aidLon = prefs.getDouble("lon", 0);
+  aidAlt = prefs.getFloat("alt", 0);
+  aidSavedEpoch = prefs.getULong("epoch", 0);
+  memset(&aidHistory, 0, sizeof(aidHistory));
+  if (prefs.getBytesLength("ttff") == sizeof(aidHistory)) prefs.getBytes("ttff", &aidHistory, sizeof(aidHistory));
+  prefs.end();
+}
+
+void aidSavePos(double lat, double lon, unsigned long epoch)
+{
+  Preferences prefs;
+  prefs.begin("gpsaid", false);
+  prefs.putBool("have", true);
+  prefs.putDouble("lat", lat);
+  prefs.putDouble("lon", lon);
+  prefs.putFloat("alt", aidAlt);
+  prefs.putULong("epoch", epoch);
+  prefs.end();
+  aidHavePos = true;
+  aidLat = lat;
+  aidLon = lon;
+  aidSavedEpoch = epoch;
+}
+
+void aidSaveHistory()
+{
+  Preferences prefs;
+  prefs.begin("gpsaid", false);
+  prefs.putBytes("ttff", &aidHistory, sizeof(aidHistory));
+  prefs.end();
+}
+
+void aidClear()
+{
+  Preferences prefs;
+  prefs.begin("gpsaid", false);
+  prefs.clear();
+  prefs.end();
+  fileSystem.remove(AID_DBDFN);
+  aidHavePos = false;
+  memset(&aidHistory, 0, sizeof(aidHistory));
+}
+
+//----------------------------------------------------------
+// message building
+void aidPutU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+void aidPutU32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+// queue a UBX frame, payload already in place at aidTx[aidTxLen+6]
+void aidUbxQueue(uint8_t cls, uint8_t id, int len)
+{
+  uint8_t* p = &aidTx[aidTxLen];
+  p[0] = 0xB5; p[1] = 0x62; p[2] = cls; p[3] = id;
+  aidPutU16(&p[4], len);
+  uint8_t a = 0, b = 0;
+  for (int i = 2; i < 6 + len; i++) { a += p[i]; b += a; }
+  p[6 + len] = a;
+  p[7 + len] = b;
+  aidTxLen += 8 + len;
+}
+
+// CASIC checksum: (id << 24) + (class << 16) + len, plus the payload as 32 bit words
+void aidCasicQueue(uint8_t cls, uint8_t id, int len)
+{
+  uint8_t* p = &aidTx[aidTxLen];
+  p[0] = 0xBA; p[1] = 0xCE;
+  aidPutU16(&p[2], len);
+  p[4] = cls; p[5] = id;
+  uint32_t sum = ((uint32_t)id << 24) + ((uint32_t)cls << 16) + len;
+  for (int i = 0; i < len; i += 4)
+    sum += p[6+i] | (p[7+i] << 8) | (p[8+i] << 16) | ((uint32_t)p[9+i] << 24);
+  aidPutU32(&p[6 + len], sum);
+  aidTxLen += 10 + len;
+}
+
+void aidPutDouble(uint8_t* p, double v) { memcpy(p, &v, 8); } // both little endian
+void aidPutFloat(uint8_t* p, float v) { memcpy(p, &v, 4); }
+
+// GPS week and seconds into it, from UTC
+void aidGpsTime(unsigned long epoch, uint16_t* week, double* tow)
+{
+  unsigned long gps = epoch - 315964800UL + AID_LEAPSECONDS; // 1980-01-06
+  *week = gps / 604800UL;
+  *tow = gps % 604800UL;
+}
+
+//----------------------------------------------------------
+// position (and time, if we have it) in the receiver's own protocol
+void aidQueueInit(int withTime)
+{
+  unsigned long epoch = withTime ? rtc.getEpoch() : 0;
+  uint8_t* p = &aidTx[aidTxLen + 6];
+
+  if (aidType == AIDTYPE_UBX)
+  {
+    if (aidHavePos && !(aidDone & AIDED_POS)) // separate messages, the position only once
+    {
+      memset(p, 0, 20);
+      p[0] = 0x01; // POS_LLH
+      aidPutU32(&p[4], (int32_t)lround(aidLat * 1e7));
+      aidPutU32(&p[8], (int32_t)lround(aidLon * 1e7));
+      aidPutU32(&p[12], (int32_t)lround(aidAlt * 100));
+      aidPutU32(&p[16], AID_POSACC_M * 100UL);
+      aidUbxQueue(0x13, 0x40, 20);
+      aidDone |= AIDED_POS;
+    }
+    if (withTime)
+    {
+      time_t t = epoch;
+      struct tm tm;
+      gmtime_r(&t, &tm);
+      p = &aidTx[aidTxLen + 6];
+      memset(p, 0, 24);
+      p[0] = 0x10; // TIME_UTC
+      p[3] = (uint8_t)(int8_t)-128; // leap seconds unknown, receiver's own
+      aidPutU16(&p[4], tm.tm_year + 1900);
+      p[6] = tm.tm_mon + 1; p[7] = tm.tm_mday;
+      p[8] = tm.tm_hour; p[9] = tm.tm_min; p[10] = tm.tm_sec;
+      aidPutU16(&p[16], AID_TIMEACC_S);
+      aidUbxQueue(0x13, 0x40, 24);
+      aidDone |= AIDED_TIME;
+    }
+  }
+  else if (aidType == AIDTYPE_CASIC)
+  {
+    // AID-INI: lat, lon, alt (R8), tow (R8), freq bias, posAcc, tAcc, fAcc (R4), res (U4),
+    // week (U2), time source (U1), flags (U1) - bit 0 position valid, 1 time valid, 5 LLA
+    uint16_t week = 0;
+    double tow = 0;
+    if (!aidHavePos && !withTime) return;
+    if (withTime) aidGpsTime(epoch, &week, &tow);
+    memset(p, 0, 56);
+    aidPutDouble(&p[0], aidLat);
+    aidPutDouble(&p[8], aidLon);
+    aidPutDouble(&p[16], aidAlt);
+    aidPutDouble(&p[24], tow);
+    aidPutFloat(&p[36], AID_POSACC_M);
+    aidPutFloat(&p[40], AID_TIMEACC_S);
+    aidPutU16(&p[52], week);
+    p[55] = (aidHavePos ? 0x01 : 0) | (withTime ? 0x02 : 0) | 0x20;
+    aidCasicQueue(0x0B, 0x01, 56);
+    if (aidHavePos) aidDone |= AIDED_POS;
+    if (withTime) aidDone |= AIDED_TIME;
+  }
+  else if ((aidType == AIDTYPE_PMTK) && withTime)
+  {
+    // $PMTK741 takes position and time together, $PMTK740 time alone
+    char body[96];
+    time_t t = epoch;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    int n = aidHavePos ? snprintf(body, sizeof(body), "PMTK741,%.6f,%.6f,%.0f,", aidLat, aidLon, aidAlt) :
+                         snprintf(body, sizeof(body), "PMTK740,");
+    snprintf(&body[n], sizeof(body) - n, "%04d,%02d,%02d,%02d,%02d,%02d",
+      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    uint8_t cs = 0;
+    for (char* q = body; *q; q++) cs ^= *q;
+    aidTxLen += snprintf((char*)&aidTx[aidTxLen], sizeof(aidTx) - aidTxLen, "$%s*%02X\r\n", body, cs);
+    aidDone |= AIDED_TIME | (aidHavePos ? AIDED_POS : 0);
+  }
+}
+
+//----------------------------------------------------------
+void aidInit(const char* gpsType)
+{
+  aidType = aidTypeFromName(gpsType);
+  aidLoad();
+  aidBootMs = millis();
+  aidBootSent = aidTimeSent = false;
+  aidDone = 0;
+  aidTtff = -1;
+  aidTxLen = aidTxPos = 0;
+  aidTxFileLeft = 0;
+  gpsTxRelease(GPSTX_AID);
+}
+
+//----------------------------------------------------------
+// UBX: ask for the navigation database, the answer is collected by aidService()
+void aidDbdPoll()
+{
+  if ((aidType != AIDTYPE_UBX) || aidDbdActive || aidTxFileOpen || (aidTxLen > 0)) return;
+  aidDbdFile = fileSystem.open(AID_DBDTMPFN, FILE_WRITE);
+  if (!aidDbdFile) return;
+  aidDbdActive = true;
+  aidDbdBytes = aidDbdFrames = 0;
+  aidDbdTimer = millis();
+  aidUbxQueue(0x13, 0x80, 0);
+}
+
+void aidDbdFrame()
+{
+  if ((gpsBinLen < 8) || (gpsBinFrame[0] != 0xB5) || (gpsBinFrame[2] != 0x13) || (gpsBinFrame[3] != 0x80)) return;
+  uint8_t a = 0, b = 0;
+  for (int i = 2; i < gpsBinLen - 2; i++) { a += gpsBinFrame[i]; b += a; }
+  if ((a != gpsBinFrame[gpsBinLen-2]) || (b != gpsBinFrame[gpsBinLen-1])) return;
+  if (aidDbdBytes + gpsBinLen > AID_DBD_MAX) return;
+  aidDbdFile.write(gpsBinFrame, gpsBinLen); // stored as received, sent back as is
+  aidDbdBytes += gpsBinLen;
+  aidDbdFrames++;
+  aidDbdTimer = millis();
+}
+
+void aidDbdEnd()
+{
+  aidDbdFile.close();
+  aidDbdActive = false;
+  if (aidDbdFrames == 0)
+  {
+    fileSystem.remove(AID_DBDTMPFN); // keep the last good one
+    return;
+  }
+  fileSystem.remove(AID_DBDFN);
+  fileSystem.rename(AID_DBDTMPFN, AID_DBDFN);
+}
+
+//----------------------------------------------------------
+// with each line from gpsService() - TTFF, and the position to save
+void aidLine(const char* line)
+{
+  char f[16];
+  if (nmeaIsType(line, "GGA") && (nmeaField(line, 9, f, sizeof(f)) > 0)) aidAlt = atof(f);
+
+  GpsFix fix;
+  if (!rmcParse(line, &fix) || !fix.valid) return;
+
+  if (aidTtff < 0)
+  {
+    char msg[80];
+    aidTtff = (millis() - aidBootMs) / 1000;
+    snprintf(msg, sizeof(msg), "GPS TTFF %lds, aided:%s%s%s%s", aidTtff,
+      aidDone & AIDED_POS ? " pos" : "", aidDone & AIDED_TIME ? " time" : "",
+      aidDone & AIDED_DBD ? " dbd" : "", aidDone ? "" : " none");
+    logMessage(msg);
+    for (int i = AID_HISTORY-1; i > 0; i--)
+    {
+      aidHistory.ttffSec[i] = aidHistory.ttffSec[i-1];
+      aidHistory.aided[i] = aidHistory.aided[i-1];
+    }
+    aidHistory.ttffSec[0] = aidTtff > 65535 ? 65535 : aidTtff;
+    aidHistory.aided[0] = aidDone;
+    if (aidHistory.count < AID_HISTORY) aidHistory.count++;
+    aidSaveHistory();
+    aidSaveTimer = millis() - AID_SAVE_MIN * 60000UL; // save this position right away
+    aidDbdPollTimer = millis() - (AID_DBD_MIN - 2) * 60000UL; // and dump in 2 minutes, ephemeris complete by then
+  }
+
+  if (millis() - aidSaveTimer >= AID_SAVE_MIN * 60000UL)
+  {
+    aidSaveTimer = millis();
+    double dlat = (fix.lat - aidLat) * 111195.0;
+    double dlon = (fix.lon - aidLon) * 111195.0 * cos(fix.lat * M_PI / 180.0);
+    if (!aidHavePos || (dlat*dlat + dlon*dlon > (double)AID_SAVE_MOVED_M * AID_SAVE_MOVED_M))
+      aidSavePos(fix.lat, fix.lon, fixEpoch(&fix));
+  }
+  if (millis() - aidDbdPollTimer >= AID_DBD_MIN * 60000UL)
+  {
+    aidDbdPollTimer = millis();
+    aidDbdPoll();
+  }
+}
+
+//----------------------------------------------------------
+void aidService()
+{
+  // binary frames from the receiver
+  if (gpsBinLen > 0)
+  {
+    if (aidDbdActive) aidDbdFrame();
+    gpsBinLen = 0;
+  }
+  if (aidDbdActive && (millis() - aidDbdTimer >= AID_DBD_QUIET_MS)) aidDbdEnd();
+
+  // what goes to the receiver, and when
+  if (!aidBootSent && (millis() - aidBootMs >= AID_BOOT_MS))
+  {
+    aidBootSent = true;
+    aidQueueInit(false);
+    if ((aidType == AIDTYPE_UBX) && (aidTtff < 0))
+    {
+      aidTxFile = fileSystem.open(AID_DBDFN, FILE_READ);
+      aidTxFileOpen = (bool)aidTxFile;
+      if (aidTxFileOpen) aidDone |= AIDED_DBD;
+    }
+  }
+  if (aidBootSent && !aidTimeSent && (aidTtff < 0) && ntpComplete() && (aidTxLen == 0) && !aidTxFileOpen)
+  {
+    aidTimeSent = true;
+    aidQueueInit(true); // CASIC/PMTK send the position again, it's one message
+  }
+
+  // as much as the UART will take without waiting, a frame at a time
+  // from when the port is ours
+  int room = GPSPORT.availableForWrite();
+  if ((room > 0) && (aidTxPos < aidTxLen) && gpsTxClaim(GPSTX_AID))
+  {
+    int n = aidTxLen - aidTxPos;
+    if (n > room) n = room;
+    GPSPORT.write(&aidTx[aidTxPos], n);
+    aidTxPos += n;
+    room -= n;
+    if (aidTxPos >= aidTxLen)
+    {
+      aidTxLen = aidTxPos = 0;
+      gpsTxRelease(GPSTX_AID);
+    }
+  }
+  if ((room > 0) && (aidTxLen == 0) && aidTxFileOpen)
+  {
+    if (aidTxFileLeft == 0)
+    {
+      // next frame of the dump - its header says how long it is
+      if ((room < 6) || !gpsTxClaim(GPSTX_AID)) return;
+      uint8_t hdr[6];
+      if ((aidTxFile.read(hdr, 6) != 6) || (hdr[0] != 0xB5) || (hdr[1] != 0x62))
+      {
+        aidTxFile.close(); // end of the dump (or not one after all)
+        aidTxFileOpen = false;
+        gpsTxRelease(GPSTX_AID);
+        return;
+      }
+      GPSPORT.write(hdr, 6);
+      room -= 6;
+      aidTxFileLeft = (hdr[4] | (hdr[5] << 8)) + 2;
+    }
+    uint8_t buf[64];
+    if (room > (int)sizeof(buf)) room = sizeof(buf);
+    if (room > aidTxFileLeft) room = aidTxFileLeft;
+    int n = (room > 0) ? aidTxFile.read(buf, room) : 0;
+    if (n > 0)
+    {
+      GPSPORT.write(buf, n);
+      aidTxFileLeft -= n;
+    }
+    else if (room > 0)
+    {
+      aidTxFile.close(); // cut short, the receiver drops the frame on its checksum
+      aidTxFileOpen = false;
+      aidTxFileLeft = 0;
+    }
+    if (aidTxFileLeft == 0) gpsTxRelease(GPSTX_AID);
+  }
+}
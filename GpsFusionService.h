@@ -0,0 +1,346 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Dual receiver fusion - two GPS modules, the best fix of each epoch
+//----------------------------------------------------------------------------
+// For antenna-redundant installs:  a second receiver on GPS2PORT, and the
+// RMC/GGA of both go through here instead of straight to the log.
+//
+// Each receiver's sentences are collected per epoch (the hhmmss.ss in
+// RMC and GGA):  RMC and GGA with the same time complete it, or an RMC
+// with no GGA after FUSE_GGAWAITMS.  The epochs of the two are matched
+// by that time, not by when they arrived - the second receiver's lines
+// are often a few hundred ms behind.  An epoch the other receiver
+// doesn't have within FUSE_WAITMS (or that receiver is out) goes alone,
+// one the other has decided on already is late and dropped.
+//
+// Per epoch the better fix wins - fix quality first (RTK, DGPS, GPS,
+// dead reckoning, none), then HDOP, then satellites used.  When both
+// are the same quality and within FUSE_MAXM of each other the position
+// is the HDOP weighted mean (1/HDOP^2), speed and course from the
+// better one.  Further apart than that one antenna is wrong, the better
+// fix is taken as is and it's counted.
+//
+// fuseService() returns the epoch's RMC line - the winner's as
+// received, or with the fused position and a new checksum - for rmcbuf,
+// MQTT and the fan-out, like an RMC from gpsService().  Never an older
+// epoch than the last one out.
+//
+// Health per receiver:  lines, bad checksums, epochs, epochs with a
+// fix, times chosen, mean HDOP and satellites, epochs too late, outages
+// (no epoch for FUSE_OUTMS, logged going out and coming back) and the
+// time out.  A receiver asleep on purpose (motion standby) isn't out,
+// fuseAsleep() says so.
+//
+// Call fuseLine(rx, line) with each line of receiver rx (0 = GPSPORT,
+// 1 = GPS2PORT) and fuseService() from the high rate part of loop().
+//
+// Needs rmcParse()/ggaParse()/nmeaChecksumOk() (NmeaService.h), logMessage()
+
+#define FUSE_RECEIVERS (2)
+#define FUSE_GGAWAITMS (300)   /* RMC with no GGA this long - an epoch without quality */
+#define FUSE_WAITMS (600)      /* an epoch waits this long for the other receiver's */
+#define FUSE_OUTMS (10000)     /* no epoch this long - the receiver is out (stationary is a fix every 5 s) */
+#define FUSE_MAXM (25.0)       /* fuse only this close, else pick */
+#define FUSE_NOHDOP (99.9)     /* HDOP when there's no GGA */
+#define FUSE_DAYCS (8640000L)  /* hundredths of a second in a day */
+
+typedef struct
+{
+  long t;                      // hundredths of a second since midnight, -1 = none
+  int haveRmc, haveGga;
+  unsigned long ms;            // millis() the first line of it came
+  char rmc[128];
+  GpsFix fix;
+  GpsGga gga;
+} FuseEpoch;
+
+typedef struct
+{
+  FuseEpoch building;          // sentences coming in
+  FuseEpoch ready;             // complete, waiting for the other receiver's
+  unsigned long lastEpochMs;
+  int out;
+  int asleep;
+  // health
+  unsigned long lines, badLines, epochs, fixEpochs, chosen, late, outages, outSec;
+  float hdopSum;
+  unsigned long satsSum, ggaEpochs;
+} FuseRx;
+
+FuseRx fuseRx[FUSE_RECEIVERS];
+int fuseEnabled = false;       // a second receiver is configured
+long fuseLastT = -1;           // epoch last out
+char fuseRmcOut[128];
+
+// statistics
+unsigned long fuseEpochsOut = 0;
+unsigned long fuseMatched = 0;  // epochs both receivers had
+unsigned long fuseFused = 0;    // ...and the positions were averaged
+unsigned long fuseDisagree = 0; // ...both with a fix but more than FUSE_MAXM apart
+unsigned long fuseSkewMsSum = 0;
+
+//----------------------------------------------------------
+void fuseInit()
+{
+  memset(fuseRx, 0, sizeof(fuseRx));
+  for (int i = 0; i < FUSE_RECEIVERS; i++)
+  {
+    fuseRx[i].building.t = fuseRx[i].ready.t = -1;
+    fuseRx[i].lastEpochMs = millis();
+  }
+  fuseLastT = -1;
+  fuseEpochsOut = fuseMatched = fuseFused = fuseDisagree = fuseSkewMsSum = 0;
+}
+
+// receiver rx is in standby on purpose, no epochs expected
+void fuseAsleep(int rx, int asleep)
+{
+  fuseRx[rx].asleep = asleep;
+  if (asleep) fuseRx[rx].lastEpochMs = millis();
+}
+
+long fuseTime(int hour, int minute, float second)
+{
+  return (hour * 3600L + minute * 60L) * 100L + (long)(second * 100.0f + 0.5f);
+}
+
+// t is after fuseLastT (a day wraps at midnight)
+int fuseIsNewer(long t)
+{
+  if (fuseLastT < 0) return true;
+  long d = t - fuseLastT;
+  if (d < -FUSE_DAYCS / 2) d += FUSE_DAYCS;
+  return d > 0;
+}
+
+//----------------------------------------------------------
+// quality order:  none, dead reckoning, GPS (or RMC only), DGPS, RTK float, RTK fixed
+int fuseRank(FuseEpoch* e)
+{
+  if (!e->fix.valid) return 0;
+  if (!e->haveGga) return 2;
+  switch (e->gga.quality)
+  {
+    case 6: return 1;
+    case 1: case 3: return 2;
+    case 2: return 3;
+    case 5: return 4;
+    case 4: return 5;
+  }
+  return 0;
+}
+
+// true if a is the better fix
+int fuseBetter(FuseEpoch* a, FuseEpoch* b)
+{
+  int ra = fuseRank(a), rb = fuseRank(b);
+  if (ra != rb) return ra > rb;
+  if (fabs(a->gga.hdop - b->gga.hdop) > 0.05) return a->gga.hdop < b->gga.hdop;
+  return a->gga.sats >= b->gga.sats;
+}
+
+// ddmm.mmmmm / dddmm.mmmmm and the hemisphere
+int fuseDm(char* buf, int maxlen, double deg, int degDigits, char pos, char neg)
+{
+  double a = fabs(deg);
+  int d = (int)a;
+  long m = lround((a - d) * 6000000.0); // minutes * 100000
+  if (m >= 6000000L) { d++; m -= 6000000L; }
+  return snprintf(buf, maxlen, "%0*d%02ld.%05ld,%c", degDigits, d, m / 100000L, m % 100000L, (deg < 0) ? neg : pos);
+}
+
+// src RMC with lat/lon replaced, new checksum
+void fuseRmcLine(const char* src, double lat, double lon, char* out, int maxlen)
+{
+  const char* p = src;
+  int commas = 0;
+  while (*p && (commas < 3)) if (*p++ == ',') commas++; // $GxRMC,time,status,
+  const char* rest = p;
+  while (*rest && (commas < 7)) if (*rest++ == ',') commas++; // past lat,N,lon,W,
+  const char* star = strchr(rest, '*');
+  int restLen = star ? (int)(star - rest) : (int)strlen(rest);
+
+  int n = snprintf(out, maxlen, "%.*s", (int)(p - src), src);
+  n += fuseDm(out + n, maxlen - n, lat, 2, 'N', 'S');
+  n += snprintf(out + n, maxlen - n, ",");
+  n += fuseDm(out + n, maxlen - n, lon, 3, 'E', 'W');
+  n += snprintf(out + n, maxlen - n, ",%.*s", restLen, rest);
+  if (n >= maxlen - 3) { strncpy(out, src, maxlen - 1); out[maxlen - 1] = 0; return; } // didn't fit, as received
+  uint8_t sum = 0;
+  for (int i = 1; i < n; i++) sum ^= (uint8_t)out[i];
+  snprintf(out + n, maxlen - n, "*%02X", sum);
+}
+
+//----------------------------------------------------------
+// an epoch of receiver rx is complete - it waits in ready for the other's
+void fuseComplete(int rx)
+{
+  FuseRx* r = &fuseRx[rx];
+  FuseEpoch* e = &r->building;
+  if (!e->haveRmc) { e->t = -1; return; } // GGA alone, nothing to log
+  r->epochs++;
+  if (e->fix.valid)
+  {
+    r->fixEpochs++;
+    if (e->haveGga)
+    {
+      r->ggaEpochs++;
+      r->hdopSum += e->gga.hdop;
+      r->satsSum += e->gga.sats;
+    }
+  }
+  if (r->out)
+  {
+    unsigned long sec = (millis() - r->lastEpochMs) / 1000;
+    r->outSec += sec;
+    r->out = false;
+    char msg[48];
+    snprintf(msg, sizeof(msg), "GPS%d back after %lus", rx + 1, sec);
+    logMessage(msg);
+  }
+  r->lastEpochMs = millis();
+  if (r->ready.t >= 0) r->late++; // the last one never got out, this one replaces it
+  r->ready = *e;
+  e->t = -1;
+}
+
+void fuseLine(int rx, const char* line)
+{
+  FuseRx* r = &fuseRx[rx];
+  int isRmc = nmeaIsType(line, "RMC");
+  if (!isRmc && !nmeaIsType(line, "GGA")) return;
+  r->lines++;
+
+  GpsFix fix;
+  GpsGga gga;
+  long t;
+  if (isRmc)
+  {
+    if (!rmcParse(line, &fix)) { r->badLines++; return; }
+    t = fuseTime(fix.hour, fix.minute, fix.second);
+  }
+  else
+  {
+    if (!ggaParse(line, &gga)) { r->badLines++; return; }
+    t = fuseTime(gga.hour, gga.minute, gga.second);
+  }
+
+  FuseEpoch* e = &r->building;
+  if ((e->t >= 0) && (e->t != t)) fuseComplete(rx); // the next epoch started
+  if (e->t < 0)
+  {
+    memset(e, 0, sizeof(FuseEpoch));
+    e->t = t;
+    e->ms = millis();
+    e->gga.hdop = FUSE_NOHDOP;
+  }
+  if (isRmc)
+  {
+    e->haveRmc = true;
+    e->fix = fix;
+    strncpy(e->rmc, line, sizeof(e->rmc) - 1);
+    e->rmc[sizeof(e->rmc) - 1] = 0;
+  }
+  else
+  {
+    e->haveGga = true;
+    e->gga = gga;
+  }
+  if (e->haveRmc && e->haveGga) fuseComplete(rx);
+}
+
+//----------------------------------------------------------
+// a (and b, if the other receiver has the same epoch) out as one RMC
+char* fuseEmit(int ra, int rb)
+{
+  FuseEpoch* a = &fuseRx[ra].ready;
+  FuseEpoch* b = (rb >= 0) ? &fuseRx[rb].ready : NULL;
+  long t = a->t;
+  char* out = NULL;
+
+  if (!fuseIsNewer(t))
+  {
+    fuseRx[ra].late++;
+    if (b) fuseRx[rb].late++;
+  }
+  else if (b == NULL)
+  {
+    fuseRx[ra].chosen++;
+    strcpy(fuseRmcOut, a->rmc);
+    out = fuseRmcOut;
+  }
+  else
+  {
+    fuseMatched++;
+    fuseSkewMsSum += (a->ms > b->ms) ? a->ms - b->ms : b->ms - a->ms;
+    FuseEpoch* best = fuseBetter(a, b) ? a : b;
+    FuseEpoch* other = (best == a) ? b : a;
+    fuseRx[(best == a) ? ra : rb].chosen++;
+    strcpy(fuseRmcOut, best->rmc);
+    if (best->fix.valid && other->fix.valid)
+    {
+      double mPerDeg = 111195.0;
+      double dn = (best->fix.lat - other->fix.lat) * mPerDeg;
+      double de = (best->fix.lon - other->fix.lon) * mPerDeg * cos(best->fix.lat * M_PI / 180.0);
+      if (sqrt(dn*dn + de*de) > FUSE_MAXM) fuseDisagree++;
+      else if ((fuseRank(best) == fuseRank(other)) && best->haveGga && other->haveGga)
+      {
+        double wb = 1.0 / (best->gga.hdop * best->gga.hdop + 0.01);
+        double wo = 1.0 / (other->gga.hdop * other->gga.hdop + 0.01);
+        double lat = (best->fix.lat * wb + other->fix.lat * wo) / (wb + wo);
+        double lon = (best->fix.lon * wb + other->fix.lon * wo) / (wb + wo);
+        fuseRmcLine(best->rmc, lat, lon, fuseRmcOut, sizeof(fuseRmcOut));
+        fuseFused++;
+      }
+    }
+    out = fuseRmcOut;
+  }
+  if (out)
+  {
+    fuseLastT = t;
+    fuseEpochsOut++;
+  }
+  a->t = -1;
+  if (b) b->t = -1;
+  return out;
+}
+
+// the epoch's RMC line once it's decided, NULL if none this time
+char* fuseService()
+{
+  unsigned long now = millis();
+  for (int i = 0; i < FUSE_RECEIVERS; i++)
+  {
+    FuseRx* r = &fuseRx[i];
+    if ((r->building.t >= 0) && r->building.haveRmc && (now - r->building.ms > FUSE_GGAWAITMS)) fuseComplete(i);
+    if (!r->out && !r->asleep && (now - r->lastEpochMs > FUSE_OUTMS))
+    {
+      r->out = true;
+      r->outages++;
+      char msg[32];
+      snprintf(msg, sizeof(msg), "GPS%d out", i + 1);
+      logMessage(msg);
+    }
+  }
+
+  FuseEpoch* a = &fuseRx[0].ready;
+  FuseEpoch* b = &fuseRx[1].ready;
+  if ((a->t >= 0) && (b->t >= 0))
+  {
+    if (a->t == b->t) return fuseEmit(0, 1);
+    long d = a->t - b->t; // the older goes alone, the newer waits for its match
+    if (d < -FUSE_DAYCS / 2) d += FUSE_DAYCS;
+    if (d > FUSE_DAYCS / 2) d -= FUSE_DAYCS;
+    return (d < 0) ? fuseEmit(0, -1) : fuseEmit(1, -1);
+  }
+  for (int i = 0; i < FUSE_RECEIVERS; i++)
+  {
+    FuseRx* r = &fuseRx[i];
+    FuseRx* o = &fuseRx[1 - i];
+    if (r->ready.t < 0) continue;
+    unsigned long wait = FUSE_WAITMS;
+    if (o->building.t == r->ready.t) wait += FUSE_GGAWAITMS; // the other's is coming in
+    if (o->out || o->asleep || (now - r->ready.ms > wait)) return fuseEmit(i, -1);
+  }
+  return NULL;
+}
@@ -0,0 +1,181 @@
+// Initial version 18-Oct-2026, split out of GpsLogger.ino
+//
+// Needs LOGFN and fileSystem defined
+void gpsLogFlush();
+
+//----------------------------------------------------------------------------
+//             L O G  F I L E  S E R V I C E
+//
+// We can append lines to a log file.
+// Since it's a flash file system, we want to minimize the number of times
+// flash is written (as it has a limited number of write cycles before it's
+// worn out.
+//
+// So we keep some buffer of lines and stuff them in the buffer.
+// Then every so often we'll dump the buffered lines to the file system.
+//
+// Line buffer size in characters (auto flush when full), define it before
+// the include for another size
+#ifndef LOGBUFFERSIZE
+#define LOGBUFFERSIZE (8*1024)
+#endif
+char logbuffer[LOGBUFFERSIZE];
+int bufferWritePosition = 0;
+
+// With PSRAM (a WROVER-class board, built with PSRAM enabled) the lines go
+// to a LOGPSRAMSIZE buffer there instead, gpsLogUsePsram(), and are written
+// out in big batches:  when it's 3/4 full, or every LOGFLUSHHOURS= hours -
+// not every hour - so that much can be lost with the power.  A batch goes
+// out LOGWRITECHUNK bytes per gpsLogService() call so loop() doesn't stall
+// for seconds;  gpsLogFlush() still writes everything at once (uploads,
+// deep sleep).  Without PSRAM it's logbuffer and the hourly flush as ever.
+//
+// Either way it's a linear buffer drained in place, not a ring:  lines go
+// on at bufferWritePosition while a batch is going out (they go out with
+// it), and it starts again at 0 once everything is written.  If the log
+// file can't be opened the lines stay where they are and the next hour or
+// batch tries again;  only a line that still doesn't fit after a failed
+// flush throws the buffer away (logLostBytes).
+#ifndef LOGPSRAMSIZE
+#define LOGPSRAMSIZE (256*1024)
+#endif
+#define LOGWRITECHUNK (4096)  /* a flash sector */
+#define LOGPAGE (256)         /* SPIFFS page, for the wear estimate */
+
+char* logBuf = logbuffer;     // where the lines go, logbuffer or PSRAM
+int logBufSize = LOGBUFFERSIZE;
+int logDraining = false;      // a batch is going out ...
+int logDrainPosition = 0;     // ... written up to here
+File logDrainFile;
+int logFlushHours = 6;        // LOGFLUSHHOURS=, with PSRAM
+int logHoursHeld = 0;
+
+// flushes (file appends) and bytes, and the flushes the 8K buffer flushed
+// hourly would have needed for the same lines
+unsigned long logFlushes = 0;
+unsigned long logFlushBytes = 0;
+unsigned long logBaseFlushes = 0;
+int logBaseFill = 0;
+unsigned long logLostBytes = 0;    // thrown away, the log file couldn't be opened
+
+void gpsLogUsePsram()
+{
+#ifdef BOARD_HAS_PSRAM
+  if ((logBuf != logbuffer) || (ESP.getPsramSize() == 0)) return;
+  char* p = (char*)ps_malloc(LOGPSRAMSIZE);
+  if (p == NULL) return; // stay in logbuffer
+  memcpy(p, logbuffer, bufferWritePosition); // a journal from before a deep sleep
+  logBuf = p;
+  logBufSize = LOGPSRAMSIZE;
+#endif
+}
+
+void gpsLogInit()
+{
+  bufferWritePosition = 0; // next character to write
+  gpsLogUsePsram();
+}
+
+void gpsLogBaseFlush()
+{
+  if (logBaseFill > 0) logBaseFlushes++;
+  logBaseFill = 0;
+}
+
+void gpsLogFlushed(int bytes)
+{
+  logFlushes++;
+  logFlushBytes += bytes;
+  logHoursHeld = 0;
+}
+
+// start writing a batch out, gpsLogService() does the rest
+void gpsLogDrain()
+{
+  if (logDraining || (bufferWritePosition == 0)) return;
+  logDrainFile = fileSystem.open(LOGFN, FILE_APPEND);
+  if (!logDrainFile)
+  {
+    Serial.println("- failed to open log file for appending"); // kept, next hour or batch tries again
+    return;
+  }
+  logDraining = true;
+  logDrainPosition = 0;
+}
+
+void gpsLogLine(char* msg)
+{
+  int len = strlen(msg);
+  if (len == 0) return; // nothing to log
+  
+  // we don't want to overflow the buffer, so if this line would overflow it,
+  // then we'll flush it first
+  int lastbyte = bufferWritePosition+len+8; // little buffer at the end
+  if (lastbyte >= logBufSize) gpsLogFlush();
+  if (bufferWritePosition+len+8 >= logBufSize)
+  {
+    // the flush didn't get it out, make room
+    logLostBytes += bufferWritePosition;
+    bufferWritePosition = 0;
+  }
+  strcpy(&logBuf[bufferWritePosition], msg);
+  bufferWritePosition += len;
+  logBuf[bufferWritePosition++] = '\015'; // CR
+  logBuf[bufferWritePosition++] = '\012'; // LF
+  // no \0 between lines!
+
+  if (logBaseFill + len + 8 >= LOGBUFFERSIZE) gpsLogBaseFlush();
+  logBaseFill += len + 2;
+  if ((logBuf != logbuffer) && (bufferWritePosition >= logBufSize / 4 * 3)) gpsLogDrain();
+}
+
+// every pass of loop(), a chunk of the batch going out
+void gpsLogService()
+{
+  if (!logDraining) return;
+  int n = bufferWritePosition - logDrainPosition;
+  if (n > LOGWRITECHUNK) n = LOGWRITECHUNK;
+  logDrainFile.write((uint8_t*)&logBuf[logDrainPosition], n);
+  logDrainPosition += n;
+  if (logDrainPosition < bufferWritePosition) return;
+  logDrainFile.close();
+  logDraining = false;
+  gpsLogFlushed(bufferWritePosition);
+  bufferWritePosition = 0;
+}
+
+// hourly
+void gpsLogHour()
+{
+  gpsLogBaseFlush();
+  if (logBuf == logbuffer) gpsLogFlush();
+  else if ((bufferWritePosition > 0) && (++logHoursHeld >= logFlushHours)) gpsLogDrain();
+}
+
+void gpsLogFlush()
+{
+  gpsLogBaseFlush();
+  if (logDraining)
+  {
+    logDrainFile.write((uint8_t*)&logBuf[logDrainPosition], bufferWritePosition - logDrainPosition);
+    logDrainFile.close();
+    logDraining = false;
+    gpsLogFlushed(bufferWritePosition);
+  }
+  else if (bufferWritePosition > 0)
+  {
+    File file = fileSystem.open(LOGFN, FILE_APPEND);
+    if(!file){
+      Serial.println("- failed to open log file for appending"); // kept for the next flush
+      return;
+   }
+   if((int)file.write((uint8_t*)logBuf, bufferWritePosition) == bufferWritePosition){
+      Serial.println("- message appended");
+   } else {
+      Serial.println("- append failed");
+   }
+   file.close();
+   gpsLogFlushed(bufferWritePosition);
+  }
+  bufferWritePosition = 0;
+}
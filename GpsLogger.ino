@@ -21,7 +21,7 @@
 // 1) There will be a configuration file (config.ini) stored on the SD card which will have information
 //    a) WiFi SSID and password
 //    b) How many hours between attempts to upload the log files to an FTP server
-//    c) FTP details (server name, user name, password)
+//    c) FTP details (server name, user name, password), or an HTTPS upload URL
 //    d) Baud rate for GPS module
 //    f) Time zone offset
 //
@@ -43,9 +43,43 @@
 // 15-Nov-2023 - V1.0 - Log GPRMC (GNRMC, BNRMC) NEMA messages to flash file system
 // 15-Nov-2023 - V1.1 - add sio shell commands, WIFI disconnect/reconnect
 // 16-Nov-2023 - V1.2 - add event logging, wifi connect timeout handler
+// 18-Oct-2026 - V1.3 - ftpPut() moved to FtpService.h, host network simulator (host/netsim.cpp),
+//                      fix NTP never completing when the first answer was lost
+// 18-Oct-2026 - V1.4 - replay command, NMEA helpers, GPS input and log buffer moved to
+//                      GpsService.h and GpsLogService.h, host pipeline benchmark (host/replay.cpp)
+// 18-Oct-2026 - V1.5 - HTTPS upload (UPLOADURL) with TLS session resumption, tls command
+// 18-Oct-2026 - V1.6 - batched-ack upload protocol (BATCHSERVER, DEVICEID), batch command
+// 18-Oct-2026 - V1.7 - geofence (ZONE1..4, ZONEFALLBACKMIN): WiFi only near known APs,
+//                      upload on arrival, zone command
+// 18-Oct-2026 - V1.8 - web dashboard (www/index.html) with live fix and stats over a WebSocket
+// 18-Oct-2026 - V1.9 - NMEA fan-out server (gpsd style port 2947, NMEA port 10110), fan command
+// 18-Oct-2026 - V2.0 - MQTT publisher, QoS 1 batches queued in flash (MQTTSERVER, MQTTTOPIC,
+//                      MQTTUSER, MQTTPASSWORD), mqtt command
+// 18-Oct-2026 - V2.1 - GPS hot-start aiding (GPSTYPE=UBX/CASIC/PMTK), TTFF logged each boot,
+//                      aid command
+// 18-Oct-2026 - V2.2 - Motion-adaptive receiver rate/sentences, receiver asleep when parked
+//                      (GPSPARKMIN, GPSWAKEMIN), motion command
+// 18-Oct-2026 - V2.3 - Parked deep sleep with state in RTC memory and a fast wake path
+//                      (SLEEPAFTERMIN), sleep command
+// 18-Oct-2026 - V2.4 - Second receiver on Serial1 (GPS2BAUD), best/fused fix per epoch,
+//                      fuse command
+// 18-Oct-2026 - V2.5 - Satellite signal statistics from GSV/GSA, a record every SIGNALMIN
+//                      minutes to /signal.log, signal command
+// 18-Oct-2026 - V2.6 - Logged fixes also kept as columnar segments (/track.seg), top speed
+//                      and bounding box from the segment headers, track command
+// 18-Oct-2026 - V2.7 - Raw capture of everything the receiver sends with us timestamps into
+//                      a flash ring (CAPTUREKB, CAPTUREMIN), cap command, replay of the dump
+// 18-Oct-2026 - V2.8 - UDP fix telemetry to a fleet collector (TELEMETRYSERVER, TELEMETRYSEC),
+//                      telemetry command, host collector and load generator (host/udpcollect.cpp)
+// 18-Oct-2026 - V2.9 - loop()'s receiver-to-upload chain as compile-time stages (Pipeline.h),
+//                      build variants PIPELINE_TRACKER / PIPELINE_LOGONLY, pipe command
+// 18-Oct-2026 - V3.0 - Static buffers in one budget table with compile-time capacity checks
+//                      (MemoryBudget.h), mem command (buffers, heap, task stack high-water marks)
+// 18-Oct-2026 - V3.1 - Location log buffer in PSRAM when there is some (LOGPSRAMSIZE), written in
+//                      batches every LOGFLUSHHOURS or when 3/4 full, logbuf command
 
 // Signon message with version number
-#define SIGNON "\nGPS Monitor V1.2 (16Nov2023)\n\n"
+#define SIGNON "\nGPS Monitor V3.1 (18Oct2026)\n\n"
 
 //---- TODO ideas ----
 // **DONE**
@@ -62,7 +96,7 @@
 // - Parse the NEMA RMS command to something like 2023/11/15,09:51:00,151.991W,47.45N,20kts
 // - Post to the CodeProject site with article
 // - Some way to get status out of the thing - optically with LED??? optional sio port? display?  bluetooth?
-// - Can possibly use the tool GPSBabel (gpsbabel.org) to convert NEMA RMC log to a GPX file to import in Google Maps to show track
+// - GPX/KML/GeoJSON of the logs: host/trackconv.cpp does a fleet's uploads at once (GPSBabel, gpsbabel.org, does one file a run)
 //
 //----------------------------------------------------------------------------
 //                     G P S   M O D U L E
@@ -80,6 +114,9 @@
 // TXD     RXD (can be mapped, ESP32 Serial 2 uses GPIO16 by default)
 // RXD     TXD (can be mapped, ESP32 Serial 2 uses GPIO17 by default)
 //
+// A second module (antenna redundancy) goes the same way on Serial 1,
+// its TXD to GPIO4 and RXD to GPIO5.
+//
 // Note: The 3.3V supply from an ESP32 board is somewhat limited and can
 //    vary from one ESP32 implementation to the next.   Check that the
 //    ESP32 board you choose has sufficient capacity to power the GPS module.
@@ -95,6 +132,25 @@
 //
 //#define WANTSD_MMC 1
 #define WANTSPIFFS 1
+// Build variant, which stages loop() runs per line and fix (see Pipeline.h) -
+//   none of these: everything;  a tracker: log, MQTT, UDP telemetry;  or the log only.
+//   The services a variant leaves out aren't compiled in at all.
+//#define PIPELINE_TRACKER 1
+//#define PIPELINE_LOGONLY 1
+#if defined(PIPELINE_LOGONLY)
+#define PIPE_VARIANT "logonly"
+#elif defined(PIPELINE_TRACKER)
+#define PIPE_VARIANT "tracker"
+#else
+#define PIPE_VARIANT "full"
+#define PIPE_FULL 1      /* capture, echo, aid, signal, fusion, fan-out */
+#endif
+#ifndef PIPELINE_LOGONLY
+#define PIPE_UPLINK 1    /* MQTT, UDP telemetry */
+#endif
+// A bigger log buffer is fewer flash writes (one per hour if it holds an
+// hour's fixes) - MemoryBudget.h checks it still fits
+//#define LOGBUFFERSIZE (16*1024)
 // if you have SD_MMC, put config.ini in the root folder of the SD card
 // if you have SPIFFS, put config.ini in the data folder under this schetch
 //   and use tools | ESP32 Sketch Data Upload to upload the initial flash file system
@@ -131,6 +187,20 @@
 #endif
 
 #include <ESP32_FTPClient.h>
+#include "BatchProtocol.h" // batched-ack upload framing
+#ifdef PIPE_UPLINK
+#include "TelemetryProtocol.h" // UDP fix datagrams
+#include "lwip/sockets.h" // MQTT connects without waiting
+#include "lwip/dns.h"
+#endif
+
+#include <Preferences.h> // NVS, for the saved TLS session
+#include "mbedtls/ssl.h" // for HTTPS upload
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/sha256.h" // pinned server certificate
 
 //-- forward defs for logging
 void logMessage(char* msg);
@@ -138,6 +208,8 @@ void logMessage(String msg);
 
 #include <ESP32Time.h> // real-time clock
 #include "ESPTelnet.h" // telnet interface
+#include <AsyncTCP.h> // web dashboard
+#include <ESPAsyncWebServer.h>
 
 /* comfort LED, turns on when telnet is connected */
 #define LEDPIN (2) 
@@ -148,6 +220,12 @@ void logMessage(String msg);
 
 #define EVENTFN "/event.log"
 
+#define SIGNALFN "/signal.log"
+
+#define SEGFN "/track.seg"
+
+#define CAPFN "/capture.bin"
+
 //-----------------------------------------------------------------
 // real time clock (software based, not backed up for power failures
 ESP32Time rtc(-8*3600);  // -8 from GMT by default
@@ -158,45 +236,15 @@ ESP32Time rtc(-8*3600);  // -8 from GMT by default
 #define GPSPORT Serial2
 #define GPSESP_RXD_PIN (16)
 #define GPSESP_TXD_PIN (17)
+// optional second receiver, GPS2BAUD= in config.ini (Serial1's own pins
+// are the flash on most boards, so it's mapped)
+#ifdef PIPE_FULL
+#define GPS2PORT Serial1
+#define GPS2ESP_RXD_PIN (4)
+#define GPS2ESP_TXD_PIN (5)
+#endif
 
-#define GPSBUFLEN (512)
-char gpsRxBuf[GPSBUFLEN+2];
-char gpsRxLine[GPSBUFLEN];
-int gpsBufPtr = 0;
-int gpsLineAvail = 0;
-void gpsInit(long baudrate)
-{
-  GPSPORT.begin(baudrate, SERIAL_8N1, GPSESP_RXD_PIN, GPSESP_TXD_PIN);
-  //GPSPORT.setRxBufferSize(GPSBUFLEN);
-  gpsBufPtr = 0;
-  gpsLineAvail=0;
-}
-
-char* gpsService()
-{
-  if (GPSPORT.available())
-  {
-    char c = GPSPORT.read()  & 0x7f; // 7 bits are important
-    if ((c == 10) || (c == 13)) // if it's end-of-line
-    {
-      if (gpsBufPtr > 0) // if the line is not empty
-      {
-        gpsRxBuf[gpsBufPtr]=0; // copy to gpsRxLine
-        strcpy(gpsRxLine, gpsRxBuf); // copy received line
-        gpsLineAvail++; // set flag indicating line is available
-        gpsBufPtr = 0;
-        return &gpsRxLine[0];
-      }
-    }
-    else
-    {
-      gpsRxBuf[gpsBufPtr] = c;
-      if (gpsBufPtr < (GPSBUFLEN-1)) gpsBufPtr++;
-    }
-  }
-  return NULL;
-}
-
+#include "GpsService.h"
 
 
 //--------------------------------------------------------------------------
@@ -271,12 +319,51 @@ void apCmd(String str)
 }
 
 void ftpPut(char* fn);
+int tlsPut(char* fn);
+int batchStart(char* fn);
+char uploadUrl[128]; // https://... to upload with HTTPS instead of FTP
+char uploadSha256[68]; // the server's certificate SHA-256, if there's no /ca.pem
+char batchServer[128]; // host of the batched-ack receiver, upload with that instead
+uint16_t batchPort;
+char batchDeviceId[64];
+#ifdef PIPE_UPLINK
+#define MQTT_PORT_DEFAULT (1883)
+char mqttServer[128]; // MQTT broker host, empty = no MQTT
+uint16_t mqttPort;
+char mqttTopic[128];
+char mqttUser[64];
+char mqttPwd[64];
+#endif
+void gpsLogFlush();
 void ftpCmd(String str)
 {
+  gpsLogFlush(); // what's still in the log buffer goes too
+  if (batchServer[0] != 0)
+  {
+    zprintln("Batch upload log file to server");
+    if (!batchStart(LOGFN)) zprintln("Not connected yet, will keep trying");
+    return;
+  }
+  if (uploadUrl[0] != 0)
+  {
+    zprintln("HTTPS log file to server");
+    tlsPut(LOGFN);
+    return;
+  }
   zprintln("FTP log file to server");
   ftpPut(LOGFN);
 }
 
+void tlsStats();
+void tlsSessionForget();
+void tlsCmd(String str)
+{
+  // tls         - handshake statistics
+  // tls forget  - drop the cached session, next upload does a full handshake
+  if (str.startsWith("tls forget")) tlsSessionForget();
+  tlsStats();
+}
+
 //----------------------------------------------------------------------------
 //   L O G G I N G   S E R V I C E
 //----------------------------------------------------------------------------
@@ -341,6 +428,7 @@ char tmpbuf[128];
 char ftpUploadFolder[128];
 long tzOffsetSec; // 32 bit
 long baudRate;
+char gpsType[16]; // receiver protocol for hot-start aiding, UBX CASIC PMTK or empty
 int  hrsPerUploadAttempt = 1;
 
 int readConfigFile(char* configFn)
@@ -357,6 +445,36 @@ int readConfigFile(char* configFn)
   retval &= readKey(configFn, "FTPPASSWORD=", ftpPwd, 63);
   retval &= readKey(configFn, "BAUDRATE=", tmpbuf, 63);
   retval &= readKey(configFn, "FTPFOLDER=", ftpUploadFolder, 127);
+  readKey(configFn, "UPLOADURL=", uploadUrl, 127); // optional
+  readKey(configFn, "UPLOADSHA256=", uploadSha256, 66); // optional, or /ca.pem
+  readKey(configFn, "BATCHSERVER=", batchServer, 127); // optional, host:port
+  char* colon = strchr(batchServer, ':');
+  batchPort = BATCH_PORT_DEFAULT;
+  if (colon != NULL)
+  {
+    *colon = '\0';
+    batchPort = atoi(colon+1);
+  }
+  if (!readKey(configFn, "DEVICEID=", batchDeviceId, 63) || (batchDeviceId[0] == 0))
+  {
+    uint64_t mac = ESP.getEfuseMac(); // unique per board
+    sprintf(batchDeviceId, "gps-%04X%08X", (uint16_t)(mac >> 32), (uint32_t)mac);
+  }
+#ifdef PIPE_UPLINK
+  readKey(configFn, "MQTTSERVER=", mqttServer, 127); // optional, host:port
+  colon = strchr(mqttServer, ':');
+  mqttPort = MQTT_PORT_DEFAULT;
+  if (colon != NULL)
+  {
+    *colon = '\0';
+    mqttPort = atoi(colon+1);
+  }
+  if (!readKey(configFn, "MQTTTOPIC=", mqttTopic, 127) || (mqttTopic[0] == 0))
+    snprintf(mqttTopic, sizeof(mqttTopic), "gpslogger/%s/fixes", batchDeviceId);
+  readKey(configFn, "MQTTUSER=", mqttUser, 63);
+  readKey(configFn, "MQTTPASSWORD=", mqttPwd, 63);
+#endif
+  readKey(configFn, "GPSTYPE=", gpsType, 15); // optional
   
   baudRate = atol(tmpbuf);
   //retval &= readKey(configFn, "HOURSPERUPLOAD=", tmpbuf, 63);
@@ -373,40 +491,35 @@ int readConfigFile(char* configFn)
   return retval;
 }
 
-void ftpPut(char* fn)
-{
-  char linebuf[256];
-
-  String targetfn = rtc.getTime("gpslog_%Y%m%d-%H%M%S.log"); // "20221116-182201"
-  zprint("FTP to "); zprintln(targetfn);
-  ESP32_FTPClient ftp (ftpServer,ftpUser,ftpPwd, 5000, 1); // 50 sec timeout, verbose=1
-  ftp.OpenConnection();
-  ftp.InitFile("Type I");
-  ftp.ChangeWorkDir(ftpUploadFolder);
-  ftp.NewFile(targetfn.c_str());
-
-  // open file and read each line - send to FTP
-  File finp = fileSystem.open(LOGFN, FILE_READ);
-  if (!finp)
-  {
-    zprintln("Unable to read log file");
-    return;
-  }
+//----------------------------------------------------------------------------
+//             F T P   U P L O A D   S E R V I C E
+#include "FtpService.h"
+//----------------------------------------------------------------------------
+//             H T T P S   U P L O A D   S E R V I C E
+#include "TlsUploadService.h"
+//----------------------------------------------------------------------------
+//             W I F I   S E R V I C E
+#include "WiFiService.h"
+//----------------------------------------------------------------------------
+//             B A T C H E D - A C K   U P L O A D   S E R V I C E
+#include "BatchUploadService.h"
 
-  while (readln(finp, (uint8_t*)linebuf, 250))
+void batchCmd(String str)
+{
+  // batch       - batch upload status
+  // batch stop  - give up on the current upload
+  if (str.startsWith("batch stop"))
   {
-    strcat(linebuf,"\n");
-    ftp.WriteData( (unsigned char*)linebuf, strlen(linebuf) );
+    batchDisconnect("stopped");
+    batchWanted = false;
   }
-  finp.close();
-  zprintln("FTP upload completed.");
-  ftp.CloseFile();
-  ftp.CloseConnection();  
-
+  zprint("Batch upload "); zprint(batchWanted ? "active" : "idle");
+  zprint(", acked "); zprint((int)batchAckedSeq);
+  zprint(", sent "); zprint((int)batchNextSeq);
+  zprint(", sessions "); zprint((int)batchSessions);
+  zprint(", records sent "); zprintln((int)batchRecordsSent);
 }
-//----------------------------------------------------------------------------
-//             W I F I   S E R V I C E
-#include "WiFiService.h"
+
 //----------------------------------------------------------------------------
 //             N T P   S E R V I C E
 #include "NTPService.h"
@@ -468,11 +581,499 @@ void zprintln(int x)
 
 #include "sioService.h"
 
+//----------------------------------------------------------------------------
+//        T R A C K   R E P L A Y
+//----------------------------------------------------------------------------
+// replay                         - replay the log to telnet at 60x
+// replay 10                      - at 10x (1 = real time)
+// replay max                     - as fast as it can go
+// replay 10 dec                  - decoded fixes instead of NMEA
+// replay max udp 192.168.1.5 10110  - send to a UDP target instead
+// replay stop
+#include "NmeaService.h"
+#include "ReplayService.h"
+
+char rmcbuf[128]; // temporarily stores $GxRMC messages, log once per minute 
+
+#define REPLAY_DEFAULTSPEED (60)
+
+WiFiUDP replayUdp;
+char replayUdpHost[64];
+uint16_t replayUdpPort = 0; // 0 = send to telnet
+
+void replayOutput(const char* line)
+{
+  if (replayUdpPort != 0)
+  {
+    replayUdp.beginPacket(replayUdpHost, replayUdpPort);
+    replayUdp.write((const uint8_t*)line, strlen(line));
+    replayUdp.write((const uint8_t*)"\r\n", 2);
+    replayUdp.endPacket();
+  }
+  else if (telnetConnected)
+  {
+    telnet.println(line);
+  }
+}
+
+void replayCmd(String str)
+{
+  char buf[SIO_INPUT_MAXLEN+4];
+  int speed = REPLAY_DEFAULTSPEED;
+  int decoded = false;
+
+  strncpy(buf, str.c_str(), SIO_INPUT_MAXLEN);
+  buf[SIO_INPUT_MAXLEN] = 0;
+  replayUdpPort = 0;
+  strtok(buf, " "); // "replay"
+  for (char* tok = strtok(NULL, " "); tok != NULL; tok = strtok(NULL, " "))
+  {
+    if (strcmp(tok, "stop") == 0)
+    {
+      zprint("Replay stopped after "); zprint((int)replayLines); zprintln(" lines");
+      replayStop();
+      return;
+    }
+    else if (strcmp(tok, "max") == 0)
+      speed = 0;
+    else if (strcmp(tok, "dec") == 0)
+      decoded = true;
+    else if (strcmp(tok, "udp") == 0)
+    {
+      char* host = strtok(NULL, " ");
+      char* port = strtok(NULL, " ");
+      if ((host == NULL) || (port == NULL))
+      {
+        zprintln("replay command error:  replay [speed] udp host port");
+        return;
+      }
+      strncpy(replayUdpHost, host, sizeof(replayUdpHost)-1);
+      replayUdpPort = atoi(port);
+    }
+    else if (atoi(tok) > 0)
+      speed = atoi(tok);
+  }
+
+  if (!replayStart(LOGFN, speed, decoded))
+  {
+    zprintln("Unable to read log file");
+    return;
+  }
+  zprint("Replaying "); zprint(LOGFN); zprint(" at ");
+  if (speed == 0) zprintln("max speed"); else { zprint(speed); zprintln("x"); }
+}
+
+//----------------------------------------------------------------------------
+//        G P S   A I D I N G
+//----------------------------------------------------------------------------
+// Last position (and time, once NTP has it) given to the receiver at boot
+// for a hot start, GPSTYPE= in config.ini says how.  TTFF goes to the
+// event log every boot.
+// aid                            - aiding status and TTFF history
+// aid save                       - save the position now (and UBX database dump)
+// aid clear                      - forget the saved position, dump and history
+#ifdef PIPE_FULL
+#include "GpsAidService.h"
+
+void aidPrintHow(int how)
+{
+  if (how & AIDED_POS) zprint(" pos");
+  if (how & AIDED_TIME) zprint(" time");
+  if (how & AIDED_DBD) zprint(" dbd");
+  if (how == 0) zprint(" none");
+}
+
+void aidCmd(String str)
+{
+  if (str.startsWith("aid clear"))
+  {
+    aidClear();
+    zprintln("Aiding data cleared");
+    return;
+  }
+  if (str.startsWith("aid save"))
+  {
+    aidSaveTimer = millis() - AID_SAVE_MIN * 60000UL; // on the next fix
+    aidDbdPollTimer = millis() - AID_DBD_MIN * 60000UL;
+    zprintln("Saving on the next fix");
+  }
+  zprint("Receiver "); zprint(aidTypeName());
+  if (aidHavePos)
+  {
+    char buf[64];
+    time_t t = aidSavedEpoch;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    snprintf(buf, sizeof(buf), ", saved %.5f,%.5f %.0fm at %04d/%02d/%02d %02d:%02d",
+      aidLat, aidLon, aidAlt, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min);
+    zprint(buf);
+  }
+  else zprint(", no saved position");
+  File f = fileSystem.open(AID_DBDFN, FILE_READ);
+  if (f) { zprint(", dump "); zprint((int)f.size()); zprint(" bytes"); f.close(); }
+  zprintln("");
+  zprint("This boot aided:"); aidPrintHow(aidDone);
+  if (aidTtff >= 0) { zprint(", TTFF "); zprint((int)aidTtff); zprintln("s"); }
+  else { zprint(", no fix yet after "); zprint((int)((millis() - aidBootMs) / 1000)); zprintln("s"); }
+  for (int i = 0; i < aidHistory.count; i++)
+  {
+    zprint("  TTFF "); zprint((int)aidHistory.ttffSec[i]); zprint("s aided:"); aidPrintHow(aidHistory.aided[i]); zprintln("");
+  }
+}
+#else
+// only the receiver's protocol is wanted from GpsAidService.h, for the
+// motion stage
+#define AIDTYPE_NONE  (0)
+#define AIDTYPE_UBX   (1)
+#define AIDTYPE_CASIC (2)
+#define AIDTYPE_PMTK  (3)
+
+int aidType = AIDTYPE_NONE;
+
+int aidTypeFromName(const char* name)
+{
+  if (strcasecmp(name, "UBX") == 0) return AIDTYPE_UBX;
+  if (strcasecmp(name, "CASIC") == 0) return AIDTYPE_CASIC;
+  if (strcasecmp(name, "PMTK") == 0) return AIDTYPE_PMTK;
+  return AIDTYPE_NONE;
+}
+
+const char* aidTypeName()
+{
+  const char* names[] = { "none", "UBX", "CASIC", "PMTK" };
+  return names[aidType];
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        M O T I O N   P O W E R
+//----------------------------------------------------------------------------
+// Receiver rate and sentences follow the motion state, and the receiver
+// sleeps when parked (GPSPARKMIN= minutes still, woken every GPSWAKEMIN=
+// minutes to look).  Needs GPSTYPE= to send anything.
+// motion                         - motion state, time and NMEA bytes per state
+#include "MotionService.h"
+
+void motionReadConfig(char* configFn)
+{
+  if (readKey(configFn, "GPSPARKMIN=", tmpbuf, 63) && (tmpbuf[0] != 0)) motionParkMin = atoi(tmpbuf);
+  if (readKey(configFn, "GPSWAKEMIN=", tmpbuf, 63) && (tmpbuf[0] != 0)) motionWakeMin = atoi(tmpbuf);
+  if (motionWakeMin < 1) motionWakeMin = 1;
+}
+
+void motionCmd(String str)
+{
+  zprint("Motion "); zprint(motionStateName(motionState));
+  zprint(" for "); zprint((int)motionStateSec); zprint("s, "); zprint(String(motionKts, 1)); zprint(" kts");
+  zprint(", receiver "); zprint(aidTypeName()); zprintln(motionAsleep() ? " asleep" : "");
+  for (int i = 0; i < MOTION_STATES; i++)
+  {
+    zprint("  "); zprint(motionStateName(i)); zprint(" "); zprint((int)motionSec[i]);
+    zprint("s "); zprint((int)motionBytes[i]); zprintln(" bytes");
+  }
+  zprint("  sleeps "); zprint((int)motionSleeps); zprint(", wakes "); zprint((int)motionWakes);
+  zprint(", moved while asleep "); zprintln((int)motionWokeMoved);
+}
+
+//----------------------------------------------------------------------------
+//        D U A L   R E C E I V E R   F U S I O N
+//----------------------------------------------------------------------------
+// A second receiver on GPS2PORT (GPS2BAUD= in config.ini, empty = none).
+// Both receivers' RMC/GGA are matched by epoch, the best fix (or the two
+// averaged) is what gets logged, published and fanned out.  Aiding and
+// the motion commands only go to the first one.
+// fuse                           - per receiver health, fused epochs
+#ifdef PIPE_FULL
+#include "GpsFusionService.h"
+
+long gps2BaudRate = 0;
+
+void fuseReadConfig(char* configFn)
+{
+  gps2BaudRate = 0;
+  if (readKey(configFn, "GPS2BAUD=", tmpbuf, 63) && (tmpbuf[0] != 0)) gps2BaudRate = atol(tmpbuf);
+  if ((gps2BaudRate != 0) && (gps2BaudRate < 1200)) gps2BaudRate = 1200;
+  if (gps2BaudRate > 115200) gps2BaudRate = 115200;
+}
+
+void fuseStart()
+{
+  fuseEnabled = (gps2BaudRate != 0);
+  if (!fuseEnabled) return;
+  gps2Init(gps2BaudRate);
+  fuseInit();
+}
+
+void fuseCmd(String str)
+{
+  if (!fuseEnabled) { zprintln("One receiver (GPS2BAUD not set)"); return; }
+  zprint("Epochs out "); zprint((int)fuseEpochsOut);
+  zprint(", both "); zprint((int)fuseMatched);
+  zprint(", fused "); zprint((int)fuseFused);
+  zprint(", disagree "); zprint((int)fuseDisagree);
+  zprint(", skew "); zprint((int)(fuseMatched ? fuseSkewMsSum / fuseMatched : 0)); zprintln(" ms");
+  for (int i = 0; i < FUSE_RECEIVERS; i++)
+  {
+    FuseRx* r = &fuseRx[i];
+    char buf[160];
+    snprintf(buf, sizeof(buf), " GPS%d %s lines %lu bad %lu epochs %lu fix %lu chosen %lu late %lu hdop %.1f sats %.1f outages %lu out %lus",
+      i + 1, r->out ? "OUT" : r->asleep ? "asleep" : "ok", r->lines, r->badLines, r->epochs, r->fixEpochs, r->chosen, r->late,
+      r->ggaEpochs ? r->hdopSum / r->ggaEpochs : 0.0, r->ggaEpochs ? (float)r->satsSum / r->ggaEpochs : 0.0,
+      r->outages, r->outSec + (r->out ? (millis() - r->lastEpochMs) / 1000 : 0));
+    zprintln(buf);
+  }
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        S I G N A L   S T A T I S T I C S
+//----------------------------------------------------------------------------
+// C/N0 per satellite and constellation from GSV, satellites used and DOP
+// from GSA, one record every SIGNALMIN= minutes to /signal.log - for
+// spotting a bad antenna or cable.  First receiver only.
+// signal                         - last record, C/N0 per satellite this interval
+#ifdef PIPE_FULL
+#include "GpsSignalService.h"
+
+void signalReadConfig(char* configFn)
+{
+  if (readKey(configFn, "SIGNALMIN=", tmpbuf, 63) && (tmpbuf[0] != 0)) sigIntervalMin = atoi(tmpbuf);
+}
+
+void signalCmd(String str)
+{
+  zprint("Last record C/N0 "); zprint(sigLastMin); zprint("/"); zprint(sigLastMedian); zprint("/"); zprint(sigLastMax);
+  zprint(" dB-Hz min/median/max, used "); zprint(String(sigLastUsed, 1));
+  zprint(", HDOP "); zprintln(String(sigLastHdop, 1));
+  zprint(" GSV "); zprint((int)sigGsvLines); zprint(", GSA "); zprint((int)sigGsaLines);
+  zprint(", bad "); zprint((int)sigBadLines); zprint(", records "); zprint((int)sigRecordsMade);
+  zprint(", every "); zprint(sigIntervalMin); zprintln(" min");
+  for (int s = 0; s < SIG_SYSTEMS; s++)
+  {
+    char buf[SIG_PRNS * 8];
+    int n = 0;
+    for (int i = 0; i < SIG_PRNS; i++)
+    {
+      int cn0 = signalSatCn0(s, i);
+      if (cn0 > 0) n += snprintf(buf + n, sizeof(buf) - n, " %c%02d:%d", sigSystemChar[s], i + 1, cn0);
+    }
+    if (n > 0) zprintln(buf);
+  }
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        T R A C K   S E G M E N T S
+//----------------------------------------------------------------------------
+// The fixes that go to location.log also go to /track.seg, a column per
+// field in segments of up to an hour, so top speed and where it's been
+// come from the segment headers instead of parsing the whole log.
+// track                          - segments stored, bytes per fix
+// track speed [hours]            - top speed, the last hours or all
+// track box [hours]              - bounding box, the last hours or all
+#include "TrackSegmentService.h"
+
+void trackCmd(String str)
+{
+  char what[8], buf[160];
+  float hours = 0;
+  what[0] = 0;
+  sscanf(str.c_str(), "track %7s %f", what, &hours);
+  if (what[0] == 0)
+  {
+    File file = fileSystem.open(SEGFN, FILE_READ);
+    long bytes = file ? file.size() : 0;
+    if (file) file.close();
+    snprintf(buf, sizeof(buf), "%s %ld bytes, %lu segments %lu fixes written since boot (%.1f bytes/fix), %d buffered",
+      SEGFN, bytes, segWritten, segFixes - segCount, segFixes > (unsigned long)segCount ? (float)segBytes / (segFixes - segCount) : 0.0, segCount);
+    zprintln(buf);
+    return;
+  }
+  int32_t t1 = segNewest();
+  if (t1 < 0) { zprintln("No fixes stored"); return; }
+  int32_t t0 = (hours > 0) ? t1 - (int32_t)(hours * 3600) : -SEG_ALL;
+  int32_t lo, hi, lo2, hi2;
+  unsigned long n;
+  if (strcmp(what, "speed") == 0)
+  {
+    n = segQuery(SEG_SPEED, t0, t1, &lo, &hi);
+    snprintf(buf, sizeof(buf), "Top speed %.1f kts over %lu fixes", hi / 100.0, n);
+  }
+  else if (strcmp(what, "box") == 0)
+  {
+    n = segQuery(SEG_LAT, t0, t1, &lo, &hi);
+    segQuery(SEG_LON, t0, t1, &lo2, &hi2);
+    snprintf(buf, sizeof(buf), "Lat %.6f to %.6f, lon %.6f to %.6f over %lu fixes", lo / 1e6, hi / 1e6, lo2 / 1e6, hi2 / 1e6, n);
+  }
+  else
+  {
+    zprintln("track [speed|box] [hours]");
+    return;
+  }
+  zprintln(buf);
+  snprintf(buf, sizeof(buf), " segments from the header %lu, decoded %lu, skipped %lu", segFromHeader, segDecoded, segSkipped);
+  zprintln(buf);
+}
+
+//----------------------------------------------------------------------------
+//        R A W   C A P T U R E
+//----------------------------------------------------------------------------
+// Every line and binary frame from the receiver with its time in us, for
+// receiver trouble - compressed into a ring of CAPTUREKB= in /capture.bin
+// (oldest overwritten), for CAPTUREMIN= minutes.  The dump, logged from
+// telnet, goes straight into replay or host/replay.
+// cap                            - capture status
+// cap start [minutes] [kb]       - start a capture
+// cap stop                       - stop it
+// cap dump                       - the capture as text, oldest first
+#ifdef PIPE_FULL
+#include "CaptureService.h"
+
+void capReadConfig(char* configFn)
+{
+  if (readKey(configFn, "CAPTUREKB=", tmpbuf, 63) && (tmpbuf[0] != 0)) capKb = atol(tmpbuf);
+  if (readKey(configFn, "CAPTUREMIN=", tmpbuf, 63) && (tmpbuf[0] != 0)) capMinutes = atoi(tmpbuf);
+}
+
+void capDumpLine(const char* text)
+{
+  zprintln((char*)text);
+}
+
+void capCmd(String str)
+{
+  char what[8];
+  int minutes = capMinutes;
+  long kb = capKb;
+  what[0] = 0;
+  sscanf(str.c_str(), "cap %7s %d %ld", what, &minutes, &kb);
+  if (strcmp(what, "start") == 0)
+  {
+    if (!capStart(minutes, kb)) { zprintln("Unable to start a capture (no room?)"); return; }
+    zprint("Capturing for "); zprint(minutes); zprint(" min into "); zprint(capBlocks * CAP_BLOCK / 1024); zprintln(" KB");
+    return;
+  }
+  if (strcmp(what, "stop") == 0) capStop();
+  else if (strcmp(what, "dump") == 0)
+  {
+    if (capActive) { zprintln("Stop the capture first"); return; }
+    unsigned long n = capDump(capDumpLine);
+    zprint("# "); zprint((int)n); zprintln(" records");
+    return;
+  }
+  else if (what[0] != 0)
+  {
+    zprintln("cap [start [minutes] [kb]|stop|dump]");
+    return;
+  }
+  char buf[160];
+  snprintf(buf, sizeof(buf), "Capture %s, %lu lines %lu binary frames, %lu bytes in %lu out (%.1fx), %lu blocks of %d",
+    capActive ? "running" : "stopped", capLines, capFrames, capInBytes, capOutBytes,
+    capOutBytes ? (float)capInBytes / capOutBytes : 0.0, capSeq, capBlocks);
+  zprintln(buf);
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        G E O F E N C E
+//----------------------------------------------------------------------------
+// Only look for WiFi near the known APs (ZONE1= .. ZONE4= in config.ini),
+// and upload as soon as WiFi connects after arriving in a zone.
+// With no zones configured WiFi is always on, as before.
+// zone                           - geofence status
+#include "GeofenceService.h"
+
+int uploadOnConnect = false; // arrived in a zone, upload once WiFi is up
+
+void geofenceReadConfig(char* configFn)
+{
+  char key[8];
+  for (int i = 1; i <= GEOFENCE_MAX; i++)
+  {
+    sprintf(key, "ZONE%d=", i);
+    if (readKey(configFn, key, tmpbuf, 127) && (tmpbuf[0] != 0) && !geofenceAddZone(tmpbuf))
+    {
+      zprint("Bad zone "); zprintln(tmpbuf);
+    }
+  }
+  if (readKey(configFn, "ZONEFALLBACKMIN=", tmpbuf, 63) && (tmpbuf[0] != 0))
+    geofenceFallbackMin = atoi(tmpbuf);
+}
+
+// once per second, before wifiService()
+void geofenceWifiService()
+{
+  geofenceUpdate(rmcbuf);
+  if (geofenceWantWifi())
+  {
+    if (wifiIsOff()) wifiConnect(); // near a known AP, or a fallback window
+  }
+  else if (!wifiIsConnected() && !wifiIsOff())
+  {
+    wifiOff(); // nothing to find out here
+  }
+  if (geofenceArrived())
+  {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Arrived in zone %d", geofenceNearest+1);
+    logMessage(msg);
+    wifiRetryNow();
+    uploadOnConnect = true;
+  }
+}
+
+void zoneCmd(String str)
+{
+  zprint("Geofence "); zprint(geofenceStateName());
+  if (geofenceCount == 0) { zprintln(", no zones - WiFi always on"); return; }
+  zprint(", zone "); zprint(geofenceNearest+1);
+  zprint(" "); zprint((int)geofenceEdgeM); zprint("m");
+  zprint(", entries "); zprint((int)geofenceEntries);
+  zprint(", WiFi "); zprintln(wifiIsOff() ? "off" : "on");
+  for (int i = 0; i < geofenceCount; i++)
+  {
+    char buf[64];
+    snprintf(buf, sizeof(buf), " %d: %.5f,%.5f %dm", i+1,
+      geofenceZones[i].lat, geofenceZones[i].lon, (int)geofenceZones[i].radiusM);
+    zprintln(buf);
+  }
+}
+
 //---------------------------------------------------------------------
 //        S I M P L E   S H E L L   C O M M A N D   H A N D L E R
 //---------------------------------------------------------------------
+#ifdef PIPE_FULL
 int gpsTelnetEcho = true;
 int gpsSerialEcho = false;
+#endif
+
+void webCmd(String str);
+void fanCmd(String str);
+void mqttCmd(String str);
+void telemetryCmd(String str);
+void aidCmd(String str);
+void motionCmd(String str);
+void sleepCmd(String str);
+void fuseCmd(String str);
+void signalCmd(String str);
+void trackCmd(String str);
+void capCmd(String str);
+void pipeCmd(String str);
+void memCmd(String str);
+void logbufCmd(String str);
+void pipeNotInBuild();
+
+// a command for a stage the build variant leaves out just says so
+#ifdef PIPE_FULL
+#define PIPE_FULL_ONLY(cmd) cmd
+#else
+#define PIPE_FULL_ONLY(cmd) pipeNotInBuild()
+#endif
+#ifdef PIPE_UPLINK
+#define PIPE_UPLINK_ONLY(cmd) cmd
+#else
+#define PIPE_UPLINK_ONLY(cmd) pipeNotInBuild()
+#endif
 
 void handleShellCommand(String str)
 {
@@ -488,17 +1089,53 @@ void handleShellCommand(String str)
   else if (str.startsWith("ap "))
     apCmd(str); // append one line at a time to a file
   else if (str.startsWith("on"))
-    gpsTelnetEcho = true;
+    PIPE_FULL_ONLY(gpsTelnetEcho = true);
   else if (str.startsWith("off"))
-    gpsTelnetEcho = false;
+    PIPE_FULL_ONLY(gpsTelnetEcho = false);
   else if (str.startsWith("son"))
-    gpsSerialEcho = true;
+    PIPE_FULL_ONLY(gpsSerialEcho = true);
   else if (str.startsWith("soff"))
-    gpsSerialEcho = false;
+    PIPE_FULL_ONLY(gpsSerialEcho = false);
   else if (str.startsWith("test"))
     WiFi.disconnect(); // TODO - add anything you want here for testing purposes
   else if (str.startsWith("ftp"))
     ftpCmd(str);
+  else if (str.startsWith("replay"))
+    replayCmd(str);
+  else if (str.startsWith("tls"))
+    tlsCmd(str);
+  else if (str.startsWith("batch"))
+    batchCmd(str);
+  else if (str.startsWith("zone"))
+    zoneCmd(str);
+  else if (str.startsWith("web"))
+    webCmd(str);
+  else if (str.startsWith("fan"))
+    PIPE_FULL_ONLY(fanCmd(str));
+  else if (str.startsWith("mqtt"))
+    PIPE_UPLINK_ONLY(mqttCmd(str));
+  else if (str.startsWith("telemetry"))
+    PIPE_UPLINK_ONLY(telemetryCmd(str));
+  else if (str.startsWith("aid"))
+    PIPE_FULL_ONLY(aidCmd(str));
+  else if (str.startsWith("motion"))
+    motionCmd(str);
+  else if (str.startsWith("sleep"))
+    sleepCmd(str);
+  else if (str.startsWith("fuse"))
+    PIPE_FULL_ONLY(fuseCmd(str));
+  else if (str.startsWith("signal"))
+    PIPE_FULL_ONLY(signalCmd(str));
+  else if (str.startsWith("track"))
+    trackCmd(str);
+  else if (str.startsWith("cap"))
+    PIPE_FULL_ONLY(capCmd(str));
+  else if (str.startsWith("pipe"))
+    pipeCmd(str);
+  else if (str.startsWith("mem"))
+    memCmd(str);
+  else if (str.startsWith("logbuf"))
+    logbufCmd(str);
   else
     zprintln("\r\n ehh?");
   telnet.print(">"); // prompt
@@ -518,6 +1155,26 @@ void handleShellCommand(String str)
 // -- echo GPS info to telnet switch (on by default)
 //  on
 //  off
+//  ftp                                   - upload the location log (batched-ack if BATCHSERVER
+//                                          is set, else HTTPS if UPLOADURL is set, else FTP)
+//  batch [stop]                          - batched-ack upload status
+//  zone                                  - geofence status (WiFi only near known APs)
+//  web                                   - web dashboard status (browse to http://<logger ip>/)
+//  fan                                   - NMEA fan-out clients (ports 2947 gpsd, 10110 NMEA)
+//  mqtt [flush]                          - MQTT publisher status, queue the part batch now
+//  telemetry                             - UDP fix telemetry status
+//  aid [save|clear]                      - GPS hot-start aiding status and TTFF history
+//  motion                                - motion state, receiver rate/sleep statistics
+//  sleep                                 - parked deep sleep statistics
+//  fuse                                  - dual receiver health and fused epochs
+//  signal                                - satellite C/N0, satellites used, DOP
+//  track [speed|box] [hours]             - track segments, top speed / bounding box from them
+//  cap [start [min] [kb]|stop|dump]      - raw receiver capture with us timestamps
+//  pipe [reset]                          - build variant, stages, static RAM / flash, cycles per fix
+//  mem [all]                             - static buffer budget, heap, task stack high-water marks
+//  logbuf                                - location log buffer (DRAM/PSRAM), flushes, flash writes saved
+//  tls [forget]                          - HTTPS handshake statistics, drop the cached session
+//  replay [speed|max|stop] [dec] [udp host port] - replay the location log
 
 void onInputReceived(String str)
 {
@@ -581,82 +1238,468 @@ void setupTelnet() {
 }
 
 #include "SchedulerService.h"
+
 //----------------------------------------------------------------------------
-//             L O G  F I L E  S E R V I C E
-//
-// We can append lines to a log file.
-// Since it's a flash file system, we want to minimize the number of times
-// flash is written (as it has a limited number of write cycles before it's
-// worn out.
-//
-// So we keep some buffer of lines and stuff them in the buffer.
-// Then every so often we'll dump the buffered lines to the file system.
-//
-// Line buffer size in characters (auto flush when full)
-#define LOGBUFFERSIZE (8*1024)
-char logbuffer[LOGBUFFERSIZE];
-int bufferWritePosition = 0;
+//        L O C A T I O N   L O G   B U F F E R
+//----------------------------------------------------------------------------
+// In RAM until it's written to LOGFN - 8K hourly, or with PSRAM a much
+// bigger buffer written in batches (LOGFLUSHHOURS= in config.ini)
+// logbuf                         - buffer, flushes and the flash writes saved
+#include "GpsLogService.h"
 
-void gpsLogInit()
+void gpsLogReadConfig(char* configFn)
 {
-  bufferWritePosition = 0; // next character to write
+  if (readKey(configFn, "LOGFLUSHHOURS=", tmpbuf, 63) && (tmpbuf[0] != 0)) logFlushHours = atoi(tmpbuf);
+  if (logFlushHours < 1) logFlushHours = 1;
 }
 
-void gpsLogLine(char* msg)
+void logbufCmd(String str)
 {
-  int len = strlen(msg);
-  if (len == 0) return; // nothing to log
-  
-  // we don't want to overflow the buffer, so if this line would overflow it,
-  // then we'll flush it first
-  int lastbyte = bufferWritePosition+len+8; // little buffer at the end
-  if (lastbyte >= LOGBUFFERSIZE) gpsLogFlush();
-  strcpy(&logbuffer[bufferWritePosition], msg);
-  bufferWritePosition += len;
-  logbuffer[bufferWritePosition++] = '\015'; // CR
-  logbuffer[bufferWritePosition++] = '\012'; // LF
-  // no \0 between lines!
+  zprint("Log buffer "); zprint(logBufSize / 1024);
+  zprint((logBuf == logbuffer) ? " KB in DRAM" : " KB in PSRAM");
+  zprint(", "); zprint(bufferWritePosition); zprint(" bytes held");
+  if (logBuf != logbuffer) { zprint(", batch every "); zprint(logFlushHours); zprint(" h or 3/4 full"); }
+  zprintln(logDraining ? ", writing" : "");
+  zprint(" flushes "); zprint((int)logFlushes); zprint(", "); zprint((int)(logFlushBytes / 1024)); zprint(" KB");
+  zprint(", the 8K buffer hourly "); zprint((int)logBaseFlushes);
+  if (logLostBytes > 0) { zprint(", "); zprint((int)logLostBytes); zprint(" bytes lost (log file wouldn't open)"); }
+  // each append programs its pages, rewrites the part page before it and
+  // updates the file's index page
+  unsigned long pages = logFlushBytes / LOGPAGE + 2 * logFlushes;
+  unsigned long basePages = logFlushBytes / LOGPAGE + 2 * logBaseFlushes;
+  if ((basePages > 0) && (pages <= basePages))
+  {
+    zprint(", ~"); zprint((int)(100 - pages * 100 / basePages)); zprint("% fewer page writes");
+  }
+  zprintln("");
 }
 
+//----------------------------------------------------------------------------
+//        N M E A   F A N - O U T   S E R V E R
+//----------------------------------------------------------------------------
+// port 2947 - gpsd style (?WATCH json or nmea), port 10110 - plain NMEA
+// fan                            - fan-out clients
+#ifdef PIPE_FULL
+#include "FanoutService.h"
 
-void gpsLogFlush()
+void fanCmd(String str)
 {
-  if (bufferWritePosition > 0)
+  zprint("NMEA fan-out "); zprint(fanStarted ? "running" : "not started");
+  zprint(", accepted "); zprint((int)fanAccepted);
+  zprint(", refused "); zprint((int)fanRefused);
+  zprint(", cut off "); zprintln((int)fanCutOff);
+  for (int i = 0; i < FAN_MAXCLIENTS; i++)
   {
-    File file = fileSystem.open(LOGFN, FILE_APPEND);
-    if(!file){
-      Serial.println("- failed to open log file for appending");\
-      bufferWritePosition = 0;
-      return;
-   }
-   logbuffer[bufferWritePosition] = '\0'; // null terminate
-   if(file.print(logbuffer)){
-      Serial.println("- message appended");
-   } else {
-      Serial.println("- append failed");
-   }
-   file.close();
+    FanClient* fc = &fanClients[i];
+    if (!fc->inUse) continue;
+    FanRing* r = (fc->mode == FANMODE_JSON) ? &fanJson : &fanRaw;
+    char buf[96];
+    snprintf(buf, sizeof(buf), " %s %s sent %lu behind %lu",
+      fc->client.remoteIP().toString().c_str(),
+      (fc->mode == FANMODE_JSON) ? "json" : (fc->mode == FANMODE_RAW) ? "nmea" : "idle",
+      (unsigned long)fc->sent, (unsigned long)(fc->mode ? r->head - fc->cursor : 0));
+    zprintln(buf);
   }
-  bufferWritePosition = 0;
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        M Q T T   P U B L I S H E R
+//----------------------------------------------------------------------------
+// Batches of fixes to MQTTSERVER (QoS 1), queued in flash until acknowledged
+// mqtt                           - publisher status
+// mqtt flush                     - queue the part batch now
+#ifdef PIPE_UPLINK
+#include "MqttService.h"
+
+void mqttCmd(String str)
+{
+  if (str.startsWith("mqtt flush")) mqttBatchClose();
+  if (mqttServer[0] == 0) { zprintln("MQTT not configured (MQTTSERVER)"); return; }
+  zprint("MQTT "); zprint(mqttState == MQTTSTATE_UP ? "connected" : mqttState == MQTTSTATE_IDLE ? "idle" :
+    mqttState == MQTTSTATE_RESOLVE ? "looking up the broker" : "connecting");
+  zprint(", queued "); zprint(mqttPending()); zprint(" bytes");
+  zprint(", in flight "); zprint(mqttInflightCount);
+  zprint(", next seq "); zprint((int)mqttSeq);
+  zprint(", fixes waiting "); zprintln(mqttBatchFixes);
+  zprint(" sessions "); zprint((int)mqttSessions);
+  zprint(", published "); zprint((int)mqttPublished);
+  zprint(", acked "); zprint((int)mqttAckedCount);
+  zprint(", resent "); zprint((int)mqttResent);
+  zprint(", dropped "); zprintln((int)mqttDropped);
+}
+
+//----------------------------------------------------------------------------
+//        U D P   T E L E M E T R Y
+//----------------------------------------------------------------------------
+// A fix every TELEMETRYSEC= seconds as a UDP datagram to TELEMETRYSERVER=
+// (host:port), for a fleet pointed at one collector (host/udpcollect.cpp)
+// telemetry                      - telemetry status
+char telServer[128]; // empty = no telemetry
+uint16_t telPort = TEL_PORT_DEFAULT;
+long telEverySec = 10;
+#include "TelemetryService.h"
+
+void telReadConfig(char* configFn)
+{
+  readKey(configFn, "TELEMETRYSERVER=", telServer, 127);
+  char* colon = strchr(telServer, ':');
+  telPort = TEL_PORT_DEFAULT;
+  if (colon != NULL)
+  {
+    *colon = '\0';
+    telPort = atoi(colon+1);
+  }
+  if (readKey(configFn, "TELEMETRYSEC=", tmpbuf, 63) && (atol(tmpbuf) > 0)) telEverySec = atol(tmpbuf);
+}
+
+void telemetryCmd(String str)
+{
+  if (telServer[0] == 0) { zprintln("Telemetry not configured (TELEMETRYSERVER)"); return; }
+  zprint("Telemetry to "); zprint(telServer); zprint(":"); zprint((int)telPort);
+  zprint(" every "); zprint((int)telEverySec); zprint("s");
+  zprint(", next seq "); zprintln((int)telSeq);
+  zprint(" sent "); zprint((int)telSent);
+  zprint(", no WiFi "); zprint((int)telNoLink);
+  zprint(", failed "); zprintln((int)telFailed);
+}
+#endif
+
+//----------------------------------------------------------------------------
+//        W E B   D A S H B O A R D
+//----------------------------------------------------------------------------
+// http://<logger ip>/ - live fix, track and stats (page from www/index.html)
+// web                            - dashboard status
+#include "WebService.h"
+
+void webCollectStats()
+{
+  webStat("uptime", millis() / 1000);
+  webStat("nmeaLines", gpsLineAvail);
+  webStat("logBuffered", bufferWritePosition);
+  webStat("freeHeap", ESP.getFreeHeap());
+  webStat("minFreeHeap", ESP.getMinFreeHeap());
+  webStat("wifi", wifiIsConnected());
+  webStat("rssi", wifiIsConnected() ? WiFi.RSSI() : 0);
+  webStat("zoneState", geofenceState);
+  webStat("zoneEdgeM", (long)geofenceEdgeM);
+  webStat("batchAcked", batchAckedSeq);
+  webStat("batchSessions", batchSessions);
+  webStat("replayLines", replayLines);
+  webStat("motion", motionState);
+#ifdef PIPE_FULL
+  webStat("ttffSec", aidTtff);
+  webStat("cn0Median", sigLastMedian);
+  webStat("satsUsed", (long)(sigLastUsed + 0.5));
+#endif
+#ifdef PIPE_UPLINK
+  webStat("mqttQueued", mqttPending());
+#endif
+  webStat("webClients", webSocket.count());
+  webStat("webDropped", webDropped);
+}
+
+void webCmd(String str)
+{
+  zprint("Web dashboard "); zprint(webStarted ? "running" : "not started");
+  zprint(", clients "); zprint((int)webSocket.count());
+  zprint(", pushes "); zprint((int)webPushes);
+  zprint(", dropped "); zprint((int)webDropped);
+  zprint(", closed slow "); zprint((int)webKicked);
+  zprint(", refused "); zprintln((int)webRefused);
 }
 
 int setupTelnetDone = false;
 int ntpDone = false;
-char rmcbuf[128]; // temporarily stores $GxRMC messages, log once per minute 
 
 //----------------------------------------------------------------------------
-// setup() - runs one time when the ESP32 boots up
+//        P A R K E D   D E E P   S L E E P
 //----------------------------------------------------------------------------
-void setup() 
+// Parked SLEEPAFTERMIN= minutes with nothing going on - the ESP32 deep
+// sleeps too, state in RTC memory, woken every GPSWAKEMIN= minutes for a
+// look without the full setup().  Needs GPSTYPE=.
+// sleep                          - deep sleep statistics
+#include "SleepService.h"
+
+void sleepReadConfig(char* configFn)
 {
-  ntpDone = false;
-  // Set up the serial port for diagnostic purposes
-  Serial.begin(115200);
-  // output a signon message to diagnostic port
-  Serial.println(SIGNON);
+  if (readKey(configFn, "SLEEPAFTERMIN=", tmpbuf, 63) && (tmpbuf[0] != 0)) sleepAfterMin = atoi(tmpbuf);
+}
 
-  pinMode(LEDPIN,OUTPUT); // init LED comfort pin
+// nothing a deep sleep would cut off
+int sleepIdle()
+{
+  if (telnet.isConnected() || (webStarted && (webSocket.count() > 0))) return false;
+  if (replayIsActive() || batchIsActive() || uploadOnConnect) return false;
+#ifdef PIPE_FULL
+  if (fanRawClients || fanJsonClients || capActive) return false;
+#endif
+#ifdef PIPE_UPLINK
+  if (mqttInflightCount || ((mqttState == MQTTSTATE_UP) && (mqttPending() > 0))) return false; // let the queue drain
+#endif
+  return true;
+}
+
+void sleepCmd(String str)
+{
+  zprint("Deep sleep ");
+  if (sleepAfterMin <= 0) zprint("off (SLEEPAFTERMIN=0)");
+  else { zprint("after "); zprint(sleepAfterMin); zprint(" min parked"); }
+  zprint(", parked "); zprint((int)sleepParkedSec); zprintln("s");
+  zprint(" sleeps "); zprint((int)sleepDeepSleeps);
+  zprint(", fast wakes "); zprint((int)sleepFastWakes);
+  zprint(", slept "); zprint((int)(sleepSleptSec / 60)); zprint(" min");
+  zprint(", last wake to GPS "); zprint((int)sleepWakeMs); zprintln(" ms");
+}
+
+//----------------------------------------------------------------------------
+//        M E M O R Y   B U D G E T
+//----------------------------------------------------------------------------
+// mem                            - static buffers total, heap, task stacks left
+// mem all                        - ... and every buffer in the budget
+#include "MemoryBudget.h"
+
+void memCmd(String str)
+{
+  memReport(str.indexOf("all") > 0);
+}
+
+//----------------------------------------------------------------------------
+//        R E C E I V E R   T O   U P L O A D   C H A I N
+//----------------------------------------------------------------------------
+// What loop() does with each line from the receiver and each fix, as the
+// stages of Pipeline.h - only those of the build variant are compiled in:
+//   (default)         everything
+//   PIPELINE_TRACKER  the log, MQTT and UDP telemetry
+//   PIPELINE_LOGONLY  the log only
+// The services' own settings (MQTTSERVER=, GPS2BAUD= ...) still turn them
+// on and off at run time, within the variant.  A service the variant
+// leaves out isn't compiled in (PIPE_FULL, PIPE_UPLINK around it), its
+// settings aren't read and its command says "Not in this build".
+//
+// pipe [reset]                  - the variant, its stages, static RAM, flash, cycles per fix
+#include "Pipeline.h"
+
+#ifdef PIPE_FULL
+struct CaptureStage : NoStage
+{
+  static const char* name() { return "capture"; }
+  static inline void raw(char* line) { capService(line); } // raw capture, if one is running
+  static unsigned ramBytes() { return sizeof(capBlock); }
+};
+
+struct EchoStage : NoStage
+{
+  static const char* name() { return "echo"; }
+  template <class P> static inline void line(char* line)
+  {
+    if (gpsSerialEcho) Serial.println(line);
+    if (gpsTelnetEcho && telnetConnected) telnet.println(line);
+  }
+};
+
+struct AidStage : NoStage
+{
+  static const char* name() { return "aid"; }
+  template <class P> static inline void line(char* line) { aidLine(line); } // TTFF, position saved for the next boot
+  template <class P> static inline void service() { aidService(); } // aiding messages to the receiver
+  static unsigned ramBytes() { return sizeof(aidTx); }
+};
+#endif
+
+struct MotionStage : NoStage
+{
+  static const char* name() { return "motion"; }
+  template <class P> static inline void line(char* line) { motionLine(line); } // speed for the motion state
+  template <class P> static inline void service() { motionTxService(); } // rate / sleep commands to the receiver
+  static unsigned ramBytes() { return sizeof(motionTx); }
+};
+
+#ifdef PIPE_FULL
+struct SignalStage : NoStage
+{
+  static const char* name() { return "signal"; }
+  template <class P> static inline void line(char* line) { signalLine(line); } // GSV/GSA statistics
+  static inline void minute() { signalMinute(); } // a signal record every SIGNALMIN minutes
+  static inline void hour() { signalFlush(); }
+  static unsigned ramBytes() { return sizeof(sigCn0Hist); }
+};
+
+// with GPS2BAUD=, the fix is the fusion's, once per epoch ...
+struct FuseStage : NoStage
+{
+  static const char* name() { return "fuse"; }
+  template <class P> static inline void line(char* line) { if (fuseEnabled) fuseLine(0, line); }
+  template <class P> static inline void service()
+  {
+    if (!fuseEnabled) return;
+    char* line2 = gps2Service();
+    if (line2 != NULL) fuseLine(1, line2);
+    char* rmc = fuseService(); // the epoch's best (or fused) fix
+    if (rmc != NULL) P::fix(rmc);
+  }
+  static inline bool fused() { return fuseEnabled; }
+  static unsigned ramBytes() { return sizeof(fuseRx) + sizeof(fuseRmcOut); }
+};
+#endif
+
+// ... otherwise every $GxRMC from the receiver
+struct RmcStage : NoStage
+{
+  static const char* name() { return "rmc"; }
+  template <class P> static inline void line(char* line)
+  {
+    if (!P::fused() &&
+        (line[1] == 'G') &&
+        (line[3] == 'R') &&
+        (line[4] == 'M') &&
+        (line[5] == 'C')) P::fix(line);
+  }
+  template <class P> static inline void fix(char* rmc)
+  {
+    if (strlen(rmc) < sizeof(rmcbuf)) strcpy(rmcbuf, rmc); // save for minute by minute logging
+  }
+  static unsigned ramBytes() { return sizeof(rmcbuf); }
+};
+
+struct LogStage : NoStage
+{
+  static const char* name() { return "log"; }
+  static inline void minute()
+  {
+    if (!motionParked()) // log position if available once per minute, not the same one while parked
+    {
+      gpsLogLine(rmcbuf);
+      segAddRmc(rmcbuf); // and its columns
+    }
+  }
+  static inline void hour()
+  {
+    gpsLogHour(); // flush log hourly, or a batch every LOGFLUSHHOURS with PSRAM
+    segFlush();
+  }
+  template <class P> static inline void service() { gpsLogService(); } // a batch going out
+  static unsigned ramBytes() { return sizeof(logbuffer) + sizeof(segBuf); }
+};
+
+#ifdef PIPE_UPLINK
+struct MqttStage : NoStage
+{
+  static const char* name() { return "mqtt"; }
+  template <class P> static inline void fix(char* rmc) { mqttAddFix(rmc); } // every fix goes to MQTT, in batches
+  template <class P> static inline void service() { mqttService(); } // MQTT publishing, if configured
+  static unsigned ramBytes() { return sizeof(mqttBatch) + sizeof(mqttInflight); }
+};
 
+struct TelemetryStage : NoStage
+{
+  static const char* name() { return "telemetry"; }
+  template <class P> static inline void fix(char* rmc) { telemetryFix(rmc); } // every TELEMETRYSEC to the UDP collector
+};
+#endif
+
+#ifdef PIPE_FULL
+struct FanoutStage : NoStage
+{
+  static const char* name() { return "fanout"; }
+  template <class P> static inline void line(char* line)
+  {
+    if (!P::fused() || !nmeaIsType(line, "RMC")) fanoutLine(line); // fused, the RMC is the fusion's
+  }
+  template <class P> static inline void fix(char* rmc) { if (P::fused()) fanoutLine(rmc); }
+  template <class P> static inline void service() { fanoutService(); } // NMEA fan-out clients
+  static unsigned ramBytes() { return sizeof(fanClients); }
+};
+#endif
+
+#if defined(PIPELINE_LOGONLY)
+typedef GpsChain<MotionStage, RmcStage, LogStage> GpsPipeline;
+#elif defined(PIPELINE_TRACKER)
+typedef GpsChain<MotionStage, RmcStage, LogStage, MqttStage, TelemetryStage> GpsPipeline;
+#else
+typedef GpsChain<CaptureStage, EchoStage, AidStage, MotionStage, SignalStage, FuseStage, RmcStage,
+                 LogStage, MqttStage, TelemetryStage, FanoutStage> GpsPipeline;
+#endif
+
+void pipeNotInBuild()
+{
+  zprintln("Not in this build (" PIPE_VARIANT ", see pipe)");
+}
+
+void pipeCmd(String str)
+{
+  typedef GpsPipeline::Chain C;
+  if (str.indexOf("reset") > 0)
+  {
+    pipeCycles = 0;
+    pipeMaxCycles = 0;
+    pipeLines = 0;
+    pipeFixes = 0;
+  }
+  zprint("Chain " PIPE_VARIANT ":");
+  for (int i = 0; i < C::stages(); i++)
+  {
+    zprint(" "); zprint((char*)C::stageName(i));
+    if (C::stageRam(i) > 0) { zprint("("); zprint((int)C::stageRam(i)); zprint(")"); }
+  }
+  zprintln("");
+  zprint(" static RAM "); zprint((int)MEM_STATIC_TOTAL); zprint(" bytes in this build's buffers (mem all)");
+  zprint(", sketch "); zprint((int)(ESP.getSketchSize() / 1024));
+  zprint(" KB, "); zprint((int)(ESP.getFreeSketchSpace() / 1024)); zprintln(" KB flash free");
+  zprint(" lines "); zprint((int)pipeLines); zprint(", fixes "); zprint((int)pipeFixes);
+  if (pipeFixes > 0)
+  {
+    uint32_t perFix = (uint32_t)(pipeCycles / pipeFixes);
+    zprint(", "); zprint((int)perFix); zprint(" cycles per fix (");
+    zprint((int)(perFix / ESP.getCpuFreqMHz())); zprint(" us), max "); zprint((int)pipeMaxCycles);
+  }
+  zprintln("");
+}
+
+// after a fast wake:  GPS, the motion check and the log only, until it's
+// parked again (back to sleep) or it has moved (the rest of setup())
+void setupResume();
+void sleepCheckLoop()
+{
+  char* line = gpsService();
+  if (line != NULL)
+  {
+    motionLine(line);
+    if ((line[1] == 'G') && (line[3] == 'R') && (line[4] == 'M') && (line[5] == 'C') && (strlen(line) < sizeof(rmcbuf)))
+      strcpy(rmcbuf, line);
+  }
+  motionTxService();
+  if (secondDetector())
+  {
+    motionService();
+    if (motionState == MOTION_PARKED)
+    {
+      segFlush(); // a fix from a minute it looked like moving
+      sleepEnter(); // still where it was
+    }
+    else if (motionState != MOTION_WAKING) setupResume();
+  }
+  if (minuteDetector())
+  {
+    if (!motionParked())
+    {
+      gpsLogLine(rmcbuf);
+      segAddRmc(rmcbuf);
+    }
+  }
+  if (hourDetector())
+  {
+    gpsLogFlush();
+    segFlush();
+  }
+  dayDetector(); // the daily NTP comes with WiFi after resuming
+}
+
+//----------------------------------------------------------------------------
+// mount the file system - false if it can't be
+//----------------------------------------------------------------------------
+int fileSystemMount()
+{
   //----------- initialize the file system ---------------
   // can be either on an SD card or use the built-in flash
   // with the SPI flash file service (SPIFFS)
@@ -695,13 +1738,45 @@ void setup()
   if(!SPIFFS.begin(true))
   {
     Serial.println("An Error has occurred while mounting SPIFFS");
-    return;
+    return false;
   }
   else
   {
     Serial.println("SPIFFS mounted");
   }
 #endif
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// setup() - runs one time when the ESP32 boots up
+//----------------------------------------------------------------------------
+void setup() 
+{
+  ntpDone = false;
+  // Set up the serial port for diagnostic purposes
+  Serial.begin(115200);
+  // output a signon message to diagnostic port
+  Serial.println(SIGNON);
+
+  pinMode(LEDPIN,OUTPUT); // init LED comfort pin
+
+  if (!fileSystemMount()) return;
+
+  // woke from a park sleep with the state in RTC memory - the GPS and the
+  // log carry on, the rest waits for setupResume() once it has moved
+  if (sleepFastWake())
+  {
+    logInit(EVENTFN, true);
+    gpsInit(baudRate);
+#ifdef PIPE_FULL
+    aidBootSent = aidTimeSent = true; // receiver kept its fix in backup, nothing to aid
+    aidTtff = 0;
+#endif
+    motionSetState(MOTION_WAKING);
+    sleepWakeMs = millis();
+    return;
+  }
 
   // initialize the RTC, uses timer 0
   rtc.setTime(00,00,00, 1, 1, 2023); // default time 00:00:00 1/1/2023
@@ -715,6 +1790,19 @@ void setup()
   {
     logMessage("Unable to read config file");
   }
+  geofenceReadConfig(CONFIGFN);
+  motionReadConfig(CONFIGFN);
+  sleepReadConfig(CONFIGFN);
+#ifdef PIPE_FULL
+  fuseReadConfig(CONFIGFN);
+  signalReadConfig(CONFIGFN);
+  capReadConfig(CONFIGFN);
+#endif
+#ifdef PIPE_UPLINK
+  telReadConfig(CONFIGFN);
+  mqttInit(); // picks up batches queued before a reboot
+#endif
+  gpsLogReadConfig(CONFIGFN);
 
   schedulerInit(); // initialize the scheduler used by the loop() function
 
@@ -725,6 +1813,14 @@ void setup()
 
   // Set up serial port for connection to GPS module
   gpsInit(baudRate); 
+#ifdef PIPE_FULL
+  aidInit(gpsType); // hot-start aiding, TTFF from here;  GPSTYPE= for the motion stage too
+  fuseStart(); // second receiver, if there is one
+  signalInit();
+#else
+  aidType = aidTypeFromName(gpsType); // the motion stage's commands
+#endif
+  segInit();
 
   rmcbuf[0] = '\0';
   
@@ -735,10 +1831,44 @@ void setup()
   //log_d("Free heap: %d", ESP.getFreeHeap());
   //("Total PSRAM: %d", ESP.getPsramSize());
   //log_d("Free PSRAM: %d", ESP.getFreePsram());
+  if (logBuf != logbuffer) logMessage("Log buffer in PSRAM");
   
   Serial.print("\n>");  // initial serial prompt
 }
 
+//----------------------------------------------------------------------------
+// the part of setup() a fast wake skipped, once it has moved off
+//----------------------------------------------------------------------------
+void setupResume()
+{
+  sleepChecking = false;
+  if (!readConfigFile(CONFIGFN))
+  {
+    logMessage("Unable to read config file");
+  }
+  geofenceReadConfig(CONFIGFN);
+  motionReadConfig(CONFIGFN);
+  sleepReadConfig(CONFIGFN);
+#ifdef PIPE_FULL
+  fuseReadConfig(CONFIGFN);
+  fuseStart();
+  signalReadConfig(CONFIGFN);
+  capReadConfig(CONFIGFN);
+#endif
+#ifdef PIPE_UPLINK
+  telReadConfig(CONFIGFN);
+  mqttInit();
+#endif
+  gpsLogReadConfig(CONFIGFN);
+#ifdef PIPE_FULL
+  aidLoad(); // the saved position, kept up to date from here
+#endif
+  gpsLogUsePsram(); // the journal moves there
+  wifiConnect();
+  setupTelnetDone = false;
+  sioInit();
+}
+
 //----------------------------------------------------------------------------
 // Main repeatitive tasks go here.  This is called over and over endlessly
 // once setup() has completed.
@@ -751,26 +1881,45 @@ void loop()
   //----------------------------
   // high rate tasks here
   //----------------------------
-  char* line = gpsService();
-  if (line != NULL)
+  if (sleepChecking)
   {
-    if (gpsSerialEcho) Serial.println(line);
-    if (gpsTelnetEcho && telnetConnected) telnet.println(line);
-    // $GxRMC
-    //Serial.print(line[0]); Serial.print(line[1]); Serial.print(line[3]); Serial.print(line[4]); Serial.println(line[5]);    
-    if ((line[1] == 'G') &&
-        (line[3] == 'R') &&
-        (line[4] == 'M') &&
-        (line[5] == 'C'))  strcpy(rmcbuf,line); // save for minute by minute logging
+    sleepCheckLoop(); // just woke up parked, nothing else yet
+    return;
   }
+  char* line = gpsService();
+  GpsPipeline::raw(line);
+  if (line != NULL) GpsPipeline::line(line); // echo, aiding, motion, signal, the fix, fan-out ...
+  GpsPipeline::service(); // ... and their services
   telnet.loop(); // process any telnet traffic
+  replayService(); // send any replay lines that are due
+  batchService(); // batched-ack upload, if one is running
+  webService(rmcbuf); // push to dashboard browsers, if any
     
   //----------------------------
   // tasks executed once per second
   //----------------------------
   if (secondDetector())
   {
+    motionService(); // receiver rate and sleep from the motion state
+#ifdef PIPE_FULL
+    if (fuseEnabled) fuseAsleep(0, motionAsleep()); // not out, in standby
+#endif
+    if (sleepWanted(sleepIdle()))
+    {
+#ifdef PIPE_FULL
+      signalFlush(); // RAM is gone in a deep sleep
+#endif
+      segFlush();
+      sleepEnter(); // parked long enough, ESP32 too
+    }
+    geofenceWifiService(); // WiFi on only near a known AP
     wifiService(); // service the wifi connection controller
+    if (uploadOnConnect && wifiIsConnected())
+    {
+      uploadOnConnect = false;
+      gpsLogFlush(); // the trip so far goes too
+      ftpCmd("ftp");
+    }
     
     if (wifiIsConnected() && !ntpStarted() && (ntpAttempts == 0)) ntpStart(); // first NTP request
     ntpService();
@@ -784,8 +1933,14 @@ void loop()
     {
       setupTelnetDone = true;
       setupTelnet();
+      webInit();
+#ifdef PIPE_FULL
+      fanoutInit();
+#endif
     }
 
+    webCleanup();
+
     char* sioinputline = sioService();
     if (sioinputline != NULL) handleShellCommand(String(sioinputline));
   }
@@ -795,7 +1950,7 @@ void loop()
   //----------------------------
   if (minuteDetector())
   {
-    gpsLogLine(rmcbuf); // log position if available once per minute
+    GpsPipeline::minute(); // log position, signal record
   }
 
   //----------------------------
@@ -803,7 +1958,7 @@ void loop()
   //----------------------------
   if (hourDetector())
   {
-    gpsLogFlush(); // flush log hourly
+    GpsPipeline::hour(); // flush the logs
   }
 
   //----------------------------
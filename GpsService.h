@@ -0,0 +1,181 @@
+// Initial version 18-Oct-2026, split out of GpsLogger.ino
+//----------------------------------------------------------------------------
+// GPS module serial input - assembles NMEA lines from the GPS port
+//----------------------------------------------------------------------------
+// Call gpsInit() from setup() and gpsService() from the high rate part of
+// loop().  gpsService() returns a complete line (without CR/LF) or NULL.
+//
+// Binary frames from the receiver - u-blox UBX (B5 62) and CASIC (BA CE) -
+// never go into a line:  they are collected whole into gpsBinFrame, and
+// gpsBinLen is set to the frame length (sync bytes and checksum included)
+// once one is complete.  Whoever wants them clears gpsBinLen; the next
+// frame overwrites it either way.
+//
+// More than one service writes to the receiver (aiding, motion settings).
+// A frame from one landing inside a frame from the other spoils both, so
+// a writer takes the port with gpsTxClaim() before the first byte of a
+// frame and gives it back with gpsTxRelease() once a frame (or a run of
+// them) has gone out whole.  Nobody else starts writing in between.
+//
+// A second receiver (GPS2PORT defined) gets its own line assembler,
+// gps2Init() / gps2Service().  NMEA only - nothing is ever sent to it, so
+// no binary frames come back.
+//
+// Needs GPSPORT, GPSESP_RXD_PIN, GPSESP_TXD_PIN defined
+// (and GPS2ESP_RXD_PIN, GPS2ESP_TXD_PIN with GPS2PORT)
+
+#define GPSBUFLEN (512)
+#define GPSRXBUF (2048)  /* UART buffer - a flash write (raw capture) at 115200 doesn't lose bytes */
+char gpsRxBuf[GPSBUFLEN+2];
+char gpsRxLine[GPSBUFLEN];
+int gpsBufPtr = 0;
+int gpsLineAvail = 0;
+
+#define GPSBINLEN (256)
+uint8_t gpsBinFrame[GPSBINLEN];
+int gpsBinPtr = 0;     // bytes of the frame being collected, 0 = none
+int gpsBinWant = 0;    // its full length, once the header is in
+int gpsBinLen = 0;     // length of the complete frame in gpsBinFrame
+unsigned long gpsBinFrames = 0;
+
+#define GPSTX_NONE   (0)
+#define GPSTX_AID    (1)   /* GpsAidService.h */
+#define GPSTX_MOTION (2)   /* MotionService.h */
+int gpsTxOwner = GPSTX_NONE;   // who is part way through writing to GPSPORT
+unsigned long gpsTxWaits = 0;  // times a writer found the port taken
+
+void gpsInit(long baudrate)
+{
+  GPSPORT.setRxBufferSize(GPSRXBUF); // before begin()
+  GPSPORT.begin(baudrate, SERIAL_8N1, GPSESP_RXD_PIN, GPSESP_TXD_PIN);
+  gpsBufPtr = 0;
+  gpsLineAvail=0;
+  gpsBinPtr = 0;
+  gpsBinLen = 0;
+  gpsTxOwner = GPSTX_NONE;
+}
+
+// may who write to GPSPORT now?  Takes the port if nobody has it
+int gpsTxClaim(int who)
+{
+  if (gpsTxOwner == GPSTX_NONE) gpsTxOwner = who;
+  if (gpsTxOwner != who)
+  {
+    gpsTxWaits++;
+    return false;
+  }
+  return true;
+}
+
+// who's done, its frames have gone out whole, the port is free again
+void gpsTxRelease(int who)
+{
+  if (gpsTxOwner == who) gpsTxOwner = GPSTX_NONE;
+}
+
+// take byte c if it belongs to a binary frame, return true if it did
+int gpsBinByte(uint8_t c)
+{
+  if (gpsBinPtr == 0)
+  {
+    if ((c != 0xB5) && (c != 0xBA)) return false;
+    gpsBinFrame[gpsBinPtr++] = c;
+    gpsBinWant = 0;
+    return true;
+  }
+  if (gpsBinPtr == 1)
+  {
+    if (((gpsBinFrame[0] == 0xB5) && (c != 0x62)) || ((gpsBinFrame[0] == 0xBA) && (c != 0xCE)))
+    {
+      gpsBinPtr = 0; // not a frame after all
+      return false;
+    }
+  }
+  gpsBinFrame[gpsBinPtr++] = c;
+  if (gpsBinPtr == 6)
+  {
+    // UBX: class, id, length, payload, 2 byte checksum
+    // CASIC: length, class, id, payload, 4 byte checksum
+    if (gpsBinFrame[0] == 0xB5) gpsBinWant = 6 + (gpsBinFrame[4] | (gpsBinFrame[5] << 8)) + 2;
+    else gpsBinWant = 6 + (gpsBinFrame[2] | (gpsBinFrame[3] << 8)) + 4;
+    if (gpsBinWant > GPSBINLEN)
+    {
+      gpsBinPtr = 0; // too big for us, the rest just fails as NMEA
+      return true;
+    }
+  }
+  if ((gpsBinWant > 0) && (gpsBinPtr >= gpsBinWant))
+  {
+    gpsBinLen = gpsBinPtr;
+    gpsBinPtr = 0;
+    gpsBinFrames++;
+  }
+  return true;
+}
+
+char* gpsService()
+{
+  if (GPSPORT.available())
+  {
+    int raw = GPSPORT.read();
+    if ((raw < 0) || gpsBinByte((uint8_t)raw)) return NULL;
+    char c = raw & 0x7f; // 7 bits are important
+    if ((c == 10) || (c == 13)) // if it's end-of-line
+    {
+      if (gpsBufPtr > 0) // if the line is not empty
+      {
+        gpsRxBuf[gpsBufPtr]=0; // copy to gpsRxLine
+        strcpy(gpsRxLine, gpsRxBuf); // copy received line
+        gpsLineAvail++; // set flag indicating line is available
+        gpsBufPtr = 0;
+        return &gpsRxLine[0];
+      }
+    }
+    else
+    {
+      gpsRxBuf[gpsBufPtr] = c;
+      if (gpsBufPtr < (GPSBUFLEN-1)) gpsBufPtr++;
+    }
+  }
+  return NULL;
+}
+
+#ifdef GPS2PORT
+char gps2RxBuf[GPSBUFLEN+2];
+char gps2RxLine[GPSBUFLEN];
+int gps2BufPtr = 0;
+unsigned long gps2Lines = 0;
+
+void gps2Init(long baudrate)
+{
+  GPS2PORT.begin(baudrate, SERIAL_8N1, GPS2ESP_RXD_PIN, GPS2ESP_TXD_PIN);
+  gps2BufPtr = 0;
+}
+
+char* gps2Service()
+{
+  if (GPS2PORT.available())
+  {
+    int raw = GPS2PORT.read();
+    if (raw < 0) return NULL;
+    char c = raw & 0x7f;
+    if ((c == 10) || (c == 13))
+    {
+      if (gps2BufPtr > 0)
+      {
+        gps2RxBuf[gps2BufPtr] = 0;
+        strcpy(gps2RxLine, gps2RxBuf);
+        gps2Lines++;
+        gps2BufPtr = 0;
+        return &gps2RxLine[0];
+      }
+    }
+    else
+    {
+      gps2RxBuf[gps2BufPtr] = c;
+      if (gps2BufPtr < (GPSBUFLEN-1)) gps2BufPtr++;
+    }
+  }
+  return NULL;
+}
+#endif
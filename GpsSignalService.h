@@ -0,0 +1,351 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Satellite signal statistics - C/N0 per satellite and constellation from
+// GSV, satellites used and DOP from GSA
+//----------------------------------------------------------------------------
+// GSV is most of what comes over the UART and nothing else looks at it.
+// signalLine() takes each line from gpsService(), skips anything that
+// isn't GSV/GSA on the sentence type alone, and walks the fields once
+// into fixed tables - no allocation, no sorting:
+//   sigSats[system][prn]   C/N0 sum and count this interval, per satellite
+//   sigCn0Hist[dB-Hz]      every C/N0 sample this interval, for min/median/max
+//   per system             satellites in view / tracked (C/N0 > 0), summed
+//                          per complete GSV cycle (SBAS with GPS, it comes
+//                          in $GPGSV)
+//   GSA                    satellites used per epoch (a receiver's GSAs for
+//                          one epoch come one after another, one per
+//                          system) and PDOP/HDOP/VDOP
+// Dual frequency receivers report each satellite once per signal (NMEA
+// 4.10 signal id, the last GSV field) - only the L1/E1 one is counted.
+//
+// Every sigIntervalMin minutes (signalMinute() from the minute tick) the
+// interval becomes one record, buffered and appended to SIGNALFN with
+// the hourly log flush (signalFlush()):
+//   2023/11/15,09:50:00,SIG,18,34,45,5520,8,9.4,1.8,0.9,1.5,G9/11 R5/7 E4/6 B3/5
+//   time, C/N0 min, median, max (dB-Hz), samples, used min, used mean,
+//   PDOP, HDOP, VDOP (means), tracked/in view per system (mean per cycle)
+// An interval with no GSV or GSA at all (receiver asleep) has no record.
+//
+// Needs nmeaChecksumOk() (NmeaService.h), rtc, fileSystem, SIGNALFN
+
+#define SIG_SYSTEMS (6)      /* GPS, GLONASS, Galileo, BeiDou, QZSS, other (SBAS, NavIC) */
+#define SIG_PRNS (64)        /* per system */
+#define SIG_CN0MAX (64)      /* dB-Hz, 0..63 */
+#define SIG_SATCAP (60000)   /* per satellite sum stops here, the mean stays right */
+#define SIG_RECORDS (8)
+#define SIG_RECLEN (128)
+
+// RINEX letters, and the NMEA 4.10 signal id of L1 C/A, E1, B1I...
+const char sigSystemChar[SIG_SYSTEMS] = { 'G', 'R', 'E', 'B', 'Q', 'S' };
+const uint8_t sigPrimarySignal[SIG_SYSTEMS] = { 1, 1, 7, 1, 1, 1 };
+
+typedef struct
+{
+  uint16_t cn0Sum;
+  uint16_t cn0N;
+} SigSat;
+
+SigSat sigSats[SIG_SYSTEMS][SIG_PRNS];
+uint32_t sigCn0Hist[SIG_CN0MAX];
+unsigned long sigSamples = 0;
+
+// GSV cycles:  the one being received, and the interval's sums
+int sigCycleView[SIG_SYSTEMS], sigCycleTracked[SIG_SYSTEMS];
+unsigned long sigViewSum[SIG_SYSTEMS], sigTrackedSum[SIG_SYSTEMS], sigCycles[SIG_SYSTEMS];
+
+// GSA
+int sigInGsa = false;        // the last line was a GSA
+int sigUsedEpoch = 0;        // satellites used, this epoch's GSAs so far
+unsigned long sigUsedSum = 0, sigUsedN = 0;
+int sigUsedMin = 99;
+float sigPdopSum = 0, sigHdopSum = 0, sigVdopSum = 0;
+unsigned long sigDopN = 0;
+
+int sigIntervalMin = 10;     // SIGNALMIN, 0 = no records
+int sigMinutes = 0;
+unsigned long sigLines = 0;  // GSV/GSA lines this interval
+
+// records waiting for the flush
+char sigRecords[SIG_RECORDS][SIG_RECLEN];
+int sigRecordCount = 0;
+
+// the last record, for the signal command and the dashboard
+int sigLastMin = 0, sigLastMedian = 0, sigLastMax = 0;
+float sigLastUsed = 0, sigLastHdop = 0;
+
+// statistics
+unsigned long sigGsvLines = 0, sigGsaLines = 0, sigBadLines = 0, sigRecordsMade = 0;
+
+void signalFlush();
+
+//----------------------------------------------------------
+void signalClear()
+{
+  memset(sigSats, 0, sizeof(sigSats));
+  memset(sigCn0Hist, 0, sizeof(sigCn0Hist));
+  memset(sigViewSum, 0, sizeof(sigViewSum));
+  memset(sigTrackedSum, 0, sizeof(sigTrackedSum));
+  memset(sigCycles, 0, sizeof(sigCycles));
+  sigSamples = 0;
+  sigUsedSum = sigUsedN = 0;
+  sigUsedMin = 99;
+  sigPdopSum = sigHdopSum = sigVdopSum = 0;
+  sigDopN = 0;
+  sigLines = 0;
+}
+
+void signalInit()
+{
+  signalClear();
+  memset(sigCycleView, 0, sizeof(sigCycleView));
+  memset(sigCycleTracked, 0, sizeof(sigCycleTracked));
+  sigInGsa = false;
+  sigUsedEpoch = 0;
+  sigMinutes = 0;
+  sigRecordCount = 0;
+}
+
+// next field as an int, -1 if empty;  *pp left on the ',' or '*' after it
+int sigInt(const char** pp)
+{
+  const char* p = *pp;
+  int v = -1;
+  while ((*p >= '0') && (*p <= '9')) v = ((v < 0) ? 0 : v * 10) + (*p++ - '0');
+  while (*p && (*p != ',') && (*p != '*')) p++; // a decimal part, not wanted
+  *pp = p;
+  return v;
+}
+
+float sigFloat(const char** pp)
+{
+  const char* p = *pp;
+  float v = (*p == ',' || *p == '*') ? -1 : atof(p);
+  while (*p && (*p != ',') && (*p != '*')) p++;
+  *pp = p;
+  return v;
+}
+
+// system from the talker ($GP, $GL, ...), -1 = by PRN ($GN)
+int sigTalkerSystem(const char* line)
+{
+  if (line[1] == 'G')
+  {
+    switch (line[2])
+    {
+      case 'P': return 0;
+      case 'L': return 1;
+      case 'A': return 2;
+      case 'B': return 3;
+      case 'Q': return 4;
+      case 'I': return 5;
+    }
+    return -1;
+  }
+  if ((line[1] == 'B') && (line[2] == 'D')) return 3;
+  return -1;
+}
+
+// system and PRN slot (0..SIG_PRNS-1) of a satellite, false if it fits nowhere
+int sigSlot(int sys, int prn, int* s, int* slot)
+{
+  if (prn <= 0) return false;
+  if ((sys == 0) || (sys < 0))
+  {
+    if (prn <= 32) { *s = 0; *slot = prn - 1; return true; }
+    if (prn <= 64) { *s = 5; *slot = prn - 33; return true; }         // SBAS
+    if ((prn <= 96) && (sys < 0)) { *s = 1; *slot = prn - 65; return true; }
+    if ((prn >= 193) && (prn <= 202)) { *s = 4; *slot = prn - 193; return true; } // QZSS as GP
+    return false;
+  }
+  if ((sys == 1) && (prn > 64)) prn -= 64;   // GLONASS 65..96
+  if ((sys == 2) && (prn > 300)) prn -= 300; // some Galileo 301..336
+  if ((sys == 3) && (prn > 200)) prn -= 200; // some BeiDou 201..263
+  if ((sys == 4) && (prn > 192)) prn -= 192;
+  if (prn > SIG_PRNS) return false;
+  *s = sys;
+  *slot = prn - 1;
+  return true;
+}
+
+//----------------------------------------------------------
+// $GxGSV,total,num,inview,prn,elev,azim,cn0,... [,signal]*hh
+void signalGsv(const char* line)
+{
+  int f[21];
+  int n = 0;
+  const char* p = line + 7;
+  while (n < 21)
+  {
+    f[n++] = sigInt(&p);
+    if (*p != ',') break;
+    p++;
+  }
+  if (n < 3) return;
+  int talker = sigTalkerSystem(line);
+  int sats = (n - 3) / 4;
+  if ((n - 3) % 4 == 1) // NMEA 4.10 signal id
+  {
+    int sysForSignal = (talker < 0) ? 0 : talker;
+    if ((f[n-1] >= 0) && (f[n-1] != sigPrimarySignal[sysForSignal])) return;
+  }
+  int cycleSys = (talker < 0) ? 0 : talker; // $GNGSV cycles count as GPS's
+  if (f[1] == 1)
+  {
+    sigCycleView[cycleSys] = 0;
+    sigCycleTracked[cycleSys] = 0;
+  }
+  for (int i = 0; i < sats; i++)
+  {
+    int s, slot;
+    int cn0 = f[3 + i*4 + 3];
+    if (!sigSlot(talker, f[3 + i*4], &s, &slot)) continue;
+    sigCycleView[cycleSys]++;
+    if (cn0 <= 0) continue;
+    sigCycleTracked[cycleSys]++;
+    if (cn0 >= SIG_CN0MAX) cn0 = SIG_CN0MAX - 1;
+    sigCn0Hist[cn0]++;
+    sigSamples++;
+    SigSat* st = &sigSats[s][slot];
+    if (st->cn0Sum < SIG_SATCAP)
+    {
+      st->cn0Sum += cn0;
+      st->cn0N++;
+    }
+  }
+  if ((f[0] > 0) && (f[1] == f[0])) // the cycle's last message
+  {
+    sigViewSum[cycleSys] += sigCycleView[cycleSys];
+    sigTrackedSum[cycleSys] += sigCycleTracked[cycleSys];
+    sigCycles[cycleSys]++;
+  }
+}
+
+// $GxGSA,mode,fix,prn x12,pdop,hdop,vdop[,system]*hh
+void signalGsa(const char* line)
+{
+  const char* p = line + 7;
+  int field = 1;
+  int used = 0;
+  float dop[3] = { -1, -1, -1 };
+  while (*p && (*p != '*'))
+  {
+    if ((field >= 3) && (field <= 14)) { if (sigInt(&p) > 0) used++; }
+    else if ((field >= 15) && (field <= 17)) dop[field - 15] = sigFloat(&p);
+    else sigInt(&p);
+    if (*p != ',') break;
+    p++;
+    field++;
+  }
+  if (!sigInGsa) sigUsedEpoch = 0; // first GSA of an epoch
+  sigUsedEpoch += used;
+  if ((dop[0] > 0) && (dop[1] > 0) && (dop[2] > 0) && (dop[0] < 99))
+  {
+    sigPdopSum += dop[0];
+    sigHdopSum += dop[1];
+    sigVdopSum += dop[2];
+    sigDopN++;
+  }
+}
+
+// the epoch's GSAs are all in once another sentence comes
+void signalGsaDone()
+{
+  sigInGsa = false;
+  sigUsedSum += sigUsedEpoch;
+  sigUsedN++;
+  if (sigUsedEpoch < sigUsedMin) sigUsedMin = sigUsedEpoch;
+}
+
+//----------------------------------------------------------
+// every line from gpsService()
+void signalLine(const char* line)
+{
+  int gsa = (line[3] == 'G') && (line[4] == 'S') && (line[5] == 'A');
+  int gsv = (line[3] == 'G') && (line[4] == 'S') && (line[5] == 'V');
+  if (sigInGsa && !gsa) signalGsaDone();
+  if ((!gsa && !gsv) || (line[0] != '$') || (line[6] != ',')) return;
+  if (!nmeaChecksumOk(line))
+  {
+    sigBadLines++;
+    return;
+  }
+  sigLines++;
+  if (gsv)
+  {
+    sigGsvLines++;
+    signalGsv(line);
+  }
+  else
+  {
+    sigGsaLines++;
+    signalGsa(line);
+    sigInGsa = true;
+  }
+}
+
+//----------------------------------------------------------
+// the interval's C/N0 sample at rank (0 = the lowest)
+int signalCn0At(unsigned long rank)
+{
+  unsigned long seen = 0;
+  for (int i = 0; i < SIG_CN0MAX; i++)
+  {
+    seen += sigCn0Hist[i];
+    if (seen > rank) return i;
+  }
+  return 0;
+}
+
+// per satellite mean C/N0 this interval, 0 = not tracked
+int signalSatCn0(int sys, int slot)
+{
+  SigSat* st = &sigSats[sys][slot];
+  return st->cn0N ? (st->cn0Sum + st->cn0N / 2) / st->cn0N : 0;
+}
+
+void signalRecord()
+{
+  if (sigLines == 0) return; // receiver asleep, nothing heard
+  if (sigInGsa) signalGsaDone();
+  sigLastMin = sigSamples ? signalCn0At(0) : 0;
+  sigLastMedian = sigSamples ? signalCn0At((sigSamples - 1) / 2) : 0;
+  sigLastMax = sigSamples ? signalCn0At(sigSamples - 1) : 0;
+  sigLastUsed = sigUsedN ? (float)sigUsedSum / sigUsedN : 0;
+  sigLastHdop = sigDopN ? sigHdopSum / sigDopN : 0;
+
+  if (sigRecordCount >= SIG_RECORDS) signalFlush();
+  char* r = sigRecords[sigRecordCount++];
+  int n = snprintf(r, SIG_RECLEN, "%s,SIG,%d,%d,%d,%lu,%d,%.1f,%.1f,%.1f,%.1f,",
+    rtc.getTime("%Y/%m/%d,%H:%M:%S").c_str(), sigLastMin, sigLastMedian, sigLastMax, sigSamples,
+    sigUsedN ? sigUsedMin : 0, sigLastUsed, sigDopN ? sigPdopSum / sigDopN : 0, sigLastHdop,
+    sigDopN ? sigVdopSum / sigDopN : 0);
+  for (int s = 0; (s < SIG_SYSTEMS) && (n < SIG_RECLEN - 12); s++)
+  {
+    if (sigCycles[s] == 0) continue;
+    n += snprintf(r + n, SIG_RECLEN - n, "%s%c%lu/%lu", (r[n-1] == ',') ? "" : " ", sigSystemChar[s],
+      (sigTrackedSum[s] + sigCycles[s] / 2) / sigCycles[s], (sigViewSum[s] + sigCycles[s] / 2) / sigCycles[s]);
+  }
+  sigRecordsMade++;
+  signalClear();
+}
+
+// from the minute tick
+void signalMinute()
+{
+  if (sigIntervalMin <= 0) return;
+  if (++sigMinutes < sigIntervalMin) return;
+  sigMinutes = 0;
+  signalRecord();
+}
+
+void signalFlush()
+{
+  if (sigRecordCount == 0) return;
+  File file = fileSystem.open(SIGNALFN, FILE_APPEND);
+  if (file)
+  {
+    for (int i = 0; i < sigRecordCount; i++) file.println(sigRecords[i]);
+    file.close();
+  }
+  sigRecordCount = 0;
+}
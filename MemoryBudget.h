@@ -0,0 +1,196 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Memory budget - the static buffers in one table, checked at compile time
+//----------------------------------------------------------------------------
+// MEM_BUFFERS lists every global buffer worth counting, with what it's
+// for.  The build fails (static_assert) if
+//   - the lot is over MEM_STATIC_BUDGET of the ~320 KB of DRAM - the rest
+//     is the heap WiFi, lwIP and TLS need (a TLS handshake alone takes
+//     ~40 KB), and the stacks;
+//   - one buffer is copied into another that can't hold it (a fix into
+//     rmcbuf, rmcbuf into the log buffer, a logged line into ftpPut()'s
+//     line buffer on the stack, the sleep journal back into the log
+//     buffer ...);
+//   - a buffer on loop()'s stack is too big a share of it.
+// So a buffer can be made bigger - LOGBUFFERSIZE, say, for fewer flash
+// writes - and the build says if that doesn't fit.  The checks only run in
+// the ESP32 build of the sketch; the host tools don't include this file.
+//
+// The table follows the build variant:  the buffers of the services a
+// PIPELINE_TRACKER / PIPELINE_LOGONLY build leaves out (PIPE_FULL,
+// PIPE_UPLINK not defined) aren't in it, so MEM_STATIC_TOTAL is this
+// build's.
+//
+// memReport() prints the table, the heap (free, lowest since boot, largest
+// block) and how close each task has come to the end of its stack.
+//
+// Include after all the services, it needs their buffers.
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#define MEM_STATIC_BUDGET (64*1024)  /* our buffers, of the ~320 KB DRAM */
+#define MEM_HEAP_LOW (32*1024)       /* free heap below this is flagged */
+#define MEM_STACK_LOW (1024)         /* stack left below this is flagged */
+#define MEM_NMEA_MAXLEN (82)         /* NMEA 0183 sentence, $ to LF */
+
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+#define MEM_LOOP_STACK CONFIG_ARDUINO_LOOP_STACK_SIZE
+#else
+#define MEM_LOOP_STACK (8192)
+#endif
+
+#ifdef GPS2PORT
+#define MEM_GPS2_BUFFERS(X) \
+  X(gps2RxBuf,       "2nd receiver line assembly") \
+  X(gps2RxLine,      "2nd receiver line")
+#else
+#define MEM_GPS2_BUFFERS(X)
+#endif
+
+// capture, signal, fusion, aiding, fan-out - the full build only
+#ifdef PIPE_FULL
+#define MEM_FULL_BUFFERS(X) \
+  X(capBlock,        "raw capture block") \
+  X(capSlot,         "raw capture slots") \
+  X(sigSats,         "satellite signal state") \
+  X(sigCn0Hist,      "C/N0 histogram") \
+  X(sigRecords,      "signal records until the flush") \
+  X(fuseRx,          "fusion, per receiver") \
+  X(fuseRmcOut,      "fused fix") \
+  X(aidTx,           "aiding frame to the receiver") \
+  X(fanRaw,          "NMEA fan-out ring, raw") \
+  X(fanJson,         "NMEA fan-out ring, gpsd JSON") \
+  X(fanClients,      "NMEA fan-out clients")
+#else
+#define MEM_FULL_BUFFERS(X)
+#endif
+
+// MQTT, UDP telemetry - not in a log-only build
+#ifdef PIPE_UPLINK
+#define MEM_UPLINK_BUFFERS(X) \
+  X(mqttBatch,       "MQTT batch payload") \
+  X(mqttInflight,    "MQTT PUBLISHes awaiting PUBACK")
+#define MEM_UPLINK_STRINGS(X) \
+  X(mqttServer,      "config MQTTSERVER") \
+  X(mqttTopic,       "config MQTTTOPIC") \
+  X(mqttUser,        "config MQTTUSER") \
+  X(mqttPwd,         "config MQTTPASSWORD") \
+  X(telServer,       "config TELEMETRYSERVER")
+#else
+#define MEM_UPLINK_BUFFERS(X)
+#define MEM_UPLINK_STRINGS(X)
+#endif
+
+#define MEM_BUFFERS(X) \
+  X(gpsRxBuf,        "receiver line assembly") \
+  X(gpsRxLine,       "receiver line") \
+  X(gpsBinFrame,     "receiver UBX/CASIC frame") \
+  MEM_GPS2_BUFFERS(X) \
+  X(rmcbuf,          "last fix, logged once a minute") \
+  X(logbuffer,       "log lines until the flush") \
+  X(segCols,         "track segment columns") \
+  X(segBuf,          "track segment encoding") \
+  X(motionTx,        "rate/sleep frames to the receiver") \
+  MEM_FULL_BUFFERS(X) \
+  MEM_UPLINK_BUFFERS(X) \
+  X(batchInflight,   "batched upload frames in flight") \
+  X(replayLine,      "replay line") \
+  X(webLastRmc,      "dashboard's last fix") \
+  X(webStats,        "dashboard stats") \
+  X(webClientIds,    "dashboard clients") \
+  X(webMissed,       "dashboard pushes missed") \
+  X(geofenceZones,   "geofence zones") \
+  X(siobuf,          "serial shell input") \
+  X(siorx,           "serial shell line") \
+  X(tmpbuf,          "config reading") \
+  MEM_CONFIG_STRINGS(X)
+
+// config.ini values and other names, kept for the whole run
+#define MEM_CONFIG_STRINGS(X) \
+  X(wifissid,        "config WIFISSID") \
+  X(wifipwd,         "config WIFIPASSWORD") \
+  X(ftpServer,       "config FTPSERVER") \
+  X(ftpUser,         "config FTPUSER") \
+  X(ftpPwd,          "config FTPPASSWORD") \
+  X(ftpUploadFolder, "config FTPFOLDER") \
+  X(uploadUrl,       "config UPLOADURL") \
+  X(uploadSha256,    "config UPLOADSHA256") \
+  X(tlsSessionHost,  "TLS session's server") \
+  X(batchServer,     "config BATCHSERVER") \
+  X(batchDeviceId,   "config DEVICEID") \
+  X(batchFileName,   "batched upload file") \
+  MEM_UPLINK_STRINGS(X) \
+  X(logFileName,     "message log file name") \
+  X(gpsType,         "config GPSTYPE") \
+  X(replayUdpHost,   "replay UDP host")
+
+#define MEM_SIZEOF(buf, what) + sizeof(buf)
+#define MEM_STATIC_TOTAL (0 MEM_BUFFERS(MEM_SIZEOF))
+
+static_assert(MEM_STATIC_TOTAL <= MEM_STATIC_BUDGET, "static buffers over MEM_STATIC_BUDGET");
+static_assert(sizeof(gpsRxLine) >= GPSBUFLEN, "gpsRxLine can't hold a line from gpsRxBuf");
+static_assert(sizeof(rmcbuf) > MEM_NMEA_MAXLEN, "rmcbuf can't hold an NMEA sentence");
+#ifdef PIPE_FULL
+static_assert(sizeof(rmcbuf) >= sizeof(fuseRmcOut), "rmcbuf can't hold the fused fix");
+#endif
+static_assert(sizeof(webLastRmc) >= sizeof(rmcbuf), "webLastRmc can't hold rmcbuf");
+static_assert(LOGBUFFERSIZE >= 8 * sizeof(rmcbuf), "logbuffer flushes every few lines");
+static_assert(LOGBUFFERSIZE >= SLEEP_JOURNALMAX, "logbuffer can't hold the journal sleepRestore() copies back");
+static_assert(FTP_LINELEN >= sizeof(rmcbuf) + 2, "ftpPut() line buffer can't hold a logged line");
+static_assert(FTP_LINELEN <= MEM_LOOP_STACK / 8, "ftpPut() line buffer too much of loop()'s stack");
+static_assert(sizeof(siorx) >= sizeof(siobuf), "siorx can't hold a shell line");
+
+struct MemEntry
+{
+  const char* name;
+  unsigned bytes;
+  const char* what;
+};
+
+#define MEM_ENTRY(buf, what) { #buf, sizeof(buf), what },
+const MemEntry memBudget[] = { MEM_BUFFERS(MEM_ENTRY) };
+#define MEM_ENTRIES (sizeof(memBudget) / sizeof(memBudget[0]))
+
+// tasks whose stacks are reported, those that exist
+const char* memTasks[] = { "loopTask", "async_tcp", "tiT", "wifi", "sys_evt", "arduino_events", "esp_timer", "IDLE0", "IDLE1" };
+#define MEM_TASKS (sizeof(memTasks) / sizeof(memTasks[0]))
+
+void memReport(int all)
+{
+  char buf[96];
+  snprintf(buf, sizeof(buf), "Static buffers %u of %u bytes budget, %u entries",
+    (unsigned)MEM_STATIC_TOTAL, (unsigned)MEM_STATIC_BUDGET, (unsigned)MEM_ENTRIES);
+  zprintln(buf);
+  if (all)
+  {
+    for (unsigned i = 0; i < MEM_ENTRIES; i++)
+    {
+      snprintf(buf, sizeof(buf), " %-14s %6u  %s", memBudget[i].name, memBudget[i].bytes, memBudget[i].what);
+      zprintln(buf);
+    }
+  }
+
+  snprintf(buf, sizeof(buf), "Heap %u free of %u, lowest %u, largest block %u%s",
+    ESP.getFreeHeap(), ESP.getHeapSize(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(),
+    (ESP.getMinFreeHeap() < MEM_HEAP_LOW) ? "  LOW" : "");
+  zprintln(buf);
+  if (ESP.getPsramSize() > 0)
+  {
+    snprintf(buf, sizeof(buf), "PSRAM %u free of %u", ESP.getFreePsram(), ESP.getPsramSize());
+    zprintln(buf);
+  }
+
+  zprint("Stack left (lowest):");
+  for (unsigned i = 0; i < MEM_TASKS; i++)
+  {
+    TaskHandle_t task = xTaskGetHandle(memTasks[i]);
+    if (task == NULL) continue;
+    unsigned left = uxTaskGetStackHighWaterMark(task); // bytes on the ESP32
+    snprintf(buf, sizeof(buf), " %s %u%s", memTasks[i], left, (left < MEM_STACK_LOW) ? " LOW" : "");
+    zprint(buf);
+  }
+  zprintln("");
+}
+
+#endif
@@ -0,0 +1,341 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Motion-adaptive receiver rate and power - fewer sentences when slow,
+// receiver asleep when parked
+//----------------------------------------------------------------------------
+// The motion state comes from the RMC speed, with hysteresis so a stop at
+// the lights doesn't flip it:
+//   STATIONARY  under MOTION_MOVE_KTS - one fix every MOTION_SLOW_MS, RMC
+//               and GGA only
+//   MOVING      1 Hz, RMC and GGA, GSA/GSV every 5th fix
+//   HIGHWAY     over MOTION_HIGHWAY_KTS for MOTION_HIGHWAY_SEC - 1 Hz,
+//               GSA/GSV every 10th fix (nothing new in the sky per second)
+//   PARKED      stationary for motionParkMin minutes - receiver in standby
+//               / backup, woken every motionWakeMin minutes to look again
+//   WAKING      awake for a look:  moved or moving - MOVING, still where
+//               it was parked - back to sleep.  No fix in
+//               MOTION_CHECK_SEC - back to sleep too (a garage)
+//
+// Commands go in the receiver's own protocol (aidType, GPSTYPE= in the
+// config, see GpsAidService.h):
+//   UBX    CFG-RATE, CFG-MSG per NMEA sentence, RXM-PMREQ backup with
+//          a duration (it wakes itself) and UART RX as wake source
+//   CASIC  $PCAS03 sentence rates (1 Hz is the slowest $PCAS02 allows, so
+//          stationary is every 5th fix instead), $PCAS12 standby for a
+//          number of seconds
+//   PMTK   $PMTK220 fix interval, $PMTK314 sentence rates, $PMTK161,0
+//          standby (any byte wakes it)
+// With no GPSTYPE the state is followed and shown, nothing is sent.
+//
+// A receiver loses its RAM configuration in backup, so the state's
+// settings are sent again on every wake.  Writes never wait, they go
+// out as GPSPORT.availableForWrite() allows, and only start while the
+// aiding isn't part way through a frame (gpsTxClaim(), GpsService.h) -
+// the port is then held until the queue is out.
+//
+// Call motionLine() with each line from gpsService(), motionService()
+// once a second, motionTxService() from the high rate part of loop().
+//
+// Needs GPSPORT, gpsTxClaim() (GpsService.h), aidType (GpsAidService.h),
+// rmcParse() (NmeaService.h), logMessage()
+
+#define MOTION_STATIONARY (0)
+#define MOTION_MOVING     (1)
+#define MOTION_HIGHWAY    (2)
+#define MOTION_PARKED     (3)
+#define MOTION_WAKING     (4)
+#define MOTION_STATES     (5)
+
+#define MOTION_MOVE_KTS (3.0)      /* moving above this... */
+#define MOTION_STOP_KTS (1.5)      /* ...stationary below this */
+#define MOTION_STOP_SEC (30)       /*    for this long */
+#define MOTION_HIGHWAY_KTS (45.0)  /* highway above this... */
+#define MOTION_CITY_KTS (35.0)     /* ...and back below this */
+#define MOTION_HIGHWAY_SEC (20)
+#define MOTION_SLOW_MS (5000)
+#define MOTION_PARK_MOVED_M (150)  /* further than this from where it parked = moved */
+#define MOTION_CHECK_SEC (120)
+#define MOTION_WAKE_MS (500)       /* after the wake bytes, before the settings */
+#define MOTION_TXLEN (256)
+
+int motionState = MOTION_STATIONARY;
+int motionParkMin = 10;            // GPSPARKMIN, 0 = never sleep
+int motionWakeMin = 5;             // GPSWAKEMIN
+int motionApplied = -1;            // state whose settings the receiver has
+unsigned long motionStateSec = 0;  // seconds in this state
+unsigned long motionCondSec = 0;   // seconds the condition for the next state has held
+int motionFixSeen = false;         // a fix since the last motionService()
+int motionFixValid = false;
+float motionKts = 0;
+double motionLat = 0, motionLon = 0;
+double motionParkLat = 0, motionParkLon = 0;
+unsigned long motionWakeAt = 0;    // millis() the wake bytes went, 0 = not waking
+
+// statistics
+unsigned long motionSec[MOTION_STATES];
+unsigned long motionBytes[MOTION_STATES]; // NMEA bytes ingested per state
+unsigned long motionSleeps = 0;
+unsigned long motionWakes = 0;
+unsigned long motionWokeMoved = 0;
+
+uint8_t motionTx[MOTION_TXLEN];
+int motionTxLen = 0;
+int motionTxPos = 0;
+
+const char* motionStateName(int state)
+{
+  const char* names[] = { "stationary", "moving", "highway", "parked", "waking" };
+  return names[state];
+}
+
+int motionAsleep()
+{
+  return (motionState == MOTION_PARKED) && (aidType != AIDTYPE_NONE);
+}
+
+// asleep, or awake for a look that hasn't seen it move yet
+int motionParked()
+{
+  return ((motionState == MOTION_PARKED) || (motionState == MOTION_WAKING)) && (aidType != AIDTYPE_NONE);
+}
+
+//----------------------------------------------------------
+// queue to the receiver
+void motionQueue(const uint8_t* p, int len)
+{
+  if (motionTxLen + len > MOTION_TXLEN) return; // never happens with the messages below
+  memcpy(&motionTx[motionTxLen], p, len);
+  motionTxLen += len;
+}
+
+void motionQueueNmea(const char* body)
+{
+  char buf[96];
+  uint8_t cs = 0;
+  for (const char* q = body; *q; q++) cs ^= *q;
+  int len = snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, cs);
+  motionQueue((uint8_t*)buf, len);
+}
+
+void motionQueueUbx(uint8_t cls, uint8_t id, const uint8_t* payload, int len)
+{
+  uint8_t f[32];
+  f[0] = 0xB5; f[1] = 0x62; f[2] = cls; f[3] = id; f[4] = len; f[5] = len >> 8;
+  memcpy(&f[6], payload, len);
+  uint8_t a = 0, b = 0;
+  for (int i = 2; i < 6 + len; i++) { a += f[i]; b += a; }
+  f[6 + len] = a;
+  f[7 + len] = b;
+  motionQueue(f, 8 + len);
+}
+
+void motionTxService()
+{
+  int room = GPSPORT.availableForWrite();
+  if ((room <= 0) || (motionTxPos >= motionTxLen)) return;
+  if ((motionWakeAt != 0) && (motionTxPos > 0) && (millis() - motionWakeAt < MOTION_WAKE_MS)) return; // let it wake
+  if (!gpsTxClaim(GPSTX_MOTION)) return; // aiding is part way through a frame
+  int n = motionTxLen - motionTxPos;
+  if (n > room) n = room;
+  GPSPORT.write(&motionTx[motionTxPos], n);
+  motionTxPos += n;
+  if (motionTxPos >= motionTxLen)
+  {
+    motionTxLen = motionTxPos = 0;
+    gpsTxRelease(GPSTX_MOTION);
+  }
+}
+
+//----------------------------------------------------------
+// rate and sentences for a state:  fix interval, then every how many fixes
+// GGA/RMC and GSA/GSV go out (0 = off).  GLL, VTG, ZDA always off.
+void motionQueueSettings(int state)
+{
+  int ms = 1000, every = 1, sats = 5;
+  if ((state == MOTION_STATIONARY) || (state == MOTION_WAKING) || (state == MOTION_PARKED)) { ms = MOTION_SLOW_MS; sats = 0; }
+  if (state == MOTION_HIGHWAY) sats = 10;
+  if (state == MOTION_WAKING) ms = 1000; // a quick look
+
+  char body[80];
+  if (aidType == AIDTYPE_UBX)
+  {
+    uint8_t rate[6] = { (uint8_t)ms, (uint8_t)(ms >> 8), 1, 0, 1, 0 }; // measRate, navRate 1, GPS time
+    motionQueueUbx(0x06, 0x08, rate, 6);
+    const uint8_t ids[6] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 }; // GGA GLL GSA GSV RMC VTG
+    const uint8_t rates[6] = { (uint8_t)every, 0, (uint8_t)sats, (uint8_t)sats, (uint8_t)every, 0 };
+    for (int i = 0; i < 6; i++)
+    {
+      uint8_t msg[3] = { 0xF0, ids[i], rates[i] };
+      motionQueueUbx(0x06, 0x01, msg, 3);
+    }
+  }
+  else if (aidType == AIDTYPE_CASIC)
+  {
+    if (ms > 1000) { every = ms / 1000; ms = 1000; }
+    snprintf(body, sizeof(body), "PCAS02,%d", ms);
+    motionQueueNmea(body);
+    // GGA GLL GSA GSV RMC VTG ZDA ANT DHV LPS - - UTC GST - - - TIM
+    snprintf(body, sizeof(body), "PCAS03,%d,0,%d,%d,%d,0,0,0,0,0,,,0,0,,,,0", every, sats, sats, every);
+    motionQueueNmea(body);
+  }
+  else if (aidType == AIDTYPE_PMTK)
+  {
+    snprintf(body, sizeof(body), "PMTK220,%d", ms);
+    motionQueueNmea(body);
+    // GLL RMC VTG GGA GSA GSV, 11 reserved, ZDA, MCHN
+    snprintf(body, sizeof(body), "PMTK314,0,%d,0,%d,%d,%d,0,0,0,0,0,0,0,0,0,0,0,0,0", every, every, sats, sats);
+    motionQueueNmea(body);
+  }
+  motionApplied = state;
+}
+
+void motionQueueSleep()
+{
+  unsigned long sec = motionWakeMin * 60UL;
+  char body[32];
+  if (aidType == AIDTYPE_UBX)
+  {
+    unsigned long ms = sec * 1000UL;
+    // version 0, duration, flags backup+force, wake sources UART RX
+    uint8_t req[16] = { 0, 0, 0, 0, (uint8_t)ms, (uint8_t)(ms >> 8), (uint8_t)(ms >> 16), (uint8_t)(ms >> 24),
+                        0x06, 0, 0, 0, 0x08, 0, 0, 0 };
+    motionQueueUbx(0x02, 0x41, req, 16);
+  }
+  else if (aidType == AIDTYPE_CASIC)
+  {
+    snprintf(body, sizeof(body), "PCAS12,%lu", sec);
+    motionQueueNmea(body);
+  }
+  else if (aidType == AIDTYPE_PMTK)
+  {
+    motionQueueNmea("PMTK161,0");
+  }
+  motionApplied = MOTION_PARKED;
+}
+
+void motionQueueWake()
+{
+  uint8_t wake[8];
+  memset(wake, 0xFF, sizeof(wake)); // edges on RX, ignored by the parsers
+  motionTxLen = motionTxPos = 0;
+  motionQueue(wake, sizeof(wake));
+  motionWakeAt = millis();
+}
+
+//----------------------------------------------------------
+void motionSetState(int state)
+{
+  char msg[80];
+  if ((state == MOTION_PARKED) && (motionState != MOTION_WAKING))
+  {
+    motionParkLat = motionLat;
+    motionParkLon = motionLon;
+    snprintf(msg, sizeof(msg), "GPS parked, receiver %s for %d min at a time",
+      aidType != AIDTYPE_NONE ? "asleep" : "left on (no GPSTYPE)", motionWakeMin);
+    logMessage(msg);
+  }
+  if ((motionState == MOTION_WAKING) && (state == MOTION_MOVING))
+  {
+    motionWokeMoved++;
+    logMessage("GPS moved while parked, awake");
+  }
+  motionState = state;
+  motionStateSec = 0;
+  motionCondSec = 0;
+  if (aidType == AIDTYPE_NONE) return;
+
+  if (state == MOTION_PARKED)
+  {
+    motionSleeps++;
+    motionQueueSleep();
+    motionWakeAt = 0;
+  }
+  else if (state == MOTION_WAKING)
+  {
+    motionWakes++;
+    motionQueueWake();
+    motionQueueSettings(state);
+  }
+  else
+  {
+    motionWakeAt = 0;
+    motionQueueSettings(state);
+  }
+}
+
+// with each line from gpsService()
+void motionLine(const char* line)
+{
+  int s = motionState;
+  motionBytes[s] += strlen(line) + 2;
+  GpsFix fix;
+  if (!rmcParse(line, &fix)) return;
+  motionFixSeen = true;
+  motionFixValid = fix.valid;
+  if (!fix.valid) return;
+  motionKts = fix.speedKts;
+  motionLat = fix.lat;
+  motionLon = fix.lon;
+}
+
+//----------------------------------------------------------
+// once a second
+void motionService()
+{
+  int fix = motionFixSeen && motionFixValid;
+  motionFixSeen = false;
+  motionSec[motionState]++;
+  motionStateSec++;
+
+  if (fix && (motionApplied < 0) && (aidType != AIDTYPE_NONE)) motionQueueSettings(motionState); // first fix after boot
+
+  switch (motionState)
+  {
+    case MOTION_STATIONARY:
+      if (!fix) break;
+      if (motionKts > MOTION_MOVE_KTS) { motionSetState(MOTION_MOVING); break; }
+      if ((motionParkMin > 0) && (motionStateSec >= motionParkMin * 60UL)) motionSetState(MOTION_PARKED);
+      break;
+
+    case MOTION_MOVING:
+    case MOTION_HIGHWAY:
+      // at one fix a second a missing fix is a tunnel, keep the state
+      if (!fix) break;
+      if (motionKts < MOTION_STOP_KTS)
+      {
+        if (++motionCondSec >= MOTION_STOP_SEC) motionSetState(MOTION_STATIONARY);
+      }
+      else if ((motionState == MOTION_MOVING) && (motionKts > MOTION_HIGHWAY_KTS))
+      {
+        if (++motionCondSec >= MOTION_HIGHWAY_SEC) motionSetState(MOTION_HIGHWAY);
+      }
+      else if ((motionState == MOTION_HIGHWAY) && (motionKts < MOTION_CITY_KTS))
+      {
+        if (++motionCondSec >= MOTION_HIGHWAY_SEC) motionSetState(MOTION_MOVING);
+      }
+      else motionCondSec = 0;
+      break;
+
+    case MOTION_PARKED:
+      if (aidType == AIDTYPE_NONE)
+      {
+        // receiver still running, just watch for moving off
+        if (fix && (motionKts > MOTION_MOVE_KTS)) motionSetState(MOTION_MOVING);
+        break;
+      }
+      if (motionStateSec >= motionWakeMin * 60UL) motionSetState(MOTION_WAKING);
+      break;
+
+    case MOTION_WAKING:
+      if (fix)
+      {
+        double dn = (motionLat - motionParkLat) * 111195.0;
+        double de = (motionLon - motionParkLon) * 111195.0 * cos(motionLat * M_PI / 180.0);
+        if ((motionKts > MOTION_MOVE_KTS) || (dn*dn + de*de > (double)MOTION_PARK_MOVED_M * MOTION_PARK_MOVED_M))
+          motionSetState(MOTION_MOVING);
+        else if (++motionCondSec >= 5) motionSetState(MOTION_PARKED); // settled, still here
+      }
+      else if (motionStateSec >= MOTION_CHECK_SEC) motionSetState(MOTION_PARKED);
+      break;
+  }
+}
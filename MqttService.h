@@ -0,0 +1,690 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// MQTT 3.1.1 publisher - batched fixes, QoS 1, queued in flash
+//----------------------------------------------------------------------------
+// Fixes from mqttAddFix() are collected into one JSON message per
+// MQTT_BATCH_FIXES fixes (or MQTT_BATCH_SEC, whichever comes first):
+//
+//   {"dev":"gps-1234ABCD5678","seq":17,"fixes":[[1700041860,47.752060,-122.209460,0.1,0.0],...]}
+//                                                 unix time, lat, lon, knots, course
+//
+// and appended to MQTT_QUEUEFN in the file system, so a batch survives
+// disconnects and reboots until the broker has it.  MQTT_INDEXFN holds the
+// file offset of the first batch the broker hasn't acknowledged and the
+// next seq.  seq goes up by one per batch, forever, so the consumer can
+// drop the duplicates QoS 1 allows.
+//
+// While connected, batches go out of the queue as QoS 1 PUBLISHes, up to
+// MQTT_INFLIGHT waiting for a PUBACK, at most one every MQTT_PACE_MS.  The
+// broker acknowledges QoS 1 in order, so each PUBACK moves the acked
+// offset on.  After a reconnect everything past the acked offset goes
+// again with the DUP flag set.
+//
+// Nothing waits in mqttService().  The broker's name goes to lwip's DNS
+// once and the answer is kept (a refused connect forgets it), the TCP
+// connect is a non-blocking socket that mqttService() polls, handed to
+// mqttClient once it is up;  all of it gives up after MQTT_CONNECT_MS and
+// is tried again every MQTT_RETRY_MS with WiFi up.  A queue trim copies
+// MQTT_TRIMSTEP bytes a pass, so neither ever holds up loop() long enough
+// for the GPS RX buffer to overflow.
+//
+// Only CONNECT, PUBLISH (QoS 1), PINGREQ and DISCONNECT are sent, and
+// CONNACK, PUBACK and PINGRESP understood - no subscriptions.
+//
+// Call mqttInit() from setup() after the config is read, mqttAddFix() with
+// each RMC line, mqttService() from the high rate part of loop().
+//
+// Needs mqttServer, mqttPort, mqttTopic, mqttUser, mqttPwd, batchDeviceId,
+// fileSystem, rmcParse()/fixEpoch() (NmeaService.h), wifiIsConnected(),
+// logMessage(), lwip/sockets.h and lwip/dns.h
+
+#define MQTT_KEEPALIVE (60)       /* seconds */
+#define MQTT_BATCH_FIXES (30)
+#define MQTT_BATCH_SEC (60)       /* send a part batch after this long */
+#define MQTT_PAYLOADMAX (2048)
+#define MQTT_INFLIGHT (4)         /* PUBLISHes waiting for PUBACK */
+#define MQTT_PACE_MS (20)         /* at least this long between PUBLISHes */
+#define MQTT_CONNECT_MS (3000)    /* DNS + TCP connect timeout */
+#define MQTT_TIMEOUT_MS (20000)   /* no CONNACK/PUBACK for this long - drop the connection */
+#define MQTT_RETRY_MS (10000)     /* reconnect interval while there's something to send */
+#define MQTT_INDEX_MS (1000)      /* write the acked offset at most this often */
+#define MQTT_QUEUEMAX (512*1024L) /* queue file beyond this - oldest dropped, ~3h of fixes */
+#define MQTT_QUEUEKEEP (MQTT_QUEUEMAX / 2) /* what a trim keeps, so it isn't copied every batch */
+#define MQTT_TRIMSTEP (4096)      /* bytes a trim copies per mqttService() pass */
+#define MQTT_TRIMHDRS (16)        /* batch headers a trim skips per pass */
+#define MQTT_QUEUEFN "/mqttq.dat"
+#define MQTT_QUEUETMP "/mqttq.tmp"
+#define MQTT_INDEXFN "/mqttq.idx"
+
+#define MQTTSTATE_IDLE     (0)
+#define MQTTSTATE_RESOLVE  (1)    /* waiting for DNS */
+#define MQTTSTATE_TCPWAIT  (2)    /* TCP connect under way */
+#define MQTTSTATE_CONNWAIT (3)    /* CONNECT sent, waiting for CONNACK */
+#define MQTTSTATE_UP       (4)
+
+#define MQTTTRIM_IDLE (0)
+#define MQTTTRIM_SKIP (1)         /* finding the first batch kept */
+#define MQTTTRIM_COPY (2)         /* copying the kept batches to MQTT_QUEUETMP */
+
+#define MQTT_CONNECT    (0x10)
+#define MQTT_CONNACK    (0x20)
+#define MQTT_PUBLISH    (0x30)
+#define MQTT_PUBACK     (0x40)
+#define MQTT_PINGREQ    (0xC0)
+#define MQTT_PINGRESP   (0xD0)
+#define MQTT_DISCONNECT (0xE0)
+
+typedef struct
+{
+  uint16_t id;          // packet id
+  uint32_t endOffset;   // queue offset after this batch
+} MqttInflight;
+
+WiFiClient mqttClient;
+int mqttState = MQTTSTATE_IDLE;
+int mqttSock = -1;                // the socket while the TCP connect is under way
+volatile uint32_t mqttIp = 0;     // broker address (network order), 0 = not resolved
+volatile int mqttDnsDone = false; // set by mqttDnsFound()
+unsigned long mqttTimer = 0;      // last progress / connect attempt
+unsigned long mqttLastTx = 0;
+unsigned long mqttLastRx = 0;
+unsigned long mqttPaceTimer = 0;
+unsigned long mqttIndexTimer = 0;
+int mqttIndexDirty = false;
+
+// the batch being filled
+char mqttBatch[MQTT_PAYLOADMAX];
+int mqttBatchLen = 0;
+int mqttBatchFixes = 0;
+unsigned long mqttBatchStart = 0;
+
+// queue state
+uint32_t mqttSeq = 0;             // seq of the next batch
+uint32_t mqttAcked = 0;           // queue offset, everything before it is at the broker
+uint32_t mqttSendOffset = 0;      // next batch to publish
+uint32_t mqttSentHigh = 0;        // batches before this may have gone already
+uint32_t mqttQueueSize = 0;
+uint16_t mqttNextId = 1;
+MqttInflight mqttInflight[MQTT_INFLIGHT];
+int mqttInflightCount = 0;
+int mqttTrimState = MQTTTRIM_IDLE;
+uint32_t mqttTrimFrom = 0;        // where the kept batches start in the old file
+uint32_t mqttTrimAt = 0;          // copied up to here
+
+// incoming packet
+uint8_t mqttRxBuf[4];
+int mqttRxType = 0;
+int mqttRxHave = 0;               // bytes of the packet so far, including the header
+uint32_t mqttRxRemain = 0;
+int mqttRxShift = 0;
+
+// statistics
+unsigned long mqttSessions = 0;
+unsigned long mqttPublished = 0;  // PUBLISHes sent, including resends
+unsigned long mqttAckedCount = 0;
+unsigned long mqttResent = 0;
+unsigned long mqttDropped = 0;    // batches dropped from a full queue
+
+//----------------------------------------------------------
+// queue index - acked offset and next seq
+void mqttIndexWrite()
+{
+  File f = fileSystem.open(MQTT_INDEXFN, FILE_WRITE);
+  if (!f) return;
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%lu,%lu", (unsigned long)mqttAcked, (unsigned long)mqttSeq);
+  f.println(buf);
+  f.close();
+  mqttIndexDirty = false;
+  mqttIndexTimer = millis();
+}
+
+void mqttInit()
+{
+  char buf[32];
+  mqttAcked = 0;
+  mqttSeq = 0;
+  File f = fileSystem.open(MQTT_INDEXFN, FILE_READ);
+  if (f)
+  {
+    readln(f, (uint8_t*)buf, sizeof(buf));
+    f.close();
+    char* comma = strchr(buf, ',');
+    mqttAcked = strtoul(buf, NULL, 10);
+    if (comma) mqttSeq = strtoul(comma+1, NULL, 10);
+  }
+  mqttQueueSize = 0;
+  f = fileSystem.open(MQTT_QUEUEFN, FILE_READ);
+  if (f)
+  {
+    mqttQueueSize = f.size();
+    f.close();
+  }
+  if (mqttAcked > mqttQueueSize) mqttAcked = mqttQueueSize;
+  mqttSendOffset = mqttAcked;
+  mqttSentHigh = mqttQueueSize; // sent before the reboot, perhaps
+  mqttBatchLen = 0;
+  mqttBatchFixes = 0;
+  mqttInflightCount = 0;
+  mqttState = MQTTSTATE_IDLE;
+  mqttTrimState = MQTTTRIM_IDLE;
+  fileSystem.remove(MQTT_QUEUETMP); // a trim cut short by a reboot
+}
+
+int mqttPending()
+{
+  return mqttQueueSize - mqttAcked;
+}
+
+//----------------------------------------------------------
+// read the length of the batch at offset, 0 if there's none
+int mqttQueueLen(File& q, uint32_t offset)
+{
+  uint8_t hdr[2];
+  if (!q.seek(offset) || (q.read(hdr, 2) != 2)) return 0;
+  return (hdr[0] << 8) | hdr[1];
+}
+
+// the queue file is over MQTT_QUEUEMAX:  drop the oldest unacked batches
+// down to MQTT_QUEUEKEEP and copy the rest to a new file.  The acked ones
+// at the front only go here or in mqttQueueReset() (connected, all acked),
+// so without it the file grows for as long as the broker is away.  Needs
+// MQTT_QUEUEMAX + MQTT_QUEUEKEEP of flash while it copies.
+//
+// One step per mqttService() pass:  MQTT_TRIMHDRS batch headers skipped,
+// or MQTT_TRIMSTEP bytes copied.  Batches queued meanwhile go on the end
+// of the old file and are copied too;  publishing carries on from the old
+// file until the new one takes over.
+void mqttTrimStart()
+{
+  mqttTrimFrom = mqttAcked;
+  mqttTrimState = MQTTTRIM_SKIP;
+}
+
+void mqttTrimAbort()
+{
+  if (mqttTrimState == MQTTTRIM_COPY) fileSystem.remove(MQTT_QUEUETMP);
+  mqttTrimState = MQTTTRIM_IDLE;
+}
+
+void mqttTrimStep()
+{
+  File q = fileSystem.open(MQTT_QUEUEFN, FILE_READ);
+  if (!q)
+  {
+    mqttTrimAbort();
+    return;
+  }
+  if (mqttTrimState == MQTTTRIM_SKIP)
+  {
+    if (mqttTrimFrom < mqttAcked) mqttTrimFrom = mqttAcked; // acked meanwhile
+    int len = 1;
+    for (int i = 0; (i < MQTT_TRIMHDRS) && (mqttQueueSize - mqttTrimFrom > MQTT_QUEUEKEEP); i++)
+    {
+      if ((len = mqttQueueLen(q, mqttTrimFrom)) == 0) break;
+      mqttTrimFrom += 2 + len;
+      mqttDropped++;
+    }
+    q.close();
+    if ((len != 0) && (mqttQueueSize - mqttTrimFrom > MQTT_QUEUEKEEP)) return; // more to skip
+    File n = fileSystem.open(MQTT_QUEUETMP, FILE_WRITE);
+    if (!n)
+    {
+      mqttTrimAbort();
+      return;
+    }
+    n.close();
+    mqttTrimAt = mqttTrimFrom;
+    mqttTrimState = MQTTTRIM_COPY;
+    return;
+  }
+
+  File n = fileSystem.open(MQTT_QUEUETMP, FILE_APPEND);
+  if (!n)
+  {
+    q.close();
+    mqttTrimAbort();
+    return;
+  }
+  uint8_t buf[512];
+  int left = MQTT_TRIMSTEP;
+  int got;
+  q.seek(mqttTrimAt);
+  while ((left > 0) && ((got = q.read(buf, left < (int)sizeof(buf) ? left : sizeof(buf))) > 0))
+  {
+    if (n.write(buf, got) != (size_t)got) break;
+    mqttTrimAt += got;
+    left -= got;
+  }
+  q.close();
+  n.close();
+  if ((left > 0) && (mqttTrimAt < mqttQueueSize))
+  {
+    mqttTrimAbort(); // couldn't write the copy - flash full, say;  the next batch tries again
+    return;
+  }
+  if (mqttTrimAt < mqttQueueSize) return;
+
+  fileSystem.remove(MQTT_QUEUEFN);
+  fileSystem.rename(MQTT_QUEUETMP, MQTT_QUEUEFN);
+  mqttTrimState = MQTTTRIM_IDLE;
+
+  // offsets from the new start;  PUBACKs for dropped batches are ignored
+  uint32_t from = mqttTrimFrom;
+  mqttQueueSize -= from;
+  mqttAcked = (mqttAcked > from) ? mqttAcked - from : 0;
+  mqttSendOffset = (mqttSendOffset > from) ? mqttSendOffset - from : 0;
+  mqttSentHigh = (mqttSentHigh > from) ? mqttSentHigh - from : 0;
+  int k = 0;
+  for (int i = 0; i < mqttInflightCount; i++)
+  {
+    if (mqttInflight[i].endOffset <= from) continue;
+    mqttInflight[k] = mqttInflight[i];
+    mqttInflight[k++].endOffset -= from;
+  }
+  mqttInflightCount = k;
+  mqttIndexWrite();
+}
+
+// everything acked - start an empty queue file
+void mqttQueueReset()
+{
+  mqttTrimAbort();
+  fileSystem.remove(MQTT_QUEUEFN);
+  mqttQueueSize = mqttAcked = mqttSendOffset = mqttSentHigh = 0;
+  mqttIndexWrite();
+}
+
+//----------------------------------------------------------
+// close the batch being filled and queue it
+void mqttBatchClose()
+{
+  if (mqttBatchFixes == 0) return;
+  mqttBatchLen += snprintf(&mqttBatch[mqttBatchLen], sizeof(mqttBatch)-mqttBatchLen, "]}");
+  File q = fileSystem.open(MQTT_QUEUEFN, FILE_APPEND);
+  if (q)
+  {
+    uint8_t hdr[2] = { (uint8_t)(mqttBatchLen >> 8), (uint8_t)mqttBatchLen };
+    q.write(hdr, 2);
+    q.write((uint8_t*)mqttBatch, mqttBatchLen);
+    q.close();
+    mqttQueueSize += 2 + mqttBatchLen;
+    mqttSeq++;
+    mqttIndexWrite();
+  }
+  mqttBatchLen = 0;
+  mqttBatchFixes = 0;
+  if ((mqttQueueSize > MQTT_QUEUEMAX) && (mqttTrimState == MQTTTRIM_IDLE)) mqttTrimStart();
+}
+
+// with each RMC line - valid fixes go into the batch
+void mqttAddFix(const char* rmcline)
+{
+  GpsFix fix;
+  if ((mqttServer[0] == 0) || !rmcParse(rmcline, &fix) || !fix.valid) return;
+  if (mqttBatchFixes == 0)
+  {
+    mqttBatchLen = snprintf(mqttBatch, sizeof(mqttBatch), "{\"dev\":\"%s\",\"seq\":%lu,\"fixes\":[",
+      batchDeviceId, (unsigned long)mqttSeq);
+    mqttBatchStart = millis();
+  }
+  mqttBatchLen += snprintf(&mqttBatch[mqttBatchLen], sizeof(mqttBatch)-mqttBatchLen,
+    "%s[%ld,%.6f,%.6f,%.1f,%.1f]", mqttBatchFixes ? "," : "",
+    fixEpoch(&fix), fix.lat, fix.lon, fix.speedKts, fix.course);
+  mqttBatchFixes++;
+  if ((mqttBatchFixes >= MQTT_BATCH_FIXES) || (mqttBatchLen > MQTT_PAYLOADMAX - 64)) mqttBatchClose();
+}
+
+//----------------------------------------------------------
+// packet building
+int mqttPutLen(uint8_t* p, uint32_t len)
+{
+  int n = 0;
+  do
+  {
+    p[n] = len & 0x7f;
+    len >>= 7;
+    if (len) p[n] |= 0x80;
+    n++;
+  } while (len);
+  return n;
+}
+
+int mqttPutStr(uint8_t* p, const char* s)
+{
+  int len = strlen(s);
+  p[0] = len >> 8;
+  p[1] = len;
+  memcpy(&p[2], s, len);
+  return 2 + len;
+}
+
+int mqttSend(const uint8_t* p, int len)
+{
+  mqttLastTx = millis();
+  return mqttClient.write(p, len) == (size_t)len;
+}
+
+//----------------------------------------------------------
+void mqttDisconnect(const char* why)
+{
+  char msg[96];
+  if (mqttState != MQTTSTATE_IDLE)
+  {
+    snprintf(msg, sizeof(msg), "MQTT %s, %d bytes queued", why, mqttPending());
+    logMessage(msg);
+  }
+  if (mqttSock >= 0) lwip_close(mqttSock);
+  mqttSock = -1;
+  mqttClient.stop();
+  mqttState = MQTTSTATE_IDLE;
+  mqttInflightCount = 0;
+  mqttSendOffset = mqttAcked; // unacked batches go again
+  mqttTimer = millis();
+  if (mqttIndexDirty) mqttIndexWrite();
+}
+
+// send CONNECT on the new connection
+void mqttSendConnect()
+{
+  uint8_t pkt[16 + 64*3 + 8];
+  uint8_t var[16 + 64*3];
+  int n = 0;
+
+  n += mqttPutStr(&var[n], "MQTT");
+  var[n++] = 4; // 3.1.1
+  var[n++] = 0x02 | (mqttUser[0] ? 0x80 : 0) | (mqttPwd[0] ? 0x40 : 0); // clean session
+  var[n++] = MQTT_KEEPALIVE >> 8;
+  var[n++] = MQTT_KEEPALIVE & 0xff;
+  n += mqttPutStr(&var[n], batchDeviceId);
+  if (mqttUser[0]) n += mqttPutStr(&var[n], mqttUser);
+  if (mqttPwd[0]) n += mqttPutStr(&var[n], mqttPwd);
+
+  pkt[0] = MQTT_CONNECT;
+  int h = 1 + mqttPutLen(&pkt[1], n);
+  memcpy(&pkt[h], var, n);
+  mqttRxHave = 0;
+  mqttLastRx = millis();
+  mqttSessions++;
+  if (!mqttSend(pkt, h + n))
+  {
+    mqttClient.stop();
+    mqttState = MQTTSTATE_IDLE;
+    mqttTimer = millis();
+    return;
+  }
+  mqttState = MQTTSTATE_CONNWAIT;
+}
+
+//----------------------------------------------------------
+// connecting without waiting - DNS, then a non-blocking TCP connect
+
+// lwip's DNS answer, on the tcpip task
+void mqttDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg)
+{
+  if (ipaddr) mqttIp = ipaddr->u_addr.ip4.addr; // a late "not found" leaves a good answer alone
+  mqttDnsDone = true;
+}
+
+void mqttConnectFailed(int forget)
+{
+  if (mqttSock >= 0) lwip_close(mqttSock);
+  mqttSock = -1;
+  if (forget) mqttIp = 0; // look the name up again next time
+  mqttState = MQTTSTATE_IDLE;
+  mqttTimer = millis();
+}
+
+void mqttTcpStart()
+{
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(mqttPort);
+  sa.sin_addr.s_addr = mqttIp;
+  mqttSock = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (mqttSock < 0)
+  {
+    mqttConnectFailed(false);
+    return;
+  }
+  lwip_fcntl(mqttSock, F_SETFL, lwip_fcntl(mqttSock, F_GETFL, 0) | O_NONBLOCK);
+  if ((lwip_connect(mqttSock, (struct sockaddr*)&sa, sizeof(sa)) < 0) && (errno != EINPROGRESS))
+  {
+    mqttConnectFailed(true);
+    return;
+  }
+  mqttState = MQTTSTATE_TCPWAIT;
+}
+
+void mqttConnectStart()
+{
+  mqttTimer = millis();
+  if (mqttIp != 0)
+  {
+    mqttTcpStart();
+    return;
+  }
+  ip_addr_t addr;
+  mqttDnsDone = false;
+  err_t err = dns_gethostbyname(mqttServer, &addr, mqttDnsFound, NULL);
+  if (err == ERR_OK) // a dotted address, or in lwip's cache
+  {
+    mqttIp = addr.u_addr.ip4.addr;
+    mqttTcpStart();
+  }
+  else if (err == ERR_INPROGRESS) mqttState = MQTTSTATE_RESOLVE;
+  else mqttConnectFailed(false);
+}
+
+// one look at the DNS answer or the TCP connect
+void mqttConnectPoll()
+{
+  if (mqttState == MQTTSTATE_RESOLVE)
+  {
+    if (mqttDnsDone)
+    {
+      if (mqttIp != 0) mqttTcpStart();
+      else mqttConnectFailed(false);
+    }
+    else if (millis() - mqttTimer >= MQTT_CONNECT_MS) mqttConnectFailed(false);
+    return;
+  }
+
+  fd_set wr;
+  FD_ZERO(&wr);
+  FD_SET(mqttSock, &wr);
+  struct timeval tv = { 0, 0 };
+  if (lwip_select(mqttSock + 1, NULL, &wr, NULL, &tv) <= 0)
+  {
+    if (millis() - mqttTimer >= MQTT_CONNECT_MS) mqttConnectFailed(false);
+    return;
+  }
+  int err = 0;
+  socklen_t len = sizeof(err);
+  lwip_getsockopt(mqttSock, SOL_SOCKET, SO_ERROR, &err, &len);
+  if (err != 0)
+  {
+    mqttConnectFailed(true); // refused or unreachable - the broker may have moved
+    return;
+  }
+  mqttClient = WiFiClient(mqttSock); // owns the socket from here
+  mqttSock = -1;
+  mqttSendConnect();
+}
+
+//----------------------------------------------------------
+// publish the next queued batch, QoS 1
+void mqttPublishNext()
+{
+  File q = fileSystem.open(MQTT_QUEUEFN, FILE_READ);
+  if (!q) return;
+  int len = mqttQueueLen(q, mqttSendOffset);
+  if ((len == 0) || (len > MQTT_PAYLOADMAX))
+  {
+    q.close();
+    logMessage("MQTT queue damaged, dropped");
+    mqttAcked = mqttSendOffset = mqttQueueSize; // queue reset on the next pass
+    mqttInflightCount = 0; // their PUBACKs are ignored
+    mqttIndexDirty = true;
+    return;
+  }
+  uint8_t hdr[8 + 2 + 128 + 2];
+  int tlen = strlen(mqttTopic);
+  int resend = mqttSendOffset < mqttSentHigh;
+  hdr[0] = MQTT_PUBLISH | 0x02 | (resend ? 0x08 : 0); // QoS 1, DUP on resends
+  int h = 1 + mqttPutLen(&hdr[1], 2 + tlen + 2 + len);
+  h += mqttPutStr(&hdr[h], mqttTopic);
+  uint16_t id = mqttNextId++;
+  if (mqttNextId == 0) mqttNextId = 1;
+  hdr[h++] = id >> 8;
+  hdr[h++] = id & 0xff;
+
+  // one write, so a small batch goes in one TCP segment
+  static uint8_t pkt[sizeof(hdr) + MQTT_PAYLOADMAX];
+  memcpy(pkt, hdr, h);
+  q.read(&pkt[h], len);
+  q.close();
+  if (!mqttSend(pkt, h + len))
+  {
+    mqttDisconnect("write failed");
+    return;
+  }
+  mqttSendOffset += 2 + len;
+  if (mqttSendOffset > mqttSentHigh) mqttSentHigh = mqttSendOffset;
+  mqttInflight[mqttInflightCount].id = id;
+  mqttInflight[mqttInflightCount].endOffset = mqttSendOffset;
+  mqttInflightCount++;
+  mqttPublished++;
+  if (resend) mqttResent++;
+}
+
+//----------------------------------------------------------
+// broker acknowledged packet id - QoS 1 acks come in order
+void mqttPubAck(uint16_t id)
+{
+  int done = 0;
+  for (int i = 0; i < mqttInflightCount; i++)
+  {
+    if (mqttInflight[i].id == id)
+    {
+      done = i + 1;
+      break;
+    }
+  }
+  if (done == 0) return; // not ours, or from before a reconnect
+  if (mqttInflight[done-1].endOffset > mqttAcked) mqttAcked = mqttInflight[done-1].endOffset; // only ever forward
+  mqttAckedCount += done;
+  for (int i = done; i < mqttInflightCount; i++) mqttInflight[i-done] = mqttInflight[i];
+  mqttInflightCount -= done;
+  mqttTimer = millis();
+  mqttIndexDirty = true;
+}
+
+// one byte from the broker
+void mqttRxByte(uint8_t c)
+{
+  if (mqttRxHave == 0)
+  {
+    mqttRxType = c & 0xf0;
+    mqttRxRemain = 0;
+    mqttRxShift = 0;
+    mqttRxHave = -1; // reading remaining length
+    return;
+  }
+  if (mqttRxHave < 0)
+  {
+    mqttRxRemain |= (uint32_t)(c & 0x7f) << mqttRxShift;
+    mqttRxShift += 7;
+    if (c & 0x80) return;
+    mqttRxHave = 1;
+    if (mqttRxRemain > 0) return;
+  }
+  else
+  {
+    if (mqttRxHave - 1 < (int)sizeof(mqttRxBuf)) mqttRxBuf[mqttRxHave - 1] = c;
+    mqttRxHave++;
+    if ((uint32_t)(mqttRxHave - 1) < mqttRxRemain) return;
+  }
+
+  // whole packet
+  mqttRxHave = 0;
+  mqttLastRx = millis();
+  if ((mqttRxType == MQTT_CONNACK) && (mqttState == MQTTSTATE_CONNWAIT))
+  {
+    if (mqttRxBuf[1] != 0)
+    {
+      char msg[48];
+      snprintf(msg, sizeof(msg), "refused, code %d", mqttRxBuf[1]);
+      mqttDisconnect(msg);
+      return;
+    }
+    mqttState = MQTTSTATE_UP;
+    mqttTimer = millis();
+  }
+  else if ((mqttRxType == MQTT_PUBACK) && (mqttRxRemain >= 2))
+  {
+    mqttPubAck((mqttRxBuf[0] << 8) | mqttRxBuf[1]);
+  }
+}
+
+//----------------------------------------------------------
+void mqttService()
+{
+  if (mqttServer[0] == 0) return;
+
+  // a part batch goes into the queue after a while
+  if ((mqttBatchFixes > 0) && (millis() - mqttBatchStart >= MQTT_BATCH_SEC * 1000UL)) mqttBatchClose();
+  if (mqttIndexDirty && (millis() - mqttIndexTimer >= MQTT_INDEX_MS)) mqttIndexWrite();
+  if (mqttTrimState != MQTTTRIM_IDLE) mqttTrimStep();
+
+  if (mqttState == MQTTSTATE_IDLE)
+  {
+    if ((mqttPending() > 0) && wifiIsConnected() && (millis() - mqttTimer >= MQTT_RETRY_MS))
+      mqttConnectStart();
+    return;
+  }
+  if ((mqttState == MQTTSTATE_RESOLVE) || (mqttState == MQTTSTATE_TCPWAIT))
+  {
+    mqttConnectPoll();
+    return;
+  }
+
+  if (!mqttClient.connected() && !mqttClient.available())
+  {
+    mqttDisconnect("disconnected");
+    return;
+  }
+  while (mqttClient.available() && (mqttState != MQTTSTATE_IDLE)) mqttRxByte(mqttClient.read());
+  if (mqttState == MQTTSTATE_IDLE) return;
+
+  int waiting = (mqttState == MQTTSTATE_CONNWAIT) || (mqttInflightCount > 0);
+  if (waiting && (millis() - mqttTimer >= MQTT_TIMEOUT_MS))
+  {
+    mqttDisconnect("timed out");
+    return;
+  }
+  if (millis() - mqttLastRx >= MQTT_KEEPALIVE * 1500UL)
+  {
+    mqttDisconnect("keepalive timed out");
+    return;
+  }
+  if (mqttState != MQTTSTATE_UP) return;
+
+  // everything at the broker - start the queue file again
+  if ((mqttPending() == 0) && (mqttInflightCount == 0) && (mqttQueueSize > 0)) mqttQueueReset();
+
+  // paced publishing, window permitting
+  if ((mqttSendOffset < mqttQueueSize) && (mqttInflightCount < MQTT_INFLIGHT) &&
+      (millis() - mqttPaceTimer >= MQTT_PACE_MS))
+  {
+    mqttPaceTimer = millis();
+    if (mqttInflightCount == 0) mqttTimer = millis();
+    mqttPublishNext();
+  }
+  else if ((mqttState == MQTTSTATE_UP) && (millis() - mqttLastTx >= MQTT_KEEPALIVE * 500UL))
+  {
+    uint8_t ping[2] = { MQTT_PINGREQ, 0 };
+    mqttSend(ping, 2);
+  }
+}
@@ -0,0 +1,189 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// NMEA sentence helpers
+//----------------------------------------------------------------------------
+// Small C style helpers for NMEA-0183 lines as they come out of
+// gpsService() or get read back from the log file (no CR/LF).
+//
+//   nmeaChecksumOk(line)      - true if the *hh checksum matches
+//   nmeaIsType(line, "RMC")   - true for $GPRMC, $GNRMC, $BDRMC, ...
+//   nmeaField(line, n, ...)   - copy out field n ($GxRMC is field 0)
+//   rmcParse(line, &fix)      - decode a $GxRMC line into a GpsFix
+//   ggaParse(line, &gga)      - decode a $GxGGA line (fix quality, sats, HDOP)
+//   fixFormat(&fix, buf, n)   - 2023/11/15,09:51:00,47.75206N,122.20946W,0.1kts
+//   fixEpoch(&fix)            - seconds since 1970 (UTC)
+//
+// Nothing here allocates, and the parse runs straight over the line.
+
+typedef struct
+{
+  int valid;         // 'A' status in RMC
+  int year, month, day;
+  int hour, minute;
+  float second;
+  double lat;        // degrees, + north
+  double lon;        // degrees, + east
+  float speedKts;
+  float course;      // degrees true
+} GpsFix;
+
+typedef struct
+{
+  int hour, minute;
+  float second;
+  int quality;       // 0 none, 1 GPS, 2 DGPS, 4 RTK fixed, 5 RTK float, 6 dead reckoning
+  int sats;          // satellites used
+  float hdop;
+  float alt;         // metres above mean sea level
+} GpsGga;
+
+//----------------------------------------------------------
+// return true if line ends in a checksum that matches
+int nmeaChecksumOk(const char* line)
+{
+  if (line[0] != '$') return false;
+  uint8_t sum = 0;
+  const char* p = line+1;
+  while (*p && (*p != '*')) sum ^= (uint8_t)*p++;
+  if (*p != '*') return false;
+  char hex[3];
+  sprintf(hex, "%02X", sum);
+  return (toupper(p[1]) == hex[0]) && (toupper(p[2]) == hex[1]);
+}
+
+//----------------------------------------------------------
+// return true for $xxTTT where TTT is the sentence type, any talker
+int nmeaIsType(const char* line, const char* type)
+{
+  return (line[0] == '$') && (line[1] != 0) && (line[2] != 0) &&
+         (strncmp(&line[3], type, 3) == 0) && (line[6] == ',');
+}
+
+//----------------------------------------------------------
+// copy field n (0 = $GxTTT) to outbuf, return its length, -1 if no such field
+int nmeaField(const char* line, int n, char* outbuf, int maxlen)
+{
+  const char* p = line;
+  while (n > 0)
+  {
+    while (*p && (*p != ',') && (*p != '*')) p++;
+    if (*p != ',') { outbuf[0] = 0; return -1; }
+    p++;
+    n--;
+  }
+  int len = 0;
+  while (*p && (*p != ',') && (*p != '*') && (len < maxlen-1)) outbuf[len++] = *p++;
+  outbuf[len] = 0;
+  return len;
+}
+
+//----------------------------------------------------------
+// ddmm.mmmm + hemisphere to signed degrees
+double nmeaDegrees(const char* dm, const char* hemi)
+{
+  double v = atof(dm);
+  int deg = (int)(v / 100);
+  double d = deg + (v - deg*100) / 60.0;
+  if ((hemi[0] == 'S') || (hemi[0] == 'W')) d = -d;
+  return d;
+}
+
+//----------------------------------------------------------
+// decode $GxRMC,hhmmss.ss,A,ddmm.mmmm,N,dddmm.mmmm,W,kts,course,ddmmyy,...
+// return true if it was a well formed RMC line (fix->valid says if the
+// receiver had a position)
+int rmcParse(const char* line, GpsFix* fix)
+{
+  char f[16], h[4];
+
+  memset(fix, 0, sizeof(GpsFix));
+  if (!nmeaIsType(line, "RMC")) return false;
+  if (!nmeaChecksumOk(line)) return false;
+
+  if (nmeaField(line, 1, f, sizeof(f)) < 6) return false;
+  fix->hour = (f[0]-'0')*10 + (f[1]-'0');
+  fix->minute = (f[2]-'0')*10 + (f[3]-'0');
+  fix->second = atof(&f[4]);
+
+  nmeaField(line, 2, f, sizeof(f));
+  fix->valid = (f[0] == 'A');
+
+  nmeaField(line, 3, f, sizeof(f));
+  nmeaField(line, 4, h, sizeof(h));
+  fix->lat = nmeaDegrees(f, h);
+  nmeaField(line, 5, f, sizeof(f));
+  nmeaField(line, 6, h, sizeof(h));
+  fix->lon = nmeaDegrees(f, h);
+
+  nmeaField(line, 7, f, sizeof(f));
+  fix->speedKts = atof(f);
+  nmeaField(line, 8, f, sizeof(f));
+  fix->course = atof(f);
+
+  if (nmeaField(line, 9, f, sizeof(f)) == 6)
+  {
+    fix->day = (f[0]-'0')*10 + (f[1]-'0');
+    fix->month = (f[2]-'0')*10 + (f[3]-'0');
+    fix->year = 2000 + (f[4]-'0')*10 + (f[5]-'0');
+  }
+  return true;
+}
+
+//----------------------------------------------------------
+// decode $GxGGA,hhmmss.ss,ddmm.mmmm,N,dddmm.mmmm,W,q,sats,hdop,alt,M,...
+// return true if it was a well formed GGA line
+int ggaParse(const char* line, GpsGga* gga)
+{
+  char f[16];
+
+  memset(gga, 0, sizeof(GpsGga));
+  if (!nmeaIsType(line, "GGA")) return false;
+  if (!nmeaChecksumOk(line)) return false;
+
+  if (nmeaField(line, 1, f, sizeof(f)) < 6) return false;
+  gga->hour = (f[0]-'0')*10 + (f[1]-'0');
+  gga->minute = (f[2]-'0')*10 + (f[3]-'0');
+  gga->second = atof(&f[4]);
+
+  nmeaField(line, 6, f, sizeof(f));
+  gga->quality = atoi(f);
+  nmeaField(line, 7, f, sizeof(f));
+  gga->sats = atoi(f);
+  nmeaField(line, 8, f, sizeof(f));
+  gga->hdop = (f[0] != 0) ? atof(f) : 99.9;
+  nmeaField(line, 9, f, sizeof(f));
+  gga->alt = atof(f);
+  return true;
+}
+
+//----------------------------------------------------------
+// seconds since midnight (UTC) of a fix
+long fixDaySeconds(GpsFix* fix)
+{
+  return fix->hour*3600L + fix->minute*60L + (long)fix->second;
+}
+
+//----------------------------------------------------------
+// seconds since 1970-01-01 UTC, 0 if the fix has no date
+long fixEpoch(GpsFix* fix)
+{
+  if (fix->year == 0) return 0;
+  // days from civil (proleptic Gregorian), March based year
+  int y = fix->year - (fix->month <= 2);
+  int era = y / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (fix->month + (fix->month > 2 ? -3 : 9)) + 2) / 5 + fix->day - 1;
+  long days = era * 146097L + yoe * 365L + yoe/4 - yoe/100 + doy - 719468L;
+  return days * 86400L + fixDaySeconds(fix);
+}
+
+//----------------------------------------------------------
+// 2023/11/15,09:51:00,47.75206N,122.20946W,20.1kts
+void fixFormat(GpsFix* fix, char* buf, int maxlen)
+{
+  snprintf(buf, maxlen, "%04d/%02d/%02d,%02d:%02d:%02d,%.5f%c,%.5f%c,%.1fkts",
+    fix->year, fix->month, fix->day, fix->hour, fix->minute, (int)fix->second,
+    fabs(fix->lat), (fix->lat < 0) ? 'S' : 'N',
+    fabs(fix->lon), (fix->lon < 0) ? 'W' : 'E',
+    fix->speedKts);
+}
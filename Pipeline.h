@@ -0,0 +1,122 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// The receiver-to-upload chain of loop() as stages picked at compile time
+//----------------------------------------------------------------------------
+// Each stage is a struct of static functions, hooks the chain calls:
+//   raw(line)       every pass of loop(), the line or NULL (capture)
+//   line<P>(line)   every line from the receiver
+//   fix<P>(rmc)     every fix - an RMC from the receiver, or the fusion's
+//   service<P>()    every pass of loop(), after the line
+//   minute(), hour()
+//   fused()         true if the fixes come from the fusion, not the lines
+//   ramBytes()      the stage's own static buffers, shown per stage
+// A stage derives from NoStage and writes only the hooks it has;  the rest
+// are NoStage's empty inline ones.  Pipeline<A, B, C> calls A's, then B's,
+// then C's, all inline - a stage not in the list isn't called or tested
+// for, so a build that leaves out MQTT or the fan-out has none of their
+// per-line branches in loop().  Leaving the services behind a stage out
+// of the build - their buffers, code and every other use of them - is up
+// to the sketch (GpsLogger.ino does it with PIPE_FULL / PIPE_UPLINK).  P is
+// the whole chain, for a stage to hand on a fix (P::fix()) or ask
+// P::fused().
+//
+// GpsChain<...> is the top of it:  it counts the CPU cycles spent in the
+// chain per fix (every line of the epoch, not only the RMC), for the
+// "pipe" command.
+//
+// Plain C++11 templates, nothing Arduino but PIPE_CYCLES() (define it
+// before the include to use another counter).
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#ifndef PIPE_CYCLES
+#define PIPE_CYCLES() ESP.getCycleCount()
+#endif
+
+struct NoStage
+{
+  static const char* name() { return ""; }
+  static inline void raw(char* line) {}
+  template <class P> static inline void line(char* line) {}
+  template <class P> static inline void fix(char* rmc) {}
+  template <class P> static inline void service() {}
+  static inline void minute() {}
+  static inline void hour() {}
+  static inline bool fused() { return false; }
+  static unsigned ramBytes() { return 0; }
+};
+
+template <class... S> struct Pipeline;
+
+template <> struct Pipeline<>
+{
+  static inline void raw(char* line) {}
+  template <class P> static inline void line(char* line) {}
+  template <class P> static inline void fix(char* rmc) {}
+  template <class P> static inline void service() {}
+  static inline void minute() {}
+  static inline void hour() {}
+  static inline bool fused() { return false; }
+  static unsigned ramBytes() { return 0; }
+  static int stages() { return 0; }
+  static const char* stageName(int i) { return ""; }
+  static unsigned stageRam(int i) { return 0; }
+};
+
+template <class S, class... R> struct Pipeline<S, R...>
+{
+  typedef Pipeline<R...> Rest;
+  static inline void raw(char* line) { S::raw(line); Rest::raw(line); }
+  template <class P> static inline void line(char* line) { S::template line<P>(line); Rest::template line<P>(line); }
+  template <class P> static inline void fix(char* rmc) { S::template fix<P>(rmc); Rest::template fix<P>(rmc); }
+  template <class P> static inline void service() { S::template service<P>(); Rest::template service<P>(); }
+  static inline void minute() { S::minute(); Rest::minute(); }
+  static inline void hour() { S::hour(); Rest::hour(); }
+  static inline bool fused() { return S::fused() || Rest::fused(); }
+  static unsigned ramBytes() { return S::ramBytes() + Rest::ramBytes(); }
+  static int stages() { return 1 + Rest::stages(); }
+  static const char* stageName(int i) { return (i == 0) ? S::name() : Rest::stageName(i - 1); }
+  static unsigned stageRam(int i) { return (i == 0) ? S::ramBytes() : Rest::stageRam(i - 1); }
+};
+
+// cycles spent in the chain, for "pipe"
+uint64_t pipeCycles = 0;
+uint32_t pipeMaxCycles = 0;        // the most for one line (with its fix)
+unsigned long pipeLines = 0, pipeFixes = 0;
+int pipeDepth = 0;                 // in a line() - its fix() is counted there
+
+inline void pipeCount(uint32_t cycles)
+{
+  pipeCycles += cycles;
+  if (cycles > pipeMaxCycles) pipeMaxCycles = cycles;
+}
+
+template <class... S> struct GpsChain
+{
+  typedef Pipeline<S...> Chain;
+
+  static inline void raw(char* line) { Chain::raw(line); }
+  static inline void line(char* line)
+  {
+    uint32_t c0 = PIPE_CYCLES();
+    pipeDepth++;
+    Chain::template line<GpsChain>(line);
+    pipeDepth--;
+    pipeLines++;
+    pipeCount(PIPE_CYCLES() - c0);
+  }
+  static inline void fix(char* rmc)
+  {
+    uint32_t c0 = PIPE_CYCLES();
+    Chain::template fix<GpsChain>(rmc);
+    pipeFixes++;
+    if (pipeDepth == 0) pipeCount(PIPE_CYCLES() - c0);
+  }
+  static inline void service() { Chain::template service<GpsChain>(); }
+  static inline void minute() { Chain::minute(); }
+  static inline void hour() { Chain::hour(); }
+  static inline bool fused() { return Chain::fused(); }
+};
+
+#endif
@@ -0,0 +1,138 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Track replay - play the stored log back out as a live NMEA feed
+//----------------------------------------------------------------------------
+// Reads the location log and sends each line to replayOutput(), spaced by
+// the time difference between the RMC lines divided by the replay speed.
+// A raw capture dump (CaptureService.h, "cap dump") has the microseconds
+// in front of each line instead - those are taken off and the lines go
+// out on that timing.  Anything that isn't NMEA (telnet chatter) is skipped.
+// "!hex" lines are binary as they came from the receiver, replayOutput()
+// gets them as they are.
+// Nothing blocks: replayService() is called from the high rate part of
+// loop() and sends whatever lines are due (at most REPLAY_BURST per call),
+// so GPS ingest and telnet keep running during a replay.
+//
+//   replayStart("/location.log", 60, false)  - 60x, lines as stored
+//   replayStart("/location.log", 0, true)    - as fast as possible, decoded
+//   replayStop()
+//
+// The sketch provides  void replayOutput(const char* line)  to send a
+// line to its target (telnet session, UDP, or the GPS input on the host).
+//
+// Needs readln() from FileSystemService.h and rmcParse() from NmeaService.h
+
+#define REPLAY_BURST (8)        /* max lines per replayService() call */
+#define REPLAY_MAXGAP (3600)    /* seconds, gaps in the track are cut to this */
+#define REPLAY_LINELEN (1100)   /* a capture dump's binary frames in hex */
+
+void replayOutput(const char* line);
+
+File replayFile;
+int replayActive = false;
+int replaySpeed = 0;            // 0 = as fast as possible
+int replayDecoded = false;      // send decoded fixes instead of NMEA
+unsigned long replayDueMs = 0;  // millis() when the pending line is due
+long replayLastSec = -1;        // RMC time of the previous line
+int replayTimed = false;        // lines have capture timestamps
+uint64_t replayFirstUs = 0;     // the first line's timestamp
+unsigned long replayStartMs = 0;
+unsigned long replayLines = 0;
+char replayLine[REPLAY_LINELEN];
+int replayPending = false;      // replayLine holds a line not yet sent
+
+void replayStop()
+{
+  if (replayActive) replayFile.close();
+  replayActive = false;
+  replayPending = false;
+}
+
+int replayStart(const char* fn, int speed, int decoded)
+{
+  replayStop();
+  replayFile = fileSystem.open(fn, FILE_READ);
+  if (!replayFile) return false;
+  replaySpeed = speed;
+  replayDecoded = decoded;
+  replayLastSec = -1;
+  replayTimed = false;
+  replayLines = 0;
+  replayDueMs = replayStartMs = millis();
+  replayActive = true;
+  return true;
+}
+
+int replayIsActive()
+{
+  return replayActive;
+}
+
+// read the next line and work out when it's due
+int replayNext()
+{
+  for (;;)
+  {
+    int more = readln(replayFile, (uint8_t*)replayLine, REPLAY_LINELEN);
+    if ((replayLine[0] >= '0') && (replayLine[0] <= '9'))
+    {
+      // "1234567 $GNRMC,..." from a capture dump
+      char* rest;
+      uint64_t us = strtoull(replayLine, &rest, 10);
+      if ((*rest == ' ') && ((rest[1] == '$') || (rest[1] == '!')))
+      {
+        if (!replayTimed) replayFirstUs = us;
+        replayTimed = true;
+        if (replaySpeed > 0) replayDueMs = replayStartMs + (unsigned long)((us - replayFirstUs) / 1000 / replaySpeed);
+        memmove(replayLine, rest + 1, strlen(rest + 1) + 1);
+        replayPending = true;
+        return true;
+      }
+    }
+    if (((replayLine[0] == '$') || (replayLine[0] == '!')) && !replayTimed) break;
+    if (!more) return false; // end of file
+  }
+  GpsFix fix;
+  if (rmcParse(replayLine, &fix) && (replaySpeed > 0))
+  {
+    long sec = fixDaySeconds(&fix);
+    if (replayLastSec >= 0)
+    {
+      long gap = sec - replayLastSec;
+      if (gap < 0) gap += 24*3600L; // past midnight
+      if (gap > REPLAY_MAXGAP) gap = REPLAY_MAXGAP;
+      replayDueMs += (unsigned long)(gap * 1000L / replaySpeed);
+    }
+    replayLastSec = sec;
+  }
+  replayPending = true;
+  return true;
+}
+
+void replayService()
+{
+  if (!replayActive) return;
+  for (int i = 0; i < REPLAY_BURST; i++)
+  {
+    if (!replayPending && !replayNext())
+    {
+      replayStop();
+      return;
+    }
+    if ((long)(millis() - replayDueMs) < 0) return; // not due yet
+    if (replayDecoded)
+    {
+      GpsFix fix;
+      char buf[80];
+      if (!rmcParse(replayLine, &fix)) { replayPending = false; continue; }
+      fixFormat(&fix, buf, sizeof(buf));
+      replayOutput(buf);
+    }
+    else
+    {
+      replayOutput(replayLine);
+    }
+    replayPending = false;
+    replayLines++;
+  }
+}
@@ -0,0 +1,247 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Parked deep sleep - the ESP32 sleeps with the receiver, woken by its
+// timer for a look
+//----------------------------------------------------------------------------
+// Once the receiver has been parked (MotionService.h) for sleepAfterMin
+// minutes and the sketch says nothing is going on, the state that has to
+// outlive the reset goes to RTC slow memory and the ESP32 deep sleeps for
+// motionWakeMin minutes.  WiFi, telnet and the servers go down with it.
+//
+// Carried in RTC memory (sleepRtc, checked by magic, size and CRC):
+//   clock       epoch going to sleep and the timer, for when the clock
+//               didn't run through the sleep
+//   scheduler   lastHr/lastDay, so the hour that ticked during a sleep
+//               still flushes the log once (the minutes don't catch up,
+//               that would log a stale line every wake)
+//   journal     location log lines not flushed yet, up to SLEEP_JOURNALMAX
+//               (more than that goes to the file first), and the last RMC
+//   motion      state, where it parked, time/bytes per state, sleep and
+//               wake counts - the statistics carry on as if awake
+//   settings    what a wake needs from config.ini - baud rate, receiver
+//               type, park/wake/sleep minutes
+//
+// setup() calls sleepFastWake() first.  A timer wake with good state
+// restores all of it and skips the rest of setup() (listDir, config file,
+// WiFi):  the GPS port is open a few milliseconds after the reset and
+// sleepChecking is set.  While it's set the sketch runs only the GPS, the
+// motion check and the log - parked still, sleepEnter() again; moved, the
+// skipped setup() work is done then and the full loop() takes over.
+// Anything else (power on, reset button, a bad CRC, another build's
+// layout) is a full boot as before.
+//
+// Needs GPSTYPE= (the receiver has to sleep too), rtc, the scheduler
+// (SchedulerService.h), the log buffer (GpsLogService.h), MotionService.h,
+// baudRate, ntpDone, rmcbuf, logMessage()
+
+#define SLEEP_MAGIC (0x50524B31)     /* "PRK1" */
+#define SLEEP_JOURNALMAX (2048)
+#define SLEEP_TXWAIT_MS (1000)       /* for the receiver's sleep command to go */
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t size;                     // sizeof(SleepRtc), a build with another layout boots in full
+  uint32_t crc;                      // of everything after it
+  // clock and scheduler
+  uint32_t epoch;
+  uint32_t epochMs;
+  uint32_t sleepSec;
+  int32_t lastHr, lastDay;
+  int32_t ntpDone;
+  // settings
+  int32_t baudRate;
+  int32_t aidType;
+  int32_t parkMin, wakeMin, afterMin;
+  // motion
+  int32_t motionState;
+  double parkLat, parkLon;
+  uint32_t motionSec[MOTION_STATES];
+  uint32_t motionBytes[MOTION_STATES];
+  uint32_t motionSleeps, motionWakes, motionWokeMoved;
+  uint32_t parkedSec;
+  // statistics
+  uint32_t deepSleeps, fastWakes, sleptSec, wakeMs;
+  // journal
+  char rmc[128];
+  uint32_t journalLen;
+  char journal[SLEEP_JOURNALMAX];
+} SleepRtc;
+
+RTC_DATA_ATTR SleepRtc sleepRtc;
+
+int sleepAfterMin = 20;              // SLEEPAFTERMIN, 0 = never deep sleep
+int sleepChecking = false;           // woke from a park sleep, only GPS and motion run
+unsigned long sleepParkedSec = 0;    // parked, asleep or looking, this long
+
+// statistics, carried through the sleeps, from 0 at a full boot
+unsigned long sleepDeepSleeps = 0;
+unsigned long sleepFastWakes = 0;
+unsigned long sleepSleptSec = 0;
+unsigned long sleepWakeMs = 0;       // reset to GPS port open, last fast wake
+
+//----------------------------------------------------------
+uint32_t sleepCrc32(const uint8_t* p, int len)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  while (len-- > 0)
+  {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+uint32_t sleepRtcCrc()
+{
+  const uint8_t* p = (const uint8_t*)&sleepRtc.epoch;
+  return sleepCrc32(p, sizeof(SleepRtc) - (p - (const uint8_t*)&sleepRtc));
+}
+
+int sleepRtcValid()
+{
+  if ((sleepRtc.magic != SLEEP_MAGIC) || (sleepRtc.size != sizeof(SleepRtc))) return false;
+  if (sleepRtc.journalLen > SLEEP_JOURNALMAX) return false;
+  return sleepRtc.crc == sleepRtcCrc();
+}
+
+//----------------------------------------------------------
+// once a second, after motionService().  True when it's time to sleep,
+// idle = nothing going on the sleep would cut off (sketch decides)
+int sleepWanted(int idle)
+{
+  if ((motionState == MOTION_PARKED) || (motionState == MOTION_WAKING)) sleepParkedSec++;
+  else sleepParkedSec = 0;
+  if ((sleepAfterMin <= 0) || !motionAsleep() || !idle) return false;
+  return sleepParkedSec >= sleepAfterMin * 60UL;
+}
+
+void sleepSave(unsigned long sec)
+{
+  SleepRtc* s = &sleepRtc;
+  s->magic = SLEEP_MAGIC;
+  s->size = sizeof(SleepRtc);
+  s->epoch = rtc.getEpoch();
+  s->epochMs = rtc.getMillis();
+  s->sleepSec = sec;
+  s->lastHr = lastHr;
+  s->lastDay = lastDay;
+  s->ntpDone = ntpDone;
+
+  s->baudRate = baudRate;
+  s->aidType = aidType;
+  s->parkMin = motionParkMin;
+  s->wakeMin = motionWakeMin;
+  s->afterMin = sleepAfterMin;
+
+  s->motionState = motionState;
+  s->parkLat = motionParkLat;
+  s->parkLon = motionParkLon;
+  for (int i = 0; i < MOTION_STATES; i++)
+  {
+    s->motionSec[i] = motionSec[i];
+    s->motionBytes[i] = motionBytes[i];
+  }
+  s->motionSleeps = motionSleeps;
+  s->motionWakes = motionWakes;
+  s->motionWokeMoved = motionWokeMoved;
+  s->parkedSec = sleepParkedSec;
+
+  s->deepSleeps = sleepDeepSleeps;
+  s->fastWakes = sleepFastWakes;
+  s->sleptSec = sleepSleptSec;
+  s->wakeMs = sleepWakeMs;
+
+  strncpy(s->rmc, rmcbuf, sizeof(s->rmc) - 1);
+  s->rmc[sizeof(s->rmc) - 1] = '\0';
+  s->journalLen = bufferWritePosition;
+  memcpy(s->journal, logBuf, bufferWritePosition);
+  s->crc = sleepRtcCrc();
+}
+
+void sleepRestore()
+{
+  SleepRtc* s = &sleepRtc;
+  // the ESP32 clock runs through a deep sleep, if it didn't (or was
+  // never set) it's the epoch plus the timer
+  if (rtc.getEpoch() < s->epoch) rtc.setTime(s->epoch + s->sleepSec, s->epochMs);
+  lastSec = rtc.getSecond();
+  lastMin = rtc.getMinute();
+  lastHr = s->lastHr;
+  lastDay = s->lastDay;
+  ntpDone = s->ntpDone;
+
+  baudRate = s->baudRate;
+  aidType = s->aidType;
+  motionParkMin = s->parkMin;
+  motionWakeMin = s->wakeMin;
+  sleepAfterMin = s->afterMin;
+
+  motionState = s->motionState;
+  motionParkLat = s->parkLat;
+  motionParkLon = s->parkLon;
+  for (int i = 0; i < MOTION_STATES; i++)
+  {
+    motionSec[i] = s->motionSec[i];
+    motionBytes[i] = s->motionBytes[i];
+  }
+  motionSleeps = s->motionSleeps;
+  motionWakes = s->motionWakes;
+  motionWokeMoved = s->motionWokeMoved;
+  motionSec[MOTION_PARKED] += s->sleepSec; // parked all along
+  sleepParkedSec = s->parkedSec + s->sleepSec;
+
+  sleepDeepSleeps = s->deepSleeps;
+  sleepFastWakes = s->fastWakes;
+  sleepSleptSec = s->sleptSec + s->sleepSec;
+  sleepWakeMs = s->wakeMs;
+
+  strcpy(rmcbuf, s->rmc);
+  memcpy(logBuf, s->journal, s->journalLen); // logbuffer, PSRAM comes with setupResume()
+  bufferWritePosition = s->journalLen;
+}
+
+//----------------------------------------------------------
+// first thing in setup().  True = woke from a park sleep and the state is
+// back, skip the rest of setup()
+int sleepFastWake()
+{
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) return false;
+  if (!sleepRtcValid()) return false;
+  sleepRestore();
+  sleepFastWakes++;
+  sleepChecking = true;
+  return true;
+}
+
+// parked long enough, or still parked after a look - doesn't come back
+// (on the host it does, the tool plays the reset)
+void sleepEnter()
+{
+  // the receiver was told motionWakeMin from when it parked, wake with it
+  unsigned long sec = motionWakeMin * 60UL;
+  sec = (motionStateSec < sec) ? sec - motionStateSec : 1;
+  if (!sleepChecking)
+  {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Parked, deep sleep, looking every %d min", motionWakeMin);
+    logMessage(msg);
+  }
+  // the receiver's sleep command has to be out before the UART goes
+  for (unsigned long t = millis(); (motionTxLen > 0) && (millis() - t < SLEEP_TXWAIT_MS); )
+  {
+    motionTxService();
+    delay(1);
+  }
+  GPSPORT.flush();
+  if (logDraining || (bufferWritePosition > SLEEP_JOURNALMAX)) gpsLogFlush();
+  if (bufferWritePosition > SLEEP_JOURNALMAX)
+  {
+    logLostBytes += bufferWritePosition; // couldn't be written, too big for RTC memory
+    bufferWritePosition = 0;
+  }
+  sleepDeepSleeps++;
+  sleepSave(sec);
+  esp_sleep_enable_timer_wakeup(sec * 1000000ULL);
+  esp_deep_sleep_start();
+}
@@ -0,0 +1,85 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Fix telemetry datagrams - the format shared by the logger
+// (TelemetryService.h) and the collector (host/udpcollect.cpp)
+//----------------------------------------------------------------------------
+// One UDP datagram, fire and forget, no answer.  seq goes up by one per
+// datagram sent, so the collector counts the ones it never got from the
+// gaps.  seq starts again from 0 after a reboot or a deep sleep, each
+// with a new random session - a new session tells the collector to start
+// counting again rather than take the low seqs for old ones.  All big
+// endian.
+//
+//   0   'G' 'T'
+//   2   version (TEL_VERSION)
+//   3   fixes in it, 1..TEL_MAXFIXES
+//   4   device id, ASCII, zero padded to TEL_IDLEN
+//   20  u32 session, not 0
+//   24  u32 seq
+//   28  per fix: u32 unix time, i32 lat, i32 lon (degrees x 1e6),
+//       i32 speed (knots x 100)
+//
+// Plain C, no Arduino calls, so the host tools can include it too.
+// Needs batchPutU32() / batchGetU32() (BatchProtocol.h)
+
+#define TEL_PORT_DEFAULT (5006)
+#define TEL_VERSION (2)
+#define TEL_IDLEN (16)
+#define TEL_HDRLEN (28)
+#define TEL_FIXLEN (16)
+#define TEL_MAXFIXES (8)
+#define TEL_MAXLEN (TEL_HDRLEN + TEL_MAXFIXES * TEL_FIXLEN)
+
+typedef struct
+{
+  uint32_t t;                        // unix time
+  int32_t lat, lon;                  // degrees x 1e6
+  int32_t speed;                     // knots x 100
+} TelFix;
+
+//----------------------------------------------------------
+// build a datagram, return its length
+int telPack(uint8_t* buf, const char* id, uint32_t session, uint32_t seq, const TelFix* fixes, int count)
+{
+  if (count > TEL_MAXFIXES) count = TEL_MAXFIXES;
+  buf[0] = 'G';
+  buf[1] = 'T';
+  buf[2] = TEL_VERSION;
+  buf[3] = count;
+  memset(&buf[4], 0, TEL_IDLEN);
+  strncpy((char*)&buf[4], id, TEL_IDLEN);
+  batchPutU32(&buf[20], session);
+  batchPutU32(&buf[24], seq);
+  uint8_t* p = &buf[TEL_HDRLEN];
+  for (int i = 0; i < count; i++, p += TEL_FIXLEN)
+  {
+    batchPutU32(p, fixes[i].t);
+    batchPutU32(p + 4, (uint32_t)fixes[i].lat);
+    batchPutU32(p + 8, (uint32_t)fixes[i].lon);
+    batchPutU32(p + 12, (uint32_t)fixes[i].speed);
+  }
+  return TEL_HDRLEN + count * TEL_FIXLEN;
+}
+
+// check a datagram, the id (TEL_IDLEN+1 chars), session, seq and fixes
+// out of it;  returns the number of fixes, 0 if it isn't one
+int telUnpack(const uint8_t* buf, int len, char* id, uint32_t* session, uint32_t* seq, TelFix* fixes)
+{
+  if ((len < TEL_HDRLEN + TEL_FIXLEN) || (buf[0] != 'G') || (buf[1] != 'T') || (buf[2] != TEL_VERSION)) return 0;
+  int count = buf[3];
+  if ((count < 1) || (count > TEL_MAXFIXES) || (len != TEL_HDRLEN + count * TEL_FIXLEN)) return 0;
+  memcpy(id, &buf[4], TEL_IDLEN);
+  id[TEL_IDLEN] = 0;
+  *session = batchGetU32(&buf[20]);
+  *seq = batchGetU32(&buf[24]);
+  if (*session == 0) return 0;
+  const uint8_t* p = &buf[TEL_HDRLEN];
+  for (int i = 0; i < count; i++, p += TEL_FIXLEN)
+  {
+    fixes[i].t = batchGetU32(p);
+    fixes[i].lat = (int32_t)batchGetU32(p + 4);
+    fixes[i].lon = (int32_t)batchGetU32(p + 8);
+    fixes[i].speed = (int32_t)batchGetU32(p + 12);
+  }
+  return count;
+}
@@ -0,0 +1,51 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Fix telemetry over UDP - a fix every TELEMETRYSEC seconds to a collector
+//----------------------------------------------------------------------------
+// For a fleet pointed at one collector box (host/udpcollect.cpp): each fix
+// goes out as it comes, one datagram (TelemetryProtocol.h), nothing
+// queued, nothing resent - MQTT is the one for every fix getting there.
+// telSeq only moves on for a datagram handed to the stack, so the gaps the
+// collector sees are the ones the network lost;  fixes while WiFi is down
+// are counted here, not sent.  telSeq starts from 0 with the RAM, after
+// a reboot or a deep sleep, so telSession is a new random one each time.
+//
+// Call telemetryFix() with each RMC line.
+//
+// Needs telServer, telPort, telEverySec, batchDeviceId, rmcParse() /
+// fixEpoch() (NmeaService.h), wifiIsConnected(), WiFiUDP, TelemetryProtocol.h
+
+WiFiUDP telUdp;
+uint32_t telSession = 0;           // this boot / wake, 0 = not picked yet
+uint32_t telSeq = 0;               // of the next datagram
+long telLastT = 0;                 // unix time of the last fix sent
+
+// statistics
+unsigned long telSent = 0, telNoLink = 0, telFailed = 0;
+
+//----------------------------------------------------------
+void telemetryFix(const char* rmc)
+{
+  if (telServer[0] == 0) return;
+  GpsFix fix;
+  if (!rmcParse(rmc, &fix) || !fix.valid || (fix.year == 0)) return;
+  long t = fixEpoch(&fix);
+  if ((t >= telLastT) && (t - telLastT < telEverySec)) return;
+  telLastT = t;
+  if (!wifiIsConnected()) { telNoLink++; return; }
+
+  TelFix f;
+  f.t = (uint32_t)t;
+  f.lat = lround(fix.lat * 1e6);
+  f.lon = lround(fix.lon * 1e6);
+  f.speed = lround(fix.speedKts * 100);
+  uint8_t buf[TEL_MAXLEN];
+  while (telSession == 0) telSession = esp_random();
+  int len = telPack(buf, batchDeviceId, telSession, telSeq, &f, 1);
+  if (telUdp.beginPacket(telServer, telPort) && (telUdp.write(buf, len) == (size_t)len) && telUdp.endPacket())
+  {
+    telSeq++;
+    telSent++;
+  }
+  else telFailed++;
+}
@@ -0,0 +1,388 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// HTTPS upload of the location log, with TLS session resumption
+//----------------------------------------------------------------------------
+// FTP sends FTPUSER/FTPPASSWORD and the log in clear text.  This uploader
+// does an HTTPS PUT of the log to UPLOADURL instead:
+//
+//   UPLOADURL=https://my.server.com:8443/gpslogs/
+//   -> PUT /gpslogs/gpslog_20231116-182201.log, Basic auth FTPUSER:FTPPASSWORD
+//
+// A full TLS handshake costs the ESP32 several hundred ms of CPU (the
+// public key operations), so the session from the last upload is kept in
+// RAM and in NVS (Preferences "tls") and offered again next time.  When the
+// server accepts it (session ID or session ticket) the handshake is
+// abbreviated - no certificate, no key exchange.
+//
+// Each handshake is logged to the event log with its time and bytes, and
+// the "tls" shell command shows the full vs resumed totals.
+//
+// The credentials only go to a server that has proved who it is:  its
+// certificate must check out against /ca.pem on the file system, or its
+// SHA-256 fingerprint must be UPLOADSHA256= (64 hex digits, as
+// host/tlsserver.cpp prints it) for a self-signed one.  With neither the
+// upload is refused.
+//
+// Written against mbedtls 2.x as shipped with arduino-esp32 2.x.
+// Needs ftpUser, ftpPwd, uploadUrl, uploadSha256, rtc, fileSystem,
+// logMessage(), zprint()
+
+#define TLS_PORT_DEFAULT (443)
+#define TLS_TIMEOUT_MS (10000)
+#define TLS_CHUNK (1024)
+#define TLS_SESSION_MAXSAVE (2048) /* bytes of NVS for the saved session */
+#define TLS_CAFN "/ca.pem"
+
+mbedtls_ssl_session tlsSession;   // last session, offered for resumption
+int tlsSessionValid = false;
+int tlsSessionLoaded = false;     // NVS copy has been looked at
+char tlsSessionHost[128];         // server the session belongs to
+
+// statistics
+unsigned long tlsFullCount = 0, tlsResumedCount = 0;
+unsigned long tlsFullMs = 0, tlsResumedMs = 0;       // total handshake time
+unsigned long tlsFullBytes = 0, tlsResumedBytes = 0; // total handshake bytes in+out
+unsigned long tlsBytesIn = 0, tlsBytesOut = 0;       // current connection
+
+//----------------------------------------------------------
+// mbedtls I/O over a WiFiClient, counting bytes
+int tlsSend(void* ctx, const unsigned char* buf, size_t len)
+{
+  WiFiClient* client = (WiFiClient*)ctx;
+  if (!client->connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+  int n = client->write(buf, len);
+  if (n <= 0) return MBEDTLS_ERR_NET_SEND_FAILED;
+  tlsBytesOut += n;
+  return n;
+}
+
+int tlsRecv(void* ctx, unsigned char* buf, size_t len, uint32_t timeoutMs)
+{
+  WiFiClient* client = (WiFiClient*)ctx;
+  unsigned long start = millis();
+  while (!client->available())
+  {
+    if (!client->connected()) return 0; // EOF
+    if (millis() - start >= timeoutMs) return MBEDTLS_ERR_SSL_TIMEOUT;
+    delay(2);
+  }
+  int n = client->read(buf, len);
+  if (n < 0) return MBEDTLS_ERR_NET_RECV_FAILED;
+  tlsBytesIn += n;
+  return n;
+}
+
+//----------------------------------------------------------
+// split https://host[:port]/path into its pieces, return true if ok
+int tlsParseUrl(const char* url, char* host, int hostlen, int* port, char* path, int pathlen)
+{
+  if (strncmp(url, "https://", 8) != 0) return false;
+  const char* h = url + 8;
+  const char* slash = strchr(h, '/');
+  if (slash == NULL) slash = h + strlen(h);
+  const char* colon = (const char*)memchr(h, ':', slash - h);
+  const char* hend = colon ? colon : slash;
+  if ((hend == h) || (hend - h >= hostlen)) return false;
+  memcpy(host, h, hend - h);
+  host[hend - h] = 0;
+  *port = colon ? atoi(colon+1) : TLS_PORT_DEFAULT;
+  strncpy(path, *slash ? slash : "/", pathlen-1);
+  path[pathlen-1] = 0;
+  return true;
+}
+
+//----------------------------------------------------------
+// session cache in NVS
+void tlsSessionSave()
+{
+  unsigned char* buf = (unsigned char*)malloc(TLS_SESSION_MAXSAVE);
+  size_t len = 0;
+  if (buf == NULL) return;
+  if (mbedtls_ssl_session_save(&tlsSession, buf, TLS_SESSION_MAXSAVE, &len) == 0)
+  {
+    Preferences prefs;
+    prefs.begin("tls", false);
+    prefs.putBytes("sess", buf, len);
+    prefs.putString("host", tlsSessionHost);
+    prefs.end();
+  }
+  free(buf);
+}
+
+void tlsSessionLoad()
+{
+  tlsSessionLoaded = true;
+  Preferences prefs;
+  prefs.begin("tls", true);
+  size_t len = prefs.getBytesLength("sess");
+  if ((len > 0) && (len <= TLS_SESSION_MAXSAVE))
+  {
+    unsigned char* buf = (unsigned char*)malloc(len);
+    if (buf != NULL)
+    {
+      prefs.getBytes("sess", buf, len);
+      prefs.getString("host", tlsSessionHost, sizeof(tlsSessionHost));
+      mbedtls_ssl_session_init(&tlsSession);
+      tlsSessionValid = (mbedtls_ssl_session_load(&tlsSession, buf, len) == 0);
+      free(buf);
+    }
+  }
+  prefs.end();
+}
+
+void tlsSessionForget()
+{
+  if (tlsSessionValid) mbedtls_ssl_session_free(&tlsSession);
+  tlsSessionValid = false;
+  tlsSessionLoaded = true;
+  Preferences prefs;
+  prefs.begin("tls", false);
+  prefs.clear();
+  prefs.end();
+}
+
+//----------------------------------------------------------
+// the server's certificate against UPLOADSHA256=, true if it matches
+int tlsPinMatches(mbedtls_ssl_context* ssl)
+{
+  const mbedtls_x509_crt* crt = mbedtls_ssl_get_peer_cert(ssl);
+  if ((crt == NULL) || (strlen(uploadSha256) != 64)) return false;
+  unsigned char md[32];
+  char hex[65];
+  if (mbedtls_sha256_ret(crt->raw.p, crt->raw.len, md, 0) != 0) return false;
+  for (int i = 0; i < 32; i++) snprintf(&hex[i*2], 3, "%02x", md[i]);
+  return strcasecmp(hex, uploadSha256) == 0;
+}
+
+//----------------------------------------------------------
+// write all of buf, return true if ok
+int tlsWriteAll(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len)
+{
+  while (len > 0)
+  {
+    int n = mbedtls_ssl_write(ssl, buf, len);
+    if ((n == MBEDTLS_ERR_SSL_WANT_READ) || (n == MBEDTLS_ERR_SSL_WANT_WRITE)) continue;
+    if (n <= 0) return false;
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+//----------------------------------------------------------
+// HTTPS PUT the file fn, return true if the server said 2xx
+int tlsPut(char* fn)
+{
+  char host[128], path[128], line[160];
+  int port;
+  int ok = false;
+
+  if (!tlsParseUrl(uploadUrl, host, sizeof(host), &port, path, sizeof(path)))
+  {
+    zprintln("UPLOADURL must be https://host[:port]/path");
+    return false;
+  }
+  File finp = fileSystem.open(fn, FILE_READ);
+  if (!finp)
+  {
+    zprintln("Unable to read log file");
+    return false;
+  }
+  String targetfn = rtc.getTime("gpslog_%Y%m%d-%H%M%S.log");
+  zprint("HTTPS PUT to "); zprint(host); zprint(path); zprintln(targetfn);
+
+  if (!tlsSessionLoaded) tlsSessionLoad();
+  if (tlsSessionValid && (strcmp(tlsSessionHost, host) != 0)) tlsSessionForget(); // other server
+
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config conf;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_x509_crt ca;
+  mbedtls_ssl_init(&ssl);
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&drbg);
+  mbedtls_x509_crt_init(&ca);
+
+  int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0);
+  if (ret == 0) ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+                        MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  int verify = false;
+  if (ret == 0)
+  {
+    File cafile = fileSystem.open(TLS_CAFN, FILE_READ);
+    if (cafile)
+    {
+      // PEM parser wants the terminating \0 counted in the length
+      size_t len = cafile.size();
+      unsigned char* pem = (unsigned char*)malloc(len+1);
+      if (pem != NULL)
+      {
+        cafile.read(pem, len);
+        pem[len] = 0;
+        verify = (mbedtls_x509_crt_parse(&ca, pem, len+1) == 0);
+        free(pem);
+      }
+      cafile.close();
+    }
+    if (verify)
+    {
+      mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+      mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
+    else if (uploadSha256[0] != 0)
+    {
+      mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE); // pinned, checked after the handshake
+    }
+    else
+    {
+      logMessage("HTTPS upload refused - no /ca.pem or UPLOADSHA256 to check the server with");
+      ret = -1;
+    }
+  }
+  if (ret == 0)
+  {
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    mbedtls_ssl_conf_read_timeout(&conf, TLS_TIMEOUT_MS);
+    ret = mbedtls_ssl_setup(&ssl, &conf);
+  }
+  if (ret == 0) ret = mbedtls_ssl_set_hostname(&ssl, host);
+
+  // only connect once there is a way to check the server
+  WiFiClient tcp;
+  if ((ret == 0) && !tcp.connect(host, port))
+  {
+    logMessage("HTTPS upload - unable to connect");
+    ret = -1;
+  }
+
+  // offer the last session
+  int offered = false;
+  if ((ret == 0) && tlsSessionValid) offered = (mbedtls_ssl_set_session(&ssl, &tlsSession) == 0);
+
+  if (ret == 0)
+  {
+    mbedtls_ssl_set_bio(&ssl, &tcp, tlsSend, NULL, tlsRecv);
+    tlsBytesIn = tlsBytesOut = 0;
+    unsigned long t0 = millis();
+    do
+    {
+      ret = mbedtls_ssl_handshake(&ssl);
+    } while ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE));
+    unsigned long ms = millis() - t0;
+    unsigned long bytes = tlsBytesIn + tlsBytesOut;
+
+    // resumed if the server took the offered session:  the same session
+    // ID, or for a ticket (which is sent with a fresh random ID, RFC 5077)
+    // the same original start time
+    mbedtls_ssl_session sess;
+    mbedtls_ssl_session_init(&sess);
+    int haveSess = (ret == 0) && (mbedtls_ssl_get_session(&ssl, &sess) == 0);
+    int resumed = offered && haveSess &&
+      (((sess.id_len == tlsSession.id_len) && (sess.id_len > 0) && (memcmp(sess.id, tlsSession.id, sess.id_len) == 0)) ||
+       (sess.start == tlsSession.start));
+
+    if ((ret == 0) && !verify && !tlsPinMatches(&ssl))
+    {
+      logMessage("HTTPS upload refused - server certificate doesn't match UPLOADSHA256");
+      ret = -1;
+      if (offered) tlsSessionForget();
+      offered = false;
+    }
+    else if (ret == 0)
+    {
+      if (resumed) { tlsResumedCount++; tlsResumedMs += ms; tlsResumedBytes += bytes; }
+      else { tlsFullCount++; tlsFullMs += ms; tlsFullBytes += bytes; }
+      snprintf(line, sizeof(line), "TLS %s handshake %lu ms, %lu bytes in, %lu bytes out, %s",
+        resumed ? "resumed" : "full", ms, tlsBytesIn, tlsBytesOut, mbedtls_ssl_get_ciphersuite(&ssl));
+      logMessage(line);
+
+      // keep this session for next time
+      if (tlsSessionValid) mbedtls_ssl_session_free(&tlsSession);
+      tlsSession = sess; // it owns what sess pointed to now
+      tlsSessionValid = haveSess;
+      haveSess = false;
+      if (tlsSessionValid && !resumed)
+      {
+        strncpy(tlsSessionHost, host, sizeof(tlsSessionHost)-1);
+        tlsSessionSave();
+      }
+    }
+    else
+    {
+      snprintf(line, sizeof(line), "TLS handshake failed -0x%04x", -ret);
+      logMessage(line);
+      if (offered) tlsSessionForget(); // don't offer a bad session again
+    }
+    if (haveSess) mbedtls_ssl_session_free(&sess);
+  }
+
+  if (ret == 0)
+  {
+    // basic auth header
+    char cred[132];
+    unsigned char b64[180];
+    size_t b64len = 0;
+    snprintf(cred, sizeof(cred), "%s:%s", ftpUser, ftpPwd);
+    mbedtls_base64_encode(b64, sizeof(b64)-1, &b64len, (const unsigned char*)cred, strlen(cred));
+    b64[b64len] = 0;
+
+    String hdr = String("PUT ") + path + targetfn + " HTTP/1.1\r\n" +
+                 "Host: " + host + "\r\n" +
+                 "Authorization: Basic " + (const char*)b64 + "\r\n" +
+                 "Content-Type: text/plain\r\n" +
+                 "Content-Length: " + String((unsigned long)finp.size()) + "\r\n" +
+                 "Connection: close\r\n\r\n";
+    int sent = tlsWriteAll(&ssl, (const unsigned char*)hdr.c_str(), hdr.length());
+
+    unsigned char buf[TLS_CHUNK];
+    while (sent && finp.available())
+    {
+      int n = finp.read(buf, sizeof(buf));
+      if (n <= 0) break;
+      sent = tlsWriteAll(&ssl, buf, n);
+    }
+
+    // status line, HTTP/1.1 201 Created
+    if (sent)
+    {
+      int n = mbedtls_ssl_read(&ssl, (unsigned char*)line, sizeof(line)-1);
+      if (n > 0)
+      {
+        line[n] = 0;
+        char* eol = strchr(line, '\r');
+        if (eol) *eol = 0;
+        ok = (strncmp(line, "HTTP/1.", 7) == 0) && (line[9] == '2');
+        zprintln(line);
+      }
+    }
+    mbedtls_ssl_close_notify(&ssl);
+    logMessage(ok ? "HTTPS upload completed" : "HTTPS upload failed");
+  }
+
+  finp.close();
+  tcp.stop();
+  mbedtls_ssl_free(&ssl);
+  mbedtls_ssl_config_free(&conf);
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_ctr_drbg_free(&drbg);
+  mbedtls_entropy_free(&entropy);
+  return ok;
+}
+
+//----------------------------------------------------------
+// "tls" shell command - handshake statistics
+void tlsStats()
+{
+  zprint("TLS full handshakes:    "); zprint((int)tlsFullCount);
+  if (tlsFullCount) { zprint(", avg ms "); zprint((int)(tlsFullMs/tlsFullCount));
+                      zprint(", avg bytes "); zprint((int)(tlsFullBytes/tlsFullCount)); }
+  zprintln("");
+  zprint("TLS resumed handshakes: "); zprint((int)tlsResumedCount);
+  if (tlsResumedCount) { zprint(", avg ms "); zprint((int)(tlsResumedMs/tlsResumedCount));
+                         zprint(", avg bytes "); zprint((int)(tlsResumedBytes/tlsResumedCount)); }
+  zprintln("");
+  zprint("Cached session: "); zprintln(tlsSessionValid ? tlsSessionHost : "none");
+}
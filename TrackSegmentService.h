@@ -0,0 +1,256 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Track segments - the logged fixes again, column by column
+//----------------------------------------------------------------------------
+// location.log is a row per fix (the RMC line), so "what was the top
+// speed" or "where has it been" means reading and parsing every line of
+// it.  Here the same fixes are kept as segments, each field its own
+// column:
+//   SegHeader   count, and per column the min, max and first value
+//   time        seconds from SEG_EPOCH   - each the deltas from the
+//   lat, lon    degrees x 1e6            - value before, zigzag varint
+//   speed       knots x 100              -
+// A fix a minute is a byte or two per column, and the headers answer
+// max/min questions on their own - a segment only gets decoded where it
+// straddles the edge of the time range asked about, and then only the
+// time column and the one asked about.
+//
+// segAddRmc() from the minute log, segFlush() appends the buffered fixes
+// as a segment to SEGFN (with the hourly log flush, or when SEG_MAXFIXES
+// are buffered).  Little endian on the ESP32 and the PC both.
+//
+// Needs rmcParse(), fixEpoch() (NmeaService.h), fileSystem, SEGFN
+
+#define SEG_COLS (4)
+#define SEG_TIME (0)
+#define SEG_LAT (1)
+#define SEG_LON (2)
+#define SEG_SPEED (3)
+#define SEG_MAXFIXES (240)
+#define SEG_VARINTMAX (5)
+#define SEG_MAGIC (0x4753)           /* "SG" */
+#define SEG_EPOCH (1577836800L)      /* 2020/01/01 00:00:00 UTC */
+#define SEG_ALL (0x7fffffffL)
+
+const char* segColName[SEG_COLS] = { "time", "lat", "lon", "speed" };
+
+typedef struct
+{
+  uint16_t magic;
+  uint16_t count;                    // fixes
+  int32_t minv[SEG_COLS];
+  int32_t maxv[SEG_COLS];
+  int32_t first[SEG_COLS];           // the deltas start from here
+  uint16_t bytes[SEG_COLS];          // column lengths, the columns follow in order
+} SegHeader;
+
+// fixes waiting for the flush, a column each
+int32_t segCols[SEG_COLS][SEG_MAXFIXES];
+int segCount = 0;
+uint8_t segBuf[SEG_MAXFIXES * SEG_VARINTMAX];
+
+// statistics
+unsigned long segFixes = 0, segWritten = 0, segBytes = 0;
+unsigned long segFromHeader = 0, segDecoded = 0, segSkipped = 0; // by the last query
+
+void segFlush();
+
+//----------------------------------------------------------
+void segInit()
+{
+  segCount = 0;
+}
+
+void segAdd(GpsFix* fix)
+{
+  if (segCount >= SEG_MAXFIXES) segFlush();
+  segCols[SEG_TIME][segCount] = fixEpoch(fix) - SEG_EPOCH;
+  segCols[SEG_LAT][segCount] = lround(fix->lat * 1e6);
+  segCols[SEG_LON][segCount] = lround(fix->lon * 1e6);
+  segCols[SEG_SPEED][segCount] = lround(fix->speedKts * 100);
+  segCount++;
+  segFixes++;
+}
+
+// the line that went to the log, if it's a fix
+void segAddRmc(const char* rmc)
+{
+  GpsFix fix;
+  if (rmcParse(rmc, &fix) && fix.valid) segAdd(&fix);
+}
+
+//----------------------------------------------------------
+// zigzag varint, 7 bits a byte, low first
+int segPut(uint8_t* p, int32_t v)
+{
+  uint32_t z = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+  int n = 0;
+  while (z >= 0x80)
+  {
+    p[n++] = (uint8_t)(z | 0x80);
+    z >>= 7;
+  }
+  p[n++] = (uint8_t)z;
+  return n;
+}
+
+int32_t segGet(const uint8_t** pp, const uint8_t* end)
+{
+  const uint8_t* p = *pp;
+  uint32_t z = 0;
+  int shift = 0;
+  while ((p < end) && (*p & 0x80) && (shift < 28))
+  {
+    z |= (uint32_t)(*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  if (p < end) z |= (uint32_t)*p++ << shift;
+  *pp = p;
+  return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+// a column as deltas into segBuf, returns the bytes
+int segEncode(const int32_t* col, int count)
+{
+  int n = 0;
+  for (int i = 1; i < count; i++) n += segPut(segBuf + n, col[i] - col[i - 1]);
+  return n;
+}
+
+void segDecode(const uint8_t* p, int bytes, int32_t first, int count, int32_t* out)
+{
+  const uint8_t* end = p + bytes;
+  out[0] = first;
+  for (int i = 1; i < count; i++) out[i] = out[i - 1] + segGet(&p, end);
+}
+
+//----------------------------------------------------------
+void segFlush()
+{
+  if (segCount == 0) return;
+  SegHeader h;
+  memset(&h, 0, sizeof(h));
+  h.magic = SEG_MAGIC;
+  h.count = segCount;
+  for (int c = 0; c < SEG_COLS; c++)
+  {
+    h.minv[c] = h.maxv[c] = h.first[c] = segCols[c][0];
+    for (int i = 1; i < segCount; i++)
+    {
+      if (segCols[c][i] < h.minv[c]) h.minv[c] = segCols[c][i];
+      if (segCols[c][i] > h.maxv[c]) h.maxv[c] = segCols[c][i];
+    }
+    h.bytes[c] = segEncode(segCols[c], segCount);
+  }
+  File file = fileSystem.open(SEGFN, FILE_APPEND);
+  if (file)
+  {
+    file.write((uint8_t*)&h, sizeof(h));
+    for (int c = 0; c < SEG_COLS; c++)
+    {
+      int n = segEncode(segCols[c], segCount);
+      file.write(segBuf, n);
+      segBytes += n;
+    }
+    segBytes += sizeof(h);
+    segWritten++;
+    file.close();
+  }
+  segCount = 0;
+}
+
+//----------------------------------------------------------
+// the next segment's header, false at the end (or a torn last write)
+int segReadHeader(File& file, SegHeader* h)
+{
+  if (file.read((uint8_t*)h, sizeof(SegHeader)) != sizeof(SegHeader)) return false;
+  if ((h->magic != SEG_MAGIC) || (h->count == 0) || (h->count > SEG_MAXFIXES)) return false;
+  unsigned long len = 0;
+  for (int c = 0; c < SEG_COLS; c++) len += h->bytes[c];
+  return (file.available() >= (int)len);
+}
+
+// one column of the segment whose header was just read, the file is left there
+int segReadColumn(File& file, SegHeader* h, int col, int32_t* out)
+{
+  size_t start = file.position();
+  size_t at = start;
+  for (int c = 0; c < col; c++) at += h->bytes[c];
+  file.seek(at);
+  int ok = (file.read(segBuf, h->bytes[col]) == h->bytes[col]);
+  if (ok) segDecode(segBuf, h->bytes[col], h->first[col], h->count, out);
+  file.seek(start);
+  return ok;
+}
+
+void segSkip(File& file, SegHeader* h)
+{
+  size_t at = file.position();
+  for (int c = 0; c < SEG_COLS; c++) at += h->bytes[c];
+  file.seek(at);
+}
+
+// min and max of a column for the fixes from t0 to t1 (times as in the
+// time column), the ones still buffered too;  returns the number of
+// fixes - 0, and min/max untouched, if there were none
+unsigned long segQuery(int col, int32_t t0, int32_t t1, int32_t* minv, int32_t* maxv)
+{
+  static int32_t times[SEG_MAXFIXES], vals[SEG_MAXFIXES];
+  unsigned long n = 0;
+  segFromHeader = segDecoded = segSkipped = 0;
+  for (int i = 0; i < segCount; i++)
+  {
+    if ((segCols[SEG_TIME][i] < t0) || (segCols[SEG_TIME][i] > t1)) continue;
+    if ((n == 0) || (segCols[col][i] < *minv)) *minv = segCols[col][i];
+    if ((n == 0) || (segCols[col][i] > *maxv)) *maxv = segCols[col][i];
+    n++;
+  }
+  File file = fileSystem.open(SEGFN, FILE_READ);
+  if (!file) return n;
+  SegHeader h;
+  while (segReadHeader(file, &h))
+  {
+    if ((h.maxv[SEG_TIME] < t0) || (h.minv[SEG_TIME] > t1))
+    {
+      segSkipped++;
+    }
+    else if ((h.minv[SEG_TIME] >= t0) && (h.maxv[SEG_TIME] <= t1))
+    {
+      if ((n == 0) || (h.minv[col] < *minv)) *minv = h.minv[col];
+      if ((n == 0) || (h.maxv[col] > *maxv)) *maxv = h.maxv[col];
+      n += h.count;
+      segFromHeader++;
+    }
+    else if (segReadColumn(file, &h, SEG_TIME, times) && segReadColumn(file, &h, col, vals))
+    {
+      for (int i = 0; i < h.count; i++)
+      {
+        if ((times[i] < t0) || (times[i] > t1)) continue;
+        if ((n == 0) || (vals[i] < *minv)) *minv = vals[i];
+        if ((n == 0) || (vals[i] > *maxv)) *maxv = vals[i];
+        n++;
+      }
+      segDecoded++;
+    }
+    segSkip(file, &h);
+  }
+  file.close();
+  return n;
+}
+
+// time of the newest fix stored or buffered, -1 if none
+int32_t segNewest()
+{
+  if (segCount > 0) return segCols[SEG_TIME][segCount - 1];
+  int32_t t = -1;
+  File file = fileSystem.open(SEGFN, FILE_READ);
+  if (!file) return t;
+  SegHeader h;
+  while (segReadHeader(file, &h))
+  {
+    if (h.maxv[SEG_TIME] > t) t = h.maxv[SEG_TIME];
+    segSkip(file, &h);
+  }
+  file.close();
+  return t;
+}
@@ -0,0 +1,265 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Web dashboard - static page from the file system, live data over a WebSocket
+//----------------------------------------------------------------------------
+// Uses ESPAsyncWebServer (and AsyncTCP), which runs in its own task, so a
+// browser never holds up loop().
+//
+// The page is www/index.html in the sketch folder.  Put it on the file
+// system gzipped, e.g.
+//   mkdir -p data/www && gzip -9 -c www/index.html > data/www/index.html.gz
+// then ESP32 Sketch Data Upload.  serveStatic() finds the .gz, sends it
+// with Content-Encoding: gzip, streamed from flash straight into the TCP
+// send buffer (never read into RAM whole), and the Cache-Control header
+// lets the browser keep it.  A plain /www/index.html works too.
+//
+// /ws pushes JSON text:
+//   {"fix":{"date":"2023/11/15","time":"09:51:00","valid":1,"lat":47.752060,
+//           "lon":-122.209460,"kts":0.1,"crs":0.0}}
+//       at most every WEB_FIX_MS, only when the RMC line has changed
+//   {"st":{"name":value,...}}
+//       every WEB_STATS_MS, only the stats that changed since the last push
+//       (all of them after a browser connects or misses a push)
+//
+// Each push is formatted once for all clients.  A client whose
+// queue is full, or whose TCP send buffer hasn't drained the last push,
+// just misses this one (fixes and stats are both "latest wins"), and after
+// WEB_KICK_DROPS misses in a row it is closed.
+//
+// Connects and disconnects come in on the AsyncTCP task.  webEvent() only
+// queues them (under webMux) and webService() takes them on loop(), so the
+// client slots, webLastRmc and the timers are only ever touched there.
+//
+// Call webInit() once WiFi is up, webService() from the high rate part of
+// loop().  The sketch provides webCollectStats(), calling webStat() for
+// each value it wants on the page.
+//
+// Needs fileSystem, rmcParse() (NmeaService.h)
+
+#define WEB_PORT (80)
+#define WEB_FIX_MS (1000)      /* fastest fix push */
+#define WEB_STATS_MS (5000)    /* stats push interval */
+#define WEB_MAX_CLIENTS (4)
+#define WEB_KICK_DROPS (30)    /* pushes missed in a row before a client is closed */
+#define WEB_MAXSTATS (24)
+#define WEB_PUSHLEN (512)
+#define WEB_EVENTS (8)         /* connects/disconnects queued for loop() */
+#define WEB_CACHE "max-age=86400"
+
+typedef struct
+{
+  const char* name;
+  long value;
+  long sent;
+} WebStat;
+
+typedef struct
+{
+  uint32_t id;
+  int connect;                 // true = connect, false = disconnect
+} WebEvent;
+
+AsyncWebServer webServer(WEB_PORT);
+AsyncWebSocket webSocket("/ws");
+int webStarted = false;
+int webSendAll = false;            // a client connected, next stats push has everything
+unsigned long webFixTimer = 0;
+unsigned long webStatsTimer = 0;
+char webLastRmc[128];
+WebStat webStats[WEB_MAXSTATS];
+int webStatCount = 0;
+
+uint32_t webClientIds[WEB_MAX_CLIENTS]; // 0 = free slot
+uint8_t webMissed[WEB_MAX_CLIENTS];     // pushes missed in a row, per slot
+
+portMUX_TYPE webMux = portMUX_INITIALIZER_UNLOCKED;
+WebEvent webEvents[WEB_EVENTS];         // from the AsyncTCP task, under webMux
+int webEventCount = 0;
+
+// statistics
+unsigned long webPushes = 0;       // messages queued to a client
+unsigned long webDropped = 0;      // pushes a slow client missed
+unsigned long webKicked = 0;
+unsigned long webRefused = 0;      // no free slot, or the event queue full
+
+void webCollectStats();
+
+//----------------------------------------------------------
+// runs in the AsyncTCP task - only queue the event here
+void webEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
+              AwsEventType type, void* arg, uint8_t* data, size_t len)
+{
+  if ((type != WS_EVT_CONNECT) && (type != WS_EVT_DISCONNECT)) return;
+  int queued = false;
+  portENTER_CRITICAL(&webMux);
+  if (webEventCount < WEB_EVENTS)
+  {
+    webEvents[webEventCount].id = client->id();
+    webEvents[webEventCount].connect = (type == WS_EVT_CONNECT);
+    webEventCount++;
+    queued = true;
+  }
+  portEXIT_CRITICAL(&webMux);
+  // a lost disconnect is caught by webCleanup(), a lost connect never gets a slot
+  if (!queued && (type == WS_EVT_CONNECT)) client->close();
+}
+
+//----------------------------------------------------------
+// the queued connects/disconnects, on loop()
+void webTakeEvents()
+{
+  WebEvent ev[WEB_EVENTS];
+  int n;
+  portENTER_CRITICAL(&webMux);
+  n = webEventCount;
+  memcpy(ev, webEvents, n * sizeof(WebEvent));
+  webEventCount = 0;
+  portEXIT_CRITICAL(&webMux);
+
+  for (int e = 0; e < n; e++)
+  {
+    if (!ev[e].connect)
+    {
+      for (int i = 0; i < WEB_MAX_CLIENTS; i++)
+        if (webClientIds[i] == ev[e].id) webClientIds[i] = 0;
+      continue;
+    }
+    int i = 0;
+    while ((i < WEB_MAX_CLIENTS) && (webClientIds[i] != 0)) i++;
+    if (i == WEB_MAX_CLIENTS)
+    {
+      AsyncWebSocketClient* c = webSocket.client(ev[e].id);
+      if (c != NULL) c->close(); // full up
+      webRefused++;
+      continue;
+    }
+    webMissed[i] = 0;
+    webClientIds[i] = ev[e].id;
+    webSendAll = true;
+    webStatsTimer = 0;
+    webLastRmc[0] = 0; // send the current fix straight away
+  }
+}
+
+void webInit()
+{
+  if (webStarted) return;
+  webSocket.onEvent(webEvent);
+  webServer.addHandler(&webSocket);
+  webServer.serveStatic("/", fileSystem, "/www/").setDefaultFile("index.html").setCacheControl(WEB_CACHE);
+  webServer.onNotFound([](AsyncWebServerRequest* request) { request->send(404, "text/plain", "Not found"); });
+  webServer.begin();
+  webStarted = true;
+}
+
+//----------------------------------------------------------
+// add or update a stat, from webCollectStats()
+void webStat(const char* name, long value)
+{
+  for (int i = 0; i < webStatCount; i++)
+  {
+    if (webStats[i].name == name)
+    {
+      webStats[i].value = value;
+      return;
+    }
+  }
+  if (webStatCount >= WEB_MAXSTATS) return;
+  webStats[webStatCount].name = name;
+  webStats[webStatCount].value = value;
+  webStats[webStatCount].sent = value - 1; // goes out the first time
+  webStatCount++;
+}
+
+//----------------------------------------------------------
+// queue one message to every client that can take it now
+void webPushAll(const char* msg, int len)
+{
+  for (int i = 0; i < WEB_MAX_CLIENTS; i++)
+  {
+    if (webClientIds[i] == 0) continue;
+    AsyncWebSocketClient* c = webSocket.client(webClientIds[i]);
+    if ((c == NULL) || (c->status() != WS_CONNECTED)) continue;
+    if (c->queueIsFull() || (c->client()->space() < (size_t)len))
+    {
+      webDropped++;
+      if (++webMissed[i] >= WEB_KICK_DROPS)
+      {
+        c->close();
+        webKicked++;
+      }
+      continue;
+    }
+    webMissed[i] = 0;
+    c->text(msg, len);
+    webPushes++;
+  }
+}
+
+//----------------------------------------------------------
+void webPushFix(const char* rmcline)
+{
+  GpsFix fix;
+  char msg[WEB_PUSHLEN];
+  if (!rmcParse(rmcline, &fix)) return;
+  int len = snprintf(msg, sizeof(msg),
+    "{\"fix\":{\"date\":\"%04d/%02d/%02d\",\"time\":\"%02d:%02d:%02d\",\"valid\":%d,"
+    "\"lat\":%.6f,\"lon\":%.6f,\"kts\":%.1f,\"crs\":%.1f}}",
+    fix.year, fix.month, fix.day, fix.hour, fix.minute, (int)fix.second, fix.valid,
+    fix.lat, fix.lon, fix.speedKts, fix.course);
+  webPushAll(msg, len);
+}
+
+void webPushStats()
+{
+  char msg[WEB_PUSHLEN];
+  int all = webSendAll;
+  webSendAll = false;
+  int len = snprintf(msg, sizeof(msg), "{\"st\":{");
+  int n = 0;
+  for (int i = 0; i < webStatCount; i++)
+  {
+    WebStat* s = &webStats[i];
+    if (!all && (s->value == s->sent)) continue;
+    if (len > WEB_PUSHLEN - 48) break; // rest goes next time
+    len += snprintf(&msg[len], sizeof(msg)-len, "%s\"%s\":%ld", n++ ? "," : "", s->name, s->value);
+    s->sent = s->value;
+  }
+  if (n == 0) return; // nothing changed
+  len += snprintf(&msg[len], sizeof(msg)-len, "}}");
+  unsigned long dropped = webDropped;
+  webPushAll(msg, len);
+  if (webDropped != dropped) webSendAll = true; // someone missed a delta, resync next time
+}
+
+//----------------------------------------------------------
+void webService(const char* rmcline)
+{
+  if (!webStarted) return;
+  webTakeEvents();
+  if (webSocket.count() == 0) return;
+
+  if ((millis() - webFixTimer >= WEB_FIX_MS) && (strcmp(rmcline, webLastRmc) != 0))
+  {
+    webFixTimer = millis();
+    strncpy(webLastRmc, rmcline, sizeof(webLastRmc)-1);
+    webPushFix(rmcline);
+  }
+  if ((webStatsTimer == 0) || (millis() - webStatsTimer >= WEB_STATS_MS))
+  {
+    webStatsTimer = millis();
+    if (webStatsTimer == 0) webStatsTimer = 1;
+    webCollectStats();
+    webPushStats();
+  }
+}
+
+void webCleanup()
+{
+  // once per second - free the closed clients, and any slot whose client
+  // has gone without its disconnect getting through
+  if (!webStarted) return;
+  webSocket.cleanupClients(WEB_MAX_CLIENTS);
+  for (int i = 0; i < WEB_MAX_CLIENTS; i++)
+    if ((webClientIds[i] != 0) && (webSocket.client(webClientIds[i]) == NULL)) webClientIds[i] = 0;
+}
@@ -0,0 +1,144 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Receiver side of the batched-ack upload protocol (../BatchProtocol.h)
+//----------------------------------------------------------------------------
+// One BatchReceiver per TCP connection.  Bytes from the logger go in with
+// onData(), frames to send back come out through the reply callback.
+// Records are appended to <outdir>/<device id>.log one line each (CRLF);
+// the number of lines already in that file is the next seq wanted, so the
+// file itself is the resume state and survives a receiver restart.
+// On NEWFILE (the logger's log is shorter than that file) the file is
+// renamed to <device id>.<n>.log, the first n not taken, and the upload
+// starts again at seq 0 in an empty <device id>.log.
+//
+// Used by host/batchrecv.cpp (real sockets) and host/batchbench.cpp
+// (simulated link).
+//
+#ifndef BATCHRECEIVER_H
+#define BATCHRECEIVER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <functional>
+#include "../BatchProtocol.h"
+
+struct BatchReceiverStats
+{
+  unsigned long sessions = 0;
+  unsigned long records = 0;    // stored
+  unsigned long duplicates = 0; // already stored, dropped
+  unsigned long gaps = 0;       // ahead of the next seq wanted, dropped
+  unsigned long newFiles = 0;   // files put aside on NEWFILE
+};
+
+class BatchReceiver
+{
+public:
+  BatchReceiver(const std::string& outdir, BatchReceiverStats& stats,
+                std::function<void(const uint8_t*, size_t)> reply)
+    : outdir(outdir), stats(stats), reply(reply)
+  {
+    batchRxInit(&rx);
+  }
+  ~BatchReceiver() { if (fp) fclose(fp); }
+
+  void onData(const uint8_t* data, size_t len)
+  {
+    for (size_t i = 0; i < len; i++)
+    {
+      int got = batchRxPush(&rx, data[i]);
+      if (got > 0) frame();
+    }
+  }
+
+  const std::string& device() const { return deviceId; }
+
+private:
+  void frame()
+  {
+    uint8_t* p = batchRxPayload(&rx);
+    int len = batchRxLen(&rx);
+    uint8_t out[BATCH_HDRLEN + 4];
+
+    if (batchRxType(&rx) == BATCH_HELLO)
+    {
+      deviceId.clear();
+      for (int i = 0; i < len; i++)
+        deviceId += (isalnum(p[i]) || p[i] == '-' || p[i] == '_') ? (char)p[i] : '_';
+      if (deviceId.empty()) deviceId = "unknown";
+      if (fp) fclose(fp);
+      std::string fn = outdir + "/" + deviceId + ".log";
+      nextSeq = countLines(fn.c_str());
+      fp = fopen(fn.c_str(), "ab");
+      stats.sessions++;
+      reply(out, batchSeqFrame(out, BATCH_RESUME, nextSeq));
+    }
+    else if ((batchRxType(&rx) == BATCH_NEWFILE) && fp)
+    {
+      fclose(fp);
+      std::string fn = outdir + "/" + deviceId + ".log";
+      std::string old;
+      for (int n = 1; ; n++)
+      {
+        old = outdir + "/" + deviceId + "." + std::to_string(n) + ".log";
+        FILE* f = fopen(old.c_str(), "rb");
+        if (!f) break;
+        fclose(f);
+      }
+      rename(fn.c_str(), old.c_str());
+      fp = fopen(fn.c_str(), "ab");
+      nextSeq = 0;
+      stats.newFiles++;
+      reply(out, batchSeqFrame(out, BATCH_RESUME, nextSeq));
+    }
+    else if ((batchRxType(&rx) == BATCH_DATA) && fp && (len >= 4))
+    {
+      uint32_t seq = batchGetU32(p);
+      int at = 4;
+      while (at < len)
+      {
+        int n = p[at++];
+        if (at + n > len) break;
+        if (seq == nextSeq)
+        {
+          fwrite(&p[at], 1, n, fp);
+          fwrite("\r\n", 1, 2, fp);
+          nextSeq++;
+          stats.records++;
+        }
+        else if (seq < nextSeq) stats.duplicates++;
+        else stats.gaps++;
+        seq++;
+        at += n;
+      }
+      fflush(fp); // stored before it is acknowledged
+      reply(out, batchSeqFrame(out, BATCH_ACK, nextSeq));
+    }
+  }
+
+  static uint32_t countLines(const char* fn)
+  {
+    FILE* f = fopen(fn, "rb");
+    if (!f) return 0;
+    uint32_t n = 0;
+    char buf[65536];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), f)) > 0)
+      for (size_t i = 0; i < got; i++) n += (buf[i] == '\n');
+    fclose(f);
+    return n;
+  }
+
+  std::string outdir;
+  BatchReceiverStats& stats;
+  std::function<void(const uint8_t*, size_t)> reply;
+  BatchRx rx;
+  std::string deviceId;
+  FILE* fp = nullptr;
+  uint32_t nextSeq = 0;
+};
+
+#endif
@@ -0,0 +1,496 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Host (Linux) stand-ins for the Arduino/ESP32 pieces the services use
+//----------------------------------------------------------------------------
+// Lets the service .h files from the sketch folder compile with g++ so they
+// can be exercised on a PC.  Only what the services actually call is here:
+//
+//   - a virtual clock:  millis(), micros(), delay() advance hostMicros only,
+//                       nothing ever sleeps, so simulations run as fast as
+//                       the CPU allows
+//   - String, IPAddress, Serial/Serial1/Serial2
+//   - ESP32Time rtc, driven from the virtual clock
+//   - deep sleep calls and RTC_DATA_ATTR
+//   - portMUX critical sections, a spinlock (a tool may run a second
+//     thread as another FreeRTOS task)
+//   - fs::FS / File, an in-memory file system (SPIFFS)
+//   - zprint()/zprintln() going to Serial
+//
+// Network stand-ins (WiFi, WiFiUDP, NTPClient, FTP) are in HostNet.h,
+// WiFiServer/WiFiClient on real sockets in HostSocket.h.
+//
+// Use:   #include "HostArduino.h"  then include the service .h files
+//
+#ifndef HOSTARDUINO_H
+#define HOSTARDUINO_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstdarg>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+
+//----------------------------------------------------------------------------
+// virtual clock
+//----------------------------------------------------------------------------
+inline uint64_t hostMicros = 0;
+
+inline unsigned long millis() { return (unsigned long)(hostMicros / 1000); }
+inline unsigned long micros() { return (unsigned long)hostMicros; }
+inline void delay(unsigned long ms) { hostMicros += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostMicros += us; }
+inline void yield() {}
+
+#define HIGH (1)
+#define LOW (0)
+#define OUTPUT (1)
+#define INPUT (0)
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+
+//----------------------------------------------------------------------------
+// deep sleep - RTC memory is ordinary memory here, esp_deep_sleep_start()
+// only records the request and returns, the tool plays the reset and sets
+// the wake cause for the next setup()
+//----------------------------------------------------------------------------
+#define RTC_DATA_ATTR
+typedef enum { ESP_SLEEP_WAKEUP_UNDEFINED = 0, ESP_SLEEP_WAKEUP_TIMER = 4 } esp_sleep_wakeup_cause_t;
+inline esp_sleep_wakeup_cause_t hostWakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+inline uint64_t hostSleepUs = 0;
+inline bool hostSleepStarted = false;
+inline void esp_sleep_enable_timer_wakeup(uint64_t us) { hostSleepUs = us; }
+inline void esp_deep_sleep_start() { hostSleepStarted = true; }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return hostWakeCause; }
+
+//----------------------------------------------------------------------------
+// FreeRTOS critical sections - a spinlock, as on the dual core ESP32
+//----------------------------------------------------------------------------
+struct portMUX_TYPE { std::atomic_flag locked = ATOMIC_FLAG_INIT; };
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) { while (mux->locked.test_and_set(std::memory_order_acquire)) ; }
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) { mux->locked.clear(std::memory_order_release); }
+
+//----------------------------------------------------------------------------
+// String - just enough of the Arduino String class
+//----------------------------------------------------------------------------
+class String
+{
+public:
+  String() {}
+  String(const char* s) : str(s ? s : "") {}
+  String(const std::string& s) : str(s) {}
+  String(char c) : str(1, c) {}
+  String(int x) : str(std::to_string(x)) {}
+  String(long x) : str(std::to_string(x)) {}
+  String(unsigned long x) : str(std::to_string(x)) {}
+  String(double x, int decimals = 2)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, x);
+    str = buf;
+  }
+
+  const char* c_str() const { return str.c_str(); }
+  unsigned int length() const { return str.size(); }
+  char operator[](unsigned int i) const { return i < str.size() ? str[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  String substring(unsigned int from) const { return from < str.size() ? String(str.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const
+  {
+    if (from >= str.size() || to <= from) return String();
+    return String(str.substr(from, to - from));
+  }
+  int indexOf(const char* s) const { size_t i = str.find(s); return i == std::string::npos ? -1 : (int)i; }
+  int indexOf(char c) const { size_t i = str.find(c); return i == std::string::npos ? -1 : (int)i; }
+  int indexOf(char c, unsigned int from) const { size_t i = str.find(c, from); return i == std::string::npos ? -1 : (int)i; }
+  bool startsWith(const char* s) const { return str.compare(0, strlen(s), s) == 0; }
+  bool startsWith(const String& s) const { return startsWith(s.c_str()); }
+  bool endsWith(const char* s) const
+  {
+    size_t n = strlen(s);
+    return n <= str.size() && str.compare(str.size() - n, n, s) == 0;
+  }
+  long toInt() const { return atol(str.c_str()); }
+  double toFloat() const { return atof(str.c_str()); }
+  void trim()
+  {
+    size_t b = str.find_first_not_of(" \t\r\n");
+    size_t e = str.find_last_not_of(" \t\r\n");
+    str = (b == std::string::npos) ? std::string() : str.substr(b, e - b + 1);
+  }
+
+  bool operator==(const char* s) const { return str == s; }
+  bool operator==(const String& s) const { return str == s.str; }
+  bool operator!=(const char* s) const { return str != s; }
+  String& operator+=(const String& s) { str += s.str; return *this; }
+  String& operator+=(const char* s) { str += s; return *this; }
+  String& operator+=(char c) { str += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.str + b.str); }
+  friend String operator+(const String& a, const char* b) { return String(a.str + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.str); }
+
+private:
+  std::string str;
+};
+
+//----------------------------------------------------------------------------
+// IPAddress
+//----------------------------------------------------------------------------
+class IPAddress
+{
+public:
+  IPAddress() : addr{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr{a, b, c, d} {}
+  uint8_t operator[](int i) const { return addr[i]; }
+  String toString() const
+  {
+    char buf[20];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+    return String(buf);
+  }
+private:
+  uint8_t addr[4];
+};
+
+//----------------------------------------------------------------------------
+// Serial ports
+//----------------------------------------------------------------------------
+// Output goes to stdout when echo is set (off by default so simulations are
+// quiet).  Input comes from rxData, which a tool can fill with a recorded
+// stream;  with meterRx set it is metered out at the baud rate against the
+// virtual clock like a real UART would.
+#define SERIAL_8N1 (0x800001c)
+
+class HostSerial
+{
+public:
+  bool echo = false;
+  std::string rxData;
+  size_t rxPos = 0;
+  bool meterRx = false;            // false = everything available at once
+  unsigned long rxBytesPerSec = 0;
+  uint64_t rxStartMicros = 0;
+  unsigned long txBytes = 0;
+  bool keepTx = false;             // keep what's written in txData, for a tool to read
+  std::string txData;
+  unsigned long txBytesPerSec = 0; // the FIFO drains at this rate, 0 = never full
+  size_t txFifo = 0;               // bytes in the 128 byte FIFO
+  uint64_t txDrainMicros = 0;
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int rxPin = -1, int txPin = -1)
+  {
+    (void)config; (void)rxPin; (void)txPin;
+    rxBytesPerSec = meterRx ? baud / 10 : 0; // 8N1 = 10 bits per byte
+    rxStartMicros = hostMicros;
+  }
+  void end() {}
+  void setRxBufferSize(size_t) {}
+
+  void feed(const char* data, size_t len) { rxData.append(data, len); }
+  int available()
+  {
+    size_t limit = rxData.size();
+    if (rxBytesPerSec)
+    {
+      uint64_t arrived = (hostMicros - rxStartMicros) * rxBytesPerSec / 1000000;
+      if (arrived < limit) limit = arrived;
+    }
+    return limit > rxPos ? (int)(limit - rxPos) : 0;
+  }
+  int read()
+  {
+    if (!available()) return -1;
+    int c = (uint8_t)rxData[rxPos++];
+    if (!meterRx && (rxPos == rxData.size())) { rxData.clear(); rxPos = 0; } // all consumed
+    return c;
+  }
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len)
+  {
+    txBytes += len;
+    if (txBytesPerSec) { availableForWrite(); txFifo += len; }
+    if (keepTx) txData.append((const char*)buf, len);
+    if (echo) fwrite(buf, 1, len, stdout);
+    return len;
+  }
+  int availableForWrite() // the UART FIFO
+  {
+    if (!txBytesPerSec) return 128;
+    size_t gone = (size_t)((hostMicros - txDrainMicros) * txBytesPerSec / 1000000);
+    if (gone > 0) txDrainMicros += (uint64_t)gone * 1000000 / txBytesPerSec;
+    txFifo = (gone >= txFifo) ? 0 : txFifo - gone;
+    if (txFifo == 0) txDrainMicros = hostMicros;
+    return txFifo >= 128 ? 0 : (int)(128 - txFifo);
+  }
+  void flush() {}
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int x) { return print(String(x)); }
+  size_t print(long x) { return print(String(x)); }
+  size_t print(unsigned int x) { return print(String((unsigned long)x)); }
+  size_t print(unsigned long x) { return print(String(x)); }
+  size_t print(double x, int decimals = 2) { return print(String(x, decimals)); }
+  size_t print(const IPAddress& ip) { return print(ip.toString()); }
+  template <typename T> size_t println(const T& x) { size_t n = print(x); return n + print("\r\n"); }
+  size_t println(double x, int decimals) { size_t n = print(x, decimals); return n + print("\r\n"); }
+  size_t println() { return print("\r\n"); }
+  size_t printf(const char* fmt, ...)
+  {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return print(buf);
+  }
+};
+
+inline HostSerial Serial;
+inline HostSerial Serial1;
+inline HostSerial Serial2;
+
+//----------------------------------------------------------------------------
+// ESP32Time - software RTC running off the virtual clock
+//----------------------------------------------------------------------------
+class ESP32Time
+{
+public:
+  ESP32Time(long offset = 0) : offset(offset) {}
+
+  void setTime(unsigned long epoch, int ms = 0)
+  {
+    base = epoch;
+    setAt = hostMicros - (uint64_t)ms * 1000;
+  }
+  void setTime(int sc, int mn, int hr, int dy, int mt, int yr, int ms = 0)
+  {
+    struct tm t = {};
+    t.tm_sec = sc; t.tm_min = mn; t.tm_hour = hr;
+    t.tm_mday = dy; t.tm_mon = mt - 1; t.tm_year = yr - 1900;
+    setTime((unsigned long)timegm(&t), ms);
+  }
+  unsigned long getEpoch() { return base + (unsigned long)((hostMicros - setAt) / 1000000); }
+  unsigned long getLocalEpoch() { return getEpoch() + offset; }
+  unsigned long getMillis() { return (unsigned long)((hostMicros - setAt) / 1000 % 1000); }
+
+  String getTime(const char* fmt)
+  {
+    struct tm t = local();
+    char buf[64];
+    strftime(buf, sizeof(buf), fmt, &t);
+    return String(buf);
+  }
+  int getSecond() { return local().tm_sec; }
+  int getMinute() { return local().tm_min; }
+  int getHour(bool mode24 = false)
+  {
+    int hr = local().tm_hour;
+    if (mode24) return hr;
+    hr %= 12;
+    return hr == 0 ? 12 : hr;
+  }
+  int getDay() { return local().tm_mday; }
+  int getMonth() { return local().tm_mon; }
+  int getYear() { return local().tm_year + 1900; }
+
+  long offset;
+
+private:
+  struct tm local()
+  {
+    time_t now = (time_t)getLocalEpoch();
+    struct tm t;
+    gmtime_r(&now, &t);
+    return t;
+  }
+  unsigned long base = 0;
+  uint64_t setAt = 0;
+};
+
+//----------------------------------------------------------------------------
+// In-memory file system standing in for SPIFFS / SD_MMC
+//----------------------------------------------------------------------------
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+typedef std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> HostFileMap;
+
+// Like the ESP32 File, copies share one open file (readln() takes a File
+// by value and the caller's position moves along with it).
+class File
+{
+public:
+  File() {}
+  File(std::string path, std::shared_ptr<std::vector<uint8_t>> data, bool writable, bool append = true)
+    : f(std::make_shared<Open>())
+  {
+    f->path = path;
+    f->data = data;
+    f->writable = writable;
+    f->append = append;
+  }
+  File(std::string path, HostFileMap* dir) : f(std::make_shared<Open>())
+  {
+    f->path = path;
+    f->dir = dir;
+    f->dirIt = dir->begin();
+  }
+
+  operator bool() const { return f && (f->data || f->dir); }
+  bool isDirectory() const { return f && f->dir; }
+  const char* name() const { return f ? f->path.c_str() : ""; }
+  size_t size() const { return (f && f->data) ? f->data->size() : 0; }
+  size_t position() const { return f ? f->pos : 0; }
+  bool seek(size_t p)
+  {
+    if (!*this || !f->data || p > f->data->size()) return false;
+    f->pos = p;
+    return true;
+  }
+
+  int available() { return (f && f->data) ? (int)(f->data->size() - f->pos) : 0; }
+  int read() { return available() ? (*f->data)[f->pos++] : -1; }
+  int peek() { return available() ? (*f->data)[f->pos] : -1; }
+  size_t read(uint8_t* buf, size_t len)
+  {
+    size_t n = available();
+    if (n > len) n = len;
+    if (n) memcpy(buf, f->data->data() + f->pos, n);
+    if (n) f->pos += n;
+    return n;
+  }
+
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len)
+  {
+    if (!f || !f->data || !f->writable) return 0;
+    if (f->append) f->pos = f->data->size();
+    if (f->pos + len > f->data->size()) f->data->resize(f->pos + len); // "r+" writes over what's there
+    memcpy(f->data->data() + f->pos, buf, len);
+    f->pos += len;
+    return len;
+  }
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t println(const char* s) { size_t n = print(s); return n ? n + print("\r\n") : 0; }
+  size_t println(const String& s) { return println(s.c_str()); }
+  void flush() {}
+  void close()
+  {
+    if (!f) return;
+    f->data = nullptr;
+    f->dir = nullptr;
+  }
+
+  File openNextFile()
+  {
+    if (!isDirectory() || f->dirIt == f->dir->end()) return File();
+    File next(f->dirIt->first, f->dirIt->second, false);
+    ++f->dirIt;
+    return next;
+  }
+
+private:
+  struct Open
+  {
+    std::string path;
+    std::shared_ptr<std::vector<uint8_t>> data;
+    bool writable = false;
+    bool append = true;
+    size_t pos = 0;
+    HostFileMap* dir = nullptr;
+    HostFileMap::iterator dirIt;
+  };
+  std::shared_ptr<Open> f;
+};
+
+class FS
+{
+public:
+  File open(const char* path, const char* mode = FILE_READ)
+  {
+    std::string p(path);
+    if (p == "/") return File(p, &files);
+    auto it = files.find(p);
+    if (failWrites && (mode[0] != 'r')) return File();
+    if (mode[0] == 'r')
+    {
+      if (it == files.end()) return File();
+      return File(p, it->second, mode[1] == '+', false);
+    }
+    if (it == files.end() || mode[0] == 'w')
+      it = files.insert_or_assign(p, std::make_shared<std::vector<uint8_t>>()).first;
+    return File(p, it->second, true);
+  }
+  File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+  bool exists(const char* path) { return files.count(path) != 0; }
+  bool remove(const char* path) { return files.erase(path) != 0; }
+  bool rename(const char* from, const char* to)
+  {
+    auto it = files.find(from);
+    if (it == files.end()) return false;
+    auto data = it->second;
+    files.erase(it);
+    files[to] = data;
+    return true;
+  }
+  bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+  size_t totalBytes() { return 1378241; } // typical 1.5MB SPIFFS partition
+  size_t usedBytes()
+  {
+    size_t n = 0;
+    for (auto& f : files) n += f.second->size();
+    return n;
+  }
+
+  // host helpers - load a real file into the in-memory file system
+  bool load(const char* path, const char* hostPath)
+  {
+    FILE* fp = fopen(hostPath, "rb");
+    if (!fp) return false;
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) data->insert(data->end(), buf, buf + n);
+    fclose(fp);
+    files[path] = data;
+    return true;
+  }
+  void format() { files.clear(); }
+
+  HostFileMap files;
+  bool failWrites = false; // host helper - opens for writing fail (flash full, say)
+};
+
+} // namespace fs
+
+using fs::File;
+inline fs::FS SPIFFS;
+
+//----------------------------------------------------------------------------
+// telnet/serial printing used by the services (see GpsLogger.ino)
+//----------------------------------------------------------------------------
+inline void zprint(const char* msg) { Serial.print(msg); }
+inline void zprint(const String& msg) { Serial.print(msg); }
+inline void zprint(int x) { Serial.print(x); }
+inline void zprint(size_t x) { Serial.print((unsigned long)x); }
+inline void zprintln(const char* msg) { Serial.println(msg); }
+inline void zprintln(const String& msg) { Serial.println(msg); }
+inline void zprintln(int x) { Serial.println(x); }
+inline void zprintln(size_t x) { Serial.println((unsigned long)x); }
+
+#endif
@@ -0,0 +1,674 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Host stand-ins for WiFi, WiFiUDP/NTPClient, ESP32_FTPClient, WiFiClient
+//----------------------------------------------------------------------------
+// Everything here follows a scripted link (hostNet) on the virtual clock
+// from HostArduino.h.  A script is a list of phases, each saying from which
+// second (since hostNet.script()) the AP is in range, what the one-way
+// latency is, what percentage of packets get lost and the link bandwidth.
+//
+//   hostNet.script({ {0, 1, 20, 0, 2000},       // in range, 20ms, no loss
+//                    {300, 0, 0, 0, 0},          // drive off at 5 minutes
+//                    {1500, 1, 20, 0, 2000} },   // back at 25 minutes
+//                  seed);
+//
+// Loss is drawn from a fixed-seed PRNG, so a script always plays out the
+// same way.  Blocking calls (NTP, FTP) advance the virtual clock by the
+// time they would have held up loop() on the ESP32, hostStats adds it up.
+//
+// The stand-ins copy the library behaviour the services depend on:
+//  - WiFi keeps trying to (re)associate while begin() is in effect, until
+//    disconnect() is called (arduino-esp32 auto reconnect)
+//  - NTPClient::update() only asks the server again once the update
+//    interval (60s) has passed since the last good answer, forceUpdate()
+//    always asks and waits up to 1s for the answer
+//  - ESP32_FTPClient ignores errors, once the control connection is gone
+//    every further call just fails (after its timeout if the link is down)
+//  - WiFiClient is one TCP connection to an in-process HostPeer (the
+//    server side of whatever is being simulated).  Bytes reach the peer as
+//    they are written, its replies show up after a round trip.  When the
+//    link goes away the connection is reset:  data in flight is lost both
+//    ways and connected() goes false.
+//  - lwip's non-blocking socket connect and dns_gethostbyname() never
+//    wait.  The connect reaches the same HostPeer once lwip_select() says
+//    it's writable and the socket is handed to WiFiClient(fd);  the DNS
+//    callback comes from hostNetTask(), which a tool calls every pass of
+//    its loop to play lwip's tcpip task.
+//
+#ifndef HOSTNET_H
+#define HOSTNET_H
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "HostArduino.h"
+
+//----------------------------------------------------------------------------
+// scripted link
+//----------------------------------------------------------------------------
+struct NetPhase
+{
+  unsigned long startSec;  // phase starts this many seconds into the script
+  int apUp;                // true if the AP is in range
+  unsigned long latencyMs; // one way
+  int lossPct;             // per packet (or TCP segment)
+  unsigned long kbps;      // link bandwidth, kbit/s
+};
+
+class HostNetLink
+{
+public:
+  void script(const std::vector<NetPhase>& p, uint32_t seed)
+  {
+    phases = p;
+    rng = seed ? seed : 1;
+    startMicros = hostMicros;
+  }
+
+  const NetPhase& phase() const
+  {
+    static const NetPhase always = { 0, true, 5, 0, 10000 };
+    const NetPhase* cur = &always;
+    unsigned long sec = secondsIn();
+    for (const NetPhase& p : phases)
+      if (p.startSec <= sec) cur = &p;
+    return *cur;
+  }
+
+  bool up() const { return phase().apUp; }
+  unsigned long rttMs() const { return 2 * phase().latencyMs; }
+  unsigned long secondsIn() const { return (unsigned long)((hostMicros - startMicros) / 1000000); }
+
+  // when did the AP most recently come into range (micros)
+  uint64_t upSinceMicros() const
+  {
+    unsigned long sec = secondsIn();
+    uint64_t since = startMicros;
+    int wasUp = true;
+    for (const NetPhase& p : phases)
+    {
+      if (p.startSec > sec) break;
+      if (p.apUp && !wasUp) since = startMicros + (uint64_t)p.startSec * 1000000;
+      wasUp = p.apUp;
+    }
+    return since;
+  }
+
+  // true if this packet gets lost
+  bool lost()
+  {
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; // xorshift32
+    return (int)(rng % 100) < phase().lossPct;
+  }
+
+private:
+  std::vector<NetPhase> phases;
+  uint32_t rng = 1;
+  uint64_t startMicros = 0;
+};
+
+inline HostNetLink hostNet;
+
+//----------------------------------------------------------------------------
+// statistics collected by the stand-ins
+//----------------------------------------------------------------------------
+struct HostNetStats
+{
+  uint64_t radioOffUs;       // STA not started, or disconnect() called
+  uint64_t radioSearchUs;    // STA started, not associated (scan/assoc)
+  uint64_t radioConnectedUs; // associated
+  uint64_t lastSampleUs;
+  unsigned long wifiBegins;
+  unsigned long ntpRequests;
+  unsigned long ntpAnswers;
+  uint64_t ntpBlockedUs;
+  unsigned long tcpConnects;
+  uint64_t tcpBytesOut;      // written by the client, including resends after loss
+  unsigned long dnsLookups;  // dns_gethostbyname() queries sent
+  unsigned long ftpSessions;
+  unsigned long ftpFailed;   // sessions that lost the connection
+  uint64_t ftpBytesOffered;
+  uint64_t ftpBytesDelivered;
+  uint64_t ftpUs;
+};
+
+inline HostNetStats hostStats;
+
+//----------------------------------------------------------------------------
+// WiFi
+//----------------------------------------------------------------------------
+typedef int wl_status_t;
+#define WL_IDLE_STATUS (0)
+#define WL_NO_SSID_AVAIL (1)
+#define WL_CONNECTED (3)
+#define WL_CONNECT_FAILED (4)
+#define WL_CONNECTION_LOST (5)
+#define WL_DISCONNECTED (6)
+
+#define WIFI_OFF (0)
+#define WIFI_STA (1)
+#define WIFI_AP (2)
+#define WIFI_AP_STA (3)
+
+#define WIFI_ASSOC_MS (2500) /* scan + auth + assoc + DHCP once the AP is in range */
+
+class WiFiClass
+{
+public:
+  bool mode(int m) { wifiMode = m; if (m == WIFI_OFF) disconnect(); return true; }
+  int getMode() { return wifiMode; }
+
+  int begin(const char* ssid, const char* pwd)
+  {
+    (void)ssid; (void)pwd;
+    staStarted = true;
+    associated = false;
+    beginMicros = hostMicros;
+    hostStats.wifiBegins++;
+    return WL_DISCONNECTED;
+  }
+
+  bool disconnect(bool wifioff = false, bool eraseap = false)
+  {
+    (void)eraseap;
+    staStarted = false;
+    associated = false;
+    if (wifioff) wifiMode = WIFI_OFF;
+    return true;
+  }
+
+  wl_status_t status()
+  {
+    if (!staStarted) return WL_DISCONNECTED;
+    int was = associated;
+    if (!linkUp()) return was ? WL_CONNECTION_LOST : WL_NO_SSID_AVAIL;
+    return WL_CONNECTED;
+  }
+  bool isConnected() { return linkUp(); }
+  IPAddress localIP() { return linkUp() ? IPAddress(192, 168, 1, 77) : IPAddress(); }
+  int RSSI() { return linkUp() ? -67 : 0; }
+
+  // true once associated with the AP in range
+  bool linkUp()
+  {
+    if (!staStarted || !hostNet.up())
+    {
+      associated = false;
+      return false;
+    }
+    if (!associated)
+    {
+      uint64_t from = hostNet.upSinceMicros();
+      if (beginMicros > from) from = beginMicros;
+      if (hostMicros >= from + (WIFI_ASSOC_MS + hostNet.rttMs()) * 1000ULL) associated = true;
+    }
+    return associated;
+  }
+
+  // add the time since the last call to the radio statistics
+  void sampleRadio()
+  {
+    uint64_t dt = hostMicros - hostStats.lastSampleUs;
+    hostStats.lastSampleUs = hostMicros;
+    if (!staStarted) hostStats.radioOffUs += dt;
+    else if (linkUp()) hostStats.radioConnectedUs += dt;
+    else hostStats.radioSearchUs += dt;
+  }
+
+private:
+  int wifiMode = WIFI_OFF;
+  bool staStarted = false;
+  bool associated = false;
+  uint64_t beginMicros = 0;
+};
+
+inline WiFiClass WiFi;
+
+//----------------------------------------------------------------------------
+// UDP + NTP client
+//----------------------------------------------------------------------------
+#define HOSTNET_EPOCH (1700000000UL) /* "true" time at virtual time zero */
+
+inline unsigned long hostTrueEpoch() { return HOSTNET_EPOCH + (unsigned long)(hostMicros / 1000000); }
+
+class WiFiUDP
+{
+public:
+  uint8_t begin(uint16_t port) { (void)port; return 1; }
+  void stop() {}
+};
+
+class NTPClient
+{
+public:
+  NTPClient(WiFiUDP& udp) { (void)udp; }
+
+  void begin() {}
+  void begin(unsigned int port) { (void)port; }
+  void end() {}
+  void setTimeOffset(int off) { timeOffset = off; }
+  void setUpdateInterval(unsigned long ms) { updateInterval = ms; }
+
+  bool update()
+  {
+    if ((millis() - lastUpdate >= updateInterval) || lastUpdate == 0)
+      return forceUpdate();
+    return false; // not time to ask yet
+  }
+
+  bool forceUpdate()
+  {
+    uint64_t t0 = hostMicros;
+    hostStats.ntpRequests++;
+    // the library polls for the answer every 10ms for up to 1s
+    unsigned long rtt = hostNet.rttMs();
+    bool answered = WiFi.linkUp() && !hostNet.lost() && !hostNet.lost() && (rtt < 1000);
+    if (answered)
+    {
+      delay((rtt / 10 + 1) * 10);
+      lastUpdate = millis();
+      epoch = hostTrueEpoch();
+      hostStats.ntpAnswers++;
+    }
+    else
+    {
+      delay(1010);
+    }
+    hostStats.ntpBlockedUs += hostMicros - t0;
+    return answered;
+  }
+
+  bool isTimeSet() const { return lastUpdate != 0; }
+  unsigned long getEpochTime() const { return timeOffset + epoch + (millis() - lastUpdate) / 1000; }
+
+private:
+  long timeOffset = 0;
+  unsigned long updateInterval = 60000;
+  unsigned long lastUpdate = 0;
+  unsigned long epoch = 0;
+};
+
+//----------------------------------------------------------------------------
+// FTP client
+//----------------------------------------------------------------------------
+#define HOSTNET_MSS (1460)
+
+class ESP32_FTPClient
+{
+public:
+  ESP32_FTPClient(char* server, char* user, char* pwd, uint16_t timeout = 10000, uint8_t verbose = 1)
+    : timeoutMs(timeout)
+  {
+    (void)server; (void)user; (void)pwd; (void)verbose;
+  }
+  ~ESP32_FTPClient()
+  {
+    if (started) hostStats.ftpUs += hostMicros - startMicros;
+  }
+
+  void OpenConnection()
+  {
+    started = true;
+    startMicros = hostMicros;
+    hostStats.ftpSessions++;
+    connected = true;
+    exchange(4); // TCP connect, banner, USER, PASS
+  }
+  void InitFile(const char* type) { (void)type; exchange(3); } // TYPE, PASV, data connect
+  void ChangeWorkDir(const char* dir) { (void)dir; exchange(1); }
+  void NewFile(const char* fn) { (void)fn; exchange(1); }
+  void CloseFile() { exchange(1); }
+  void CloseConnection() { exchange(1); connected = false; }
+  bool isConnected() { return connected; }
+
+  void WriteData(unsigned char* data, int len)
+  {
+    (void)data;
+    hostStats.ftpBytesOffered += len;
+    if (!connected) return;
+    if (!WiFi.linkUp())
+    {
+      fail();
+      return;
+    }
+    // small writes get coalesced into full segments by the TCP stack,
+    // a lost segment costs a retransmission timeout
+    unsigned long kbps = hostNet.phase().kbps ? hostNet.phase().kbps : 1;
+    delayMicroseconds((unsigned int)((uint64_t)len * 8 * 1000 / kbps));
+    segFill += len;
+    while (segFill >= HOSTNET_MSS)
+    {
+      segFill -= HOSTNET_MSS;
+      if (hostNet.lost()) delay(rto());
+    }
+    hostStats.ftpBytesDelivered += len;
+  }
+
+private:
+  // n command/response round trips on the control connection
+  void exchange(int n)
+  {
+    while (connected && n-- > 0)
+    {
+      unsigned long waited = 0;
+      for (;;)
+      {
+        if (!WiFi.linkUp() || waited >= timeoutMs)
+        {
+          fail();
+          return;
+        }
+        if (!hostNet.lost() && !hostNet.lost()) break;
+        delay(rto());
+        waited += rto();
+      }
+      delay(hostNet.rttMs());
+    }
+  }
+
+  unsigned long rto() { unsigned long r = 3 * hostNet.rttMs(); return r < 200 ? 200 : r; }
+
+  // connection is gone - the library waits out its timeout, then gives up
+  void fail()
+  {
+    delay(timeoutMs);
+    connected = false;
+    hostStats.ftpFailed++;
+  }
+
+  unsigned long timeoutMs;
+  int segFill = 0;
+  bool started = false;
+  bool connected = false;
+  uint64_t startMicros = 0;
+};
+
+//----------------------------------------------------------------------------
+// TCP client talking to an in-process server
+//----------------------------------------------------------------------------
+class HostPeer
+{
+public:
+  virtual ~HostPeer() {}
+  virtual void onConnect() = 0;
+  virtual void onData(const uint8_t* data, size_t len) = 0;
+  virtual void onClose() = 0;
+
+  // reply to the client, arrives one round trip from now
+  void send(const uint8_t* data, size_t len)
+  {
+    uint64_t at = hostMicros + hostNet.rttMs() * 1000ULL;
+    for (size_t i = 0; i < len; i++) replies.push_back({ at, data[i] });
+  }
+
+  struct Byte { uint64_t at; uint8_t c; };
+  std::vector<Byte> replies;
+  size_t replyPos = 0;
+};
+
+inline HostPeer* hostPeer = nullptr; // the server WiFiClient::connect() reaches
+
+class WiFiClient
+{
+public:
+  WiFiClient() {}
+  WiFiClient(int fd) // a socket lwip_connect() has connected
+  {
+    (void)fd;
+    attach();
+  }
+
+  int connect(const char* host, uint16_t port, int32_t timeout = 3000)
+  {
+    (void)host; (void)port;
+    stop();
+    if (hostPeer == nullptr) return 0;
+    unsigned long waited = 0;
+    // SYN / SYN-ACK, retried on loss like the TCP stack does
+    for (;;)
+    {
+      if (!WiFi.linkUp() || (long)waited >= timeout)
+      {
+        delay(timeout > (long)waited ? timeout - waited : 0);
+        return 0;
+      }
+      if (!hostNet.lost() && !hostNet.lost()) break;
+      delay(1000);
+      waited += 1000;
+    }
+    delay(hostNet.rttMs());
+    attach();
+    return 1;
+  }
+
+  size_t write(const uint8_t* buf, size_t len)
+  {
+    size_t done = 0;
+    while (connected() && (done < len))
+    {
+      size_t n = len - done > HOSTNET_MSS ? HOSTNET_MSS : len - done;
+      unsigned long kbps = hostNet.phase().kbps ? hostNet.phase().kbps : 1;
+      delayMicroseconds((unsigned int)((uint64_t)n * 8 * 1000 / kbps));
+      hostStats.tcpBytesOut += n;
+      while (hostNet.lost() && connected()) // retransmit
+      {
+        unsigned long r = 3 * hostNet.rttMs();
+        delay(r < 200 ? 200 : r);
+        hostStats.tcpBytesOut += n;
+      }
+      if (!connected()) break;
+      peer->onData(buf + done, n);
+      done += n;
+    }
+    return done;
+  }
+  size_t write(uint8_t c) { return write(&c, 1); }
+
+  int available()
+  {
+    if (!connected()) return 0;
+    size_t n = 0;
+    for (size_t i = peer->replyPos; i < peer->replies.size() && peer->replies[i].at <= hostMicros; i++) n++;
+    return (int)n;
+  }
+  int read()
+  {
+    if (!available()) return -1;
+    return peer->replies[peer->replyPos++].c;
+  }
+  int read(uint8_t* buf, size_t len)
+  {
+    size_t n = 0;
+    while ((n < len) && available()) buf[n++] = (uint8_t)read();
+    return (int)n;
+  }
+
+  // false once the link has dropped - the connection is reset
+  uint8_t connected()
+  {
+    if (peer && !WiFi.linkUp()) stop();
+    return peer != nullptr;
+  }
+
+  void stop()
+  {
+    if (peer) peer->onClose();
+    peer = nullptr;
+  }
+
+private:
+  void attach()
+  {
+    hostStats.tcpConnects++;
+    peer = hostPeer;
+    peer->replies.clear();
+    peer->replyPos = 0;
+    peer->onConnect();
+  }
+
+  HostPeer* peer = nullptr;
+};
+
+//----------------------------------------------------------------------------
+// lwip sockets - just a non-blocking connect to hostPeer
+//----------------------------------------------------------------------------
+#define HOSTSOCK_FIRST (54) /* LWIP_SOCKET_OFFSET on the ESP32 */
+
+struct HostSocket
+{
+  bool open;
+  bool nonBlocking;
+  bool connecting;
+  uint64_t readyAt;   // the handshake is done (micros)
+  int err;            // SO_ERROR
+};
+
+inline std::vector<HostSocket> hostSockets;
+
+inline HostSocket* hostSocket(int fd)
+{
+  if ((fd < HOSTSOCK_FIRST) || (fd >= HOSTSOCK_FIRST + (int)hostSockets.size())) return nullptr;
+  HostSocket* s = &hostSockets[fd - HOSTSOCK_FIRST];
+  return s->open ? s : nullptr;
+}
+
+inline int lwip_socket(int domain, int type, int protocol)
+{
+  (void)domain; (void)type; (void)protocol;
+  size_t i = 0;
+  while ((i < hostSockets.size()) && hostSockets[i].open) i++;
+  if (i == hostSockets.size()) hostSockets.push_back(HostSocket());
+  hostSockets[i] = HostSocket();
+  hostSockets[i].open = true;
+  return HOSTSOCK_FIRST + (int)i;
+}
+
+inline int lwip_fcntl(int fd, int cmd, int val)
+{
+  HostSocket* s = hostSocket(fd);
+  if (!s) return -1;
+  if (cmd == F_GETFL) return s->nonBlocking ? O_NONBLOCK : 0;
+  if (cmd == F_SETFL) s->nonBlocking = (val & O_NONBLOCK) != 0;
+  return 0;
+}
+
+// SYNs lost and retried as in WiFiClient::connect(), but nothing waits
+inline int lwip_connect(int fd, const struct sockaddr* addr, socklen_t len)
+{
+  (void)addr; (void)len;
+  HostSocket* s = hostSocket(fd);
+  if (!s || !s->nonBlocking) { errno = EBADF; return -1; } // only the non-blocking kind here
+  if (!WiFi.linkUp()) { errno = EHOSTUNREACH; return -1; }
+  if (hostPeer == nullptr) { errno = ECONNREFUSED; return -1; }
+  unsigned long ms = 0;
+  while ((hostNet.lost() || hostNet.lost()) && (ms < 75000)) ms += 1000;
+  s->connecting = true;
+  s->readyAt = hostMicros + (ms + hostNet.rttMs()) * 1000ULL;
+  errno = EINPROGRESS;
+  return -1;
+}
+
+// write readiness only, and always a poll (tv is taken as zero)
+inline int lwip_select(int n, fd_set* rd, fd_set* wr, fd_set* ex, struct timeval* tv)
+{
+  (void)tv;
+  if (rd) FD_ZERO(rd);
+  if (ex) FD_ZERO(ex);
+  int ready = 0;
+  for (int fd = HOSTSOCK_FIRST; wr && (fd < n); fd++)
+  {
+    if (!FD_ISSET(fd, wr)) continue;
+    HostSocket* s = hostSocket(fd);
+    if (s && s->connecting && WiFi.linkUp() && (hostMicros >= s->readyAt)) ready++;
+    else FD_CLR(fd, wr);
+  }
+  return ready;
+}
+
+inline int lwip_getsockopt(int fd, int level, int name, void* val, socklen_t* len)
+{
+  (void)level; (void)name;
+  HostSocket* s = hostSocket(fd);
+  if (!s || (*len < sizeof(int))) return -1;
+  *(int*)val = s->err;
+  return 0;
+}
+
+inline int lwip_close(int fd)
+{
+  HostSocket* s = hostSocket(fd);
+  if (!s) return -1;
+  s->open = false;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// lwip DNS - the answer one round trip later, nothing if a packet is lost
+// (lwip gives up after a few retries and says so)
+//----------------------------------------------------------------------------
+typedef int8_t err_t;
+#define ERR_OK (0)
+#define ERR_INPROGRESS (-5)
+#define ERR_ARG (-16)
+
+#define HOSTDNS_GIVEUP_MS (5000)
+#define HOSTDNS_ADDR "10.0.0.2" /* every name resolves to this */
+
+struct ip4_addr_t { uint32_t addr; };
+struct ip_addr_t
+{
+  union { ip4_addr_t ip4; } u_addr;
+  uint8_t type;
+};
+typedef void (*dns_found_callback)(const char* name, const ip_addr_t* ipaddr, void* arg);
+
+struct HostDnsQuery
+{
+  uint64_t at;
+  bool answered;
+  std::string name;
+  dns_found_callback found;
+  void* arg;
+};
+
+inline std::vector<HostDnsQuery> hostDnsQueries;
+
+inline err_t dns_gethostbyname(const char* name, ip_addr_t* addr, dns_found_callback found, void* arg)
+{
+  if ((name == nullptr) || (name[0] == 0)) return ERR_ARG;
+  struct in_addr a;
+  if (inet_pton(AF_INET, name, &a) == 1)
+  {
+    addr->u_addr.ip4.addr = a.s_addr;
+    addr->type = 0;
+    return ERR_OK;
+  }
+  hostStats.dnsLookups++;
+  bool answered = WiFi.linkUp() && !hostNet.lost() && !hostNet.lost();
+  uint64_t at = hostMicros + (answered ? hostNet.rttMs() : HOSTDNS_GIVEUP_MS) * 1000ULL;
+  hostDnsQueries.push_back({ at, answered, name, found, arg });
+  return ERR_INPROGRESS;
+}
+
+// lwip's tcpip task - callbacks for the DNS answers due
+inline void hostNetTask()
+{
+  for (size_t i = 0; i < hostDnsQueries.size(); )
+  {
+    HostDnsQuery q = hostDnsQueries[i];
+    if (q.at > hostMicros)
+    {
+      i++;
+      continue;
+    }
+    hostDnsQueries.erase(hostDnsQueries.begin() + i);
+    ip_addr_t addr = {};
+    inet_pton(AF_INET, HOSTDNS_ADDR, &addr.u_addr.ip4.addr);
+    q.found(q.name.c_str(), q.answered ? &addr : nullptr, q.arg);
+  }
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Host stand-ins for WiFiServer / WiFiClient on real (POSIX) sockets
+//----------------------------------------------------------------------------
+// For host tools that serve real clients on the PC, e.g. a gpsd client or
+// a nav app pointed at localhost.  Like the arduino-esp32 classes, copies
+// of a WiFiClient share one socket, fd() is the lwIP socket number (so
+// services can call send()/recv() on it directly), and
+// WiFiServer::available() never waits.
+//
+// Accepted sockets get a send buffer the size of lwIP's default
+// (TCP_SND_BUF), so a client that stops reading backs up as soon as it
+// would on the ESP32 rather than after megabytes of Linux buffering.
+//
+// Not for use together with HostNet.h, which has a simulated WiFiClient.
+//
+#ifndef HOSTSOCKET_H
+#define HOSTSOCKET_H
+
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "HostArduino.h"
+
+#define HOSTSOCKET_SNDBUF (5744) /* arduino-esp32 CONFIG_LWIP_TCP_SND_BUF_DEFAULT */
+
+class WiFiClient
+{
+public:
+  WiFiClient() {}
+  explicit WiFiClient(int fd) : sock(std::make_shared<Sock>(fd)) {}
+
+  int fd() const { return sock ? sock->fd : -1; }
+  explicit operator bool() const { return fd() >= 0; }
+
+  uint8_t connected()
+  {
+    if (fd() < 0) return false;
+    char c;
+    int n = recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0) return true;
+    if (n == 0) return false; // orderly close
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+  }
+
+  int available()
+  {
+    int n = 0;
+    if ((fd() < 0) || (ioctl(fd(), FIONREAD, &n) < 0)) return 0;
+    return n;
+  }
+
+  int read()
+  {
+    uint8_t c;
+    return (fd() >= 0) && (recv(fd(), &c, 1, MSG_DONTWAIT) == 1) ? c : -1;
+  }
+
+  size_t write(const uint8_t* buf, size_t len)
+  {
+    if (fd() < 0) return 0;
+    ssize_t n = send(fd(), buf, len, MSG_NOSIGNAL);
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  void setNoDelay(bool on)
+  {
+    int v = on;
+    if (fd() >= 0) setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+  }
+
+  IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+
+  void stop() { sock.reset(); }
+
+private:
+  struct Sock
+  {
+    explicit Sock(int f) : fd(f) {}
+    ~Sock() { if (fd >= 0) close(fd); }
+    int fd;
+  };
+  std::shared_ptr<Sock> sock;
+};
+
+class WiFiServer
+{
+public:
+  explicit WiFiServer(uint16_t port) : port(port) {}
+
+  void begin()
+  {
+    signal(SIGPIPE, SIG_IGN); // a client going away is an error return, as on lwIP
+    lfd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    if ((bind(lfd, (sockaddr*)&a, sizeof(a)) < 0) || (listen(lfd, 8) < 0))
+    {
+      perror("WiFiServer");
+      exit(1);
+    }
+    fcntl(lfd, F_SETFL, O_NONBLOCK);
+  }
+
+  void setNoDelay(bool on) { noDelay = on; }
+
+  // accept a waiting connection, if there is one
+  WiFiClient available()
+  {
+    int fd = accept(lfd, NULL, NULL);
+    if (fd < 0) return WiFiClient();
+    int sndbuf = HOSTSOCKET_SNDBUF;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    WiFiClient c(fd);
+    c.setNoDelay(noDelay);
+    return c;
+  }
+
+private:
+  uint16_t port;
+  int lfd = -1;
+  bool noDelay = false;
+};
+
+#endif
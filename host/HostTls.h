@@ -0,0 +1,206 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Host stand-ins for the mbedtls 2.x calls TlsUploadService.h makes, and
+// Preferences (NVS)
+//----------------------------------------------------------------------------
+// No cryptography here - this is for checking what tlsPut() does around
+// the handshake (when it connects, what it writes), not TLS itself.  The
+// handshake writes a ClientHello sized record through the BIO and then
+// fails as if the server had hung up, so an upload never gets as far as
+// the credentials.  hostTls counts the calls a check looks at.
+//
+// mbedtls_x509_crt_parse() accepts anything that starts with a PEM
+// certificate header, so a test can put a "good" or an unreadable
+// /ca.pem on the file system.
+//
+#ifndef HOSTTLS_H
+#define HOSTTLS_H
+
+#include "HostArduino.h"
+
+#define MBEDTLS_ERR_NET_SEND_FAILED   (-0x004E)
+#define MBEDTLS_ERR_NET_RECV_FAILED   (-0x004C)
+#define MBEDTLS_ERR_NET_CONN_RESET    (-0x0050)
+#define MBEDTLS_ERR_SSL_CONN_EOF      (-0x7280)
+#define MBEDTLS_ERR_SSL_WANT_READ     (-0x6900)
+#define MBEDTLS_ERR_SSL_WANT_WRITE    (-0x6880)
+#define MBEDTLS_ERR_SSL_TIMEOUT       (-0x6800)
+#define MBEDTLS_ERR_X509_INVALID_FORMAT (-0x2180)
+
+#define MBEDTLS_SSL_IS_CLIENT (0)
+#define MBEDTLS_SSL_TRANSPORT_STREAM (0)
+#define MBEDTLS_SSL_PRESET_DEFAULT (0)
+#define MBEDTLS_SSL_VERIFY_NONE (0)
+#define MBEDTLS_SSL_VERIFY_REQUIRED (2)
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED (1)
+
+#define HOSTTLS_HELLO (517) /* bytes of a typical ClientHello record */
+
+struct HostTlsStats
+{
+  unsigned long setups;      // mbedtls_ssl_setup()
+  unsigned long handshakes;  // mbedtls_ssl_handshake() started
+  unsigned long appWrites;   // mbedtls_ssl_write() - the HTTP request
+};
+
+inline HostTlsStats hostTls;
+
+typedef int (*mbedtls_ssl_send_t)(void*, const unsigned char*, size_t);
+typedef int (*mbedtls_ssl_recv_t)(void*, unsigned char*, size_t);
+typedef int (*mbedtls_ssl_recv_timeout_t)(void*, unsigned char*, size_t, uint32_t);
+
+struct mbedtls_x509_buf { unsigned char* p = nullptr; size_t len = 0; };
+struct mbedtls_x509_crt { mbedtls_x509_buf raw; int parsed = false; };
+struct mbedtls_entropy_context { int unused; };
+struct mbedtls_ctr_drbg_context { int unused; };
+struct mbedtls_ssl_session
+{
+  size_t id_len = 0;
+  unsigned char id[32] = {};
+  time_t start = 0;
+};
+struct mbedtls_ssl_config { int authmode = MBEDTLS_SSL_VERIFY_REQUIRED; };
+struct mbedtls_ssl_context
+{
+  const mbedtls_ssl_config* conf = nullptr;
+  void* bio = nullptr;
+  mbedtls_ssl_send_t send = nullptr;
+  int up = false;
+};
+
+inline int mbedtls_entropy_func(void*, unsigned char* out, size_t len) { memset(out, 0x5A, len); return 0; }
+inline void mbedtls_entropy_init(mbedtls_entropy_context*) {}
+inline void mbedtls_entropy_free(mbedtls_entropy_context*) {}
+inline void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context*) {}
+inline void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context*) {}
+inline int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context*, int (*)(void*, unsigned char*, size_t),
+  void*, const unsigned char*, size_t) { return 0; }
+inline int mbedtls_ctr_drbg_random(void*, unsigned char* out, size_t len) { memset(out, 0xA5, len); return 0; }
+
+inline void mbedtls_x509_crt_init(mbedtls_x509_crt* crt) { *crt = mbedtls_x509_crt(); }
+inline void mbedtls_x509_crt_free(mbedtls_x509_crt* crt) { *crt = mbedtls_x509_crt(); }
+inline int mbedtls_x509_crt_parse(mbedtls_x509_crt* crt, const unsigned char* buf, size_t len)
+{
+  static const char hdr[] = "-----BEGIN CERTIFICATE-----";
+  if ((len < sizeof(hdr)) || (memcmp(buf, hdr, sizeof(hdr) - 1) != 0)) return MBEDTLS_ERR_X509_INVALID_FORMAT;
+  crt->parsed = true;
+  return 0;
+}
+
+inline void mbedtls_ssl_config_init(mbedtls_ssl_config* conf) { *conf = mbedtls_ssl_config(); }
+inline void mbedtls_ssl_config_free(mbedtls_ssl_config*) {}
+inline int mbedtls_ssl_config_defaults(mbedtls_ssl_config*, int, int, int) { return 0; }
+inline void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int mode) { conf->authmode = mode; }
+inline void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config*, mbedtls_x509_crt*, void*) {}
+inline void mbedtls_ssl_conf_rng(mbedtls_ssl_config*, int (*)(void*, unsigned char*, size_t), void*) {}
+inline void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config*, int) {}
+inline void mbedtls_ssl_conf_read_timeout(mbedtls_ssl_config*, uint32_t) {}
+
+inline void mbedtls_ssl_init(mbedtls_ssl_context* ssl) { *ssl = mbedtls_ssl_context(); }
+inline void mbedtls_ssl_free(mbedtls_ssl_context*) {}
+inline int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf)
+{
+  hostTls.setups++;
+  ssl->conf = conf;
+  return 0;
+}
+inline int mbedtls_ssl_set_hostname(mbedtls_ssl_context*, const char*) { return 0; }
+inline void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* bio, mbedtls_ssl_send_t send,
+  mbedtls_ssl_recv_t, mbedtls_ssl_recv_timeout_t)
+{
+  ssl->bio = bio;
+  ssl->send = send;
+}
+inline int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl)
+{
+  hostTls.handshakes++;
+  unsigned char hello[HOSTTLS_HELLO];
+  memset(hello, 0x16, sizeof(hello));
+  if ((ssl->send == nullptr) || (ssl->send(ssl->bio, hello, sizeof(hello)) <= 0)) return MBEDTLS_ERR_NET_SEND_FAILED;
+  return MBEDTLS_ERR_SSL_CONN_EOF; // the stand-in server never answers
+}
+inline int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len)
+{
+  hostTls.appWrites++;
+  return ssl->up ? ssl->send(ssl->bio, buf, len) : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+inline int mbedtls_ssl_read(mbedtls_ssl_context*, unsigned char*, size_t) { return MBEDTLS_ERR_SSL_CONN_EOF; }
+inline int mbedtls_ssl_close_notify(mbedtls_ssl_context*) { return 0; }
+inline const char* mbedtls_ssl_get_ciphersuite(const mbedtls_ssl_context*) { return "host-stand-in"; }
+inline const mbedtls_x509_crt* mbedtls_ssl_get_peer_cert(const mbedtls_ssl_context*) { return nullptr; }
+
+inline void mbedtls_ssl_session_init(mbedtls_ssl_session* s) { *s = mbedtls_ssl_session(); }
+inline void mbedtls_ssl_session_free(mbedtls_ssl_session*) {}
+inline int mbedtls_ssl_get_session(const mbedtls_ssl_context*, mbedtls_ssl_session*) { return MBEDTLS_ERR_SSL_CONN_EOF; }
+inline int mbedtls_ssl_set_session(mbedtls_ssl_context*, const mbedtls_ssl_session*) { return 0; }
+inline int mbedtls_ssl_session_save(const mbedtls_ssl_session* s, unsigned char* buf, size_t len, size_t* olen)
+{
+  *olen = sizeof(*s);
+  if (len < sizeof(*s)) return MBEDTLS_ERR_SSL_CONN_EOF;
+  memcpy(buf, s, sizeof(*s));
+  return 0;
+}
+inline int mbedtls_ssl_session_load(mbedtls_ssl_session* s, const unsigned char* buf, size_t len)
+{
+  if (len != sizeof(*s)) return MBEDTLS_ERR_SSL_CONN_EOF;
+  memcpy(s, buf, sizeof(*s));
+  return 0;
+}
+
+inline int mbedtls_sha256_ret(const unsigned char*, size_t, unsigned char* out, int) { memset(out, 0, 32); return 0; }
+inline int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen)
+{
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = 0;
+  for (size_t i = 0; i < slen; i += 3)
+  {
+    uint32_t v = src[i] << 16 | (i + 1 < slen ? src[i+1] << 8 : 0) | (i + 2 < slen ? src[i+2] : 0);
+    if (n + 4 > dlen) return -0x002A;
+    dst[n++] = b64[(v >> 18) & 63];
+    dst[n++] = b64[(v >> 12) & 63];
+    dst[n++] = (i + 1 < slen) ? b64[(v >> 6) & 63] : '=';
+    dst[n++] = (i + 2 < slen) ? b64[v & 63] : '=';
+  }
+  *olen = n;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Preferences (NVS) - namespaces of byte strings, lost with the process
+//----------------------------------------------------------------------------
+class Preferences
+{
+public:
+  bool begin(const char* name, bool readOnly = false) { (void)readOnly; ns = &store()[name]; return true; }
+  void end() { ns = nullptr; }
+  bool clear() { ns->clear(); return true; }
+  size_t putBytes(const char* key, const void* v, size_t len) { (*ns)[key].assign((const char*)v, len); return len; }
+  size_t putString(const char* key, const char* v) { return putBytes(key, v, strlen(v)); }
+  size_t getBytesLength(const char* key) { auto it = ns->find(key); return (it == ns->end()) ? 0 : it->second.size(); }
+  size_t getBytes(const char* key, void* buf, size_t len)
+  {
+    auto it = ns->find(key);
+    if ((it == ns->end()) || (it->second.size() > len)) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+  size_t getString(const char* key, char* buf, size_t len)
+  {
+    auto it = ns->find(key);
+    if ((it == ns->end()) || (it->second.size() >= len)) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    buf[it->second.size()] = 0;
+    return it->second.size();
+  }
+
+  static std::map<std::string, std::map<std::string, std::string>>& store()
+  {
+    static std::map<std::string, std::map<std::string, std::string>> s;
+    return s;
+  }
+
+private:
+  std::map<std::string, std::string>* ns = nullptr;
+};
+
+#endif
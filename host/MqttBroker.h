@@ -0,0 +1,149 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// MQTT 3.1.1 broker stand-in - the part of a broker MqttService.h talks to
+//----------------------------------------------------------------------------
+// One MqttBroker per TCP connection.  Bytes from the client go in with
+// onData(), packets to send back come out through the reply callback.
+// CONNECT gets CONNACK (accepted), PUBLISH QoS 1 gets PUBACK once the
+// message has been handed to the message callback, PINGREQ gets PINGRESP.
+// No subscriptions, no retained messages, no QoS 2 - the message callback
+// plays the subscriber.
+//
+// Used by host/mqttbench.cpp (simulated link).
+//
+#ifndef MQTTBROKER_H
+#define MQTTBROKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+struct MqttBrokerStats
+{
+  unsigned long connects = 0;
+  unsigned long publishes = 0;  // including DUP resends
+  unsigned long dupFlagged = 0; // arrived with the DUP flag set
+  unsigned long pings = 0;
+  unsigned long badPackets = 0;
+};
+
+class MqttBroker
+{
+public:
+  typedef std::function<void(const std::string& topic, const std::string& payload)> Message;
+
+  MqttBroker(MqttBrokerStats& stats, Message message,
+             std::function<void(const uint8_t*, size_t)> reply)
+    : stats(stats), message(message), reply(reply) {}
+
+  void onData(const uint8_t* data, size_t len)
+  {
+    for (size_t i = 0; i < len; i++) push(data[i]);
+  }
+
+  const std::string& clientId() const { return id; }
+
+private:
+  // fixed header, remaining length, then the rest of the packet
+  void push(uint8_t c)
+  {
+    if (have == 0)
+    {
+      type = c;
+      remain = 0;
+      shift = 0;
+      body.clear();
+      have = -1;
+      return;
+    }
+    if (have < 0)
+    {
+      remain |= (uint32_t)(c & 0x7f) << shift;
+      shift += 7;
+      if (c & 0x80) return;
+      have = 1;
+      if (remain == 0) packet();
+      return;
+    }
+    body.push_back(c);
+    if (body.size() == remain) packet();
+  }
+
+  void packet()
+  {
+    have = 0;
+    switch (type & 0xf0)
+    {
+      case 0x10: connect(); break;
+      case 0x30: publish(); break;
+      case 0xC0:
+      {
+        stats.pings++;
+        uint8_t pingresp[2] = { 0xD0, 0 };
+        reply(pingresp, 2);
+        break;
+      }
+      case 0xE0: break; // DISCONNECT
+      default: stats.badPackets++;
+    }
+  }
+
+  std::string str(size_t& at)
+  {
+    if (at + 2 > body.size()) return "";
+    size_t n = (body[at] << 8) | body[at+1];
+    at += 2;
+    if (at + n > body.size()) n = body.size() - at;
+    std::string s((const char*)&body[at], n);
+    at += n;
+    return s;
+  }
+
+  void connect()
+  {
+    size_t at = 0;
+    std::string proto = str(at);
+    uint8_t rc = 0;
+    if ((proto != "MQTT") || (at + 4 > body.size()) || (body[at] != 4)) rc = 1; // unacceptable protocol version
+    at += 4; // level, flags, keepalive
+    id = str(at);
+    stats.connects++;
+    uint8_t connack[4] = { 0x20, 2, 0, rc };
+    reply(connack, 4);
+  }
+
+  void publish()
+  {
+    int qos = (type >> 1) & 3;
+    size_t at = 0;
+    std::string topic = str(at);
+    uint16_t pid = 0;
+    if (qos > 0)
+    {
+      if (at + 2 > body.size()) { stats.badPackets++; return; }
+      pid = (body[at] << 8) | body[at+1];
+      at += 2;
+    }
+    stats.publishes++;
+    if (type & 0x08) stats.dupFlagged++;
+    message(topic, std::string((const char*)&body[at], body.size() - at));
+    if (qos == 1)
+    {
+      uint8_t puback[4] = { 0x40, 2, (uint8_t)(pid >> 8), (uint8_t)pid };
+      reply(puback, 4);
+    }
+  }
+
+  MqttBrokerStats& stats;
+  Message message;
+  std::function<void(const uint8_t*, size_t)> reply;
+  std::string id;
+  uint8_t type = 0;
+  int have = 0;
+  uint32_t remain = 0;
+  int shift = 0;
+  std::vector<uint8_t> body;
+};
+
+#endif
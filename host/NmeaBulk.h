@@ -0,0 +1,402 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Bulk NMEA parser for the server side tools - a buffer of lines at a time
+// into RMC and GGA columns
+//----------------------------------------------------------------------------
+// rmcParse() / ggaParse() (NmeaService.h) take a line at a time, as the
+// logger gets them, and walk it byte by byte for each field asked for.
+// Here a whole buffer (an upload, a mapped file) goes in at once:
+//   index       a window of NMEA_WINDOW bytes at a time, 64 bytes a step,
+//               compared for '\n', ',' and '*' - bitmaps, one bit a byte
+//               (AVX2 32 bytes a compare, SSE 16, or plain C)
+//   lines       from the '\n' bits;  only $xxRMC and $xxGGA go further
+//   checksum    the bytes from '$' to the first '*' XORed 32 / 16 at a
+//               time and folded, against the two hex digits after it
+//   fields      where each one starts from the ',' bits, no scanning,
+//               numbers decoded as fixed point straight from the buffer
+// into NmeaColumns, one array per field.  What goes in a column is what
+// rmcParse()/ggaParse() would have said: RMC only with an 'A' and a date,
+// GGA any with a time.
+//
+// nmeaBulkParse() picks AVX2, SSE4.2 or plain C from the CPU it runs on;
+// nmeaBulkParseWith() takes one.  One build, no -march needed (GCC/clang
+// target attributes).  Nothing is read outside the buffer.
+//
+// Used by host/nmeabench.cpp.  Include after
+// HostArduino.h, NmeaService.h and TrackSegmentService.h (SEG_EPOCH).
+//
+#ifndef NMEABULK_H
+#define NMEABULK_H
+
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NMEA_X86 1
+#endif
+
+#define NMEA_WINDOW (4096)           /* bytes indexed at a time, a multiple of 64 */
+#define NMEA_MAXFIELDS (24)
+
+enum { NMEA_SCALAR, NMEA_SSE42, NMEA_AVX2, NMEA_AUTO };
+static const char* nmeaBulkName[] = { "scalar", "sse4.2", "avx2", "auto" };
+
+struct NmeaColumns
+{
+  // RMC with status A and a date
+  std::vector<int32_t> rmcTime;      // seconds from SEG_EPOCH
+  std::vector<int32_t> rmcLat, rmcLon; // degrees x 1e6
+  std::vector<int32_t> rmcSpeed;     // knots x 100
+  std::vector<int32_t> rmcCourse;    // degrees x 100
+  // GGA with a time
+  std::vector<int32_t> ggaTime;      // seconds of the UTC day
+  std::vector<uint8_t> ggaQuality, ggaSats;
+  std::vector<int32_t> ggaHdop;      // x 100, 9990 when empty (as ggaParse())
+  std::vector<int32_t> ggaAlt;       // metres x 10
+  // lines seen, RMC/GGA with a bad checksum or form, other sentences
+  uint64_t lines = 0, bad = 0, other = 0;
+
+  void clear()
+  {
+    rmcTime.clear(); rmcLat.clear(); rmcLon.clear(); rmcSpeed.clear(); rmcCourse.clear();
+    ggaTime.clear(); ggaQuality.clear(); ggaSats.clear(); ggaHdop.clear(); ggaAlt.clear();
+    lines = bad = other = 0;
+  }
+};
+
+// bitmaps of a window, bit i of word w = byte 64*w + i
+struct NmeaIndex
+{
+  uint64_t nl[NMEA_WINDOW / 64], comma[NMEA_WINDOW / 64], star[NMEA_WINDOW / 64];
+};
+
+//----------------------------------------------------------------------------
+// index and XOR, three ways
+//----------------------------------------------------------------------------
+static inline void nmeaIndexTail(const char* p, size_t n, NmeaIndex* ix, size_t w)
+{
+  uint64_t nl = 0, comma = 0, star = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    nl |= (uint64_t)(p[i] == '\n') << i;
+    comma |= (uint64_t)(p[i] == ',') << i;
+    star |= (uint64_t)(p[i] == '*') << i;
+  }
+  ix->nl[w] = nl; ix->comma[w] = comma; ix->star[w] = star;
+}
+
+static void nmeaIndexScalar(const char* p, size_t n, NmeaIndex* ix)
+{
+  size_t w = 0;
+  for (; n >= 64; p += 64, n -= 64, w++) nmeaIndexTail(p, 64, ix, w);
+  if (n) nmeaIndexTail(p, n, ix, w);
+}
+
+static uint8_t nmeaXorScalar(const char* p, size_t n)
+{
+  uint64_t x = 0, v;
+  for (; n >= 8; p += 8, n -= 8) { memcpy(&v, p, 8); x ^= v; }
+  x ^= x >> 32; x ^= x >> 16; x ^= x >> 8;
+  uint8_t s = (uint8_t)x;
+  while (n--) s ^= (uint8_t)*p++;
+  return s;
+}
+
+#ifdef NMEA_X86
+__attribute__((target("sse4.2")))
+static void nmeaIndexSse(const char* p, size_t n, NmeaIndex* ix)
+{
+  const __m128i nl = _mm_set1_epi8('\n'), comma = _mm_set1_epi8(','), star = _mm_set1_epi8('*');
+  size_t w = 0;
+  for (; n >= 64; p += 64, n -= 64, w++)
+  {
+    uint64_t mn = 0, mc = 0, ms = 0;
+    for (int k = 0; k < 4; k++)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+      mn |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << (16 * k);
+      mc |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)) << (16 * k);
+      ms |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, star)) << (16 * k);
+    }
+    ix->nl[w] = mn; ix->comma[w] = mc; ix->star[w] = ms;
+  }
+  if (n) nmeaIndexTail(p, n, ix, w);
+}
+
+__attribute__((target("sse4.2")))
+static uint8_t nmeaXorSse(const char* p, size_t n)
+{
+  __m128i x = _mm_setzero_si128();
+  for (; n >= 16; p += 16, n -= 16) x = _mm_xor_si128(x, _mm_loadu_si128((const __m128i*)p));
+  uint64_t v = (uint64_t)_mm_cvtsi128_si64(x) ^ (uint64_t)_mm_extract_epi64(x, 1);
+  return nmeaXorScalar(p, n) ^ nmeaXorScalar((const char*)&v, 8);
+}
+
+__attribute__((target("avx2")))
+static void nmeaIndexAvx2(const char* p, size_t n, NmeaIndex* ix)
+{
+  const __m256i nl = _mm256_set1_epi8('\n'), comma = _mm256_set1_epi8(','), star = _mm256_set1_epi8('*');
+  size_t w = 0;
+  for (; n >= 64; p += 64, n -= 64, w++)
+  {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+    ix->nl[w] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl)) |
+                ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)) << 32);
+    ix->comma[w] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma)) |
+                   ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma)) << 32);
+    ix->star[w] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, star)) |
+                  ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, star)) << 32);
+  }
+  if (n) nmeaIndexTail(p, n, ix, w);
+}
+
+__attribute__((target("avx2")))
+static uint8_t nmeaXorAvx2(const char* p, size_t n)
+{
+  __m256i x = _mm256_setzero_si256();
+  for (; n >= 32; p += 32, n -= 32) x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i*)p));
+  __m128i h = _mm_xor_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  if (n >= 16) { h = _mm_xor_si128(h, _mm_loadu_si128((const __m128i*)p)); p += 16; n -= 16; }
+  uint64_t v = (uint64_t)_mm_cvtsi128_si64(h) ^ (uint64_t)_mm_extract_epi64(h, 1);
+  return nmeaXorScalar(p, n) ^ nmeaXorScalar((const char*)&v, 8);
+}
+#endif
+
+//----------------------------------------------------------------------------
+// fields
+//----------------------------------------------------------------------------
+// [p, end) as a number with exactly 'decimals' places (more dropped, fewer
+// padded), an optional '-' first;  false if empty or anything else in it
+static inline bool nmeaFixed(const char* p, const char* end, int decimals, int64_t* v)
+{
+  bool neg = (p < end) && (*p == '-');
+  if (neg) p++;
+  int64_t n = 0;
+  unsigned d;
+  bool any = false;
+  while ((p < end) && ((d = (unsigned)(*p - '0')) <= 9)) { n = n * 10 + d; p++; any = true; }
+  int places = 0;
+  if ((p < end) && (*p == '.'))
+  {
+    for (p++; (p < end) && ((d = (unsigned)(*p - '0')) <= 9); p++)
+    {
+      if (places < decimals) { n = n * 10 + d; places++; }
+      any = true;
+    }
+  }
+  if (p != end) return false;
+  for (; places < decimals; places++) n *= 10;
+  *v = neg ? -n : n;
+  return any;
+}
+
+// hhmmss at p, the seconds of the day, -1 if not six digits
+static inline int32_t nmeaDaySec(const char* p, const char* end)
+{
+  if (end - p < 6) return -1;
+  for (int i = 0; i < 6; i++) if ((unsigned)(p[i] - '0') > 9) return -1;
+  return ((p[0]-'0')*10 + (p[1]-'0')) * 3600 + ((p[2]-'0')*10 + (p[3]-'0')) * 60 + (p[4]-'0')*10 + (p[5]-'0');
+}
+
+// ddmm.mmmm (6 places kept) to degrees x 1e6, rounded
+static inline int32_t nmeaMicroDeg(int64_t dmE6)
+{
+  int64_t deg = dmE6 / 100000000LL;
+  return (int32_t)(deg * 1000000LL + (dmE6 - deg * 100000000LL + 30) / 60);
+}
+
+static inline int nmeaHex(char c)
+{
+  if ((unsigned)(c - '0') <= 9) return c - '0';
+  c |= 0x20;
+  if ((unsigned)(c - 'a') <= 5) return c - 'a' + 10;
+  return -1;
+}
+
+// the day start of a ddmmyy date, kept for the next line (a buffer is
+// mostly one day after another)
+struct NmeaDay { int64_t key = -1; int32_t start = 0; };
+
+static inline bool nmeaDate(const char* p, const char* end, NmeaDay* day, int32_t* start)
+{
+  if (end - p != 6) return false;
+  for (int i = 0; i < 6; i++) if ((unsigned)(p[i] - '0') > 9) return false;
+  int64_t key = 0;
+  memcpy(&key, p, 6);
+  if (key != day->key)
+  {
+    GpsFix g;
+    memset(&g, 0, sizeof(g));
+    g.day = (p[0]-'0')*10 + (p[1]-'0');
+    g.month = (p[2]-'0')*10 + (p[3]-'0');
+    g.year = 2000 + (p[4]-'0')*10 + (p[5]-'0');
+    day->key = key;
+    day->start = (int32_t)(fixEpoch(&g) - SEG_EPOCH);
+  }
+  *start = day->start;
+  return true;
+}
+
+// f[i] = where field i starts (f[0] the $), f[n] = one past the '*';
+// fields past the last are empty, as nmeaField() has them;  false if not
+// well formed
+static bool nmeaRmc(const char* const* f, int n, NmeaColumns* c, NmeaDay* day)
+{
+  auto beg = [&](int i) { return (i < n) ? f[i] : f[n]; };
+  auto end = [&](int i) { return (i < n) ? f[i + 1] - 1 : f[n]; };
+  int32_t sec = nmeaDaySec(beg(1), end(1));
+  if (sec < 0) return false;
+  if ((beg(2) == end(2)) || (*beg(2) != 'A') || (end(9) - beg(9) != 6)) return true; // no fix or date, not stored
+  int32_t start;
+  if (!nmeaDate(beg(9), end(9), day, &start)) return false;
+  int64_t lat, lon, speed = 0, course = 0;
+  if (!nmeaFixed(beg(3), end(3), 6, &lat) || !nmeaFixed(beg(5), end(5), 6, &lon)) return false;
+  if ((beg(7) < end(7)) && !nmeaFixed(beg(7), end(7), 3, &speed)) return false;
+  if ((beg(8) < end(8)) && !nmeaFixed(beg(8), end(8), 3, &course)) return false;
+  int32_t la = nmeaMicroDeg(lat), lo = nmeaMicroDeg(lon);
+  c->rmcTime.push_back(start + sec);
+  c->rmcLat.push_back((beg(4) < end(4)) && (*beg(4) == 'S') ? -la : la);
+  c->rmcLon.push_back((beg(6) < end(6)) && (*beg(6) == 'W') ? -lo : lo);
+  c->rmcSpeed.push_back((int32_t)((speed + 5) / 10));
+  c->rmcCourse.push_back((int32_t)((course + 5) / 10));
+  return true;
+}
+
+static bool nmeaGga(const char* const* f, int n, NmeaColumns* c)
+{
+  auto beg = [&](int i) { return (i < n) ? f[i] : f[n]; };
+  auto end = [&](int i) { return (i < n) ? f[i + 1] - 1 : f[n]; };
+  int32_t sec = nmeaDaySec(beg(1), end(1));
+  if (sec < 0) return false;
+  int64_t q = 0, sats = 0, hdop = 9990, alt = 0;
+  if ((beg(6) < end(6)) && !nmeaFixed(beg(6), end(6), 0, &q)) return false;
+  if ((beg(7) < end(7)) && !nmeaFixed(beg(7), end(7), 0, &sats)) return false;
+  if ((beg(8) < end(8)) && !nmeaFixed(beg(8), end(8), 2, &hdop)) return false;
+  if ((beg(9) < end(9)) && !nmeaFixed(beg(9), end(9), 2, &alt)) return false;
+  c->ggaTime.push_back(sec);
+  c->ggaQuality.push_back((uint8_t)q);
+  c->ggaSats.push_back((uint8_t)sats);
+  c->ggaHdop.push_back((int32_t)hdop);
+  c->ggaAlt.push_back((int32_t)((alt + (alt < 0 ? -5 : 5)) / 10));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// the walk
+//----------------------------------------------------------------------------
+typedef void (*NmeaIndexFn)(const char*, size_t, NmeaIndex*);
+typedef uint8_t (*NmeaXorFn)(const char*, size_t);
+
+// first set bit at or after 'from' and before 'to' (window offsets), -1 if none
+static inline long nmeaNextBit(const uint64_t* bits, size_t from, size_t to)
+{
+  size_t w = from >> 6;
+  uint64_t m = bits[w] & (~0ULL << (from & 63));
+  for (;;)
+  {
+    if (m)
+    {
+      size_t at = (w << 6) + __builtin_ctzll(m);
+      return (at < to) ? (long)at : -1;
+    }
+    if (((++w) << 6) >= to) return -1;
+    m = bits[w];
+  }
+}
+
+// the line [ls, le) of the window at base
+static inline void nmeaLine(const char* base, const NmeaIndex* ix, size_t ls, size_t le,
+                            NmeaXorFn xorFn, NmeaColumns* c, NmeaDay* day)
+{
+  const char* p = base + ls;
+  c->lines++;
+  if ((le - ls < 10) || (p[0] != '$')) { c->other++; return; }
+  bool rmc = (p[3] == 'R') && (p[4] == 'M') && (p[5] == 'C');
+  bool gga = (p[3] == 'G') && (p[4] == 'G') && (p[5] == 'A');
+  if ((!rmc && !gga) || (p[6] != ',')) { c->other++; return; }
+
+  long star = nmeaNextBit(ix->star, ls, le);
+  if ((star < 0) || ((size_t)star + 2 >= le)) { c->bad++; return; }
+  int hi = nmeaHex(base[star + 1]), lo = nmeaHex(base[star + 2]);
+  if ((hi < 0) || (lo < 0) || (xorFn(p + 1, star - ls - 1) != ((hi << 4) | lo))) { c->bad++; return; }
+
+  const char* f[NMEA_MAXFIELDS + 1];
+  int n = 0;
+  f[n++] = p;
+  uint64_t from = ls;
+  for (long at; (n < NMEA_MAXFIELDS) && ((at = nmeaNextBit(ix->comma, from, star)) >= 0); from = at + 1)
+    f[n++] = base + at + 1;
+  f[n] = base + star + 1;
+  bool ok = rmc ? nmeaRmc(f, n, c, day) : nmeaGga(f, n, c);
+  if (!ok) c->bad++;
+}
+
+static void nmeaBulkWalk(const char* p, size_t len, NmeaIndexFn indexFn, NmeaXorFn xorFn, NmeaColumns* c)
+{
+  static thread_local NmeaIndex ix;
+  NmeaDay day;
+  size_t ws = 0;
+  while (ws < len)
+  {
+    size_t wn = std::min((size_t)NMEA_WINDOW, len - ws);
+    const char* base = p + ws;
+    indexFn(base, wn, &ix);
+    size_t ls = 0;
+    bool any = false;
+    for (size_t w = 0; w * 64 < wn; w++)
+    {
+      for (uint64_t m = ix.nl[w]; m; m &= m - 1)
+      {
+        size_t le = w * 64 + __builtin_ctzll(m);
+        size_t e = ((le > ls) && (base[le - 1] == '\r')) ? le - 1 : le;
+        nmeaLine(base, &ix, ls, e, xorFn, c, &day);
+        ls = le + 1;
+        any = true;
+      }
+    }
+    if (ws + wn == len)
+    {
+      if (ls < wn) nmeaLine(base, &ix, ls, ((base[wn - 1] == '\r') ? wn - 1 : wn), xorFn, c, &day);
+      break;
+    }
+    if (!any) // a window with no line end in it, not NMEA - on to the next line end
+    {
+      const char* nl = (const char*)memchr(base, '\n', len - ws);
+      c->lines++;
+      c->other++;
+      if (!nl) break;
+      ws = nl - p + 1;
+      continue;
+    }
+    ws += ls;
+  }
+}
+
+static int nmeaBulkBest()
+{
+#ifdef NMEA_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return NMEA_AVX2;
+  if (__builtin_cpu_supports("sse4.2")) return NMEA_SSE42;
+#endif
+  return NMEA_SCALAR;
+}
+
+// with the given one (falls back to the best there is)
+static void nmeaBulkParseWith(int how, const char* p, size_t len, NmeaColumns* c)
+{
+  int best = nmeaBulkBest();
+  if ((how == NMEA_AUTO) || (how > best)) how = best;
+#ifdef NMEA_X86
+  if (how == NMEA_AVX2) { nmeaBulkWalk(p, len, nmeaIndexAvx2, nmeaXorAvx2, c); return; }
+  if (how == NMEA_SSE42) { nmeaBulkWalk(p, len, nmeaIndexSse, nmeaXorSse, c); return; }
+#endif
+  nmeaBulkWalk(p, len, nmeaIndexScalar, nmeaXorScalar, c);
+}
+
+static void nmeaBulkParse(const char* p, size_t len, NmeaColumns* c)
+{
+  nmeaBulkParseWith(NMEA_AUTO, p, len, c);
+}
+
+#endif
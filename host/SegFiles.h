@@ -0,0 +1,211 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Folders of track segment files, for the server side tools
+//----------------------------------------------------------------------------
+// The .seg files ingest.cpp and udpcollect.cpp write, in the format of
+// TrackSegmentService.h, one or more a logger:
+//   segFilesFind()     every .seg under a folder;  the logger is the
+//                      file's folder under the root for <root>/<logger>/*.seg,
+//                      else the file's name
+//   segFileMap()       mmap'ed and closed again (no descriptor held), and
+//                      the SegHeaders read into SegRefs - time, lat and lon
+//                      ranges and the fix count of each segment, so a
+//                      reader can pass over a segment without decoding it
+//   segFileDecode()    one segment's columns
+//   segFileWrite()     fixes out as segments
+//   segFleetGenerate() a built-in fleet:  each logger's day in
+//                      SEGFLEET_UPLOADS files that overlap by a minute and
+//                      are numbered in no time order
+//
+// Used by host/trackmerge.cpp and host/heatmap.cpp.  Include after
+// HostArduino.h, NmeaService.h, TrackSegmentService.h and UploadFleet.h.
+//
+#ifndef SEGFILES_H
+#define SEGFILES_H
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEGFLEET_UPLOADS (4)
+
+struct SegFix { int32_t t, lat, lon, speed; };
+
+struct SegRef
+{
+  size_t off;
+  int32_t first, last;                // time of the first fix, the latest
+  int32_t minLat, maxLat, minLon, maxLon;
+  int count;
+};
+
+struct SegFile
+{
+  std::string path;
+  int logger;
+  const uint8_t* p = NULL;
+  size_t len = 0;
+  std::vector<SegRef> segs;
+};
+
+static void segFilesFind(const std::string& root, std::vector<SegFile>& files, std::vector<std::string>& loggers)
+{
+  namespace fsys = std::filesystem;
+  std::map<std::string, int> ids;
+  std::vector<fsys::path> found;
+  bool one = fsys::is_regular_file(root);
+  if (one) found.push_back(root);
+  else
+  {
+    for (auto& e : fsys::recursive_directory_iterator(root))
+      if (e.is_regular_file() && (e.path().extension() == ".seg")) found.push_back(e.path());
+  }
+  std::sort(found.begin(), found.end());
+  for (auto& f : found)
+  {
+    fsys::path rel = fsys::relative(f, one ? f.parent_path() : fsys::path(root));
+    std::string name = (rel.has_parent_path() ? *rel.begin() : rel.stem()).string();
+    auto it = ids.find(name);
+    if (it == ids.end())
+    {
+      it = ids.emplace(name, (int)loggers.size()).first;
+      loggers.push_back(name);
+    }
+    SegFile s;
+    s.path = f.string();
+    s.logger = it->second;
+    files.push_back(s);
+  }
+}
+
+// false if it can't be read or a header is wrong (the segments up to it are kept)
+static bool segFileMap(SegFile& f)
+{
+  int fd = open(f.path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || (st.st_size == 0)) { close(fd); return false; }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return false;
+  f.p = (const uint8_t*)p;
+  f.len = st.st_size;
+  f.segs.clear();
+  size_t at = 0;
+  while (at + sizeof(SegHeader) <= f.len)
+  {
+    SegHeader h;
+    memcpy(&h, f.p + at, sizeof(h));
+    size_t body = (size_t)h.bytes[0] + h.bytes[1] + h.bytes[2] + h.bytes[3];
+    if ((h.magic != SEG_MAGIC) || (h.count == 0) || (h.count > SEG_MAXFIXES) ||
+        (at + sizeof(h) + body > f.len)) return false;
+    f.segs.push_back({ at, h.first[SEG_TIME], h.maxv[SEG_TIME], h.minv[SEG_LAT], h.maxv[SEG_LAT],
+                       h.minv[SEG_LON], h.maxv[SEG_LON], h.count });
+    at += sizeof(h) + body;
+  }
+  return true;
+}
+
+static void segFileUnmap(SegFile& f)
+{
+  if (f.p) munmap((void*)f.p, f.len);
+  f.p = NULL;
+  f.segs.clear();
+}
+
+// segment i into col[][], returns its fix count
+static int segFileDecode(const SegFile& f, size_t i, int32_t col[SEG_COLS][SEG_MAXFIXES])
+{
+  SegHeader h;
+  memcpy(&h, f.p + f.segs[i].off, sizeof(h));
+  const uint8_t* p = f.p + f.segs[i].off + sizeof(h);
+  for (int c = 0; c < SEG_COLS; c++)
+  {
+    segDecode(p, h.bytes[c], h.first[c], h.count, col[c]);
+    p += h.bytes[c];
+  }
+  return h.count;
+}
+
+static bool segFileWrite(const std::string& fn, const std::vector<SegFix>& fixes)
+{
+  FILE* fp = fopen(fn.c_str(), "wb");
+  if (!fp) return false;
+  bool ok = true;
+  uint8_t col[SEG_COLS][SEG_MAXFIXES * SEG_VARINTMAX];
+  for (size_t at = 0; at < fixes.size(); at += SEG_MAXFIXES)
+  {
+    int count = (int)std::min((size_t)SEG_MAXFIXES, fixes.size() - at);
+    const SegFix* f = &fixes[at];
+    SegHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SEG_MAGIC;
+    h.count = count;
+    for (int c = 0; c < SEG_COLS; c++)
+    {
+      auto val = [&](int i) { const int32_t* v = &f[i].t; return v[c]; };
+      h.minv[c] = h.maxv[c] = h.first[c] = val(0);
+      int bytes = 0;
+      for (int i = 1; i < count; i++)
+      {
+        int32_t v = val(i);
+        if (v < h.minv[c]) h.minv[c] = v;
+        if (v > h.maxv[c]) h.maxv[c] = v;
+        bytes += segPut(col[c] + bytes, v - val(i - 1));
+      }
+      h.bytes[c] = bytes;
+    }
+    ok &= (fwrite(&h, sizeof(h), 1, fp) == 1);
+    for (int c = 0; c < SEG_COLS; c++) ok &= (fwrite(col[c], 1, h.bytes[c], fp) == (size_t)h.bytes[c]);
+  }
+  ok &= (fclose(fp) == 0);
+  return ok;
+}
+
+// <root>/Lnnnnn/uploadN.seg:  each logger drives a day round its own home
+// within half a degree of HOME_LAT/HOME_LON, never more than 0.2 degrees
+// from it, a fix every 'every' seconds
+static void segFleetGenerate(const std::string& root, int loggers, int every)
+{
+  std::mt19937 rng(17);
+  std::uniform_real_distribution<double> u(0, 1);
+  int32_t day = (int32_t)(1700006400L - SEG_EPOCH);
+  for (int d = 0; d < loggers; d++)
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "L%05d", d);
+    std::filesystem::create_directories(root + "/" + name);
+    std::vector<SegFix> track;
+    double homeLat = HOME_LAT + (u(rng) - 0.5), homeLon = HOME_LON + (u(rng) - 0.5);
+    double lat = homeLat, lon = homeLon, mps = 0, course = u(rng) * 360;
+    int32_t start = day + (int32_t)(u(rng) * 4 * 3600), end = start + 14 * 3600 + (int32_t)(u(rng) * 6 * 3600);
+    for (int32_t t = start + (int32_t)(u(rng) * every); t < end; t += every)
+    {
+      mps = std::max(0.0, std::min(30.0, mps + (u(rng) - 0.5) * 4));
+      course = fmod(course + (u(rng) - 0.5) * 20 + 360, 360);
+      double north = homeLat - lat, east = (homeLon - lon) * cos(lat * M_PI / 180);
+      if (north * north + east * east > 0.2 * 0.2) course = fmod(atan2(east, north) * 180 / M_PI + 360, 360); // back toward home
+      lat += mps * every * cos(course * M_PI / 180) / 111320.0;
+      lon += mps * every * sin(course * M_PI / 180) / (111320.0 * cos(lat * M_PI / 180));
+      track.push_back({ t, (int32_t)lround(lat * 1e6), (int32_t)lround(lon * 1e6), (int32_t)lround(mps / 0.5144 * 100) });
+    }
+    std::vector<int> order(SEGFLEET_UPLOADS);
+    for (int i = 0; i < SEGFLEET_UPLOADS; i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    size_t per = track.size() / SEGFLEET_UPLOADS, overlap = 60 / every;
+    for (int i = 0; i < SEGFLEET_UPLOADS; i++)
+    {
+      size_t b = i * per;
+      size_t e = (i == SEGFLEET_UPLOADS - 1) ? track.size() : std::min(track.size(), (i + 1) * per + overlap);
+      std::vector<SegFix> part(track.begin() + b, track.begin() + e);
+      segFileWrite(root + "/" + name + "/upload" + std::to_string(order[i]) + ".seg", part);
+    }
+  }
+}
+
+#endif
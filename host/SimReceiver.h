@@ -0,0 +1,299 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Simulated GPS receiver driving a track, for the motion and sleep tools
+//----------------------------------------------------------------------------
+// The track is a built-in working day (legs from home, parked overnight,
+// at work, errands) or the RMC lines of a recorded NMEA file, one point a
+// second.  SimReceiver talks NMEA into GPSPORT at its rate and sentence
+// settings and obeys the commands MotionService.h sends per receiver
+// type - rate, per-sentence output, standby/backup and waking - the way
+// the receiver would:  u-blox loses its settings in backup and wakes on
+// the timer or UART RX, PMTK wakes on any byte, CASIC on its timer.
+//
+// Used by host/motionsim.cpp and host/sleepsim.cpp.  Include after
+// HostArduino.h, GpsService.h, NmeaService.h and the AIDTYPE_ defines.
+//
+#ifndef SIMRECEIVER_H
+#define SIMRECEIVER_H
+
+#define HOME_LAT (47.75206)
+#define HOME_LON (-122.20946)
+#define COLD_TTFF_SEC (30)
+#define HOT_TTFF_SEC (2)
+
+//----------------------------------------------------------------------------
+// the track - legs from one point to the next at a speed, 0 = stopped
+//----------------------------------------------------------------------------
+struct Leg
+{
+  double north, east;   // metres from home at the end of the leg
+  double mps;           // speed, 0 = stopped for sec seconds
+  unsigned long sec;
+};
+
+static const std::vector<Leg> day = {
+  {      0,      0,  0, 7*3600 },  // parked at home overnight
+  {   -800,      0, 11,      0 },  // out through town
+  {   -800,      0,  0,     45 },  // lights
+  {   -800,   3000, 13,      0 },
+  {   -800,   3000,  0,     60 },  // lights
+  { -20000,   9000, 29,      0 },  // highway
+  { -21500,   9000, 10,      0 },  // into the site
+  { -21500,   9000,  0, 4*3600 },  // parked at work
+  { -23000,  10000, 12,      0 },  // lunch errand
+  { -23000,  10000,  0,   1200 },  // stopped 20 minutes
+  { -21500,   9000, 12,      0 },
+  { -21500,   9000,  0, 4*3600 },  // parked at work
+  { -20000,   9000, 10,      0 },  // home again
+  {   -800,   3000, 29,      0 },
+  {   -800,   3000,  0,     90 },  // traffic
+  {   -800,      0, 12,      0 },
+  {      0,      0, 11,      0 },
+};
+
+struct Point { double lat, lon, kts, course; };
+
+static std::vector<Point> makeTrack()
+{
+  std::vector<Point> track;
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  double n = 0, e = 0, course = 0;
+  for (const Leg& leg : day)
+  {
+    double dn = leg.north - n, de = leg.east - e;
+    double dist = sqrt(dn*dn + de*de);
+    unsigned long sec = leg.mps > 0 ? (unsigned long)(dist / leg.mps) : leg.sec;
+    if (leg.mps > 0) course = fmod(atan2(de, dn) * 180 / M_PI + 360, 360);
+    for (unsigned long s = 0; s < sec; s++)
+    {
+      double f = (double)s / sec;
+      track.push_back({ HOME_LAT + (n + dn*f) / mPerDeg,
+                        HOME_LON + (e + de*f) / (mPerDeg * cos(HOME_LAT * M_PI / 180)),
+                        leg.mps / 0.5144, course });
+    }
+    n = leg.north; e = leg.east;
+  }
+  while (track.size() < 86400) track.push_back({ HOME_LAT, HOME_LON, 0, course }); // parked till midnight
+  return track;
+}
+
+// or the RMC lines of a recording, one a second
+static std::vector<Point> readTrack(const char* fn)
+{
+  std::vector<Point> track;
+  FILE* fp = fopen(fn, "rb");
+  if (!fp) { perror(fn); exit(1); }
+  char line[512];
+  long last = -1;
+  while (fgets(line, sizeof(line), fp))
+  {
+    line[strcspn(line, "\r\n")] = 0;
+    GpsFix fix;
+    if (!rmcParse(line, &fix) || !fix.valid) continue;
+    long t = fixEpoch(&fix);
+    if ((last >= 0) && (t > last))
+      for (long s = last + 1; (s < t) && (s - last < 3600); s++) track.push_back(track.back()); // gap, hold
+    if (t != last) track.push_back({ fix.lat, fix.lon, fix.speedKts, fix.course });
+    last = t;
+  }
+  fclose(fp);
+  return track;
+}
+
+//----------------------------------------------------------------------------
+// the receiver
+//----------------------------------------------------------------------------
+enum { S_GGA, S_GLL, S_GSA, S_GSV, S_RMC, S_VTG, S_COUNT };
+
+class SimReceiver
+{
+public:
+  int type = AIDTYPE_NONE;
+  unsigned long intervalMs = 1000;
+  int every[S_COUNT];
+  int asleep = false;
+  uint64_t wakeAt = 0;            // timer wake, 0 = none
+  uint64_t fixFrom = 0;           // no fix before this (TTFF)
+  uint64_t nextFixAt = 0;
+  unsigned long fixN = 0;
+  uint64_t awakeUs = 0;
+  unsigned long bytesOut = 0;
+  unsigned long sleeps = 0;
+
+  void powerOn()
+  {
+    defaults();
+    asleep = false;
+    fixFrom = hostMicros + COLD_TTFF_SEC * 1000000ULL;
+    nextFixAt = hostMicros;
+  }
+
+  // the port's bytes from the logger
+  void fromLogger(const std::string& tx)
+  {
+    for (size_t i = 0; i < tx.size(); )
+    {
+      if (asleep && (type != AIDTYPE_CASIC)) wake(); // UART RX wakes u-blox (as set up) and MediaTek
+      uint8_t c = tx[i];
+      if ((c == 0xB5) && (i + 8 <= tx.size()))
+      {
+        int len = (uint8_t)tx[i+4] | ((uint8_t)tx[i+5] << 8);
+        ubx((uint8_t)tx[i+2], (uint8_t)tx[i+3], (const uint8_t*)&tx[i+6], len);
+        i += 8 + len;
+      }
+      else if (c == '$')
+      {
+        size_t end = tx.find('\n', i);
+        if (end == std::string::npos) break;
+        text(tx.substr(i, end - i));
+        i = end + 1;
+      }
+      else i++;
+    }
+  }
+
+  // a virtual millisecond went by
+  void tick(const Point& p, unsigned long sec)
+  {
+    if (asleep)
+    {
+      if (wakeAt && (hostMicros >= wakeAt)) wake();
+      else return;
+    }
+    awakeUs += 1000;
+    if (hostMicros < nextFixAt) return;
+    nextFixAt += intervalMs * 1000ULL;
+    int valid = hostMicros >= fixFrom;
+    for (int s = 0; s < S_COUNT; s++)
+      if (every[s] && (fixN % every[s] == 0)) sentence(s, p, sec, valid);
+    fixN++;
+  }
+
+private:
+  void defaults()
+  {
+    intervalMs = 1000;
+    for (int s = 0; s < S_COUNT; s++) every[s] = 1;
+  }
+
+  void wake()
+  {
+    asleep = false;
+    wakeAt = 0;
+    if (type == AIDTYPE_UBX) defaults(); // backup keeps the BBR, not the RAM settings
+    fixFrom = hostMicros + HOT_TTFF_SEC * 1000000ULL;
+    nextFixAt = (hostMicros / 1000000 + 1) * 1000000ULL; // on the GPS second, whenever it woke
+  }
+
+  void sleep(unsigned long ms)
+  {
+    asleep = true;
+    wakeAt = ms ? hostMicros + ms * 1000ULL : 0;
+    sleeps++;
+  }
+
+  void ack(uint8_t cls, uint8_t id)
+  {
+    const uint8_t f[10] = { 0xB5, 0x62, 0x05, 0x01, 2, 0, cls, id, 0, 0 };
+    out(std::string((const char*)f, 10)); // checksum not checked by the logger
+  }
+
+  void ubx(uint8_t cls, uint8_t id, const uint8_t* p, int len)
+  {
+    if ((cls == 0x06) && (id == 0x08) && (len == 6)) intervalMs = p[0] | (p[1] << 8);
+    else if ((cls == 0x06) && (id == 0x01) && (len == 3) && (p[0] == 0xF0) && (p[1] < S_COUNT)) every[p[1]] = p[2];
+    else if ((cls == 0x02) && (id == 0x41) && (len == 16))
+    {
+      sleep(p[4] | (p[5] << 8) | (p[6] << 16) | ((unsigned long)p[7] << 24));
+      return;
+    }
+    else return;
+    ack(cls, id);
+  }
+
+  void text(const std::string& s)
+  {
+    int v[20] = {};
+    const char* f = strchr(s.c_str(), ',');
+    for (int n = 0; f && (n < 20); n++, f = strchr(f + 1, ',')) v[n] = atoi(f + 1);
+    if (s.compare(1, 7, "PMTK220") == 0) intervalMs = v[0];
+    else if (s.compare(1, 7, "PMTK314") == 0)
+    {
+      every[S_GLL] = v[0]; every[S_RMC] = v[1]; every[S_VTG] = v[2];
+      every[S_GGA] = v[3]; every[S_GSA] = v[4]; every[S_GSV] = v[5];
+    }
+    else if (s.compare(1, 7, "PMTK161") == 0) sleep(0);
+    else if (s.compare(1, 6, "PCAS02") == 0) intervalMs = v[0];
+    else if (s.compare(1, 6, "PCAS03") == 0)
+    {
+      every[S_GGA] = v[0]; every[S_GLL] = v[1]; every[S_GSA] = v[2];
+      every[S_GSV] = v[3]; every[S_RMC] = v[4]; every[S_VTG] = v[5];
+    }
+    else if (s.compare(1, 6, "PCAS12") == 0) sleep(v[0] * 1000UL);
+  }
+
+  void out(const std::string& s)
+  {
+    GPSPORT.feed(s.data(), s.size());
+    bytesOut += s.size();
+  }
+
+  void nmea(const char* body)
+  {
+    uint8_t cs = 0;
+    for (const char* c = body; *c; c++) cs ^= *c;
+    char line[160];
+    snprintf(line, sizeof(line), "$%s*%02X\r\n", body, cs);
+    out(line);
+  }
+
+  void sentence(int s, const Point& p, unsigned long sec, int valid)
+  {
+    char body[160], t[16], lat[24], lon[24];
+    double alat = fabs(p.lat), alon = fabs(p.lon);
+    snprintf(t, sizeof(t), "%02lu%02lu%02lu.000", (sec/3600) % 24, (sec/60) % 60, sec % 60);
+    if (valid)
+    {
+      snprintf(lat, sizeof(lat), "%02d%07.4f,%c", (int)alat, (alat - (int)alat) * 60, p.lat < 0 ? 'S' : 'N');
+      snprintf(lon, sizeof(lon), "%03d%07.4f,%c", (int)alon, (alon - (int)alon) * 60, p.lon < 0 ? 'W' : 'E');
+    }
+    else strcpy(lat, ","), strcpy(lon, ",");
+    double kts = valid ? p.kts : 0;
+    switch (s)
+    {
+      case S_RMC:
+        snprintf(body, sizeof(body), "GNRMC,%s,%c,%s,%s,%.2f,%.1f,151123,,,%c", t, valid ? 'A' : 'V', lat, lon,
+          kts, p.course, valid ? 'A' : 'N');
+        nmea(body);
+        break;
+      case S_GGA:
+        snprintf(body, sizeof(body), "GNGGA,%s,%s,%s,%d,%02d,%.1f,%s,M,-17.1,M,,", t, lat, lon,
+          valid, valid ? 9 : 0, valid ? 0.9 : 99.9, valid ? "35.2" : "");
+        nmea(body);
+        break;
+      case S_GLL:
+        snprintf(body, sizeof(body), "GNGLL,%s,%s,%s,%c,%c", lat, lon, t, valid ? 'A' : 'V', valid ? 'A' : 'N');
+        nmea(body);
+        break;
+      case S_VTG:
+        snprintf(body, sizeof(body), "GNVTG,%.1f,T,,M,%.2f,N,%.2f,K,%c", p.course, kts, kts * 1.852, valid ? 'A' : 'N');
+        nmea(body);
+        break;
+      case S_GSA:
+        nmea(valid ? "GNGSA,A,3,02,05,12,15,18,24,25,29,,,,,1.8,0.9,1.5,1" : "GNGSA,A,1,,,,,,,,,,,,,99.9,99.9,99.9,1");
+        break;
+      case S_GSV:
+        for (int k = 0; k < 3; k++)
+        {
+          int n = snprintf(body, sizeof(body), "GPGSV,3,%d,12", k + 1);
+          for (int j = 0; j < 4; j++)
+            n += snprintf(&body[n], sizeof(body) - n, ",%02d,%02d,%03d,%02d", k*4 + j + 1, 20 + j*10, (k*90 + j*30) % 360,
+              valid ? 25 + (int)((sec + j + k) % 20) : 0);
+          nmea(body);
+        }
+        break;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,117 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// A fleet of loggers uploading with ftpPut(), for the server side tools
+//----------------------------------------------------------------------------
+// Each logger wanders round its own patch logging a fix a minute (the odd
+// one invalid), and every 2 hours sends the whole of location.log as
+// <root>/<logger>/gpslog_YYYYMMDD-HHMMSS.log, CRLF lines.  Now and then
+// an upload is cut off by the link - mostly part way through the last
+// line, sometimes early on - and now and then the log is deleted on the
+// logger after an upload and starts over.
+//
+// fleetGenerate() writes the uploads and returns, per logger, the log as
+// it should be rebuilt: every complete line that reached the server once,
+// in order, the restarted logs one after the other.
+//
+// Used by host/ingest.cpp and host/dedup.cpp.  Include after HostArduino.h.
+//
+#ifndef UPLOADFLEET_H
+#define UPLOADFLEET_H
+
+#include <filesystem>
+#include <map>
+#include <random>
+
+#define HOME_LAT (47.75206)
+#define HOME_LON (-122.20946)
+#define FLEET_UPLOADSEC (7200)
+
+static int fleetDm(char* buf, int maxlen, double deg, int degDigits, char pos, char neg)
+{
+  double a = fabs(deg);
+  int d = (int)a;
+  long m = lround((a - d) * 6000000.0);
+  if (m >= 6000000L) { d++; m -= 6000000L; }
+  return snprintf(buf, maxlen, "%0*d%02ld.%05ld,%c", degDigits, d, m / 100000L, m % 100000L, (deg < 0) ? neg : pos);
+}
+
+static std::string fleetRmc(long t, double lat, double lon, double kts, double course, bool valid)
+{
+  time_t tt = t;
+  struct tm tm;
+  gmtime_r(&tt, &tm);
+  char la[24], lo[24], body[160], line[176];
+  fleetDm(la, sizeof(la), lat, 2, 'N', 'S');
+  fleetDm(lo, sizeof(lo), lon, 3, 'E', 'W');
+  snprintf(body, sizeof(body), "GNRMC,%02d%02d%02d.00,%c,%s,%s,%.3f,%.1f,%02d%02d%02d,,,%c",
+    tm.tm_hour, tm.tm_min, tm.tm_sec, valid ? 'A' : 'V', la, lo, kts, course,
+    tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100, valid ? 'A' : 'N');
+  uint8_t sum = 0;
+  for (const char* c = body; *c; c++) sum ^= *c;
+  snprintf(line, sizeof(line), "$%s*%02X\r\n", body, sum);
+  return line;
+}
+
+// uploads from day0 on;  only those up to 'until' are written (0 = all)
+static std::map<std::string, std::string> fleetGenerate(const std::string& root, int devices, int days, long until = 0)
+{
+  std::map<std::string, std::string> rebuilt;
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> u(0, 1);
+  long day0 = 1700006400L; // 2023/11/15
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  for (int d = 0; d < devices; d++)
+  {
+    char dev[24];
+    snprintf(dev, sizeof(dev), "gps-%08X", (unsigned)rng());
+    std::filesystem::create_directories(root + "/" + dev);
+    std::string log, done;
+    size_t kept = 0;    // of log, complete lines the server has
+    double n = (u(rng) - 0.5) * 20000, e = (u(rng) - 0.5) * 20000, course = u(rng) * 360, mps = 0;
+    long t = day0 + (long)(u(rng) * 600);
+    long nextUpload = t + FLEET_UPLOADSEC + (long)(u(rng) * 1800);
+    while (t < day0 + days * 86400L)
+    {
+      if (u(rng) < 0.05) mps = (u(rng) < 0.4) ? 0 : 5 + u(rng) * 25;
+      course = fmod(course + (u(rng) - 0.5) * 40 + 360, 360);
+      n += cos(course * M_PI / 180) * mps * 60;
+      e += sin(course * M_PI / 180) * mps * 60;
+      double lat = HOME_LAT + n / mPerDeg;
+      log += fleetRmc(t, lat, HOME_LON + e / (mPerDeg * cos(lat * M_PI / 180)), mps / 0.5144, course, u(rng) > 0.01);
+      t += 60;
+      if (t < nextUpload) continue;
+
+      char fn[64];
+      time_t tt = t;
+      struct tm tm;
+      gmtime_r(&tt, &tm);
+      strftime(fn, sizeof(fn), "gpslog_%Y%m%d-%H%M%S.log", &tm);
+      size_t len = log.size();
+      double cut = u(rng);
+      if (cut < 0.02) len = (size_t)(u(rng) * len);          // link dropped early on
+      else if (cut < 0.07) len -= 1 + (size_t)(u(rng) * 40); // ... or in the last line
+      if ((until == 0) || (t <= until))
+      {
+        FILE* fp = fopen((root + "/" + dev + "/" + fn).c_str(), "wb");
+        if (fp)
+        {
+          fwrite(log.data(), 1, len, fp);
+          fclose(fp);
+        }
+        size_t lines = log.rfind('\n', len - 1);
+        if ((len > 0) && (lines != std::string::npos) && (lines + 1 > kept)) kept = lines + 1;
+      }
+      if (u(rng) < 0.01)                                     // rm /location.log
+      {
+        done += log.substr(0, kept);
+        log.clear();
+        kept = 0;
+      }
+      nextUpload = t + FLEET_UPLOADSEC + (long)(u(rng) * 600);
+    }
+    rebuilt[dev] = done + log.substr(0, kept);
+  }
+  return rebuilt;
+}
+
+#endif
@@ -0,0 +1,444 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Hot-start aiding (GpsAidService.h) - the messages checked byte by byte,
+// and the UBX navigation database dump round trip
+//----------------------------------------------------------------------------
+// The real aidQueueInit() / aidService() / aidDbd...() with GPSPORT kept
+// (HostSerial keepTx), NVS (Preferences) in memory here, and everything
+// the logger sends decoded again by code of its own:
+//
+//   UBX    MGA-INI-POS_LLH and MGA-INI-TIME_UTC:  sync, class/id, length,
+//          the Fletcher checksum, lat/lon/alt/accuracy, the UTC fields
+//   CASIC  AID-INI:  header, the 32 bit word checksum, lat/lon/alt, the
+//          flags, GPS week and time of week - against known values
+//          (2017-01-01 00:00:00 UTC is the start of GPS week 1930, TOW 18
+//          with the 18 leap seconds) and a days-from-civil reference
+//   PMTK   $PMTK741 / $PMTK740:  NMEA checksum and every field
+//
+// Then the database:  aidDbdPoll() must send UBX-MGA-DBD with no payload,
+// the "receiver" answers with MGA-DBD frames (and a corrupt one and a
+// frame of another class, which must be left out), the dump must end in
+// AID_DBDFN after AID_DBD_QUIET_MS, and after a reboot aidService() must
+// send the position and then exactly the good frames, byte for byte,
+// with the time after them once NTP is done.  A poll that gets no answer
+// must keep the last good dump.
+//
+// Last, the boot again with MotionService.h writing to the same port:  the
+// UART FIFO drains at 9600 baud and the motion settings are queued again
+// and again while the dump goes out.  Every byte on the wire must belong
+// to a whole frame with a good checksum - none of one inside another - and
+// the dump frames must still go in order, byte for byte.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wall -Wno-write-strings -o host/aidcheck host/aidcheck.cpp
+//   host/aidcheck [-v]
+//
+#include <random>
+#include <cmath>
+#include "HostArduino.h"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+void logMessage(char* msg) { Serial.println(msg); }
+
+static bool ntpDoneSim = false;
+bool ntpComplete() { return ntpDoneSim; }
+
+//----------------------------------------------------------------------------
+// Preferences (NVS) stand-in - namespaces of byte strings, lost with the
+// process only
+//----------------------------------------------------------------------------
+class Preferences
+{
+public:
+  bool begin(const char* name, bool readOnly = false) { ns = &store()[name]; return true; }
+  void end() { ns = nullptr; }
+  bool clear() { ns->clear(); return true; }
+
+  size_t putBool(const char* key, bool v) { return put(key, &v, sizeof(v)); }
+  size_t putDouble(const char* key, double v) { return put(key, &v, sizeof(v)); }
+  size_t putFloat(const char* key, float v) { return put(key, &v, sizeof(v)); }
+  size_t putULong(const char* key, uint32_t v) { return put(key, &v, sizeof(v)); }
+  size_t putBytes(const char* key, const void* v, size_t len) { return put(key, v, len); }
+
+  bool getBool(const char* key, bool def = false) { return get(key, def); }
+  double getDouble(const char* key, double def = 0) { return get(key, def); }
+  float getFloat(const char* key, float def = 0) { return get(key, def); }
+  uint32_t getULong(const char* key, uint32_t def = 0) { return get(key, def); }
+  size_t getBytesLength(const char* key) { auto it = ns->find(key); return (it == ns->end()) ? 0 : it->second.size(); }
+  size_t getBytes(const char* key, void* buf, size_t len)
+  {
+    auto it = ns->find(key);
+    if ((it == ns->end()) || (it->second.size() > len)) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  static std::map<std::string, std::map<std::string, std::string>>& store()
+  {
+    static std::map<std::string, std::map<std::string, std::string>> s;
+    return s;
+  }
+
+private:
+  size_t put(const char* key, const void* v, size_t len) { (*ns)[key].assign((const char*)v, len); return len; }
+  template <class T> T get(const char* key, T def)
+  {
+    auto it = ns->find(key);
+    if ((it == ns->end()) || (it->second.size() != sizeof(T))) return def;
+    T v;
+    memcpy(&v, it->second.data(), sizeof(T));
+    return v;
+  }
+  std::map<std::string, std::string>* ns = nullptr;
+};
+
+#include "../GpsService.h"
+#include "../NmeaService.h"
+#include "../GpsAidService.h"
+#include "../MotionService.h"
+
+//----------------------------------------------------------------------------
+// decoding, written separately from the encoders
+//----------------------------------------------------------------------------
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  if (!ok) { printf("  FAIL %s\n", what); failures++; }
+}
+
+static uint16_t u16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t u32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static double r8(const uint8_t* p) { double v; memcpy(&v, p, 8); return v; }
+static float r4(const uint8_t* p) { float v; memcpy(&v, p, 4); return v; }
+
+// one UBX frame at p, payload and length out, false if it's not a good one
+static bool ubxFrame(const uint8_t* p, size_t avail, uint8_t cls, uint8_t id, const uint8_t** payload, int* len)
+{
+  if ((avail < 8) || (p[0] != 0xB5) || (p[1] != 0x62)) return false;
+  int n = u16(&p[4]);
+  if ((size_t)n + 8 > avail) return false;
+  uint8_t a = 0, b = 0;
+  for (int i = 2; i < 6 + n; i++) { a = a + p[i]; b = b + a; }
+  if ((p[6 + n] != a) || (p[7 + n] != b)) return false;
+  if ((p[2] != cls) || (p[3] != id)) return false;
+  *payload = &p[6];
+  *len = n;
+  return true;
+}
+
+// days since 1970-01-01 from a civil date (H. Hinnant's algorithm)
+static long daysFromCivil(int y, int m, int d)
+{
+  y -= m <= 2;
+  long era = (y >= 0 ? y : y - 399) / 400;
+  long yoe = y - era * 400;
+  long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void refGpsTime(int y, int mo, int d, int h, int mi, int s, int* week, long* tow)
+{
+  long days = daysFromCivil(y, mo, d) - daysFromCivil(1980, 1, 6);
+  long sec = days * 86400L + h * 3600L + mi * 60L + s + AID_LEAPSECONDS;
+  *week = sec / 604800L;
+  *tow = sec % 604800L;
+}
+
+//----------------------------------------------------------------------------
+struct When { int y, mo, d, h, mi, s; };
+
+static const When whens[] = {
+  { 2017,  1,  1,  0,  0,  0 },   // GPS week 1930 starts
+  { 2023, 11, 15,  9, 51,  0 },
+  { 2024,  2, 29, 23, 59, 59 },
+  { 2026, 10, 18, 12,  0,  0 },
+};
+
+static void setWhen(const When& w) { rtc.setTime(w.s, w.mi, w.h, w.d, w.mo, w.y); }
+
+static void freshBoot(const char* type, bool havePos)
+{
+  aidType = aidTypeFromName(type);
+  aidHavePos = havePos;
+  aidLat = 47.752060; aidLon = -122.209460; aidAlt = 123.4f;
+  aidDone = 0;
+  aidTxLen = aidTxPos = 0;
+}
+
+static void checkUbx(const When& w)
+{
+  char what[96];
+  freshBoot("UBX", true);
+  setWhen(w);
+  aidQueueInit(true);
+  const uint8_t* p;
+  int len = 0;
+  check(ubxFrame(aidTx, aidTxLen, 0x13, 0x40, &p, &len) && (len == 20), "UBX POS_LLH frame");
+  if (len == 20)
+  {
+    check(p[0] == 0x01, "UBX POS_LLH type");
+    check((int32_t)u32(&p[4]) == 477520600, "UBX POS_LLH lat");
+    check((int32_t)u32(&p[8]) == -1222094600, "UBX POS_LLH lon");
+    check((int32_t)u32(&p[12]) == 12340, "UBX POS_LLH alt cm");
+    check(u32(&p[16]) == AID_POSACC_M * 100UL, "UBX POS_LLH accuracy cm");
+  }
+  const uint8_t* t;
+  len = 0;
+  check(ubxFrame(aidTx + 28, aidTxLen - 28, 0x13, 0x40, &t, &len) && (len == 24), "UBX TIME_UTC frame");
+  if (len == 24)
+  {
+    snprintf(what, sizeof(what), "UBX TIME_UTC %04d-%02d-%02d %02d:%02d:%02d", w.y, w.mo, w.d, w.h, w.mi, w.s);
+    check((t[0] == 0x10) && ((int8_t)t[3] == -128), "UBX TIME_UTC type / leap seconds unknown");
+    check((u16(&t[4]) == w.y) && (t[6] == w.mo) && (t[7] == w.d) && (t[8] == w.h) && (t[9] == w.mi) && (t[10] == w.s), what);
+    check(u16(&t[16]) == AID_TIMEACC_S, "UBX TIME_UTC accuracy");
+  }
+  check(aidTxLen == 28 + 32, "UBX two frames, nothing else");
+  check(aidDone == (AIDED_POS | AIDED_TIME), "UBX aided bits");
+}
+
+static void checkCasic(const When& w, bool havePos)
+{
+  char what[128];
+  freshBoot("CASIC", havePos);
+  setWhen(w);
+  aidQueueInit(true);
+  const uint8_t* p = aidTx;
+  check((aidTxLen == 66) && (p[0] == 0xBA) && (p[1] == 0xCE) && (u16(&p[2]) == 56) && (p[4] == 0x0B) && (p[5] == 0x01),
+    "CASIC AID-INI header");
+  if (aidTxLen != 66) return;
+  uint32_t sum = (0x01u << 24) + (0x0Bu << 16) + 56;
+  for (int i = 0; i < 56; i += 4) sum += u32(&p[6 + i]);
+  check(u32(&p[62]) == sum, "CASIC checksum");
+  const uint8_t* q = &p[6];
+  if (havePos)
+  {
+    check((r8(&q[0]) == aidLat) && (r8(&q[8]) == aidLon) && (fabs(r8(&q[16]) - 123.4) < 1e-4), "CASIC lat/lon/alt");
+  }
+  check(r4(&q[36]) == AID_POSACC_M, "CASIC position accuracy");
+  check(q[55] == ((havePos ? 0x01 : 0) | 0x02 | 0x20), "CASIC flags");
+  int week;
+  long tow;
+  refGpsTime(w.y, w.mo, w.d, w.h, w.mi, w.s, &week, &tow);
+  snprintf(what, sizeof(what), "CASIC %04d-%02d-%02d %02d:%02d:%02d week %u tow %.0f, reference %d %ld",
+    w.y, w.mo, w.d, w.h, w.mi, w.s, u16(&q[52]), r8(&q[24]), week, tow);
+  check((u16(&q[52]) == week) && (r8(&q[24]) == tow), what);
+  if (Serial.echo) printf("  %s\n", what);
+}
+
+static void checkPmtk(const When& w, bool havePos)
+{
+  char what[160];
+  freshBoot("PMTK", havePos);
+  setWhen(w);
+  aidQueueInit(false);
+  check(aidTxLen == 0, "PMTK nothing without the time");
+  aidQueueInit(true);
+  std::string s((const char*)aidTx, aidTxLen);
+  snprintf(what, sizeof(what), "PMTK sentence %s", s.c_str());
+  bool ok = (s.size() > 6) && (s[0] == '$') && (s.substr(s.size() - 2) == "\r\n");
+  size_t star = s.rfind('*');
+  ok = ok && (star != std::string::npos);
+  if (ok)
+  {
+    uint8_t cs = 0;
+    for (size_t i = 1; i < star; i++) cs ^= s[i];
+    ok = (strtoul(s.substr(star + 1, 2).c_str(), NULL, 16) == cs);
+  }
+  check(ok, what);
+  char want[128];
+  if (havePos)
+    snprintf(want, sizeof(want), "$PMTK741,47.752060,-122.209460,123,%04d,%02d,%02d,%02d,%02d,%02d*",
+      w.y, w.mo, w.d, w.h, w.mi, w.s);
+  else
+    snprintf(want, sizeof(want), "$PMTK740,%04d,%02d,%02d,%02d,%02d,%02d*", w.y, w.mo, w.d, w.h, w.mi, w.s);
+  check(s.compare(0, strlen(want), want) == 0, what);
+}
+
+//----------------------------------------------------------------------------
+// the database dump and its way back
+//----------------------------------------------------------------------------
+static std::string makeDbd(uint8_t cls, uint8_t id, int len, std::mt19937& rng)
+{
+  std::string f(8 + len, 0);
+  uint8_t* p = (uint8_t*)&f[0];
+  p[0] = 0xB5; p[1] = 0x62; p[2] = cls; p[3] = id;
+  p[4] = len; p[5] = len >> 8;
+  for (int i = 0; i < len; i++) p[6 + i] = rng();
+  uint8_t a = 0, b = 0;
+  for (int i = 2; i < 6 + len; i++) { a = a + p[i]; b = b + a; }
+  p[6 + len] = a;
+  p[7 + len] = b;
+  return f;
+}
+
+static void receiverSends(const std::string& frame)
+{
+  memcpy(gpsBinFrame, frame.data(), frame.size());
+  gpsBinLen = frame.size();
+  aidService();
+  delay(20);
+}
+
+static void run(unsigned long ms)
+{
+  for (unsigned long t = 0; t < ms; t += 10)
+  {
+    aidService();
+    delay(10);
+  }
+}
+
+static void checkDbd()
+{
+  std::mt19937 rng(4242);
+  fileSystem.format();
+  Preferences::store().clear();
+  Serial2.keepTx = true;
+  const When& w = whens[1];
+
+  // a boot with a fix, the dump polled
+  freshBoot("UBX", false);
+  aidInit("UBX");
+  setWhen(w);
+  aidDbdPoll();
+  const uint8_t* p;
+  int len = 0;
+  check(ubxFrame(aidTx, aidTxLen, 0x13, 0x80, &p, &len) && (len == 0), "MGA-DBD poll frame");
+  check(aidDbdActive, "dump being received");
+  Serial2.txData.clear();
+  run(AID_BOOT_MS + 100); // the poll goes out (no position saved, nothing else)
+
+  std::string want;
+  int frames = 0;
+  for (int i = 0; i < 40; i++)
+  {
+    std::string f = makeDbd(0x13, 0x80, 20 + rng() % 140, rng);
+    if (i == 7)
+    {
+      std::string bad = f;
+      bad[10] ^= 0x01; // checksum no longer matches
+      receiverSends(bad);
+    }
+    if (i == 21) receiverSends(makeDbd(0x01, 0x07, 92, rng)); // NAV-PVT, not ours
+    receiverSends(f);
+    want += f;
+    frames++;
+  }
+  run(AID_DBD_QUIET_MS + 100);
+  check(!aidDbdActive, "dump ended after the quiet time");
+  check(fileSystem.exists(AID_DBDFN) && !fileSystem.exists(AID_DBDTMPFN), "dump renamed into place");
+  File d = fileSystem.open(AID_DBDFN);
+  std::string stored(d.size(), 0);
+  d.read((uint8_t*)&stored[0], d.size());
+  check(stored == want, "dump holds exactly the good MGA-DBD frames");
+
+  // a poll nobody answers keeps the last good dump
+  aidTxLen = aidTxPos = 0;
+  aidDbdPoll();
+  run(AID_DBD_QUIET_MS + 100);
+  check(fileSystem.exists(AID_DBDFN) && (fileSystem.open(AID_DBDFN).size() == want.size()), "unanswered poll keeps the dump");
+
+  // reboot:  position, the dump byte for byte, then the time once NTP is done
+  aidSavePos(47.752060, -122.209460, rtc.getEpoch());
+  ntpDoneSim = false;
+  aidInit("UBX");
+  Serial2.txData.clear();
+  run(AID_BOOT_MS + 5000);
+  ntpDoneSim = true;
+  run(1000);
+  const std::string& tx = Serial2.txData;
+  check(ubxFrame((const uint8_t*)tx.data(), tx.size(), 0x13, 0x40, &p, &len) && (len == 20) && (p[0] == 0x01),
+    "reboot: POS_LLH first");
+  check((tx.size() >= 28 + want.size()) && (tx.compare(28, want.size(), want) == 0), "reboot: then the dump as stored");
+  const uint8_t* t = (const uint8_t*)tx.data() + 28 + want.size();
+  check((tx.size() == 28 + want.size() + 32) && ubxFrame(t, 32, 0x13, 0x40, &p, &len) && (p[0] == 0x10),
+    "reboot: TIME_UTC after the dump");
+  check(aidDone == (AIDED_POS | AIDED_DBD | AIDED_TIME), "reboot: aided pos, dbd, time");
+  printf("dump: %d frames, %zu bytes stored, %zu bytes sent at boot\n", frames, stored.size(), tx.size());
+}
+
+//----------------------------------------------------------------------------
+// aiding and motion settings on one port
+//----------------------------------------------------------------------------
+static void checkTogether()
+{
+  // the dump from checkDbd() is still in place, and the position
+  Serial2.txData.clear();
+  Serial2.txBytesPerSec = 9600 / 10;
+  Serial2.txFifo = 0;
+  ntpDoneSim = false;
+  aidInit("UBX");
+  motionTxLen = motionTxPos = 0;
+  int queued = 0;
+  for (unsigned long t = 0; t < AID_BOOT_MS + 20000; t += 2)
+  {
+    if ((t >= AID_BOOT_MS) && (t % 700 == 0) && (motionTxLen == 0))
+    {
+      motionQueueSettings(MOTION_MOVING); // first fix, then state changes
+      queued++;
+    }
+    if (t == AID_BOOT_MS + 3000) ntpDoneSim = true;
+    aidService();
+    motionTxService();
+    delay(2);
+  }
+  Serial2.txBytesPerSec = 0;
+
+  // every byte in a whole UBX frame
+  const std::string& tx = Serial2.txData;
+  std::string dbd;
+  int cfg = 0, other = 0, broken = 0;
+  size_t at = 0;
+  while (at < tx.size())
+  {
+    const uint8_t* f = (const uint8_t*)tx.data() + at;
+    const uint8_t* pl;
+    int len;
+    if (!ubxFrame(f, tx.size() - at, f[2], f[3], &pl, &len)) { broken++; break; }
+    if ((f[2] == 0x13) && (f[3] == 0x80)) dbd.append((const char*)f, 8 + len);
+    else if (f[2] == 0x06) cfg++;
+    else other++;
+    at += 8 + len;
+  }
+  File d = fileSystem.open(AID_DBDFN);
+  std::string stored(d.size(), 0);
+  d.read((uint8_t*)&stored[0], d.size());
+  check(!broken, "with motion: every byte in a whole frame");
+  check(dbd == stored, "with motion: the dump in order, byte for byte");
+  check(cfg == queued * 7, "with motion: every CFG-RATE / CFG-MSG frame");
+  check(other == 2, "with motion: POS_LLH and TIME_UTC");
+  printf("with motion: %zu bytes at 9600 baud, %d CFG frames in between, port taken %lu times\n",
+    tx.size(), cfg, gpsTxWaits);
+}
+
+int main(int argc, char** argv)
+{
+  if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) Serial.echo = true;
+
+  int week;
+  long tow;
+  refGpsTime(2017, 1, 1, 0, 0, 0, &week, &tow);
+  check((week == 1930) && (tow == 18), "reference: 2017-01-01 is GPS week 1930, TOW 18");
+
+  for (const When& w : whens)
+  {
+    checkUbx(w);
+    checkCasic(w, true);
+    checkCasic(w, false);
+    checkPmtk(w, true);
+    checkPmtk(w, false);
+  }
+  printf("encoders: UBX, CASIC, PMTK at %zu times\n", sizeof(whens) / sizeof(whens[0]));
+  checkDbd();
+  checkTogether();
+  printf("%s\n", failures ? "FAILED" : "check: frames, checksums, GPS week/TOW and the dump round trip - OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Batched-ack upload vs ftpPut() over a simulated lossy, dropping link
+//----------------------------------------------------------------------------
+// Both uploaders run unchanged (FtpService.h, BatchUploadService.h) with
+// wifiService() on the virtual clock of HostArduino.h / HostNet.h.  The
+// batch uploader talks to the real receiver code (BatchReceiver.h), which
+// writes to a scratch folder, and the result is compared with the log.
+//
+// ftpPut() has no resume, so after a dropped session the whole file is sent
+// again from the start (the simulated operator retries as soon as WiFi is
+// back).  The batch uploader reconnects by itself and resumes.
+//
+// Reported per scenario and uploader:  virtual seconds until the whole log
+// was at the server, TCP bytes sent (including resends), sessions, and for
+// the batch protocol records stored / duplicates dropped / check vs log.
+//
+// Last, the log is replaced by a shorter one with the receiver's file kept:
+// the receiver has to put the old file aside (NEWFILE) and store the new
+// log from record 0.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/batchbench host/batchbench.cpp
+//   host/batchbench [-v]
+//
+#include <cstdlib>
+#include <unistd.h>
+#include "HostArduino.h"
+#include "HostNet.h"
+#include "BatchReceiver.h"
+
+ESP32Time rtc(-8*3600);
+fs::FS & fileSystem = SPIFFS;
+
+#define LOGFN "/location.log"
+
+char wifissid[64] = "SimAP";
+char wifipwd[64] = "SimPassword";
+char ftpServer[128] = "ftp.sim";
+char ftpUser[64] = "sim";
+char ftpPwd[64] = "sim";
+char ftpUploadFolder[128] = "/sim";
+char batchServer[128] = "batch.sim";
+uint16_t batchPort = BATCH_PORT_DEFAULT;
+char batchDeviceId[64] = "gps-sim";
+
+void logMessage(char* msg) { Serial.println(msg); }
+
+#include "../FileSystemService.h"
+#include "../SchedulerService.h"
+#include "../WiFiService.h"
+#include "../FtpService.h"
+#include "../BatchUploadService.h"
+
+#define BENCH_RECORDS (7*24*60) /* a week of once-a-minute RMC lines */
+#define BENCH_LIMIT (4*3600)    /* give up after this many virtual seconds */
+
+//----------------------------------------------------------------------------
+// the receiver, reached through WiFiClient
+//----------------------------------------------------------------------------
+std::string outdir;
+BatchReceiverStats rxStats;
+
+class BenchPeer : public HostPeer
+{
+public:
+  void onConnect() override
+  {
+    rx.reset(new BatchReceiver(outdir, rxStats,
+      [this](const uint8_t* data, size_t len) { send(data, len); }));
+  }
+  void onData(const uint8_t* data, size_t len) override { if (rx) rx->onData(data, len); }
+  void onClose() override { rx.reset(); }
+private:
+  std::unique_ptr<BatchReceiver> rx;
+};
+
+BenchPeer benchPeer;
+
+//----------------------------------------------------------------------------
+// scenarios
+//----------------------------------------------------------------------------
+struct Scenario
+{
+  const char* name;
+  int lossPct;
+  unsigned long latencyMs;
+  unsigned long kbps;
+  unsigned long upSec, downSec; // AP in range upSec, then gone downSec, repeating (0 = always up)
+};
+
+static const Scenario scenarios[] = {
+  { "clean",           0,  10, 1000,  0,  0 },
+  { "lossy 5%",        5,  50,  500,  0,  0 },
+  { "lossy 15%",      15, 100,  250,  0,  0 },
+  { "drops 20s/30s",   2,  20,  250, 20, 30 },
+  { "lossy+drops",    10,  80,  250, 40, 40 },
+};
+
+static std::vector<NetPhase> phasesFor(const Scenario& sc)
+{
+  std::vector<NetPhase> p;
+  if (sc.upSec == 0)
+  {
+    p.push_back({ 0, 1, sc.latencyMs, sc.lossPct, sc.kbps });
+    return p;
+  }
+  for (unsigned long t = 0; t < BENCH_LIMIT; t += sc.upSec + sc.downSec)
+  {
+    p.push_back({ t, 1, sc.latencyMs, sc.lossPct, sc.kbps });
+    p.push_back({ t + sc.upSec, 0, 0, 0, 0 });
+  }
+  return p;
+}
+
+static std::string logContents;
+
+static void makeLogFile(int records)
+{
+  fileSystem.format();
+  File f = fileSystem.open(LOGFN, FILE_WRITE);
+  char line[128];
+  for (int m = 0; m < records; m++)
+  {
+    snprintf(line, sizeof(line),
+      "$GNRMC,%02d%02d00.000,A,4745.%04d,N,12212.5678,W,0.12,0.00,%02d1123,,,A*6F",
+      (m/60)%24, m%60, m%10000, 15 + m/1440);
+    f.println(line);
+  }
+  f.close();
+  File r = fileSystem.open(LOGFN);
+  logContents.assign(r.size(), 0);
+  r.read((uint8_t*)&logContents[0], r.size());
+}
+
+static void startScenario(const Scenario& sc)
+{
+  hostMicros = 0;
+  hostStats = HostNetStats();
+  rxStats = BatchReceiverStats();
+  WiFi = WiFiClass();
+  hostNet.script(phasesFor(sc), 4242);
+  rtc.setTime(00,00,00, 1, 1, 2023);
+  schedulerInit();
+  wifiInit();
+  wifiConnect();
+}
+
+//----------------------------------------------------------------------------
+// ftpPut() - retried from the start until one session gets through
+//----------------------------------------------------------------------------
+static void runFtp(const Scenario& sc)
+{
+  startScenario(sc);
+  int done = false;
+  while (!done && (hostNet.secondsIn() < BENCH_LIMIT))
+  {
+    delay(10);
+    if (!secondDetector()) continue;
+    wifiService();
+    if (wifiIsConnected())
+    {
+      unsigned long failed = hostStats.ftpFailed;
+      ftpPut(LOGFN);
+      done = (hostStats.ftpFailed == failed);
+    }
+  }
+  printf("  %-6s %8.0fs %10llu B %4lu sessions%s\n", "ftp",
+    done ? hostMicros / 1e6 : (double)BENCH_LIMIT,
+    (unsigned long long)hostStats.ftpBytesDelivered, hostStats.ftpSessions,
+    done ? "" : "  (did not finish)");
+}
+
+//----------------------------------------------------------------------------
+// batched-ack upload
+//----------------------------------------------------------------------------
+static std::string readAll(const std::string& fn)
+{
+  std::string got;
+  FILE* fp = fopen(fn.c_str(), "rb");
+  if (fp)
+  {
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) got.append(buf, n);
+    fclose(fp);
+  }
+  return got;
+}
+
+// keep - leave the receiver's file from the last run
+static void runBatch(const Scenario& sc, int keep = false)
+{
+  startScenario(sc);
+  std::string devfn = outdir + "/" + batchDeviceId + ".log";
+  if (!keep) unlink(devfn.c_str());
+  batchSessions = 0;
+  batchState = BATCHSTATE_IDLE;
+  batchTimer = 0;
+  int started = false;
+  while (hostNet.secondsIn() < BENCH_LIMIT)
+  {
+    delay(10);
+    if (secondDetector()) wifiService();
+    if (!started && wifiIsConnected())
+    {
+      batchStart(LOGFN);
+      started = true;
+    }
+    batchService();
+    if (started && !batchIsActive()) break;
+  }
+
+  // compare what the receiver stored with the log
+  std::string got = readAll(devfn);
+  printf("  %-6s %8.0fs %10llu B %4lu sessions  %lu records, %lu dups dropped, %s%s\n", "batch",
+    started && !batchIsActive() ? hostMicros / 1e6 : (double)BENCH_LIMIT,
+    (unsigned long long)hostStats.tcpBytesOut, batchSessions,
+    rxStats.records, rxStats.duplicates,
+    got == logContents ? "identical to log" : "MISMATCH",
+    started && !batchIsActive() ? "" : "  (did not finish)");
+}
+
+int main(int argc, char** argv)
+{
+  if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) Serial.echo = true;
+
+  char tmpl[] = "/tmp/batchbench-XXXXXX";
+  if (!mkdtemp(tmpl)) { perror("mkdtemp"); return 1; }
+  outdir = tmpl;
+  hostPeer = &benchPeer;
+  makeLogFile(BENCH_RECORDS);
+  printf("%d records, %zu bytes\n", BENCH_RECORDS, logContents.size());
+
+  for (const Scenario& sc : scenarios)
+  {
+    printf("%s (loss %d%%, %lums, %lukbit/s", sc.name, sc.lossPct, sc.latencyMs, sc.kbps);
+    if (sc.upSec) printf(", AP %lus in range / %lus gone", sc.upSec, sc.downSec);
+    printf(")\n");
+    runFtp(sc);
+    runBatch(sc);
+  }
+
+  // log replaced by a day's worth, the receiver still has the week
+  std::string devfn = outdir + "/" + batchDeviceId + ".log";
+  std::string oldfn = outdir + "/" + batchDeviceId + ".1.log";
+  std::string week = logContents;
+  makeLogFile(BENCH_RECORDS / 7);
+  printf("log replaced (%d records), receiver file kept\n", BENCH_RECORDS / 7);
+  runBatch(scenarios[0], true);
+  printf("  %lu new files, old file %s\n", rxStats.newFiles,
+    readAll(oldfn) == week ? "put aside intact" : "MISMATCH");
+  unlink(oldfn.c_str());
+  unlink(devfn.c_str());
+  rmdir(outdir.c_str());
+  return 0;
+}
@@ -0,0 +1,110 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Receiver for the batched-ack upload protocol (BatchProtocol.h)
+//----------------------------------------------------------------------------
+// Listens for loggers (BATCHSERVER=<pc address>:5005 in config.ini) and
+// appends each logger's records to <outdir>/<device id>.log.  Any number
+// of loggers at once, single threaded with poll().
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -o host/batchrecv host/batchrecv.cpp
+//   host/batchrecv [-p 5005] [-d outdir]
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "BatchReceiver.h"
+
+struct Conn
+{
+  int fd;
+  std::string peer;
+  std::unique_ptr<BatchReceiver> rx;
+};
+
+int main(int argc, char** argv)
+{
+  int port = BATCH_PORT_DEFAULT;
+  std::string outdir = ".";
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-p") == 0) && (i+1 < argc)) port = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-d") == 0) && (i+1 < argc)) outdir = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [-p port] [-d outdir]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  int lfd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if ((bind(lfd, (sockaddr*)&addr, sizeof(addr)) < 0) || (listen(lfd, 64) < 0))
+  {
+    perror("listen");
+    return 1;
+  }
+  printf("batch receiver on port %d, writing to %s\n", port, outdir.c_str());
+  fflush(stdout);
+
+  BatchReceiverStats stats;
+  std::vector<std::unique_ptr<Conn>> conns;
+  std::vector<pollfd> pfds;
+  uint8_t buf[16384];
+
+  for (;;)
+  {
+    pfds.clear();
+    pfds.push_back({ lfd, POLLIN, 0 });
+    for (auto& c : conns) pfds.push_back({ c->fd, POLLIN, 0 });
+    if (poll(pfds.data(), pfds.size(), -1) < 0) continue;
+
+    if (pfds[0].revents & POLLIN)
+    {
+      sockaddr_in from;
+      socklen_t fromlen = sizeof(from);
+      int fd = accept(lfd, (sockaddr*)&from, &fromlen);
+      if (fd >= 0)
+      {
+        auto c = std::make_unique<Conn>();
+        c->fd = fd;
+        c->peer = inet_ntoa(from.sin_addr);
+        // replies are 7 bytes, a blocking send is fine
+        c->rx = std::make_unique<BatchReceiver>(outdir, stats,
+          [fd](const uint8_t* data, size_t len) { send(fd, data, len, MSG_NOSIGNAL); });
+        conns.push_back(std::move(c));
+      }
+    }
+
+    for (size_t i = 1; i < pfds.size(); i++)
+    {
+      if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      Conn* c = conns[i-1].get();
+      ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+      if (n > 0)
+      {
+        c->rx->onData(buf, n);
+        continue;
+      }
+      printf("%s %s closed - %lu records stored, %lu duplicates dropped, %lu sessions, %lu new files\n",
+        c->peer.c_str(), c->rx->device().c_str(), stats.records, stats.duplicates, stats.sessions, stats.newFiles);
+      fflush(stdout);
+      close(c->fd);
+      c->fd = -1;
+    }
+    for (size_t i = 0; i < conns.size(); )
+      if (conns[i]->fd < 0) conns.erase(conns.begin() + i); else i++;
+  }
+}
@@ -0,0 +1,342 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Raw capture (CaptureService.h) - a full rate receiver through the ring,
+// dumped, checked and replayed
+//----------------------------------------------------------------------------
+// A receiver at 115200 baud:  RMC, GGA, VTG, GSA at -hz (5 by default),
+// GSV for four systems, GLL, ZDA and a UBX NAV-PVT frame every second,
+// now and then a line with a bad checksum or line noise in it.  Or the
+// lines of a recorded NMEA file, at the baud rate.  Each line goes into
+// GPSPORT at the virtual time its CR arrives, through gpsService() to
+// capService() as on the logger.
+//
+//   all       a ring big enough for everything - the dump has to be every
+//             record, timestamps to the microsecond
+//   ring      CAPTUREKB of the default 256 for the same time, and the
+//             small one (-kb) - what's left is the newest blocks, exactly
+//   replay    the dump (with the telnet chatter around it) played by
+//             ReplayService.h at 1x back into the GPS input and captured
+//             again:  the same lines and frames, time within a millisecond
+// and what capService() costs per record on this PC.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/capsim host/capsim.cpp
+//   host/capsim [recorded.log] [-min n] [-hz n] [-kb n] [-o dump.txt]
+//
+// -o writes the dump as it would come over telnet, for host/replay.
+//
+#include <chrono>
+#include <random>
+#include "HostArduino.h"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+#define CAPFN "/capture.bin"
+#define DUMPFN "/dump.txt"
+
+#include "../FileSystemService.h"
+#include "../GpsService.h"
+#include "../NmeaService.h"
+#include "../ReplayService.h"
+#include "../CaptureService.h"
+
+#define BYTE_US (1000000.0 / 11520)  /* 115200 8N1 */
+
+//----------------------------------------------------------------------------
+// the receiver
+//----------------------------------------------------------------------------
+struct Rx { uint64_t us; std::string bytes; };  // bytes in by us (at the CR)
+
+static std::string nmea(const char* body)
+{
+  uint8_t cs = 0;
+  for (const char* c = body; *c; c++) cs ^= *c;
+  char line[240];
+  snprintf(line, sizeof(line), "$%s*%02X", body, cs);
+  return line;
+}
+
+static std::string ubxNavPvt(unsigned long sec, double lat, double lon)
+{
+  std::string f = "\xb5\x62\x01\x07";
+  f += (char)92; f += (char)0;
+  uint8_t payload[92];
+  memset(payload, 0, sizeof(payload));
+  uint32_t itow = (uint32_t)(sec * 1000);
+  int32_t ilat = (int32_t)lround(lat * 1e7), ilon = (int32_t)lround(lon * 1e7);
+  memcpy(payload, &itow, 4);
+  payload[20] = 3; // 3D fix
+  memcpy(payload + 24, &ilon, 4);
+  memcpy(payload + 28, &ilat, 4);
+  f.append((const char*)payload, sizeof(payload));
+  uint8_t a = 0, b = 0;
+  for (size_t i = 2; i < f.size(); i++) { a += (uint8_t)f[i]; b += a; }
+  f += (char)a; f += (char)b;
+  return f;
+}
+
+static std::vector<Rx> makeStream(int minutes, int hz, std::mt19937& rng)
+{
+  std::vector<Rx> out;
+  std::uniform_int_distribution<int> pct(0, 999);
+  double lat = 47.75206, lon = -122.20946;
+  for (unsigned long sec = 0; sec < minutes * 60UL; sec++)
+  {
+    for (int k = 0; k < hz; k++)
+    {
+      uint64_t t = sec * 1000000ULL + k * (1000000ULL / hz) + 20000; // the receiver talks 20 ms after the epoch
+      std::vector<std::string> burst;
+      char body[220], tm[16];
+      unsigned long s = 9*3600 + sec;
+      snprintf(tm, sizeof(tm), "%02lu%02lu%02lu.%02d", s / 3600, (s / 60) % 60, s % 60, k * 100 / hz);
+      lat += 0.0000012 / hz; lon += 0.0000021 / hz;
+      double la = fabs(lat), lo = fabs(lon);
+      char lls[64];
+      snprintf(lls, sizeof(lls), "%02d%08.5f,N,%03d%08.5f,W", (int)la, (la - (int)la) * 60, (int)lo, (lo - (int)lo) * 60);
+      double kts = 22.0 + (pct(rng) - 500) / 250.0;
+      if (k == 0) burst.push_back(ubxNavPvt(sec, lat, lon));
+      snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%.3f,%.2f,151123,,,A,V", tm, lls, kts, 57.0 + (pct(rng) - 500) / 200.0);
+      burst.push_back(nmea(body));
+      snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", 57.0 + (pct(rng) - 500) / 200.0, kts, kts * 1.852);
+      burst.push_back(nmea(body));
+      snprintf(body, sizeof(body), "GNGGA,%s,%s,1,%02d,%.2f,%.1f,M,-18.0,M,,", tm, lls, 14 + pct(rng) % 3, 0.8 + (pct(rng) % 20) / 100.0, 52.0 + (pct(rng) % 30) / 10.0);
+      burst.push_back(nmea(body));
+      const char* ids[4] = { "1", "2", "3", "4" };
+      for (int sys = 0; sys < 4; sys++)
+      {
+        snprintf(body, sizeof(body), "GNGSA,A,3,%02d,%02d,%02d,%02d,,,,,,,,,1.6,0.9,1.3,%s", 2 + sys * 20, 5 + sys * 20, 12 + sys * 20, 15 + sys * 20, ids[sys]);
+        burst.push_back(nmea(body));
+      }
+      if (k == 0)
+      {
+        const char* talkers[4] = { "GP", "GL", "GA", "GB" };
+        for (int sys = 0; sys < 4; sys++)
+        {
+          int sats = 9 + sys, msgs = (sats + 3) / 4;
+          for (int m = 0; m < msgs; m++)
+          {
+            int n = snprintf(body, sizeof(body), "%sGSV,%d,%d,%02d", talkers[sys], msgs, m + 1, sats);
+            for (int i = m * 4; (i < sats) && (i < m * 4 + 4); i++)
+              n += snprintf(body + n, sizeof(body) - n, ",%02d,%02d,%03d,%02d", i * 3 + 1, 10 + (i * 7) % 70, (i * 37) % 360, 28 + (i * 5 + pct(rng) % 4) % 20);
+            snprintf(body + n, sizeof(body) - n, ",1");
+            burst.push_back(nmea(body));
+          }
+        }
+        snprintf(body, sizeof(body), "GNGLL,%s,%s,A,A", lls, tm);
+        burst.push_back(nmea(body));
+        snprintf(body, sizeof(body), "GNZDA,%s,15,11,2023,00,00", tm);
+        burst.push_back(nmea(body));
+      }
+      for (std::string& l : burst)
+      {
+        if (l[0] == '$')
+        {
+          int r = pct(rng);
+          if (r < 2) l[10] ^= 0x01;          // bad checksum
+          else if (r < 3) l[12] = 0x07;      // line noise
+        }
+        t += (uint64_t)(l.size() * BYTE_US);
+        if (l[0] == '$') { out.push_back({ t, l + "\r" }); t += (uint64_t)BYTE_US; out.back().bytes += "\n"; }
+        else out.push_back({ t, l });
+      }
+    }
+  }
+  return out;
+}
+
+static std::vector<Rx> readStream(const char* fn)
+{
+  std::vector<Rx> out;
+  FILE* fp = fopen(fn, "rb");
+  if (!fp) { perror(fn); exit(1); }
+  char line[1024];
+  uint64_t t = 0;
+  while (fgets(line, sizeof(line), fp))
+  {
+    line[strcspn(line, "\r\n")] = 0;
+    if (line[0] == 0) continue;
+    t += (uint64_t)((strlen(line) + 1) * BYTE_US);
+    out.push_back({ t, std::string(line) + "\r\n" });
+    t += (uint64_t)BYTE_US;
+  }
+  fclose(fp);
+  return out;
+}
+
+//----------------------------------------------------------------------------
+// what the dump should say for each record
+//----------------------------------------------------------------------------
+static std::string hex(const std::string& b)
+{
+  std::string s = "!";
+  char h[3];
+  for (unsigned char c : b) { snprintf(h, sizeof(h), "%02x", c); s += h; }
+  return s;
+}
+
+static std::string expected(uint64_t us, const std::string& bytes)
+{
+  std::string rec;
+  if ((uint8_t)bytes[0] == 0xB5) rec = hex(bytes);
+  else
+  {
+    std::string line = bytes.substr(0, bytes.find('\r'));
+    int raw = (line.size() >= CAP_SLOTLEN) || (line[0] != '$');
+    for (char c : line) raw |= (c < 0x20) || (c >= 0x7f);
+    rec = raw ? hex(line + "\r\n") : line;
+  }
+  return std::to_string(us) + " " + rec;
+}
+
+static std::vector<std::string> dumped;
+static void collect(const char* text) { dumped.push_back(text); }
+
+// the stream through gpsService() -> capService(), the capture from t0
+static double capture(const std::vector<Rx>& rx, int minutes, long kb, std::vector<std::string>& want)
+{
+  SPIFFS.remove(CAPFN);
+  hostMicros = 1000000;
+  gpsInit(115200);
+  uint64_t t0 = hostMicros;
+  capStart(minutes + 1, kb);
+  double wallNs = 0;
+  want.clear();
+  for (const Rx& r : rx)
+  {
+    hostMicros = t0 + r.us;
+    GPSPORT.feed(r.bytes.data(), r.bytes.size());
+    while (GPSPORT.available())
+    {
+      unsigned long frames = gpsBinFrames;
+      char* line = gpsService();
+      if (line || (gpsBinFrames != frames))
+      {
+        auto w0 = std::chrono::steady_clock::now();
+        capService(line);
+        wallNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - w0).count();
+      }
+      else capService(NULL);
+    }
+    want.push_back(expected(r.us, r.bytes));
+  }
+  capStop();
+  dumped.clear();
+  capDump(collect);
+  return wallNs;
+}
+
+static int compare(const std::vector<std::string>& want, const std::vector<std::string>& got, size_t* from)
+{
+  // the dump is the newest records - find where it starts
+  *from = want.size() - std::min(want.size(), got.size());
+  int wrong = 0;
+  for (size_t i = 0; i < got.size(); i++)
+    if ((*from + i >= want.size()) || (got[i] != want[*from + i]))
+    {
+      if (wrong++ < 3) printf("  %s\n  %s\n", got[i].c_str(), *from + i < want.size() ? want[*from + i].c_str() : "(none)");
+    }
+  return wrong;
+}
+
+//----------------------------------------------------------------------------
+// replay target - back into the GPS input, timed
+//----------------------------------------------------------------------------
+static std::vector<std::pair<uint64_t, std::string>> replayed;
+
+void replayOutput(const char* line)
+{
+  replayed.push_back({ hostMicros, line });
+}
+
+int main(int argc, char** argv)
+{
+  const char* fn = NULL;
+  int minutes = 10, hz = 5;
+  const char* outfn = NULL;
+  long smallKb = 64;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-min") == 0) && (i + 1 < argc)) minutes = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-hz") == 0) && (i + 1 < argc)) hz = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-kb") == 0) && (i + 1 < argc)) smallKb = atol(argv[++i]);
+    else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) outfn = argv[++i];
+    else fn = argv[i];
+  }
+  std::mt19937 rng(5);
+  std::vector<Rx> rx = fn ? readStream(fn) : makeStream(minutes, hz, rng);
+  if (rx.empty()) { fprintf(stderr, "no lines\n"); return 1; }
+  if (fn) minutes = (int)(rx.back().us / 60000000) + 1;
+  uint64_t inBytes = 0;
+  for (const Rx& r : rx) inBytes += r.bytes.size();
+  printf("%s: %zu records, %llu bytes in %d min (%.0f%% of 115200 baud)\n\n",
+    fn ? fn : "built-in receiver", rx.size(), (unsigned long long)inBytes, minutes, 100.0 * inBytes / (minutes * 60.0 * 11520));
+  int bad = 0;
+
+  // all of it
+  std::vector<std::string> want;
+  double ns = capture(rx, minutes, 1024, want);
+  size_t from;
+  int wrong = compare(want, dumped, &from);
+  printf("all       %lu blocks, %lu bytes in %lu out, %.2fx, %.1f KB a minute - %zu of %zu records back, %d wrong\n",
+    capSeq, capInBytes, capOutBytes, (double)capInBytes / capOutBytes, capOutBytes / 1024.0 / minutes,
+    dumped.size(), want.size(), wrong);
+  printf("          capService() %.0f ns a record\n", ns / rx.size());
+  double kbPerMin = capOutBytes / 1024.0 / minutes;
+  bad += wrong || (dumped.size() != want.size());
+  std::vector<std::string> all = dumped;
+
+  // the ring
+  for (long kb : { 256L, smallKb })
+  {
+    capture(rx, minutes, kb, want);
+    wrong = compare(want, dumped, &from);
+    double keptMin = dumped.empty() ? 0 : (rx.back().us - rx[from].us) / 60e6;
+    printf("ring %3ld  %d blocks, %lu written - newest %zu records, %.1f min kept (%.0f min at this rate), %d wrong\n",
+      kb, capBlocks, capSeq, dumped.size(), keptMin, kb / kbPerMin, wrong);
+    bad += wrong || dumped.empty();
+  }
+
+  // the dump, as a telnet log, replayed at 1x into a second capture
+  std::string log = "> cap dump\r\n";
+  for (const std::string& l : all) log += l + "\r\n";
+  log += "# " + std::to_string(all.size()) + " records\r\n> ";
+  File f = SPIFFS.open(DUMPFN, FILE_WRITE);
+  f.write((const uint8_t*)log.data(), log.size());
+  f.close();
+  if (outfn)
+  {
+    FILE* fp = fopen(outfn, "wb");
+    if (fp) { fwrite(log.data(), 1, log.size(), fp); fclose(fp); }
+  }
+  replayed.clear();
+  hostMicros = 5000000;
+  uint64_t r0 = hostMicros;
+  replayStart(DUMPFN, 1, false);
+  while (replayIsActive())
+  {
+    replayService();
+    if (replayIsActive() && ((long)(millis() - replayDueMs) < 0)) hostMicros = (uint64_t)replayDueMs * 1000;
+  }
+  int lineWrong = 0;
+  uint64_t late = 0;
+  uint64_t firstUs = strtoull(all[0].c_str(), NULL, 10);
+  for (size_t i = 0; i < all.size(); i++)
+  {
+    const char* rec = strchr(all[i].c_str(), ' ') + 1;
+    uint64_t us = strtoull(all[i].c_str(), NULL, 10) - firstUs;
+    if ((i >= replayed.size()) || (replayed[i].second != rec)) { lineWrong++; continue; }
+    uint64_t at = replayed[i].first - r0;
+    uint64_t off = (at > us) ? at - us : us - at;
+    if (off > late) late = off;
+  }
+  printf("replay    %zu of %zu records, %d different, timing off by %.3f ms at most\n",
+    replayed.size(), all.size(), lineWrong, late / 1000.0);
+  bad += lineWrong || (replayed.size() != all.size()) || (late > 1000);
+
+  printf("\n%s\n", bad ? "FAILED" : "ok");
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Server side dedup of the uploaded logs - one log per logger out of the
+// overlapping gpslog_*.log copies
+//----------------------------------------------------------------------------
+// ftpPut() sends the whole of location.log every time, so upload n holds
+// uploads 1..n-1 again and what the server keeps grows with the square of
+// the time the logger has been out.  This keeps one log per logger
+//   <out>/<logger>.log     every complete line once, in order
+//   <out>/<logger>.state   a line: the newest upload taken in, where the
+//                          log now on the logger starts in .log, how much
+//                          of it .log has, the rolling hash of that much,
+//                          and counts
+// and takes each new upload (<root>/<logger>/gpslog_*.log, by name - the
+// names sort by time) in as a stream:
+//   the first len bytes are hashed as they go by;  if the hash is the one
+//   in the state the upload starts with what's stored, and the rest
+//   after it is appended, up to its last line end (a torn line comes
+//   again whole next time) - the hash carries on over it, for next time
+//   shorter than len (the link dropped early) - hashed up to its last
+//   line end and the same much of .log hashed to match;  the same is a
+//   repeat with nothing new
+//   anything else - the log was deleted on the logger and started over,
+//   the upload is appended whole as the start of the next one
+// A 64 KB buffer, and per logger only the state: O(1) memory whatever
+// the number or size of the uploads.  The hash is a polynomial mod
+// 2^61-1, rolled a byte at a time.  .log is cut back to what the state
+// vouches for before anything is appended, so a run that was killed
+// part way through is picked up cleanly.
+//
+// Run on a folder of uploads it takes in whatever is new since the last
+// run.  Without one it makes its own (UploadFleet.h, -devices loggers for
+// -days days), takes the first half in, then the rest as a second run,
+// checks each log against the one UploadFleet.h says should come out, and
+// against a run from scratch, and shows what the server would hold kept
+// as uploaded vs deduped, day by day.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/dedup host/dedup.cpp
+//   host/dedup [root] [-o outdir] [-devices n] [-days n]
+//
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <unistd.h>
+#include "HostArduino.h"
+#include "UploadFleet.h"
+
+namespace fsys = std::filesystem;
+
+#define DEDUP_BUF (65536)
+#define DEDUP_MOD ((1ULL << 61) - 1)
+#define DEDUP_BASE (1000003ULL)
+
+struct DedupState
+{
+  char last[40];           // newest upload taken in, "" for none
+  uint64_t genStart;       // where the log now on the logger starts in .log
+  uint64_t len;            // how much of it .log has, up to a line end
+  uint64_t hash;           // of those len bytes
+  long uploads, restarts, repeats;
+};
+
+struct DedupStats { long uploads = 0; uint64_t read = 0, written = 0; };
+
+//----------------------------------------------------------------------------
+// the rolling hash
+//----------------------------------------------------------------------------
+static inline uint64_t roll(uint64_t h, uint8_t c)
+{
+  unsigned __int128 p = (unsigned __int128)h * DEDUP_BASE + c + 1;
+  uint64_t r = (uint64_t)(p & DEDUP_MOD) + (uint64_t)(p >> 61);
+  return (r >= DEDUP_MOD) ? r - DEDUP_MOD : r;
+}
+
+// len bytes of fp from where it is
+static uint64_t hashSpan(FILE* fp, uint64_t len, uint8_t* buf)
+{
+  uint64_t h = 0;
+  while (len > 0)
+  {
+    size_t n = fread(buf, 1, (size_t)std::min<uint64_t>(len, DEDUP_BUF), fp);
+    if (n == 0) return ~0ULL; // shorter than it should be, matches nothing
+    for (size_t i = 0; i < n; i++) h = roll(h, buf[i]);
+    len -= n;
+  }
+  return h;
+}
+
+//----------------------------------------------------------------------------
+// the state file
+//----------------------------------------------------------------------------
+static void stateLoad(const std::string& fn, DedupState* st)
+{
+  memset(st, 0, sizeof(DedupState));
+  FILE* fp = fopen(fn.c_str(), "r");
+  if (!fp) return;
+  unsigned long long g, l, h;
+  if (fscanf(fp, "%39s %llu %llu %llx %ld %ld %ld", st->last, &g, &l, &h,
+             &st->uploads, &st->restarts, &st->repeats) == 7)
+  {
+    st->genStart = g;
+    st->len = l;
+    st->hash = h;
+  }
+  else memset(st, 0, sizeof(DedupState));
+  if (strcmp(st->last, "-") == 0) st->last[0] = 0;
+  fclose(fp);
+}
+
+static bool stateSave(const std::string& fn, const DedupState* st)
+{
+  std::string tmp = fn + ".tmp";
+  FILE* fp = fopen(tmp.c_str(), "w");
+  if (!fp) return false;
+  fprintf(fp, "%s %llu %llu %llx %ld %ld %ld\n", st->last[0] ? st->last : "-",
+          (unsigned long long)st->genStart, (unsigned long long)st->len, (unsigned long long)st->hash,
+          st->uploads, st->restarts, st->repeats);
+  bool ok = (fclose(fp) == 0);
+  return ok && (rename(tmp.c_str(), fn.c_str()) == 0);
+}
+
+//----------------------------------------------------------------------------
+// one upload into .log
+//----------------------------------------------------------------------------
+static bool takeUpload(const std::string& path, FILE* log, DedupState* st, DedupStats* stats, uint8_t* buf)
+{
+  FILE* in = fopen(path.c_str(), "rb");
+  if (!in) return false;
+  uint64_t before = st->genStart + st->len;
+  bool restarted = false;
+  for (;;)
+  {
+    uint64_t pos = 0, h = 0, lineEnd = 0, hashAtLineEnd = 0;
+    bool same = (st->len == 0), decided = same;
+    size_t n;
+    fseek(log, 0, SEEK_END);
+    while ((n = fread(buf, 1, DEDUP_BUF, in)) > 0)
+    {
+      stats->read += n;
+      size_t from = 0; // of buf, appended from here once it's known to be new
+      for (size_t i = 0; i < n; i++)
+      {
+        h = roll(h, buf[i]);
+        pos++;
+        if (buf[i] == '\n') { lineEnd = pos; hashAtLineEnd = h; }
+        if (!decided && (pos == st->len))
+        {
+          decided = true;
+          same = (h == st->hash);
+          if (!same) break;
+          from = i + 1;
+        }
+      }
+      if (decided && !same) break;
+      if (decided && (from < n)) fwrite(buf + from, 1, n - from, log);
+    }
+
+    if (!decided && (lineEnd > 0))
+    {
+      // shorter than what's stored - a repeat if it's the same as the start of it
+      fflush(log);
+      fseek(log, (long)st->genStart, SEEK_SET);
+      same = (hashSpan(log, lineEnd, buf) == hashAtLineEnd);
+      decided = true;
+      if (same) st->repeats++;
+    }
+    else if (!decided) same = true; // no whole line in it, nothing to learn
+
+    if (same)
+    {
+      // cut back the torn last line
+      fflush(log);
+      if (lineEnd > st->len)
+      {
+        st->len = lineEnd;
+        st->hash = hashAtLineEnd;
+      }
+      if (ftruncate(fileno(log), (off_t)(st->genStart + st->len)) != 0) { fclose(in); return false; }
+      break;
+    }
+
+    // started over - the whole upload is the start of the next log
+    if (restarted) break; // can't happen, the first compare always matches
+    restarted = true;
+    fflush(log);
+    fseek(log, 0, SEEK_END);
+    st->genStart = ftell(log);
+    st->len = 0;
+    st->hash = 0;
+    st->restarts++;
+    rewind(in);
+  }
+  fclose(in);
+  stats->written += st->genStart + st->len - before;
+  st->uploads++;
+  stats->uploads++;
+  return true;
+}
+
+// everything new for one logger
+static bool dedupDevice(const fsys::path& dir, const std::string& outdir, DedupStats* stats, uint8_t* buf)
+{
+  std::string dev = dir.filename().string();
+  std::string logfn = outdir + "/" + dev + ".log", statefn = outdir + "/" + dev + ".state";
+  DedupState st;
+  stateLoad(statefn, &st);
+
+  std::vector<std::string> names;
+  for (const fsys::directory_entry& e : fsys::directory_iterator(dir))
+  {
+    std::string fn = e.path().filename().string();
+    if (e.is_regular_file() && (fn.compare(0, 7, "gpslog_") == 0) && (fn.size() > 11) &&
+        (fn.compare(fn.size() - 4, 4, ".log") == 0) && (strcmp(fn.c_str(), st.last) > 0))
+      names.push_back(fn);
+  }
+  if (names.empty()) return true;
+  std::sort(names.begin(), names.end());
+
+  FILE* log = fopen(logfn.c_str(), "r+b");
+  if (!log) log = fopen(logfn.c_str(), "w+b");
+  if (!log) { perror(logfn.c_str()); return false; }
+  // anything past what the state vouches for is from a run that didn't finish
+  fseek(log, 0, SEEK_END);
+  if ((uint64_t)ftell(log) < st.genStart + st.len)
+  {
+    printf("%s: %s is shorter than %s says, starting it again\n", dev.c_str(), logfn.c_str(), statefn.c_str());
+    memset(&st, 0, sizeof(st));
+    names.clear();
+    for (const fsys::directory_entry& e : fsys::directory_iterator(dir))
+    {
+      std::string fn = e.path().filename().string();
+      if (e.is_regular_file() && (fn.compare(0, 7, "gpslog_") == 0)) names.push_back(fn);
+    }
+    std::sort(names.begin(), names.end());
+  }
+  if (ftruncate(fileno(log), (off_t)(st.genStart + st.len)) != 0) { fclose(log); return false; }
+
+  bool ok = true;
+  for (const std::string& fn : names)
+  {
+    if (!takeUpload((dir / fn).string(), log, &st, stats, buf)) { ok = false; break; }
+    snprintf(st.last, sizeof(st.last), "%s", fn.c_str());
+  }
+  ok = (fclose(log) == 0) && ok;
+  return stateSave(statefn, &st) && ok;
+}
+
+static DedupStats dedupAll(const std::string& root, const std::string& outdir)
+{
+  static uint8_t buf[DEDUP_BUF];
+  DedupStats stats;
+  fsys::create_directories(outdir);
+  std::vector<fsys::path> dirs;
+  for (const fsys::directory_entry& e : fsys::directory_iterator(root))
+    if (e.is_directory()) dirs.push_back(e.path());
+  std::sort(dirs.begin(), dirs.end());
+  for (const fsys::path& d : dirs)
+    if (!dedupDevice(d, outdir, &stats, buf)) printf("%s: failed\n", d.filename().string().c_str());
+  return stats;
+}
+
+//----------------------------------------------------------------------------
+static std::string readAll(const std::string& fn)
+{
+  std::string s;
+  FILE* fp = fopen(fn.c_str(), "rb");
+  if (!fp) return s;
+  char buf[DEDUP_BUF];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) s.append(buf, n);
+  fclose(fp);
+  return s;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const char* what, const DedupStats& s, double sec)
+{
+  printf("%-14s %5ld uploads  %8.1f MB read  %6.1f MB appended  %6.1f ms  %6.0f MB/s\n",
+         what, s.uploads, s.read / 1e6, s.written / 1e6, sec * 1e3, sec > 0 ? s.read / sec / 1e6 : 0.0);
+}
+
+// bytes of the uploads day by day, as uploaded and as deduped
+static void growth(const std::string& root, const std::string& outdir)
+{
+  std::map<std::string, uint64_t> perDay;
+  for (const fsys::directory_entry& e : fsys::recursive_directory_iterator(root))
+  {
+    std::string fn = e.path().filename().string();
+    if (e.is_regular_file() && (fn.compare(0, 7, "gpslog_") == 0)) perDay[fn.substr(7, 8)] += e.file_size();
+  }
+  uint64_t logs = 0;
+  for (const fsys::directory_entry& e : fsys::directory_iterator(outdir))
+    if (e.path().extension() == ".log") logs += e.file_size();
+  uint64_t total = 0;
+  int days = 0;
+  printf("\n  day        uploads kept    grows by\n");
+  for (auto& d : perDay)
+  {
+    total += d.second;
+    days++;
+    printf("  %s  %9.1f MB  %8.1f MB\n", d.first.c_str(), total / 1e6, d.second / 1e6);
+  }
+  printf("  deduped    %9.1f MB   (%.0fx less), about %.1f MB a day whatever the age\n",
+         logs / 1e6, logs ? (double)total / logs : 0.0, days ? logs / 1e6 / days : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+  std::string root, outdir;
+  int devices = 20, days = 7;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) outdir = argv[++i];
+    else if ((strcmp(argv[i], "-devices") == 0) && (i + 1 < argc)) devices = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-days") == 0) && (i + 1 < argc)) days = atoi(argv[++i]);
+    else root = argv[i];
+  }
+  if (outdir.empty()) outdir = (fsys::temp_directory_path() / "dedup-logs").string();
+
+  if (!root.empty())
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    DedupStats s = dedupAll(root, outdir);
+    report("new uploads", s, secondsSince(t0));
+    return 0;
+  }
+
+  root = (fsys::temp_directory_path() / "dedup-uploads").string();
+  std::string scratch = (fsys::temp_directory_path() / "dedup-scratch").string();
+  fsys::remove_all(root);
+  fsys::remove_all(outdir);
+  fsys::remove_all(scratch);
+  printf("%d loggers x %d days, uploading every %d h, into %s\n", devices, days, FLEET_UPLOADSEC / 3600, root.c_str());
+
+  long half = 1700006400L + days * 86400L / 2;
+  fleetGenerate(root, devices, days, half);
+  auto t0 = std::chrono::steady_clock::now();
+  DedupStats s = dedupAll(root, outdir);
+  report("first half", s, secondsSince(t0));
+  std::map<std::string, std::string> rebuilt = fleetGenerate(root, devices, days);
+  t0 = std::chrono::steady_clock::now();
+  s = dedupAll(root, outdir);
+  report("second half", s, secondsSince(t0));
+  t0 = std::chrono::steady_clock::now();
+  s = dedupAll(root, scratch);
+  report("from scratch", s, secondsSince(t0));
+
+  long restarts = 0, repeats = 0, bad = 0;
+  for (auto& r : rebuilt)
+  {
+    std::string log = readAll(outdir + "/" + r.first + ".log");
+    if ((log != r.second) || (readAll(scratch + "/" + r.first + ".log") != log))
+    {
+      printf("  %s: %zu bytes, should be %zu - MISMATCH\n", r.first.c_str(), log.size(), r.second.size());
+      bad++;
+    }
+    DedupState st;
+    stateLoad(outdir + "/" + r.first + ".state", &st);
+    restarts += st.restarts;
+    repeats += st.repeats;
+  }
+  printf("check: %zu logs, %ld restarted on the logger, %ld short repeats - %s\n",
+         rebuilt.size(), restarts, repeats, bad ? "NOT as uploaded" : "every line once, as uploaded, both runs");
+  growth(root, outdir);
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// NMEA fan-out server on the PC, fed from a recorded NMEA file
+//----------------------------------------------------------------------------
+// Runs FanoutService.h (the same code as the logger's ports 2947 and
+// 10110) on real sockets, with the recorded lines going in where
+// gpsService() lines would.  Point gpsd clients (cgps, gpspipe -w / -r,
+// OpenCPN, ...) or "nc localhost 10110" at it.
+//
+// Lines are paced by the RMC times divided by speed (1 = real time);  max
+// sends as fast as the loop goes, which is how a client that can't keep
+// up gets cut off.  Every 5 seconds, and at the end, it prints each
+// client's mode, bytes sent and how far behind the ring head it is.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/fanserve host/fanserve.cpp
+//   host/fanserve recorded.log [speed|max] [-loop] [-hold sec]
+//
+// -loop plays the file over and over, -hold keeps serving this many
+// seconds after the end of the file (default 5) so clients can drain.
+//
+#include <chrono>
+#include <thread>
+#include "HostSocket.h"
+
+ESP32Time rtc(0);
+
+void logMessage(char* msg) { fprintf(stderr, "%s\n", msg); }
+
+#include "../NmeaService.h"
+#include "../FanoutService.h"
+
+typedef std::chrono::steady_clock Clock;
+static const Clock::time_point start = Clock::now();
+
+// clients are real, so millis() follows the wall clock here
+static void serve()
+{
+  hostMicros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+  fanoutService();
+}
+
+static void report(const char* when)
+{
+  printf("%s: accepted %lu refused %lu cut off %lu, raw head %u json head %u\n", when,
+    fanAccepted, fanRefused, fanCutOff, fanRaw.head, fanJson.head);
+  for (int i = 0; i < FAN_MAXCLIENTS; i++)
+  {
+    FanClient* fc = &fanClients[i];
+    if (!fc->inUse) continue;
+    FanRing* r = (fc->mode == FANMODE_JSON) ? &fanJson : &fanRaw;
+    printf("  client %d %-4s sent %10u behind %5u\n", i,
+      (fc->mode == FANMODE_JSON) ? "json" : (fc->mode == FANMODE_RAW) ? "nmea" : "idle",
+      fc->sent, fc->mode ? r->head - fc->cursor : 0);
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s recorded.log [speed|max] [-loop] [-hold sec]\n", argv[0]);
+    return 1;
+  }
+  double speed = 1;
+  int loop = false;
+  int hold = 5;
+  for (int i = 2; i < argc; i++)
+  {
+    if (strcmp(argv[i], "max") == 0) speed = 0;
+    else if (strcmp(argv[i], "-loop") == 0) loop = true;
+    else if ((strcmp(argv[i], "-hold") == 0) && (i+1 < argc)) hold = atoi(argv[++i]);
+    else speed = atof(argv[i]);
+  }
+  FILE* fp = fopen(argv[1], "rb");
+  if (!fp)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fanoutInit();
+  printf("serving gpsd on %d, NMEA on %d, %s\n", FAN_GPSD_PORT, FAN_NMEA_PORT, argv[1]);
+
+  char line[512];
+  long lastSec = -1;
+  unsigned long lines = 0;
+  Clock::time_point due = Clock::now(), nextReport = Clock::now() + std::chrono::seconds(5);
+  for (;;)
+  {
+    if (!fgets(line, sizeof(line), fp))
+    {
+      if (!loop) break;
+      rewind(fp);
+      lastSec = -1;
+      continue;
+    }
+    line[strcspn(line, "\r\n")] = 0;
+    if (line[0] == 0) continue;
+
+    // pace by the RMC time, serving clients while we wait
+    GpsFix fix;
+    if ((speed > 0) && rmcParse(line, &fix))
+    {
+      long sec = fixDaySeconds(&fix);
+      if ((lastSec >= 0) && (sec > lastSec))
+        due += std::chrono::microseconds((long)((sec - lastSec) * 1e6 / speed));
+      lastSec = sec;
+      while (Clock::now() < due)
+      {
+        serve();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+
+    fanoutLine(line);
+    serve();
+    lines++;
+
+    if (Clock::now() >= nextReport)
+    {
+      nextReport += std::chrono::seconds(5);
+      report("running");
+    }
+  }
+  double sec = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("%lu lines in, %.0f lines/s\n", lines, sec > 0 ? lines / sec : 0.0);
+
+  Clock::time_point end = Clock::now() + std::chrono::seconds(hold);
+  while (Clock::now() < end)
+  {
+    serve();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  report("end");
+  return 0;
+}
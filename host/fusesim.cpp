@@ -0,0 +1,452 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Dual receiver fusion (GpsFusionService.h) - two NMEA streams with
+// injected outages
+//----------------------------------------------------------------------------
+// Two streams go into GPSPORT and GPS2PORT on the virtual clock, each
+// epoch's lines arriving when a receiver would send them (the second
+// receiver 200-400 ms after the first, with jitter), and through the real
+// gpsService() / gps2Service() / fuseLine() / fuseService().
+//
+// The streams are either two recorded NMEA files (RMC and GGA, recorded
+// side by side) or, with no files, the built-in working day of
+// SimReceiver.h seen by two receivers with their own HDOP and correlated
+// position noise - then the truth is known and the error is reported.
+//
+// Per scenario outages are injected into the streams:  a receiver silent
+// (cable cut), no fix (antenna blocked), a steady 60 m offset with a
+// normal HDOP (multipath off a wall) and corrupted lines.  For GPS1 alone
+// (the logger before), GPS2 alone and the fused output it reports the
+// epochs with a fix, the longest stretch without one and, for the
+// built-in day, the mean and 95th percentile error.  Also checked:  the
+// fused epochs only go forward and every line out has a good checksum.
+// (A flipped bit can still get through the 8 bit NMEA checksum now and
+// then - '.' to '*' with the next two characters as a matching sum - the
+// last scenario shows what one such line does to a receiver alone.)
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/fusesim host/fusesim.cpp
+//   host/fusesim [gps1.log gps2.log] [-v]
+//
+#include <algorithm>
+#include <random>
+#include "HostArduino.h"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+#define GPS2PORT Serial1
+#define GPS2ESP_RXD_PIN (4)
+#define GPS2ESP_TXD_PIN (5)
+
+ESP32Time rtc(0);
+
+static std::vector<std::string> events;
+void logMessage(char* msg)
+{
+  events.push_back(msg);
+  if (Serial.echo) Serial.println(msg);
+}
+
+#include "../GpsService.h"
+#include "../NmeaService.h"
+#include "../GpsFusionService.h"
+
+// SimReceiver.h for the built-in day only
+#define AIDTYPE_NONE  (0)
+#define AIDTYPE_UBX   (1)
+#define AIDTYPE_CASIC (2)
+#define AIDTYPE_PMTK  (3)
+#include "SimReceiver.h"
+
+#define SIM_STEPMS (5)          /* loop() period on the virtual clock */
+#define SIM_BIAS_M (60.0)       /* multipath offset */
+
+//----------------------------------------------------------------------------
+// a stream - per second of the run the lines a receiver sent, in order
+//----------------------------------------------------------------------------
+struct Epoch
+{
+  unsigned long sec;            // from the start of the run
+  std::vector<std::string> lines;
+};
+typedef std::vector<Epoch> Stream;
+
+static void checksum(char* line)
+{
+  char* star = strchr(line, '*');
+  if (star) *star = 0;
+  uint8_t cs = 0;
+  for (char* c = line + 1; *c; c++) cs ^= *c;
+  sprintf(line + strlen(line), "*%02X", cs);
+}
+
+// field n replaced with val, new checksum
+static std::string setField(const std::string& line, int n, const char* val)
+{
+  size_t b = 0;
+  for (int i = 0; i < n; i++) b = line.find(',', b) + 1;
+  size_t e = line.find_first_of(",*", b);
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s%s%s", line.substr(0, b).c_str(), val, line.substr(e).c_str());
+  checksum(buf);
+  return buf;
+}
+
+//----------------------------------------------------------------------------
+// the built-in day, two receivers
+//----------------------------------------------------------------------------
+struct RxModel
+{
+  double hdop;                  // typical
+  double phase;                 // of the slow HDOP swing (satellites coming and going)
+  int sats;
+  int ggaFirst;                 // sentence order
+};
+
+static void makeLines(Epoch& ep, const Point& p, double lat, double lon, double hdop, int sats, int ggaFirst)
+{
+  char t[16], ll[48], body[200], line[220];
+  unsigned long s = ep.sec;
+  snprintf(t, sizeof(t), "%02lu%02lu%02lu.00", (s/3600) % 24, (s/60) % 60, s % 60);
+  int n = fuseDm(ll, sizeof(ll), lat, 2, 'N', 'S');
+  n += snprintf(ll + n, sizeof(ll) - n, ",");
+  fuseDm(ll + n, sizeof(ll) - n, lon, 3, 'E', 'W');
+
+  snprintf(body, sizeof(body), "$GNGGA,%s,%s,1,%02d,%.1f,52.0,M,-18.0,M,,", t, ll, sats, hdop);
+  strcpy(line, body); checksum(line);
+  std::string gga = line;
+  snprintf(body, sizeof(body), "$GNRMC,%s,A,%s,%.2f,%.1f,151123,,,A", t, ll, p.kts, p.course);
+  strcpy(line, body); checksum(line);
+  std::string rmc = line;
+  if (ggaFirst) { ep.lines.push_back(gga); ep.lines.push_back(rmc); }
+  else { ep.lines.push_back(rmc); ep.lines.push_back(gga); }
+}
+
+static Stream makeStream(const std::vector<Point>& track, const RxModel& m, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> g(0, 1);
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  double en = 0, ee = 0, a = 0.98; // correlated error, metres
+  Stream st;
+  for (unsigned long s = 0; s < track.size(); s++)
+  {
+    const Point& p = track[s];
+    double hdop = m.hdop * (1.0 + 0.6 * (0.5 + 0.5 * sin(s * 2 * M_PI / 5400.0 + m.phase)));
+    double sigma = 2.0 * hdop;
+    en = a * en + sqrt(1 - a*a) * sigma * g(rng);
+    ee = a * ee + sqrt(1 - a*a) * sigma * g(rng);
+    Epoch ep;
+    ep.sec = s;
+    makeLines(ep, p, p.lat + en / mPerDeg, p.lon + ee / (mPerDeg * cos(p.lat * M_PI / 180)),
+      hdop, m.sats - (int)(hdop - m.hdop), m.ggaFirst);
+    st.push_back(ep);
+  }
+  return st;
+}
+
+//----------------------------------------------------------------------------
+// a recorded file - RMC and GGA grouped by their time field
+//----------------------------------------------------------------------------
+static Stream readStream(const char* fn)
+{
+  Stream st;
+  FILE* fp = fopen(fn, "rb");
+  if (!fp) { perror(fn); exit(1); }
+  char line[512], t[16], lastT[16] = "";
+  long first = -1, lastDaySec = -1, days = 0;
+  while (fgets(line, sizeof(line), fp))
+  {
+    line[strcspn(line, "\r\n")] = 0;
+    if (!nmeaIsType(line, "RMC") && !nmeaIsType(line, "GGA")) continue;
+    if (nmeaField(line, 1, t, sizeof(t)) < 6) continue;
+    if (strcmp(t, lastT) != 0)
+    {
+      long daySec = ((t[0]-'0')*10 + (t[1]-'0')) * 3600L + ((t[2]-'0')*10 + (t[3]-'0')) * 60L + atoi(&t[4]);
+      if ((lastDaySec >= 0) && (daySec < lastDaySec - 43200)) days++; // midnight
+      lastDaySec = daySec;
+      long abs = days * 86400L + daySec;
+      if (first < 0) first = abs;
+      if (!st.empty() && (abs - first <= (long)st.back().sec)) continue; // out of order, skip
+      Epoch ep;
+      ep.sec = abs - first;
+      st.push_back(ep);
+      strcpy(lastT, t);
+    }
+    st.back().lines.push_back(line);
+  }
+  fclose(fp);
+  return st;
+}
+
+//----------------------------------------------------------------------------
+// outages
+//----------------------------------------------------------------------------
+enum { OUT_SILENT, OUT_NOFIX, OUT_BIAS, OUT_CORRUPT };
+
+struct Outage
+{
+  int rx;                       // 0 = GPS1, 1 = GPS2
+  int kind;
+  double from, to;              // fraction of the run
+  unsigned long everySec, lenSec; // within from..to, lenSec out of every everySec (0 = all of it)
+};
+
+struct Scenario
+{
+  const char* name;
+  std::vector<Outage> outages;
+};
+
+static const std::vector<Scenario> scenarios = {
+  { "clean",               { } },
+  { "GPS1 cable cut",      { { 0, OUT_SILENT, 0.40, 0.45, 0, 0 }, { 0, OUT_SILENT, 0.0, 1.0, 1800, 30 } } },
+  { "GPS2 blocked",        { { 1, OUT_NOFIX, 0.0, 1.0, 600, 120 } } },
+  { "both intermittent",   { { 0, OUT_SILENT, 0.0, 1.0, 900, 90 }, { 1, OUT_NOFIX, 0.0, 1.0, 700, 100 } } },
+  { "GPS1 multipath",      { { 0, OUT_BIAS, 0.30, 0.60, 0, 0 } } },
+  { "GPS2 bad lines 5%",   { { 1, OUT_CORRUPT, 0.0, 1.0, 0, 0 } } },
+};
+
+static bool active(const Outage& o, unsigned long sec, unsigned long total)
+{
+  if ((sec < o.from * total) || (sec >= o.to * total)) return false;
+  return (o.everySec == 0) || ((sec % o.everySec) < o.lenSec);
+}
+
+static Stream inject(const Stream& in, int rx, const Scenario& sc, unsigned long total)
+{
+  std::mt19937 rng(77 + rx);
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  Stream st;
+  for (const Epoch& e : in)
+  {
+    Epoch ep;
+    ep.sec = e.sec;
+    bool silent = false;
+    for (std::string line : e.lines)
+    {
+      for (const Outage& o : sc.outages)
+      {
+        if ((o.rx != rx) || !active(o, e.sec, total)) continue;
+        if (o.kind == OUT_SILENT) silent = true;
+        else if (o.kind == OUT_NOFIX)
+        {
+          if (nmeaIsType(line.c_str(), "RMC")) line = setField(line, 2, "V");
+          else line = setField(line, 6, "0");
+        }
+        else if (o.kind == OUT_BIAS)
+        {
+          int f = nmeaIsType(line.c_str(), "RMC") ? 3 : 2; // latitude
+          char dm[16], h[4], v[32];
+          nmeaField(line.c_str(), f, dm, sizeof(dm));
+          nmeaField(line.c_str(), f + 1, h, sizeof(h));
+          if (dm[0] == 0) continue;
+          double lat = nmeaDegrees(dm, h) + SIM_BIAS_M / mPerDeg;
+          fuseDm(v, sizeof(v), lat, 2, 'N', 'S');
+          *strchr(v, ',') = 0;
+          line = setField(line, f, v);
+        }
+        else if ((o.kind == OUT_CORRUPT) && (rng() % 100 < 5))
+        {
+          line[10 + rng() % (line.size() - 14)] ^= 0x04; // a bit flipped on the wire
+        }
+      }
+      if (!silent) ep.lines.push_back(line);
+    }
+    if (!ep.lines.empty()) st.push_back(ep);
+  }
+  return st;
+}
+
+//----------------------------------------------------------------------------
+// what came out - one entry per second with a fix
+//----------------------------------------------------------------------------
+struct Result
+{
+  unsigned long fixes = 0, longestGap = 0, badLines = 0, backwards = 0;
+  std::vector<double> err;
+
+  void summarize(const std::vector<int>& got, unsigned long total)
+  {
+    unsigned long gap = 0;
+    for (unsigned long s = 0; s < total; s++)
+    {
+      if (got[s]) { fixes++; gap = 0; }
+      else if (++gap > longestGap) longestGap = gap;
+    }
+  }
+};
+
+static void record(const char* line, long& lastT, std::vector<int>& got, Result& r,
+  const std::vector<Point>* truth, unsigned long sec)
+{
+  GpsFix fix;
+  if (!nmeaChecksumOk(line)) { r.badLines++; return; }
+  if (!rmcParse(line, &fix) || !fix.valid) return;
+  long t = fuseTime(fix.hour, fix.minute, fix.second);
+  if ((lastT >= 0) && (t <= lastT) && (lastT - t < FUSE_DAYCS / 2)) r.backwards++;
+  lastT = t;
+  if (sec >= got.size() || got[sec]) return;
+  got[sec] = 1;
+  if (truth)
+  {
+    const Point& p = (*truth)[sec];
+    double mPerDeg = 6371000.0 * M_PI / 180.0;
+    double dn = (fix.lat - p.lat) * mPerDeg;
+    double de = (fix.lon - p.lon) * mPerDeg * cos(p.lat * M_PI / 180);
+    r.err.push_back(sqrt(dn*dn + de*de));
+  }
+}
+
+// the second of the run an RMC is for - its time of day, a little before it arrived
+static unsigned long runSec(const char* line, unsigned long nowSec, long t0)
+{
+  GpsFix fix;
+  rmcParse(line, &fix);
+  long lag = ((long)nowSec + t0 - fuseTime(fix.hour, fix.minute, fix.second) / 100) % 86400;
+  if (lag < 0) lag += 86400;
+  return (lag <= (long)nowSec) ? nowSec - lag : 0;
+}
+
+//----------------------------------------------------------------------------
+// one scenario
+//----------------------------------------------------------------------------
+static void run(const Scenario& sc, const Stream& s1, const Stream& s2, const std::vector<Point>* truth)
+{
+  unsigned long total = std::max(s1.empty() ? 0 : s1.back().sec, s2.empty() ? 0 : s2.back().sec) + 1;
+  Stream a = inject(s1, 0, sc, total);
+  Stream b = inject(s2, 1, sc, total);
+
+  // the first epoch's time of day, to turn RMC times back into seconds of the run
+  long t0 = 0;
+  for (const std::string& l : (s1.empty() ? s2 : s1)[0].lines)
+  {
+    GpsFix fix;
+    if (rmcParse(l.c_str(), &fix)) t0 = fuseTime(fix.hour, fix.minute, fix.second) / 100 - (s1.empty() ? s2 : s1)[0].sec;
+  }
+
+  hostMicros = 0;
+  events.clear();
+  GPSPORT = HostSerial();
+  GPS2PORT = HostSerial();
+  gpsInit(9600);
+  gps2Init(9600);
+  fuseInit();
+
+  std::mt19937 rng(5);
+  std::vector<int> got1(total), got2(total), gotF(total);
+  Result r1, r2, rf;
+  long last1 = -1, last2 = -1, lastF = -1;
+  size_t ia = 0, ib = 0;
+  // arrival times:  GPS1 60 ms into the second, GPS2 200-400 ms, 40 ms per line
+  uint64_t nextA = 0, nextB = 0;
+  int lineA = 0, lineB = 0;
+  auto arrival = [&](const Epoch& e, int late) { return e.sec * 1000000ULL + (late ? 200000 + rng() % 200000 : 60000); };
+  if (ia < a.size()) nextA = arrival(a[ia], 0);
+  if (ib < b.size()) nextB = arrival(b[ib], 1);
+
+  uint64_t end = (total + 2) * 1000000ULL;
+  while (hostMicros < end)
+  {
+    while ((ia < a.size()) && (hostMicros >= nextA))
+    {
+      const std::string& l = a[ia].lines[lineA];
+      GPSPORT.feed(l.data(), l.size());
+      GPSPORT.feed("\r\n", 2);
+      if (++lineA < (int)a[ia].lines.size()) nextA += 40000;
+      else if (++ia < a.size()) { lineA = 0; nextA = arrival(a[ia], 0); }
+    }
+    while ((ib < b.size()) && (hostMicros >= nextB))
+    {
+      const std::string& l = b[ib].lines[lineB];
+      GPS2PORT.feed(l.data(), l.size());
+      GPS2PORT.feed("\r\n", 2);
+      if (++lineB < (int)b[ib].lines.size()) nextB += 40000;
+      else if (++ib < b.size()) { lineB = 0; nextB = arrival(b[ib], 1); }
+    }
+
+    unsigned long nowSec = hostMicros / 1000000;
+    while (GPSPORT.available())
+    {
+      char* line = gpsService();
+      if (line == NULL) continue;
+      if (nmeaIsType(line, "RMC")) record(line, last1, got1, r1, truth, runSec(line, nowSec, t0));
+      fuseLine(0, line);
+    }
+    while (GPS2PORT.available())
+    {
+      char* line = gps2Service();
+      if (line == NULL) continue;
+      if (nmeaIsType(line, "RMC")) record(line, last2, got2, r2, truth, runSec(line, nowSec, t0));
+      fuseLine(1, line);
+    }
+    char* rmc = fuseService();
+    if (rmc != NULL) record(rmc, lastF, gotF, rf, truth, runSec(rmc, nowSec, t0));
+    delay(SIM_STEPMS);
+  }
+  r1.summarize(got1, total);
+  r2.summarize(got2, total);
+  rf.summarize(gotF, total);
+
+  printf("%s\n", sc.name);
+  auto row = [&](const char* name, Result& r, int isFused)
+  {
+    printf("  %-7s %6lu/%-6lu %6lus", name, r.fixes, total, r.longestGap);
+    if (truth && !r.err.empty())
+    {
+      std::sort(r.err.begin(), r.err.end());
+      double sum = 0;
+      for (double e : r.err) sum += e;
+      printf(" %8.1f %8.1f", sum / r.err.size(), r.err[r.err.size() * 95 / 100]);
+    }
+    else printf(" %8s %8s", "-", "-");
+    if (isFused) printf("   %lu backwards, %lu bad lines", r.backwards, r.badLines);
+    printf("\n");
+  };
+  row("GPS1", r1, false);
+  row("GPS2", r2, false);
+  row("fused", rf, true);
+  printf("  both %lu, fused %lu, disagree %lu, skew %lu ms\n", fuseMatched, fuseFused, fuseDisagree,
+    fuseMatched ? fuseSkewMsSum / fuseMatched : 0);
+  for (int i = 0; i < FUSE_RECEIVERS; i++)
+  {
+    FuseRx* r = &fuseRx[i];
+    printf("  GPS%d health: epochs %lu fix %lu chosen %lu late %lu bad %lu hdop %.2f sats %.1f outages %lu out %lus\n",
+      i + 1, r->epochs, r->fixEpochs, r->chosen, r->late, r->badLines,
+      r->ggaEpochs ? r->hdopSum / r->ggaEpochs : 0.0, r->ggaEpochs ? (double)r->satsSum / r->ggaEpochs : 0.0,
+      r->outages, r->outSec + (r->out ? (millis() - r->lastEpochMs) / 1000 : 0));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* fn[2] = { NULL, NULL };
+  int nfn = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else if (nfn < 2) fn[nfn++] = argv[i];
+  }
+  if (nfn == 1) { fprintf(stderr, "usage: %s [gps1.log gps2.log] [-v]\n", argv[0]); return 1; }
+
+  Stream s1, s2;
+  std::vector<Point> track;
+  if (nfn == 2)
+  {
+    s1 = readStream(fn[0]);
+    s2 = readStream(fn[1]);
+    if (s1.empty() || s2.empty()) { fprintf(stderr, "no RMC/GGA in %s\n", s1.empty() ? fn[0] : fn[1]); return 1; }
+    printf("%s + %s: %lu / %lu epochs\n", fn[0], fn[1], (unsigned long)s1.size(), (unsigned long)s2.size());
+  }
+  else
+  {
+    track = makeTrack();
+    s1 = makeStream(track, { 0.9, 0.0, 12, true }, 1);
+    s2 = makeStream(track, { 1.1, 2.5, 10, false }, 2);
+    printf("working day, two receivers: HDOP ~0.9 and ~1.1, correlated noise 2 m x HDOP\n");
+  }
+  printf("  %-7s %13s %7s %8s %8s\n", "", "epochs w/fix", "gap", "mean m", "95% m");
+  for (const Scenario& sc : scenarios) run(sc, s1, s2, track.empty() ? NULL : &track);
+  return 0;
+}
@@ -0,0 +1,257 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Geofence simulator - a driving day with and without GeofenceService.h
+//----------------------------------------------------------------------------
+// Drives a scripted route (parked at the depot, out to a customer, back
+// past the depot on the main road, then into the depot) on the virtual
+// clock.  An RMC line goes into geofenceUpdate() every second, exactly as
+// rmcbuf does in loop(), and the depot AP is in range only within
+// AP_RANGE_M of it.  The once-per-second part of loop() runs the real
+// wifiService() and, on arrival, ftpPut() as GpsLogger.ino does.
+//
+// Per policy it reports:
+//   search   - seconds the radio spent scanning/associating with no AP
+//   off      - seconds the radio was off
+//   begins   - WiFi.begin() calls
+//   connect  - seconds from the depot AP coming into range to connected
+//   uploaded - seconds from the AP coming into range to the log uploaded
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/geosim host/geosim.cpp
+//   host/geosim          (add -v to see the services' Serial output)
+//
+#include <chrono>
+#include "HostArduino.h"
+#include "HostNet.h"
+
+ESP32Time rtc(-8*3600);
+fs::FS & fileSystem = SPIFFS;
+
+#define LOGFN "/location.log"
+
+char wifissid[64] = "SimAP";
+char wifipwd[64] = "SimPassword";
+char ftpServer[128] = "ftp.sim";
+char ftpUser[64] = "sim";
+char ftpPwd[64] = "sim";
+char ftpUploadFolder[128] = "/sim";
+
+#include "../FileSystemService.h"
+#include "../SchedulerService.h"
+#include "../WiFiService.h"
+#include "../FtpService.h"
+#include "../NmeaService.h"
+#include "../GeofenceService.h"
+
+#define DEPOT_LAT (47.75206)
+#define DEPOT_LON (-122.20946)
+#define AP_RANGE_M (120)
+
+//----------------------------------------------------------------------------
+// the route - legs from one point to the next at a speed, 0 = parked
+//----------------------------------------------------------------------------
+struct Leg
+{
+  double north, east;   // metres from the depot at the end of the leg
+  double mps;           // speed, 0 = parked for sec seconds
+  unsigned long sec;
+};
+
+static const std::vector<Leg> route = {
+  {     0,     0,  0, 1800 },  // parked at the depot
+  {  -400,     0,  8,    0 },  // out to the main road
+  {  -400, 30000, 27,    0 },  // highway to the customer
+  {  -400, 30000,  0, 7200 },  // parked at the customer
+  {  -400, -5000, 27,    0 },  // back along the highway, past the depot turn
+  {  -400,  -400, 15,    0 },  // turned round
+  {  -400,     0, 10,    0 },
+  {     0,     0,  8,    0 },  // into the depot
+  {     0,     0,  0, 3600 },  // parked
+};
+
+struct Point { double lat, lon, kts, course; };
+
+static std::vector<Point> makeTrack()
+{
+  std::vector<Point> track;
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  double n = 0, e = 0;
+  for (const Leg& leg : route)
+  {
+    double dn = leg.north - n, de = leg.east - e;
+    double dist = sqrt(dn*dn + de*de);
+    unsigned long sec = leg.mps > 0 ? (unsigned long)(dist / leg.mps) : leg.sec;
+    double course = fmod(atan2(de, dn) * 180 / M_PI + 360, 360);
+    for (unsigned long s = 0; s < sec; s++)
+    {
+      double f = (double)s / sec;
+      double pn = n + dn*f, pe = e + de*f;
+      track.push_back({ DEPOT_LAT + pn / mPerDeg,
+                        DEPOT_LON + pe / (mPerDeg * cos(DEPOT_LAT * M_PI / 180)),
+                        leg.mps / 0.5144, course });
+    }
+    n = leg.north; e = leg.east;
+  }
+  return track;
+}
+
+// the AP is in range near the depot only
+static std::vector<NetPhase> linkFromTrack(const std::vector<Point>& track)
+{
+  GeofenceZone depot = { DEPOT_LAT, DEPOT_LON, AP_RANGE_M };
+  std::vector<NetPhase> phases;
+  int was = -1;
+  for (size_t s = 0; s < track.size(); s++)
+  {
+    int up = geofenceDistance(track[s].lat, track[s].lon, &depot) < AP_RANGE_M;
+    if (up != was) phases.push_back({ (unsigned long)s, up, 5, 0, 8000 });
+    was = up;
+  }
+  return phases;
+}
+
+static void rmcLine(char* buf, int maxlen, unsigned long sec, const Point& p)
+{
+  char body[128];
+  double alat = fabs(p.lat), alon = fabs(p.lon);
+  snprintf(body, sizeof(body), "GNRMC,%02lu%02lu%02lu.000,A,%02d%07.4f,%c,%03d%07.4f,%c,%.2f,%.1f,151123,,,A",
+    (sec/3600) % 24, (sec/60) % 60, sec % 60,
+    (int)alat, (alat - (int)alat) * 60, p.lat < 0 ? 'S' : 'N',
+    (int)alon, (alon - (int)alon) * 60, p.lon < 0 ? 'W' : 'E',
+    p.kts, p.course);
+  uint8_t sum = 0;
+  for (char* c = body; *c; c++) sum ^= (uint8_t)*c;
+  snprintf(buf, maxlen, "$%s*%02X", body, sum);
+}
+
+static void makeLogFile()
+{
+  fileSystem.format();
+  File f = fileSystem.open(LOGFN, FILE_WRITE);
+  char line[128];
+  for (int m = 0; m < 8*60; m++)
+  {
+    snprintf(line, sizeof(line),
+      "$GNRMC,%02d%02d00.000,A,4745.1234,N,12212.5678,W,0.12,0.00,151123,,,A*6F", m/60, m%60);
+    f.println(line);
+  }
+  f.close();
+}
+
+//----------------------------------------------------------------------------
+// one policy over the whole track
+//----------------------------------------------------------------------------
+struct Policy
+{
+  const char* name;
+  int zones;        // geofence around the depot
+  int fallbackMin;
+};
+
+static const std::vector<Policy> policies = {
+  { "always-on", false, 0 },
+  { "geofence", true, 60 },
+  { "geofence-nofb", true, 0 },
+};
+
+static void runPolicy(const Policy& po, const std::vector<Point>& track)
+{
+  hostMicros = 0;
+  hostStats = HostNetStats();
+  WiFi = WiFiClass();
+  hostNet.script(linkFromTrack(track), 12345);
+  makeLogFile();
+  rtc.setTime(00,00,00, 1, 1, 2023);
+  schedulerInit();
+  wifiInit();
+
+  geofenceCount = 0;
+  geofenceState = GEOSTATE_UNKNOWN;
+  geofenceAwaySec = 0;
+  geofenceEntries = 0;
+  geofenceArrival = false;
+  geofenceFallbackMin = po.fallbackMin;
+  if (po.zones)
+  {
+    char spec[64];
+    snprintf(spec, sizeof(spec), "%.6f,%.6f,150", DEPOT_LAT, DEPOT_LON);
+    geofenceAddZone(spec);
+  }
+
+  auto wall0 = std::chrono::steady_clock::now();
+
+  wifiConnect();
+  char rmcbuf[128] = "";
+  int uploadOnConnect = false;
+  int apWasUp = hostNet.up();
+  uint64_t apUpAt = 0;
+  double connectSec = -1, uploadSec = -1;
+
+  while (hostNet.secondsIn() < track.size())
+  {
+    delay(50); // high rate part of loop()
+
+    if (secondDetector())
+    {
+      unsigned long sec = hostNet.secondsIn();
+      rmcLine(rmcbuf, sizeof(rmcbuf), sec, track[sec < track.size() ? sec : track.size()-1]);
+
+      // geofenceWifiService() from GpsLogger.ino
+      geofenceUpdate(rmcbuf);
+      if (geofenceWantWifi())
+      {
+        if (wifiIsOff()) wifiConnect();
+      }
+      else if (!wifiIsConnected() && !wifiIsOff())
+      {
+        wifiOff();
+      }
+      if (geofenceArrived())
+      {
+        wifiRetryNow();
+        uploadOnConnect = true;
+      }
+
+      wifiService();
+      if (uploadOnConnect && wifiIsConnected())
+      {
+        uploadOnConnect = false;
+        ftpPut(LOGFN);
+        if ((apUpAt > 0) && (uploadSec < 0)) uploadSec = (hostMicros - apUpAt) / 1e6;
+      }
+    }
+
+    WiFi.sampleRadio();
+
+    // the last time the depot AP comes into range is the return trip
+    int apUp = hostNet.up();
+    if (apUp && !apWasUp)
+    {
+      apUpAt = hostMicros;
+      connectSec = uploadSec = -1;
+    }
+    apWasUp = apUp;
+    if ((apUpAt > 0) && (connectSec < 0) && wifiIsConnected()) connectSec = (hostMicros - apUpAt) / 1e6;
+  }
+
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+
+  printf("%-14s %7.0fs %7.0fs %6lu", po.name,
+    hostStats.radioSearchUs / 1e6, hostStats.radioOffUs / 1e6, hostStats.wifiBegins);
+  if (connectSec >= 0) printf(" %7.0fs", connectSec); else printf(" %8s", "never");
+  if (uploadSec >= 0) printf(" %8.0fs", uploadSec); else printf(" %9s", "-");
+  printf(" %8.0fx\n", wallSec > 0 ? hostMicros / 1e6 / wallSec : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+  if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) Serial.echo = true;
+
+  std::vector<Point> track = makeTrack();
+  printf("route %.1f hours, depot AP in range within %dm, zone radius 150m\n",
+    track.size() / 3600.0, AP_RANGE_M);
+  printf("%-14s %8s %8s %6s %8s %9s %9s\n",
+    "policy", "search", "off", "begins", "connect", "uploaded", "speedup");
+  for (const Policy& po : policies) runPolicy(po, track);
+  return 0;
+}
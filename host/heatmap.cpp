@@ -0,0 +1,457 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Fleet coverage heatmap - every stored track drawn into web mercator
+// tiles, written as PNG or raw counts
+//----------------------------------------------------------------------------
+// Reads the same .seg files as trackmerge.cpp (SegFiles.h) and draws each
+// logger's track, fix to fix, into 256 x 256 pixel tiles at each zoom
+// asked for - <out>/<z>/<x>/<y>.png, the slippy map layout any web map
+// takes as an overlay:
+//   filter      -logger names drop whole files;  -from / -to and -bbox are
+//               tried on each SegHeader first (time, lat and lon ranges),
+//               so segments outside them are never decoded, then on the
+//               fixes of the segments that are
+//   draw        the files shared out to the threads, each drawing into its
+//               own tiles (a count a pixel, a line a pixel once), made as
+//               the track first reaches them;  no line across a gap of
+//               more than HEAT_GAP seconds
+//   merge       the tiles of the same z/x/y from all threads added up,
+//               the tiles shared out to the threads again
+//   write       PNG (zlib), the count of a pixel scaled by log against the
+//               zoom's busiest pixel into a transparent to red to yellow to
+//               white ramp;  or -raw, <y>.u32, the 256 x 256 counts as
+//               little endian uint32
+//
+// Run on the built-in fleet (segFleetGenerate(), 2500 loggers a day), or
+// with -scale, it does it all with 1, 2, 4 ... -t threads and reports the
+// tiles a second of each, checking every one came out with the same
+// counts.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -pthread -o host/heatmap host/heatmap.cpp -lz
+//   host/heatmap [root] [-o outdir] [-z 8-12] [-t threads] [-raw] [-scale]
+//                [-from unix] [-to unix] [-bbox lat0,lon0,lat1,lon1] [-logger name,name]
+//                [-loggers n]
+//
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <zlib.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "UploadFleet.h"
+#include "SegFiles.h"
+
+namespace fsys = std::filesystem;
+
+#define HEAT_TILE (256)
+#define HEAT_GAP (300)                /* seconds, no line across a longer one */
+#define HEAT_MAXZOOM (18)
+
+struct Tile { uint32_t c[HEAT_TILE * HEAT_TILE]; };
+
+static inline uint64_t tileKey(int z, uint32_t x, uint32_t y)
+{
+  return ((uint64_t)z << 58) | ((uint64_t)x << 29) | y;
+}
+
+static inline int keyZoom(uint64_t k) { return (int)(k >> 58); }
+static inline uint32_t keyX(uint64_t k) { return (uint32_t)(k >> 29) & 0x1fffffff; }
+static inline uint32_t keyY(uint64_t k) { return (uint32_t)k & 0x1fffffff; }
+
+// one thread's tiles;  the last one used kept at hand, a line is mostly in one
+struct Canvas
+{
+  std::unordered_map<uint64_t, std::unique_ptr<Tile>> tiles;
+  uint64_t lastKey = ~0ULL;
+  Tile* last = NULL;
+  long pixels = 0, lines = 0, fixes = 0, segsRead = 0, segsSkipped = 0;
+
+  inline void plot(int z, uint32_t px, uint32_t py)
+  {
+    uint64_t k = tileKey(z, px >> 8, py >> 8);
+    if (k != lastKey)
+    {
+      auto& t = tiles[k];
+      if (!t) t.reset(new Tile());
+      last = t.get();
+      lastKey = k;
+    }
+    last->c[(py & 255) * HEAT_TILE + (px & 255)]++;
+    pixels++;
+  }
+};
+
+struct Heat
+{
+  std::vector<std::string> loggers;
+  std::vector<SegFile> in;
+  std::vector<int> zooms;
+  int32_t from = INT32_MIN, to = INT32_MAX;               // from SEG_EPOCH
+  int32_t lat0 = INT32_MIN, lat1 = INT32_MAX, lon0 = INT32_MIN, lon1 = INT32_MAX;
+  bool raw = false;
+  std::string outdir;
+  // results of a run
+  std::vector<std::pair<uint64_t, Tile*>> merged;
+  uint32_t peak[HEAT_MAXZOOM + 1];
+  uint64_t hash = 0;
+  long pixels = 0, lines = 0, fixes = 0, segsRead = 0, segsSkipped = 0, written = 0, bytes = 0;
+  double drawSec = 0, mergeSec = 0, writeSec = 0;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//----------------------------------------------------------------------------
+// draw
+//----------------------------------------------------------------------------
+// web mercator, the world as [0, 1) x [0, 1)
+static inline void mercator(int32_t lat, int32_t lon, double* x, double* y)
+{
+  double la = std::max(-85.05112878, std::min(85.05112878, lat / 1e6)) * M_PI / 180;
+  *x = (lon / 1e6 + 180.0) / 360.0;
+  *y = (1.0 - log(tan(la) + 1.0 / cos(la)) / M_PI) / 2.0;
+}
+
+// Bresenham from (x0, y0) to (x1, y1), the first pixel left out when it's
+// the end of the line before
+static void line(Canvas& cv, int z, int64_t x0, int64_t y0, int64_t x1, int64_t y1, bool first)
+{
+  int64_t dx = llabs(x1 - x0), dy = -llabs(y1 - y0);
+  int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+  int64_t err = dx + dy;
+  if (first) cv.plot(z, (uint32_t)x0, (uint32_t)y0);
+  while ((x0 != x1) || (y0 != y1))
+  {
+    int64_t e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+    cv.plot(z, (uint32_t)x0, (uint32_t)y0);
+  }
+}
+
+static inline bool segWanted(const Heat& h, const SegRef& s)
+{
+  return (s.last >= h.from) && (s.first < h.to) && (s.maxLat >= h.lat0) && (s.minLat <= h.lat1) &&
+         (s.maxLon >= h.lon0) && (s.minLon <= h.lon1);
+}
+
+static void drawFile(const Heat& h, Canvas& cv, const SegFile& f)
+{
+  static thread_local int32_t col[SEG_COLS][SEG_MAXFIXES];
+  bool have = false;                  // a fix before, to draw from
+  int32_t prevT = 0;
+  double prevX = 0, prevY = 0;
+  for (size_t i = 0; i < f.segs.size(); i++)
+  {
+    if (!segWanted(h, f.segs[i])) { cv.segsSkipped++; have = false; continue; }
+    cv.segsRead++;
+    int n = segFileDecode(f, i, col);
+    for (int j = 0; j < n; j++)
+    {
+      int32_t t = col[SEG_TIME][j], lat = col[SEG_LAT][j], lon = col[SEG_LON][j];
+      if ((t < h.from) || (t >= h.to) || (lat < h.lat0) || (lat > h.lat1) || (lon < h.lon0) || (lon > h.lon1))
+      {
+        have = false;
+        continue;
+      }
+      double x, y;
+      mercator(lat, lon, &x, &y);
+      bool joined = have && (t - prevT <= HEAT_GAP) && (t > prevT);
+      for (int z : h.zooms)
+      {
+        double scale = (double)((int64_t)HEAT_TILE << z);
+        int64_t x1 = (int64_t)(x * scale), y1 = (int64_t)(y * scale);
+        if (joined) line(cv, z, (int64_t)(prevX * scale), (int64_t)(prevY * scale), x1, y1, false);
+        else cv.plot(z, (uint32_t)x1, (uint32_t)y1);
+      }
+      cv.lines += joined;
+      cv.fixes++;
+      have = true;
+      prevT = t;
+      prevX = x;
+      prevY = y;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// write
+//----------------------------------------------------------------------------
+static void pngChunk(std::string& out, const char* type, const uint8_t* data, uint32_t len)
+{
+  uint8_t be[4] = { (uint8_t)(len >> 24), (uint8_t)(len >> 16), (uint8_t)(len >> 8), (uint8_t)len };
+  out.append((const char*)be, 4);
+  size_t at = out.size();
+  out.append(type, 4);
+  out.append((const char*)data, len);
+  uint32_t crc = crc32(0, (const uint8_t*)out.data() + at, len + 4);
+  uint8_t bc[4] = { (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc };
+  out.append((const char*)bc, 4);
+}
+
+// transparent, dark red, red, yellow, white as v goes 0 to 1
+static inline void ramp(double v, uint8_t* rgba)
+{
+  rgba[0] = (uint8_t)lround(255 * std::min(1.0, 0.35 + v * 2));
+  rgba[1] = (uint8_t)lround(255 * std::max(0.0, std::min(1.0, v * 2 - 0.6)));
+  rgba[2] = (uint8_t)lround(255 * std::max(0.0, v * 3 - 2));
+  rgba[3] = (uint8_t)lround(255 * std::min(1.0, 0.4 + v));
+}
+
+static std::string tilePng(const Tile& t, uint32_t peak, const std::vector<uint8_t>& lut)
+{
+  std::vector<uint8_t> raw(HEAT_TILE * (1 + 4 * HEAT_TILE));
+  uint8_t* p = raw.data();
+  double scale = 255.0 / log1p((double)peak);
+  for (int y = 0; y < HEAT_TILE; y++)
+  {
+    *p++ = 0; // no filter
+    for (int x = 0; x < HEAT_TILE; x++, p += 4)
+    {
+      uint32_t c = t.c[y * HEAT_TILE + x];
+      if (!c) { memset(p, 0, 4); continue; }
+      int level = (int)(log1p((double)c) * scale);
+      memcpy(p, &lut[4 * std::max(1, std::min(255, level))], 4);
+    }
+  }
+  uLongf zlen = compressBound(raw.size());
+  std::vector<uint8_t> z(zlen);
+  compress2(z.data(), &zlen, raw.data(), raw.size(), 1);
+
+  std::string out("\x89PNG\r\n\x1a\n", 8);
+  uint8_t ihdr[13] = { 0, 0, 1, 0, 0, 0, 1, 0, 8, 6, 0, 0, 0 }; // 256 x 256, 8 bit RGBA
+  pngChunk(out, "IHDR", ihdr, sizeof(ihdr));
+  pngChunk(out, "IDAT", z.data(), (uint32_t)zlen);
+  pngChunk(out, "IEND", NULL, 0);
+  return out;
+}
+
+static bool writeTile(const Heat& h, uint64_t key, const Tile& t, const std::vector<uint8_t>& lut, long* bytes)
+{
+  char dir[256], fn[300];
+  snprintf(dir, sizeof(dir), "%s/%d/%u", h.outdir.c_str(), keyZoom(key), keyX(key));
+  snprintf(fn, sizeof(fn), "%s/%u.%s", dir, keyY(key), h.raw ? "u32" : "png");
+  std::error_code ec;
+  fsys::create_directories(dir, ec);
+  FILE* fp = fopen(fn, "wb");
+  if (!fp) return false;
+  bool ok;
+  if (h.raw)
+  {
+    ok = (fwrite(t.c, sizeof(t.c), 1, fp) == 1);
+    *bytes += sizeof(t.c);
+  }
+  else
+  {
+    std::string png = tilePng(t, h.peak[keyZoom(key)], lut);
+    ok = (fwrite(png.data(), 1, png.size(), fp) == png.size());
+    *bytes += png.size();
+  }
+  return (fclose(fp) == 0) && ok;
+}
+
+//----------------------------------------------------------------------------
+// a run
+//----------------------------------------------------------------------------
+template <typename F> static void onThreads(int threads, F fn)
+{
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; i++) pool.emplace_back(fn, i);
+  for (auto& t : pool) t.join();
+}
+
+static bool heatmap(Heat& h, int threads)
+{
+  std::vector<Canvas> canvas(threads);
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::atomic<size_t> next{0};
+  onThreads(threads, [&](int w) {
+    for (size_t i; (i = next++) < h.in.size();) drawFile(h, canvas[w], h.in[i]);
+  });
+  h.drawSec = secondsSince(t0);
+
+  // every z/x/y with the threads' tiles of it, the first one to add the rest into
+  t0 = std::chrono::steady_clock::now();
+  std::map<uint64_t, std::vector<Tile*>> all;
+  h.pixels = h.lines = h.fixes = h.segsRead = h.segsSkipped = 0;
+  for (auto& cv : canvas)
+  {
+    for (auto& t : cv.tiles) all[t.first].push_back(t.second.get());
+    h.pixels += cv.pixels; h.lines += cv.lines; h.fixes += cv.fixes;
+    h.segsRead += cv.segsRead; h.segsSkipped += cv.segsSkipped;
+  }
+  std::vector<std::pair<uint64_t, std::vector<Tile*>*>> work;
+  for (auto& a : all) work.push_back({ a.first, &a.second });
+  std::vector<std::vector<uint32_t>> peaks(threads, std::vector<uint32_t>(HEAT_MAXZOOM + 1, 0));
+  std::vector<uint64_t> hashes(threads, 0);
+  next = 0;
+  onThreads(threads, [&](int w) {
+    for (size_t i; (i = next++) < work.size();)
+    {
+      std::vector<Tile*>& v = *work[i].second;
+      uint32_t* sum = v[0]->c;
+      for (size_t k = 1; k < v.size(); k++)
+        for (int j = 0; j < HEAT_TILE * HEAT_TILE; j++) sum[j] += v[k]->c[j];
+      uint32_t peak = 0;
+      uint64_t hash = work[i].first * 0x9E3779B97F4A7C15ULL;
+      for (int j = 0; j < HEAT_TILE * HEAT_TILE; j++)
+      {
+        peak = std::max(peak, sum[j]);
+        hash = (hash ^ sum[j]) * 0x100000001B3ULL;
+      }
+      uint32_t& zp = peaks[w][keyZoom(work[i].first)];
+      zp = std::max(zp, peak);
+      hashes[w] += hash;
+    }
+  });
+  h.merged.clear();
+  for (auto& a : work) h.merged.push_back({ a.first, (*a.second)[0] });
+  memset(h.peak, 0, sizeof(h.peak));
+  h.hash = 0;
+  for (int w = 0; w < threads; w++)
+  {
+    for (int z = 0; z <= HEAT_MAXZOOM; z++) h.peak[z] = std::max(h.peak[z], peaks[w][z]);
+    h.hash += hashes[w];
+  }
+  h.mergeSec = secondsSince(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  std::vector<uint8_t> lut(4 * 256);
+  for (int i = 0; i < 256; i++) ramp(i / 255.0, &lut[4 * i]);
+  std::atomic<long> failed{0}, bytes{0};
+  next = 0;
+  onThreads(threads, [&](int w) {
+    long b = 0;
+    for (size_t i; (i = next++) < h.merged.size();)
+      if (!writeTile(h, h.merged[i].first, *h.merged[i].second, lut, &b)) failed++;
+    bytes += b;
+  });
+  h.written = (long)h.merged.size();
+  h.bytes = bytes;
+  h.writeSec = secondsSince(t0);
+  return failed == 0;
+}
+
+static std::vector<int> parseZooms(const char* s)
+{
+  std::vector<int> z;
+  std::stringstream ss(s);
+  std::string part;
+  while (std::getline(ss, part, ','))
+  {
+    int a = 0, b = 0;
+    int n = sscanf(part.c_str(), "%d-%d", &a, &b);
+    if (n == 1) b = a;
+    for (int i = a; (n >= 1) && (i <= b); i++)
+      if ((i >= 0) && (i <= HEAT_MAXZOOM)) z.push_back(i);
+  }
+  return z;
+}
+
+int main(int argc, char** argv)
+{
+  Heat h;
+  std::string root;
+  std::set<std::string> only;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  int loggers = 2500;
+  bool scale = false;
+  h.zooms = parseZooms("8-12");
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) h.outdir = argv[++i];
+    else if ((strcmp(argv[i], "-z") == 0) && (i + 1 < argc)) h.zooms = parseZooms(argv[++i]);
+    else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) threads = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-from") == 0) && (i + 1 < argc)) h.from = (int32_t)(atol(argv[++i]) - SEG_EPOCH);
+    else if ((strcmp(argv[i], "-to") == 0) && (i + 1 < argc)) h.to = (int32_t)(atol(argv[++i]) - SEG_EPOCH);
+    else if ((strcmp(argv[i], "-bbox") == 0) && (i + 1 < argc))
+    {
+      double a, b, c, d;
+      if (sscanf(argv[++i], "%lf,%lf,%lf,%lf", &a, &b, &c, &d) == 4)
+      {
+        h.lat0 = (int32_t)lround(std::min(a, c) * 1e6); h.lat1 = (int32_t)lround(std::max(a, c) * 1e6);
+        h.lon0 = (int32_t)lround(std::min(b, d) * 1e6); h.lon1 = (int32_t)lround(std::max(b, d) * 1e6);
+      }
+    }
+    else if ((strcmp(argv[i], "-logger") == 0) && (i + 1 < argc))
+    {
+      std::stringstream ss(argv[++i]);
+      std::string name;
+      while (std::getline(ss, name, ',')) only.insert(name);
+    }
+    else if ((strcmp(argv[i], "-loggers") == 0) && (i + 1 < argc)) loggers = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-raw") == 0) h.raw = true;
+    else if (strcmp(argv[i], "-scale") == 0) scale = true;
+    else root = argv[i];
+  }
+  if (h.zooms.empty()) { printf("no zoom levels in -z\n"); return 1; }
+
+  if (root.empty())
+  {
+    root = (fsys::temp_directory_path() / "trackmerge-in").string();
+    if (!fsys::exists(root))
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      segFleetGenerate(root, loggers, 15);
+      printf("generated %d loggers x %d uploads into %s in %.1f s\n", loggers, SEGFLEET_UPLOADS, root.c_str(), secondsSince(t0));
+    }
+    scale = true;
+  }
+  if (h.outdir.empty()) h.outdir = (fsys::temp_directory_path() / "heatmap-tiles").string();
+
+  std::vector<SegFile> files;
+  segFilesFind(root, files, h.loggers);
+  long dropped = 0, bad = 0;
+  size_t segs = 0;
+  for (auto& f : files)
+  {
+    if (!only.empty() && !only.count(h.loggers[f.logger])) { dropped++; continue; }
+    if (!segFileMap(f)) bad++;
+    segs += f.segs.size();
+    h.in.push_back(f);
+  }
+  if (h.in.empty()) { printf("no .seg files under %s\n", root.c_str()); return 1; }
+  printf("%zu files (%ld left out by -logger, %ld unreadable), %zu segments, zoom", h.in.size(), dropped, bad, segs);
+  for (int z : h.zooms) printf(" %d", z);
+  printf(", %s tiles into %s (%u cores here)\n", h.raw ? "raw" : "PNG", h.outdir.c_str(), std::thread::hardware_concurrency());
+
+  for (int z : h.zooms) fsys::remove_all(h.outdir + "/" + std::to_string(z));
+  std::vector<int> counts;
+  if (scale) for (int t = 1; t < threads; t *= 2) counts.push_back(t);
+  counts.push_back(threads);
+  uint64_t hash = 0;
+  bool same = true;
+  double base = 0;
+  printf("\n%8s %9s %9s %9s %9s %10s %8s\n", "threads", "draw s", "merge s", "write s", "total s", "tiles/s", "speedup");
+  for (int t : counts)
+  {
+    if (!heatmap(h, t)) { printf("writing tiles failed\n"); return 1; }
+    double total = h.drawSec + h.mergeSec + h.writeSec;
+    if (t == counts[0]) { hash = h.hash; base = total; }
+    same &= (h.hash == hash);
+    printf("%8d %9.2f %9.2f %9.2f %9.2f %10.0f %7.2fx\n", t, h.drawSec, h.mergeSec, h.writeSec, total,
+           h.written / total, base / total);
+  }
+  printf("\n%ld fixes, %ld lines, %.1f M pixels drawn;  %ld segments decoded, %ld passed over on their headers\n",
+         h.fixes, h.lines, h.pixels / 1e6, h.segsRead, h.segsSkipped);
+  printf("%ld tiles, %.1f MB;  busiest pixel", h.written, h.bytes / 1e6);
+  for (int z : h.zooms) printf(" z%d %u", z, h.peak[z]);
+  printf("\n");
+  if (counts.size() > 1) printf("check: %s\n", same ? "every thread count gave the same tiles" : "TILES DIFFER between thread counts");
+  for (auto& f : h.in) segFileUnmap(f);
+  return same ? 0 : 1;
+}
@@ -0,0 +1,660 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Server side ingest of the uploaded logs - every gpslog_*.log of every
+// logger into one time sorted track per logger
+//----------------------------------------------------------------------------
+// ftpPut() sends the whole of location.log each time, as
+// gpslog_YYYYMMDD-HHMMSS.log into the logger's own FTPFOLDER, so the
+// server side ends up with
+//   <root>/<logger>/gpslog_*.log      thousands of them, each repeating
+//                                     most of the one before
+// This reads the lot in parallel:
+//   map         each file mmap'ed read-only, files over INGEST_CHUNK split
+//               at line ends into chunks
+//   parse       the RMC lines - checksum, then the fields in one pass
+//               straight off the mapping, no copies, \r\n or \n
+//   merge       per logger, sorted by time, one fix per second kept (the
+//               overlapping uploads are the same lines again)
+//   write       <out>/<logger>.seg, the column segments of
+//               TrackSegmentService.h (SegHeader, zigzag varint deltas),
+//               so the readers of /track.seg read these too
+// on a pool of worker threads, each with its own deque of tasks: a worker
+// takes from the back of its own, splits a big file into chunks onto it,
+// and when it runs dry steals from the front of the others'.
+//
+// Run on a folder of uploads it ingests it once and reports; without one
+// it makes its own (UploadFleet.h, -devices loggers for -days days), then
+// ingests it with 1, 2, 4 ... -t threads, each the best of 3 with the
+// files in the page cache, in GB/s of log read, and checks every track
+// against rmcParse() (NmeaService.h) line by line with a std::map.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -pthread -o host/ingest host/ingest.cpp
+//   host/ingest [root] [-o outdir] [-t threads] [-devices n] [-days n] [-check]
+//
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "UploadFleet.h"
+
+namespace fsys = std::filesystem;
+
+#define INGEST_CHUNK (1L << 20)      /* files bigger than this are parsed in pieces */
+
+struct Fix { int32_t t, lat, lon, speed; };
+
+static bool fixLess(const Fix& a, const Fix& b)
+{
+  if (a.t != b.t) return a.t < b.t;
+  if (a.lat != b.lat) return a.lat < b.lat;
+  if (a.lon != b.lon) return a.lon < b.lon;
+  return a.speed < b.speed;
+}
+
+//----------------------------------------------------------------------------
+// work stealing pool
+//----------------------------------------------------------------------------
+typedef std::function<void(int)> Task; // gets the worker running it
+
+class StealPool
+{
+public:
+  StealPool(int n) : queues(n) {}
+  int size() { return (int)queues.size(); }
+
+  // before run() round robin, from inside a task onto the worker's own deque
+  void push(int worker, Task t)
+  {
+    pending++;
+    std::lock_guard<std::mutex> lock(queues[worker].m);
+    queues[worker].q.push_back(std::move(t));
+  }
+
+  void run()
+  {
+    steals = 0;
+    std::vector<std::thread> threads;
+    for (int w = 1; w < size(); w++) threads.emplace_back([this, w] { work(w); });
+    work(0);
+    for (std::thread& t : threads) t.join();
+  }
+
+  std::atomic<long> steals{0};
+
+private:
+  struct Queue { std::mutex m; std::deque<Task> q; };
+  std::vector<Queue> queues;
+  std::atomic<long> pending{0};
+
+  bool take(int w, Task& t)
+  {
+    {
+      std::lock_guard<std::mutex> lock(queues[w].m);
+      if (!queues[w].q.empty())
+      {
+        t = std::move(queues[w].q.back());
+        queues[w].q.pop_back();
+        return true;
+      }
+    }
+    for (int i = 1; i < size(); i++)
+    {
+      Queue& v = queues[(w + i) % size()];
+      std::lock_guard<std::mutex> lock(v.m);
+      if (!v.q.empty())
+      {
+        t = std::move(v.q.front());
+        v.q.pop_front();
+        steals++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(int w)
+  {
+    Task t;
+    while (pending > 0)
+    {
+      if (take(w, t))
+      {
+        t(w);
+        t = nullptr;
+        pending--;
+      }
+      else std::this_thread::yield(); // the last tasks are running, one may still split
+    }
+  }
+};
+
+//----------------------------------------------------------------------------
+// the parser
+//----------------------------------------------------------------------------
+static inline int hexVal(char c)
+{
+  if ((c >= '0') && (c <= '9')) return c - '0';
+  if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+  return -1;
+}
+
+// digits up to the next , or *, as an integer with exactly 'decimals'
+// places (more are dropped, fewer padded);  false if there's anything else
+static inline bool fixedField(const char*& p, const char* end, int decimals, int64_t* v)
+{
+  const char* start = p;
+  int64_t n = 0;
+  unsigned d;
+  while ((p < end) && ((d = (unsigned)(*p - '0')) <= 9)) { n = n * 10 + d; p++; }
+  bool any = (p > start);
+  int places = 0;
+  if ((p < end) && (*p == '.'))
+  {
+    p++;
+    for (; (p < end) && ((d = (unsigned)(*p - '0')) <= 9); p++)
+    {
+      if (places < decimals) { n = n * 10 + d; places++; }
+      any = true;
+    }
+  }
+  if ((p < end) && (*p != ',') && (*p != '*')) return false;
+  for (; places < decimals; places++) n *= 10;
+  *v = n;
+  return any;
+}
+
+// the NMEA checksum, a word at a time
+static inline uint8_t xorSum(const char* p, const char* end)
+{
+  uint64_t w = 0, x;
+  for (; p + 8 <= end; p += 8) { memcpy(&x, p, 8); w ^= x; }
+  w ^= w >> 32;
+  w ^= w >> 16;
+  w ^= w >> 8;
+  uint8_t sum = (uint8_t)w;
+  for (; p < end; p++) sum ^= (uint8_t)*p;
+  return sum;
+}
+
+static inline bool comma(const char*& p, const char* end)
+{
+  if ((p >= end) || (*p != ',')) return false;
+  p++;
+  return true;
+}
+
+// ddmm.mmmm to degrees x 1e6, rounded
+static inline int32_t microDegrees(int64_t dmE6)
+{
+  int64_t deg = dmE6 / 100000000LL;
+  int64_t minE6 = dmE6 - deg * 100000000LL;
+  return (int32_t)(deg * 1000000LL + (minE6 + 30) / 60);
+}
+
+// one line (no line end) - a valid RMC with a date gives a Fix;  day[]
+// keeps the last date seen and its start, a log is day after day of the same
+static bool parseRmc(const char* p, const char* end, Fix* f, int64_t day[2])
+{
+  if ((end - p < 20) || (p[0] != '$') || (p[3] != 'R') || (p[4] != 'M') || (p[5] != 'C') || (p[6] != ','))
+    return false;
+  const char* star = end - 3;
+  if ((star[0] != '*')) return false;
+  uint8_t sum = xorSum(p + 1, star);
+  int hi = hexVal(star[1]), lo = hexVal(star[2]);
+  if ((hi < 0) || (lo < 0) || (sum != ((hi << 4) | lo))) return false;
+
+  const char* q = p + 7;
+  if ((star - q < 7) || (q[6] != '.' && q[6] != ',')) return false;
+  for (int i = 0; i < 6; i++) if ((q[i] < '0') || (q[i] > '9')) return false;
+  int32_t daySec = ((q[0]-'0')*10 + (q[1]-'0')) * 3600 + ((q[2]-'0')*10 + (q[3]-'0')) * 60 + (q[4]-'0')*10 + (q[5]-'0');
+  while ((q < star) && (*q != ',')) q++;
+  if (!comma(q, star) || (q >= star) || (*q != 'A')) return false;
+  q++;
+
+  int64_t v;
+  if (!comma(q, star) || !fixedField(q, star, 6, &v) || !comma(q, star)) return false;
+  f->lat = microDegrees(v);
+  if ((q < star) && (*q == 'S')) f->lat = -f->lat;
+  while ((q < star) && (*q != ',')) q++;
+  if (!comma(q, star) || !fixedField(q, star, 6, &v) || !comma(q, star)) return false;
+  f->lon = microDegrees(v);
+  if ((q < star) && (*q == 'W')) f->lon = -f->lon;
+  while ((q < star) && (*q != ',')) q++;
+  if (!comma(q, star)) return false;
+  if (!fixedField(q, star, 3, &v)) v = 0;
+  f->speed = (int32_t)((v + 5) / 10);
+  if (!comma(q, star)) return false;
+  while ((q < star) && (*q != ',')) q++; // course
+  if (!comma(q, star) || (star - q < 6)) return false;
+  for (int i = 0; i < 6; i++) if ((q[i] < '0') || (q[i] > '9')) return false;
+  if ((q + 6 < star) && (q[6] != ',')) return false;
+
+  int64_t date = 0;
+  memcpy(&date, q, 6);
+  if (date != day[0])
+  {
+    GpsFix g;
+    memset(&g, 0, sizeof(g));
+    g.day = (q[0]-'0')*10 + (q[1]-'0');
+    g.month = (q[2]-'0')*10 + (q[3]-'0');
+    g.year = 2000 + (q[4]-'0')*10 + (q[5]-'0');
+    day[0] = date;
+    day[1] = (int32_t)(fixEpoch(&g) - SEG_EPOCH);
+  }
+  f->t = day[1] + daySec;
+  return true;
+}
+
+// every line of [p, end) that starts in it;  chunks start just after a \n
+template <typename F> static void parseLines(const char* p, const char* end, F fn)
+{
+  int64_t day[2] = { -1, 0 };
+  while (p < end)
+  {
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    const char* next = eol ? eol + 1 : end;
+    if (!eol) eol = end;
+    const char* e = eol;
+    if ((e > p) && (e[-1] == '\r')) e--;
+    Fix f;
+    if (parseRmc(p, e, &f, day)) fn(f);
+    p = next;
+  }
+}
+
+//----------------------------------------------------------------------------
+// the ingest
+//----------------------------------------------------------------------------
+struct Upload { std::string path; int device; size_t size; };
+
+struct Mapped
+{
+  const char* p = NULL;
+  size_t len = 0;
+  ~Mapped() { if (p) munmap((void*)p, len); }
+};
+
+struct Ingest
+{
+  std::vector<std::string> devices;
+  std::vector<Upload> uploads;
+  size_t bytes = 0;
+  // per run
+  std::vector<std::vector<std::vector<Fix>>> found;  // [worker][device]
+  std::vector<size_t> kept, segs, outBytes;          // [device]
+  std::atomic<long> lines{0}, chunks{0}, failed{0};
+  double parseSec = 0, mergeSec = 0;
+  long steals = 0;
+};
+
+static void findUploads(Ingest& in, const std::string& root)
+{
+  std::map<std::string, int> ids;
+  for (const fsys::directory_entry& e : fsys::recursive_directory_iterator(root))
+  {
+    std::string fn = e.path().filename().string();
+    if (!e.is_regular_file() || (fn.compare(0, 7, "gpslog_") != 0) || (fn.size() < 11) ||
+        (fn.compare(fn.size() - 4, 4, ".log") != 0)) continue;
+    std::string dev = e.path().parent_path().filename().string();
+    if (ids.find(dev) == ids.end())
+    {
+      ids[dev] = (int)in.devices.size();
+      in.devices.push_back(dev);
+    }
+    in.uploads.push_back({ e.path().string(), ids[dev], (size_t)e.file_size() });
+    in.bytes += e.file_size();
+  }
+}
+
+static void parseChunk(Ingest& in, int w, int dev, std::shared_ptr<Mapped> m, size_t begin, size_t end)
+{
+  std::vector<Fix>& out = in.found[w][dev];
+  long n = 0;
+  parseLines(m->p + begin, m->p + end, [&](const Fix& f) { out.push_back(f); n++; });
+  in.lines += n;
+  in.chunks++;
+}
+
+static void mapUpload(Ingest& in, StealPool& pool, int w, const Upload& u)
+{
+  auto m = std::make_shared<Mapped>();
+  int fd = open(u.path.c_str(), O_RDONLY);
+  if (fd < 0) { in.failed++; return; }
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || (st.st_size == 0)) { close(fd); return; }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) { in.failed++; return; }
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+  m->p = (const char*)p;
+  m->len = st.st_size;
+
+  // the tail pieces go on this worker's deque for whoever gets there first
+  size_t first = m->len;
+  if (m->len > INGEST_CHUNK)
+  {
+    std::vector<size_t> cuts;
+    for (size_t at = INGEST_CHUNK; at < m->len; at += INGEST_CHUNK)
+    {
+      const char* nl = (const char*)memchr(m->p + at, '\n', m->len - at);
+      if (!nl) break;
+      size_t cut = nl - m->p + 1;
+      if (cut >= m->len) break;
+      if (cuts.empty() || (cut > cuts.back())) cuts.push_back(cut);
+      at = cut;
+    }
+    if (!cuts.empty()) first = cuts[0];
+    for (size_t i = 0; i < cuts.size(); i++)
+    {
+      size_t b = cuts[i], e = (i + 1 < cuts.size()) ? cuts[i + 1] : m->len;
+      int dev = u.device;
+      pool.push(w, [&in, m, dev, b, e](int w2) { parseChunk(in, w2, dev, m, b, e); });
+    }
+  }
+  parseChunk(in, w, u.device, m, 0, first);
+}
+
+// stable LSD radix sort on the time, a byte a pass (the passes where all
+// the fixes have the same byte skipped) - the same fix comes in once per
+// upload, so there are a lot of them
+static void sortByTime(std::vector<Fix>& v)
+{
+  std::vector<Fix> tmp(v.size());
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    size_t count[257] = { 0 };
+    for (const Fix& f : v) count[((((uint32_t)f.t ^ 0x80000000u) >> shift) & 0xff) + 1]++;
+    if (count[((((uint32_t)v[0].t ^ 0x80000000u) >> shift) & 0xff) + 1] == v.size()) continue;
+    for (int i = 1; i <= 256; i++) count[i] += count[i - 1];
+    for (const Fix& f : v) tmp[count[(((uint32_t)f.t ^ 0x80000000u) >> shift) & 0xff]++] = f;
+    v.swap(tmp);
+  }
+}
+
+// sort, one fix a second, into segments
+static void mergeDevice(Ingest& in, int dev, const std::string& outdir)
+{
+  std::vector<Fix> all;
+  size_t n = 0;
+  for (auto& w : in.found) n += w[dev].size();
+  all.reserve(n);
+  for (auto& w : in.found)
+  {
+    all.insert(all.end(), w[dev].begin(), w[dev].end());
+    std::vector<Fix>().swap(w[dev]);
+  }
+  if (!all.empty()) sortByTime(all);
+  // the same second twice should be the same fix, if not keep the lowest
+  size_t kept = 0;
+  for (size_t i = 0; i < all.size(); i++)
+  {
+    if ((kept > 0) && (all[kept - 1].t == all[i].t))
+    {
+      if (fixLess(all[i], all[kept - 1])) all[kept - 1] = all[i];
+    }
+    else all[kept++] = all[i];
+  }
+  all.resize(kept);
+  in.kept[dev] = all.size();
+
+  std::vector<uint8_t> out;
+  out.reserve(all.size() * 8 + 64);
+  uint8_t col[SEG_COLS][SEG_MAXFIXES * SEG_VARINTMAX];
+  for (size_t at = 0; at < all.size(); at += SEG_MAXFIXES)
+  {
+    int count = (int)std::min((size_t)SEG_MAXFIXES, all.size() - at);
+    const Fix* f = &all[at];
+    SegHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SEG_MAGIC;
+    h.count = count;
+    for (int c = 0; c < SEG_COLS; c++)
+    {
+      auto val = [&](int i) { const int32_t* v = &f[i].t; return v[c]; };
+      h.minv[c] = h.maxv[c] = h.first[c] = val(0);
+      int bytes = 0;
+      for (int i = 1; i < count; i++)
+      {
+        int32_t v = val(i);
+        if (v < h.minv[c]) h.minv[c] = v;
+        if (v > h.maxv[c]) h.maxv[c] = v;
+        bytes += segPut(col[c] + bytes, v - val(i - 1));
+      }
+      h.bytes[c] = bytes;
+    }
+    out.insert(out.end(), (uint8_t*)&h, (uint8_t*)&h + sizeof(h));
+    for (int c = 0; c < SEG_COLS; c++) out.insert(out.end(), col[c], col[c] + h.bytes[c]);
+    in.segs[dev]++;
+  }
+  in.outBytes[dev] = out.size();
+  std::string fn = outdir + "/" + in.devices[dev] + ".seg";
+  FILE* fp = fopen(fn.c_str(), "wb");
+  if (!fp || (fwrite(out.data(), 1, out.size(), fp) != out.size())) in.failed++;
+  if (fp) fclose(fp);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void ingest(Ingest& in, int threads, const std::string& outdir)
+{
+  int nd = (int)in.devices.size();
+  in.found.assign(threads, std::vector<std::vector<Fix>>(nd));
+  in.kept.assign(nd, 0);
+  in.segs.assign(nd, 0);
+  in.outBytes.assign(nd, 0);
+  in.lines = in.chunks = in.failed = 0;
+
+  StealPool pool(threads);
+  // biggest first, dealt round robin - the deques start about even and
+  // the stealing evens out the rest
+  std::vector<int> order(in.uploads.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+  std::sort(order.begin(), order.end(), [&](int a, int b) { return in.uploads[a].size > in.uploads[b].size; });
+  // owners pop from the back, so the small ones go in first
+  for (size_t i = order.size(); i-- > 0; )
+  {
+    const Upload* u = &in.uploads[order[i]];
+    pool.push((int)(i % threads), [&in, &pool, u](int w) { mapUpload(in, pool, w, *u); });
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  pool.run();
+  in.parseSec = secondsSince(t0);
+  in.steals = pool.steals;
+
+  auto t1 = std::chrono::steady_clock::now();
+  for (int d = 0; d < nd; d++) pool.push(d % threads, [&in, d, &outdir](int) { mergeDevice(in, d, outdir); });
+  pool.run();
+  in.mergeSec = secondsSince(t1);
+  in.steals += pool.steals;
+}
+
+//----------------------------------------------------------------------------
+// the check - rmcParse() on every line, a std::map per logger
+//----------------------------------------------------------------------------
+static std::map<int32_t, Fix> reference(const Ingest& in, int dev)
+{
+  std::map<int32_t, Fix> track;
+  char line[256];
+  for (const Upload& u : in.uploads)
+  {
+    if (u.device != dev) continue;
+    FILE* fp = fopen(u.path.c_str(), "rb");
+    if (!fp) continue;
+    while (fgets(line, sizeof(line), fp))
+    {
+      line[strcspn(line, "\r\n")] = 0;
+      GpsFix fix;
+      if (!rmcParse(line, &fix) || !fix.valid || (fix.year == 0)) continue;
+      Fix f = { (int32_t)(fixEpoch(&fix) - SEG_EPOCH), (int32_t)lround(fix.lat * 1e6), (int32_t)lround(fix.lon * 1e6),
+                (int32_t)lround(fix.speedKts * 100) };
+      auto it = track.find(f.t);
+      if ((it == track.end()) || fixLess(f, it->second)) track[f.t] = f;
+    }
+    fclose(fp);
+  }
+  return track;
+}
+
+// the .seg file back, column by column
+static std::vector<Fix> readSegments(const std::string& fn, long* segments)
+{
+  std::vector<Fix> fixes;
+  std::vector<uint8_t> data;
+  FILE* fp = fopen(fn.c_str(), "rb");
+  if (!fp) return fixes;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(fp);
+  size_t at = 0;
+  *segments = 0;
+  while (at + sizeof(SegHeader) <= data.size())
+  {
+    SegHeader h;
+    memcpy(&h, &data[at], sizeof(h));
+    if ((h.magic != SEG_MAGIC) || (h.count == 0) || (h.count > SEG_MAXFIXES)) break;
+    at += sizeof(h);
+    int32_t cols[SEG_COLS][SEG_MAXFIXES];
+    for (int c = 0; c < SEG_COLS; c++)
+    {
+      segDecode(&data[at], h.bytes[c], h.first[c], h.count, cols[c]);
+      at += h.bytes[c];
+    }
+    for (int i = 0; i < h.count; i++)
+      fixes.push_back({ cols[SEG_TIME][i], cols[SEG_LAT][i], cols[SEG_LON][i], cols[SEG_SPEED][i] });
+    (*segments)++;
+  }
+  return fixes;
+}
+
+// times and counts exactly, the fields within the last digit's rounding
+static bool check(const Ingest& in, const std::string& outdir)
+{
+  bool ok = true;
+  long fixes = 0, segments = 0;
+  for (int d = 0; d < (int)in.devices.size(); d++)
+  {
+    std::map<int32_t, Fix> ref = reference(in, d);
+    long segs = 0;
+    std::vector<Fix> got = readSegments(outdir + "/" + in.devices[d] + ".seg", &segs);
+    bool same = (got.size() == ref.size());
+    size_t i = 0;
+    for (auto it = ref.begin(); same && (it != ref.end()); it++, i++)
+    {
+      const Fix& a = it->second;
+      const Fix& b = got[i];
+      same = (a.t == b.t) && (abs(a.lat - b.lat) <= 1) && (abs(a.lon - b.lon) <= 1) && (abs(a.speed - b.speed) <= 1);
+    }
+    if (!same)
+    {
+      printf("  %s: %zu fixes, rmcParse() reference has %zu - MISMATCH at %zu\n",
+             in.devices[d].c_str(), got.size(), ref.size(), i);
+      ok = false;
+    }
+    fixes += got.size();
+    segments += segs;
+  }
+  printf("check: %zu loggers, %ld fixes in %ld segments - %s the rmcParse() reference\n",
+         in.devices.size(), fixes, segments, ok ? "same as" : "NOT the same as");
+  return ok;
+}
+
+//----------------------------------------------------------------------------
+static void report(const Ingest& in, int threads)
+{
+  double sec = in.parseSec + in.mergeSec;
+  printf("%3d threads  %7.1f ms  %6.2f GB/s   map+parse %7.1f ms (%5.2f GB/s)  merge+write %6.1f ms  %ld chunks %ld steals\n",
+         threads, sec * 1e3, in.bytes / sec / 1e9, in.parseSec * 1e3, in.bytes / in.parseSec / 1e9,
+         in.mergeSec * 1e3, (long)in.chunks, in.steals);
+}
+
+int main(int argc, char** argv)
+{
+  std::string root, outdir;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  int devices = 40, days = 3;
+  bool checkIt = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) outdir = argv[++i];
+    else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) threads = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-devices") == 0) && (i + 1 < argc)) devices = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-days") == 0) && (i + 1 < argc)) days = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-check") == 0) checkIt = true;
+    else root = argv[i];
+  }
+
+  bool built = root.empty();
+  if (built)
+  {
+    root = (fsys::temp_directory_path() / "ingest-uploads").string();
+    fsys::remove_all(root);
+    printf("generating %d loggers x %d days into %s\n", devices, days, root.c_str());
+    fleetGenerate(root, devices, days);
+    checkIt = true;
+  }
+  if (outdir.empty()) outdir = (fsys::temp_directory_path() / "ingest-tracks").string();
+  fsys::create_directories(outdir);
+
+  Ingest in;
+  findUploads(in, root);
+  if (in.uploads.empty()) { printf("no gpslog_*.log under %s\n", root.c_str()); return 1; }
+  printf("%zu uploads from %zu loggers, %.1f MB, into %s (%u cores here)\n",
+         in.uploads.size(), in.devices.size(), in.bytes / 1e6, outdir.c_str(), std::thread::hardware_concurrency());
+
+  std::vector<int> counts;
+  if (built) for (int t = 1; t < threads; t *= 2) counts.push_back(t);
+  counts.push_back(threads);
+  for (int t : counts)
+  {
+    Ingest best;
+    for (int rep = 0; rep < (built ? 3 : 1); rep++)
+    {
+      ingest(in, t, outdir);
+      if ((rep == 0) || (in.parseSec + in.mergeSec < best.parseSec + best.mergeSec))
+      {
+        best.parseSec = in.parseSec;
+        best.mergeSec = in.mergeSec;
+        best.steals = in.steals;
+        best.chunks = (long)in.chunks;
+      }
+    }
+    in.parseSec = best.parseSec;
+    in.mergeSec = best.mergeSec;
+    in.steals = best.steals;
+    in.chunks = (long)best.chunks;
+    report(in, t);
+  }
+
+  size_t fixes = 0, segs = 0, out = 0;
+  long lines = in.lines;
+  for (size_t d = 0; d < in.devices.size(); d++) { fixes += in.kept[d]; segs += in.segs[d]; out += in.outBytes[d]; }
+  printf("%ld fixes read, %zu kept after the overlaps (%.1fx), %zu segments, %.1f MB written (%.2f bytes a fix)\n",
+         lines, fixes, fixes ? (double)lines / fixes : 0.0, segs, out / 1e6, fixes ? (double)out / fixes : 0.0);
+  if (in.failed) printf("%ld files could not be read or written\n", (long)in.failed);
+  if (checkIt && !check(in, outdir)) return 1;
+  return 0;
+}
@@ -0,0 +1,140 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Location log buffer (GpsLogService.h) - DRAM vs PSRAM, with the log file
+// failing to open
+//----------------------------------------------------------------------------
+// Two days of once-a-minute RMC lines through gpsLogLine(), with the hourly
+// gpsLogHour(), gpsLogService() on every pass of loop() and an upload's
+// gpsLogFlush() once a day, as the sketch does.  Built with
+// BOARD_HAS_PSRAM against a stand-in ESP.getPsramSize() / ps_malloc(), so
+// the same build runs the 8 KB logbuffer (no PSRAM) and the LOGPSRAMSIZE
+// buffer written in batches.
+//
+// Per scenario the log file can't be opened for a while (SPIFFS.failWrites,
+// flash full, say).  Reported:  flushes (file appends) vs the 8 KB buffer
+// flushed hourly, bytes lost;  checked:  what reached location.log is the
+// lines in order, none twice, and every byte not there is counted in
+// logLostBytes - none at all while the buffer could hold the outage.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wall -Wno-write-strings -o host/logbufsim host/logbufsim.cpp
+//   host/logbufsim
+//
+#include "HostArduino.h"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+#define LOGFN "/location.log"
+#define BOARD_HAS_PSRAM 1
+
+static uint32_t hostPsramSize = 0;
+struct HostEsp
+{
+  uint32_t getPsramSize() { return hostPsramSize; }
+} ESP;
+void* ps_malloc(size_t n) { return malloc(n); }
+
+#include "../GpsLogService.h"
+
+#define SIM_MINUTES (2*24*60)
+#define SIM_PASSES (20)       /* loop() passes a minute, each a gpsLogService() */
+#define SIM_UPLOADHOUR (20)   /* the daily upload flushes everything */
+
+struct Scenario
+{
+  const char* name;
+  uint32_t psram;
+  int failFromMin, failMin;   // log file won't open from then, for so long
+  int mayLose;                // the outage is longer than the buffer holds
+};
+
+static const Scenario scenarios[] = {
+  { "DRAM",                        0,    0,       0, false },
+  { "DRAM, 1 h outage",            0,  600,      60, false },
+  { "DRAM, 5 h outage",            0,  600,   5*60, true },
+  { "PSRAM",                 4 << 20,    0,       0, false },
+  { "PSRAM, outage at a batch", 4 << 20, 6*60-5, 90, false },
+  { "PSRAM, 12 h outage",    4 << 20,  600,   12*60, false },
+  { "PSRAM, 2 day outage",   4 << 20,   30, SIM_MINUTES, false },
+};
+
+static void reset(const Scenario& sc)
+{
+  if (logBuf != logbuffer) free(logBuf);
+  logBuf = logbuffer;
+  logBufSize = LOGBUFFERSIZE;
+  logDraining = false;
+  logHoursHeld = 0;
+  logFlushes = logFlushBytes = logBaseFlushes = logLostBytes = 0;
+  logBaseFill = 0;
+  fileSystem.format();
+  fileSystem.failWrites = false;
+  hostPsramSize = sc.psram;
+  gpsLogInit();
+}
+
+static std::string line(int m)
+{
+  char buf[96];
+  snprintf(buf, sizeof(buf), "$GNRMC,%02d%02d00.000,A,4745.%04d,N,12212.5678,W,0.12,0.00,%02d1123,,,A*6F",
+    (m / 60) % 24, m % 60, m % 10000, 15 + m / 1440);
+  return buf;
+}
+
+static int run(const Scenario& sc)
+{
+  reset(sc);
+  std::vector<std::string> sent;
+  size_t sentBytes = 0;
+  for (int m = 0; m < SIM_MINUTES; m++)
+  {
+    fileSystem.failWrites = (m >= sc.failFromMin) && (m < sc.failFromMin + sc.failMin);
+    sent.push_back(line(m));
+    sentBytes += sent.back().size() + 2;
+    gpsLogLine((char*)sent.back().c_str());
+    for (int p = 0; p < SIM_PASSES; p++) gpsLogService();
+    if (m % 60 == 59) gpsLogHour();
+    if (m % 1440 == SIM_UPLOADHOUR * 60) gpsLogFlush();
+  }
+  fileSystem.failWrites = false;
+  gpsLogFlush();
+
+  // what reached the file - in order, none twice, the rest counted lost
+  std::string got;
+  File f = fileSystem.open(LOGFN);
+  if (f)
+  {
+    got.assign(f.size(), 0);
+    f.read((uint8_t*)&got[0], f.size());
+  }
+  size_t at = 0, next = 0, lines = 0;
+  int bad = 0;
+  while (at < got.size())
+  {
+    size_t eol = got.find("\r\n", at);
+    if (eol == std::string::npos) { bad++; break; }
+    std::string l = got.substr(at, eol - at);
+    while ((next < sent.size()) && (sent[next] != l)) next++;
+    if (next == sent.size()) { bad++; break; } // out of order or twice
+    next++;
+    lines++;
+    at = eol + 2;
+  }
+  if (got.size() + logLostBytes != sentBytes) bad++;
+  if (!sc.mayLose && (logLostBytes > 0)) bad++;
+
+  printf("  %-26s %s %3d KB  %4lu flushes (8K hourly %4lu)  %6zu of %zu lines, %6lu bytes lost  %s\n",
+    sc.name, (logBuf == logbuffer) ? "DRAM " : "PSRAM", logBufSize / 1024, logFlushes, logBaseFlushes,
+    lines, sent.size(), logLostBytes, bad ? "FAILED" : "ok");
+  return bad;
+}
+
+int main(int argc, char** argv)
+{
+  printf("%d minutes, log file unopenable for a while per scenario\n", SIM_MINUTES);
+  int bad = 0;
+  for (const Scenario& sc : scenarios) bad += run(sc);
+  printf("%s\n", bad ? "FAILED" : "check: lines in order, none twice, every missing byte counted - OK");
+  return bad ? 1 : 0;
+}
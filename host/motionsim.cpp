@@ -0,0 +1,139 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Motion-adaptive receiver rate/power (MotionService.h) over a day
+//----------------------------------------------------------------------------
+// A simulated receiver (SimReceiver.h) drives a track (a built-in working
+// day, or the RMC lines of a recorded NMEA file) and talks NMEA into the
+// GPS port of the real gpsService() / motionLine() / motionService() on
+// the virtual clock, obeying the commands MotionService.h sends for each
+// GPSTYPE.
+//
+// With no GPSTYPE the receiver stays at its power-on default (1 Hz, GGA
+// GLL GSA GSV x3 RMC VTG), which is what the logger did before.
+//
+// Per receiver type it reports NMEA bytes ingested per day, hours the
+// receiver was awake, sleeps / wakes, and the seconds of driving lost
+// (the vehicle moving while the receiver slept, before a wake noticed).
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/motionsim host/motionsim.cpp
+//   host/motionsim [recorded.log] [-park min] [-wake min] [-v]
+//
+#include "HostArduino.h"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+
+ESP32Time rtc(0);
+
+void logMessage(char* msg) { Serial.println(msg); }
+
+#include "../GpsService.h"
+#include "../NmeaService.h"
+
+// only aidType is wanted from GpsAidService.h
+#define AIDTYPE_NONE  (0)
+#define AIDTYPE_UBX   (1)
+#define AIDTYPE_CASIC (2)
+#define AIDTYPE_PMTK  (3)
+int aidType = AIDTYPE_NONE;
+
+#include "../MotionService.h"
+#include "SimReceiver.h"
+
+//----------------------------------------------------------------------------
+// one receiver type over the whole track
+//----------------------------------------------------------------------------
+static void run(int type, const std::vector<Point>& track, int parkMin, int wakeMin)
+{
+  hostMicros = 0;
+  GPSPORT = HostSerial();
+  GPSPORT.keepTx = true;
+  aidType = type;
+  gpsInit(9600);
+
+  motionState = MOTION_STATIONARY;
+  motionParkMin = parkMin;
+  motionWakeMin = wakeMin;
+  motionApplied = -1;
+  motionStateSec = motionCondSec = 0;
+  motionFixSeen = motionFixValid = false;
+  motionTxLen = motionTxPos = 0;
+  motionWakeAt = 0;
+  memset(motionSec, 0, sizeof(motionSec));
+  memset(motionBytes, 0, sizeof(motionBytes));
+  motionSleeps = motionWakes = motionWokeMoved = 0;
+
+  SimReceiver rx;
+  rx.type = type;
+  rx.powerOn();
+
+  unsigned long lines = 0, driveSec = 0, lostSec = 0, staleSec = 0;
+  uint64_t lastFixUs = 0;
+  for (unsigned long sec = 0; sec < track.size(); sec++)
+  {
+    const Point& p = track[sec];
+    for (int ms = 0; ms < 1000; ms++)
+    {
+      rx.tick(p, sec);
+      while (GPSPORT.available())
+      {
+        char* line = gpsService();
+        if (line == NULL) continue;
+        lines++;
+        motionLine(line);
+        GpsFix fix;
+        if (rmcParse(line, &fix) && fix.valid) lastFixUs = hostMicros;
+      }
+      motionTxService();
+      if (!GPSPORT.txData.empty())
+      {
+        rx.fromLogger(GPSPORT.txData);
+        GPSPORT.txData.clear();
+      }
+      delay(1);
+    }
+    motionService();
+
+    if (p.kts > MOTION_MOVE_KTS)
+    {
+      driveSec++;
+      if (rx.asleep) lostSec++;
+      else if (hostMicros - lastFixUs > 2000000ULL) staleSec++; // waking up, or between slow fixes
+    }
+  }
+
+  double days = track.size() / 86400.0;
+  const char* names[] = { "default", "UBX", "CASIC", "PMTK" };
+  printf("%-8s %10.0f %8.1f %6lu %6lu %7lu %7lu %7lu\n", names[type],
+    rx.bytesOut / days, rx.awakeUs / 3.6e9 / days, rx.sleeps, motionWakes, driveSec, lostSec, staleSec);
+  if (Serial.echo)
+  {
+    for (int s = 0; s < MOTION_STATES; s++)
+      printf("           %-10s %6lus %10lu bytes\n", motionStateName(s), motionSec[s], motionBytes[s]);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* fn = NULL;
+  int parkMin = 10, wakeMin = 5;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else if ((strcmp(argv[i], "-park") == 0) && (i+1 < argc)) parkMin = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-wake") == 0) && (i+1 < argc)) wakeMin = atoi(argv[++i]);
+    else fn = argv[i];
+  }
+  std::vector<Point> track = fn ? readTrack(fn) : makeTrack();
+  if (track.empty()) { fprintf(stderr, "no fixes in %s\n", fn); return 1; }
+  unsigned long moving = 0;
+  for (const Point& p : track) moving += p.kts > MOTION_MOVE_KTS;
+  printf("%s: %.1f hours, %.1f driving, park after %d min, wake every %d min\n",
+    fn ? fn : "working day", track.size() / 3600.0, moving / 3600.0, parkMin, wakeMin);
+  printf("%-8s %10s %8s %6s %6s %7s %7s %7s\n", "receiver", "bytes/day", "awake h", "sleeps", "wakes",
+    "drive s", "lost s", "stale s");
+  for (int type = AIDTYPE_NONE; type <= AIDTYPE_PMTK; type++) run(type, track, parkMin, wakeMin);
+  return 0;
+}
@@ -0,0 +1,356 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// MQTT publisher (MqttService.h) against a broker stand-in over a
+// simulated lossy, dropping link
+//----------------------------------------------------------------------------
+// MqttService.h runs unchanged with wifiService() on the virtual clock of
+// HostArduino.h / HostNet.h, fed one RMC line a second.  The broker
+// (MqttBroker.h) hands every PUBLISH to a subscriber here, which drops
+// duplicates by seq and at the end checks every fix fed in arrived.
+//
+// Scenarios cover a clean link, loss, the AP coming and going, and
+// reboots (the batch being filled is lost, the queue in flash is not -
+// those fixes are counted apart, they are the only loss allowed).
+//
+// The backlog run keeps the link down for BENCH_OFFLINE seconds of
+// fixes - more than MQTT_QUEUEMAX holds, so the oldest batches are
+// dropped and the queue file must stay within the cap (and a batch that
+// arrives while a trim is copying) - then measures how fast the queue
+// drains once it comes up:  messages per virtual second (what the pacing
+// and link allow) and per wall-clock second (the cost of the code itself).
+//
+// Every mqttService() pass is timed on the virtual clock.  One that
+// writes nothing to the broker must not take any time at all - the DNS
+// lookup and TCP connect are polled, not waited for - and a trim must copy
+// no more than MQTT_TRIMSTEP bytes a pass.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/mqttbench host/mqttbench.cpp
+//   host/mqttbench [-v]
+//
+#include <chrono>
+#include <set>
+#include "HostArduino.h"
+#include "HostNet.h"
+#include "MqttBroker.h"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+char wifissid[64] = "SimAP";
+char wifipwd[64] = "SimPassword";
+char batchDeviceId[64] = "gps-sim";
+char mqttServer[128] = "broker.sim";
+uint16_t mqttPort = 1883;
+char mqttTopic[128] = "gpslogger/gps-sim/fixes";
+char mqttUser[64] = "";
+char mqttPwd[64] = "";
+
+void logMessage(char* msg) { Serial.println(msg); }
+
+#include "../FileSystemService.h"
+#include "../SchedulerService.h"
+#include "../WiFiService.h"
+#include "../NmeaService.h"
+#include "../MqttService.h"
+
+#define BENCH_FIXES (2*3600)   /* fixes fed per scenario */
+#define BENCH_DRAIN (1800)     /* seconds allowed after the last fix */
+#define BENCH_OFFLINE (6*3600) /* backlog run, seconds of fixes with the link down, ~1MB of batches */
+#define BENCH_PASSES (10)      /* backlog run, mqttService() passes a second while offline */
+
+//----------------------------------------------------------------------------
+// the subscriber
+//----------------------------------------------------------------------------
+struct Subscriber
+{
+  std::set<unsigned long> seqs;
+  std::set<long> epochs;
+  unsigned long messages = 0;
+  unsigned long duplicates = 0;
+  unsigned long badTopic = 0;
+
+  void message(const std::string& topic, const std::string& payload)
+  {
+    messages++;
+    if (topic != mqttTopic) badTopic++;
+    const char* p = strstr(payload.c_str(), "\"seq\":");
+    if (!p) return;
+    unsigned long seq = strtoul(p + 6, NULL, 10);
+    if (!seqs.insert(seq).second)
+    {
+      duplicates++;
+      return;
+    }
+    p = strstr(p, "\"fixes\":[");
+    if (!p) return;
+    p += 9;
+    while ((p = strchr(p, '[')) != NULL)
+    {
+      p++;
+      epochs.insert(strtol(p, NULL, 10));
+    }
+  }
+};
+
+Subscriber sub;
+MqttBrokerStats brokerStats;
+
+class BenchPeer : public HostPeer
+{
+public:
+  void onConnect() override
+  {
+    broker.reset(new MqttBroker(brokerStats,
+      [](const std::string& t, const std::string& m) { sub.message(t, m); },
+      [this](const uint8_t* data, size_t len) { send(data, len); }));
+  }
+  void onData(const uint8_t* data, size_t len) override { if (broker) broker->onData(data, len); }
+  void onClose() override { broker.reset(); }
+private:
+  std::unique_ptr<MqttBroker> broker;
+};
+
+BenchPeer benchPeer;
+
+//----------------------------------------------------------------------------
+// one pass of loop() as far as MQTT goes, timed
+//----------------------------------------------------------------------------
+static uint64_t longestIdleUs = 0;  // longest pass that wrote nothing
+static size_t longestTrimStep = 0;  // most a pass added to MQTT_QUEUETMP
+
+static size_t tmpSize()
+{
+  auto it = fileSystem.files.find(MQTT_QUEUETMP);
+  return (it == fileSystem.files.end()) ? 0 : it->second->size();
+}
+
+static void pass()
+{
+  hostNetTask();
+  uint64_t t0 = hostMicros, out0 = hostStats.tcpBytesOut;
+  size_t tmp0 = tmpSize();
+  mqttService();
+  if ((hostStats.tcpBytesOut == out0) && (hostMicros - t0 > longestIdleUs)) longestIdleUs = hostMicros - t0;
+  if (tmpSize() > tmp0 && tmpSize() - tmp0 > longestTrimStep) longestTrimStep = tmpSize() - tmp0;
+}
+
+// the socket of a connect under way goes with the power too
+static void powerLoss()
+{
+  if (mqttSock >= 0) lwip_close(mqttSock);
+  mqttSock = -1;
+  mqttIp = 0;
+  mqttClient = WiFiClient(); // no DISCONNECT
+  benchPeer.onClose();
+}
+
+//----------------------------------------------------------------------------
+// scenarios
+//----------------------------------------------------------------------------
+struct Scenario
+{
+  const char* name;
+  int lossPct;
+  unsigned long latencyMs;
+  unsigned long kbps;
+  unsigned long upSec, downSec; // AP in range upSec, then gone downSec, repeating (0 = always up)
+  unsigned long rebootSec;      // reboot this often (0 = never)
+};
+
+static const Scenario scenarios[] = {
+  { "clean",           0,  10, 1000,   0,   0,    0 },
+  { "lossy 10%",      10,  80,  250,   0,   0,    0 },
+  { "drops 20s/30s",   2,  20,  250,  20,  30,    0 },
+  { "lossy+drops",    10,  80,  250, 120, 300,    0 },
+  { "reboots",         2,  20,  250, 120, 300, 1000 },
+};
+
+static std::vector<NetPhase> phasesFor(const Scenario& sc, unsigned long limit)
+{
+  std::vector<NetPhase> p;
+  if (sc.upSec == 0)
+  {
+    p.push_back({ 0, 1, sc.latencyMs, sc.lossPct, sc.kbps });
+    return p;
+  }
+  for (unsigned long t = 0; t < limit; t += sc.upSec + sc.downSec)
+  {
+    p.push_back({ t, 1, sc.latencyMs, sc.lossPct, sc.kbps });
+    p.push_back({ t + sc.upSec, 0, 0, 0, 0 });
+  }
+  p.push_back({ limit, 1, sc.latencyMs, sc.lossPct, sc.kbps }); // up for the drain
+  return p;
+}
+
+//----------------------------------------------------------------------------
+// one RMC line per second, with a good checksum
+//----------------------------------------------------------------------------
+static std::vector<long> fed;
+
+static void feedFix(int n)
+{
+  char body[128], line[140];
+  int t = 9*3600 + n;
+  snprintf(body, sizeof(body), "GNRMC,%02d%02d%02d.000,A,4745.%04d,N,12212.5678,W,%.2f,%.2f,%02d1123,,,A",
+    (t/3600)%24, (t/60)%60, t%60, n%10000, (n%300)/10.0, (double)(n%360), 15 + t/86400);
+  uint8_t cs = 0;
+  for (char* p = body; *p; p++) cs ^= *p;
+  snprintf(line, sizeof(line), "$%s*%02X", body, cs);
+  GpsFix fix;
+  rmcParse(line, &fix);
+  fed.push_back(fixEpoch(&fix));
+  mqttAddFix(line);
+}
+
+static void startRun(std::vector<NetPhase> phases)
+{
+  hostMicros = 0;
+  hostStats = HostNetStats();
+  brokerStats = MqttBrokerStats();
+  sub = Subscriber();
+  fed.clear();
+  fileSystem.format();
+  WiFi = WiFiClass();
+  hostNet.script(phases, 4242);
+  rtc.setTime(00,00,00, 1, 1, 2023);
+  mqttSessions = mqttPublished = mqttAckedCount = mqttResent = mqttDropped = 0;
+  mqttTimer = mqttLastTx = mqttLastRx = mqttPaceTimer = mqttIndexTimer = 0;
+  mqttClient.stop();
+  powerLoss();
+  hostDnsQueries.clear();
+  longestIdleUs = 0;
+  longestTrimStep = 0;
+  schedulerInit();
+  wifiInit();
+  wifiConnect();
+  mqttInit();
+}
+
+// what didn't arrive, with the fixes lost in RAM at reboots allowed for
+static void check(const std::set<long>& lostInRam, unsigned long& missing, unsigned long& extra)
+{
+  missing = extra = 0;
+  for (long e : fed)
+    if (!sub.epochs.count(e) && !lostInRam.count(e)) missing++;
+  for (long e : sub.epochs)
+    if (!std::binary_search(fed.begin(), fed.end(), e)) extra++;
+}
+
+static void runScenario(const Scenario& sc)
+{
+  startRun(phasesFor(sc, BENCH_FIXES));
+  std::set<long> lostInRam;
+  unsigned long reboots = 0;
+  int fixes = 0;
+  while (hostNet.secondsIn() < BENCH_FIXES + BENCH_DRAIN)
+  {
+    delay(10);
+    if (secondDetector())
+    {
+      wifiService();
+      if (fixes < BENCH_FIXES) feedFix(fixes++);
+      else if (mqttBatchFixes) mqttBatchClose(); // the last part batch
+      if (sc.rebootSec && fixes < BENCH_FIXES && (fixes % sc.rebootSec) == 0)
+      {
+        for (int i = 0; i < mqttBatchFixes; i++) lostInRam.insert(fed[fed.size() - 1 - i]);
+        powerLoss();
+        mqttInit();
+        reboots++;
+      }
+    }
+    pass();
+    if ((fixes == BENCH_FIXES) && (mqttBatchFixes == 0) && (mqttPending() == 0) && (mqttInflightCount == 0)) break;
+  }
+
+  unsigned long missing, extra;
+  check(lostInRam, missing, extra);
+  printf("  %4lu batches %5zu fixes in, %4lu/%5zu out, %lu connects, %lu publishes (%lu resent), %lu dups dropped\n",
+    (unsigned long)mqttSeq, fed.size(), (unsigned long)sub.seqs.size(), sub.epochs.size(), brokerStats.connects,
+    brokerStats.publishes, mqttResent, sub.duplicates);
+  printf("  %lu reboots (%zu fixes lost in RAM), %lu missing, %lu extra, %lu queue drops, %s, drained %.0fs after the last fix\n",
+    reboots, lostInRam.size(), missing, extra, mqttDropped,
+    (missing == 0) && (extra == 0) && (sub.badTopic == 0) ? "OK" : "LOSS",
+    hostMicros / 1e6 - BENCH_FIXES);
+  printf("  %lu DNS lookups, longest pass without a write %.1fms %s\n",
+    hostStats.dnsLookups, longestIdleUs / 1000.0, longestIdleUs == 0 ? "OK" : "BLOCKED");
+}
+
+//----------------------------------------------------------------------------
+// offline backlog, then drain as fast as pacing and link allow
+//----------------------------------------------------------------------------
+static void runBacklog()
+{
+  std::vector<NetPhase> p;
+  p.push_back({ 0, 0, 0, 0, 0 });
+  p.push_back({ BENCH_OFFLINE, 1, 10, 0, 10000 });
+  startRun(p);
+  uint32_t fileMax = 0;
+  for (int n = 0; n < BENCH_OFFLINE; n++)
+  {
+    feedFix(n);
+    for (int i = 0; i < BENCH_PASSES; i++)
+    {
+      hostMicros += 1000000 / BENCH_PASSES;
+      pass();
+      if (mqttQueueSize > fileMax) fileMax = mqttQueueSize;
+    }
+  }
+  mqttBatchClose();
+  while (mqttTrimState != MQTTTRIM_IDLE) pass(); // a trim under way finishes
+  unsigned long queued = mqttSeq;
+  int bytes = mqttPending();
+  File q = fileSystem.open(MQTT_QUEUEFN, FILE_READ);
+  size_t fileSize = q ? q.size() : 0;
+  q.close();
+
+  // wait for the session, then time the drain
+  while ((mqttState != MQTTSTATE_UP) && (hostNet.secondsIn() < BENCH_OFFLINE + 600))
+  {
+    delay(10);
+    if (secondDetector()) wifiService();
+    pass();
+  }
+  uint64_t v0 = hostMicros;
+  auto w0 = std::chrono::steady_clock::now();
+  unsigned long acked0 = mqttAckedCount;
+  while ((mqttPending() > 0) && (hostNet.secondsIn() < BENCH_OFFLINE + 600))
+  {
+    delay(1);
+    pass();
+  }
+  double vsec = (hostMicros - v0) / 1e6;
+  double wsec = std::chrono::duration<double>(std::chrono::steady_clock::now() - w0).count();
+  unsigned long msgs = mqttAckedCount - acked0;
+
+  unsigned long missing, extra;
+  check(std::set<long>(), missing, extra);
+  printf("  %lu batches queued offline, %lu dropped (queue full), %d bytes left, file %zu bytes (most %lu, cap %ld) %s\n",
+    queued, mqttDropped, bytes, fileSize, (unsigned long)fileMax, MQTT_QUEUEMAX,
+    (fileMax <= MQTT_QUEUEMAX + 2 + MQTT_PAYLOADMAX) && (fileSize == (size_t)bytes) && (mqttDropped > 0) ? "OK" : "OVER");
+  printf("  trims copied at most %zu bytes a pass (step %d) %s\n", longestTrimStep, MQTT_TRIMSTEP,
+    (longestTrimStep > 0) && (longestTrimStep <= MQTT_TRIMSTEP) ? "OK" : "TOO MUCH");
+  printf("  drained in %.1fs: %.0f msgs/s (%.0f fixes/s) virtual, %.0f msgs/s wall clock\n",
+    vsec, vsec > 0 ? msgs / vsec : 0, vsec > 0 ? sub.epochs.size() / vsec : 0, wsec > 0 ? msgs / wsec : 0);
+  printf("  %lu missing (%lu from dropped batches), %lu extra, %s\n",
+    missing, mqttDropped * MQTT_BATCH_FIXES, extra,
+    (missing == mqttDropped * MQTT_BATCH_FIXES) && (extra == 0) ? "OK" : "LOSS");
+}
+
+int main(int argc, char** argv)
+{
+  if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) Serial.echo = true;
+  hostPeer = &benchPeer;
+
+  for (const Scenario& sc : scenarios)
+  {
+    printf("%s (loss %d%%, %lums, %lukbit/s", sc.name, sc.lossPct, sc.latencyMs, sc.kbps);
+    if (sc.upSec) printf(", AP %lus in range / %lus gone", sc.upSec, sc.downSec);
+    if (sc.rebootSec) printf(", reboot every %lus", sc.rebootSec);
+    printf(")\n");
+    runScenario(sc);
+  }
+  printf("backlog (%ds of fixes offline, then clean 10ms 10Mbit/s)\n", BENCH_OFFLINE);
+  runBacklog();
+  return 0;
+}
@@ -0,0 +1,287 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Network fault-injection simulator for the WiFi / NTP / FTP services
+//----------------------------------------------------------------------------
+// Runs the real wifiService(), ntpService() and ftpPut() from the sketch
+// folder against the scripted link in HostNet.h, on the virtual clock, so
+// hours of driving on and off the property take a fraction of a second.
+//
+// Each scenario reports:
+//   reconnect  - seconds from the AP coming back in range until
+//                wifiIsConnected(), mean and worst case
+//   missed     - times the AP was in range but went away again before we
+//                connected;  "STUCK" if still not connected at the end
+//   searching  - seconds the radio spent scanning/associating with no AP
+//   ntp        - seconds until the clock was set, requests sent, and how
+//                long loop() was blocked waiting on NTP answers
+//   upload     - FTP sessions (failed), bytes delivered/offered, kB/s
+//   speedup    - virtual time / wall time
+//
+// Then tlsPut() (TlsUploadService.h, against the mbedtls stand-in in
+// HostTls.h) on a good link with each way of trusting the server:  with
+// no /ca.pem and no UPLOADSHA256, or a /ca.pem that doesn't parse and no
+// UPLOADSHA256, it must not even connect - nothing sent.  With either one
+// it connects and gets as far as the ClientHello (the stand-in server
+// never answers, so never as far as the credentials).
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/netsim host/netsim.cpp
+//   host/netsim          (add -v to see the services' Serial output)
+//
+#include <chrono>
+#include "HostArduino.h"
+#include "HostNet.h"
+#include "HostTls.h"
+
+ESP32Time rtc(-8*3600);
+fs::FS & fileSystem = SPIFFS;
+
+#define LOGFN "/location.log"
+
+char wifissid[64] = "SimAP";
+char wifipwd[64] = "SimPassword";
+char ftpServer[128] = "ftp.sim";
+char ftpUser[64] = "sim";
+char ftpPwd[64] = "sim";
+char ftpUploadFolder[128] = "/sim";
+char uploadUrl[128] = "https://upload.sim:8443/gpslogs/";
+char uploadSha256[68] = "";
+
+void logMessage(char* msg) { Serial.println(msg); }
+void logMessage(String msg) { Serial.println(msg.c_str()); }
+
+#include "../FileSystemService.h"
+#include "../SchedulerService.h"
+#include "../WiFiService.h"
+#include "../NTPService.h"
+#include "../FtpService.h"
+#include "../TlsUploadService.h"
+
+//----------------------------------------------------------------------------
+// scenarios
+//----------------------------------------------------------------------------
+struct Scenario
+{
+  const char* name;
+  std::vector<NetPhase> phases;
+  unsigned long durationSec;
+  std::vector<unsigned long> uploadAtSec; // "ftp" typed at these times (once connected)
+};
+
+// {startSec, apUp, latencyMs, lossPct, kbps}
+static const std::vector<Scenario> scenarios = {
+  { "home",
+    { {0, 1, 5, 0, 8000} },
+    3600, {600} },
+  { "drive-off",            // the field failure from the dev log
+    { {0, 1, 5, 0, 8000}, {300, 0, 0, 0, 0}, {1500, 1, 5, 0, 8000} },
+    3600, {1600} },
+  { "edge-of-range",        // AP comes and goes while parked at the fence
+    { {0, 1, 20, 10, 1000}, {120, 0, 0, 0, 0}, {165, 1, 20, 10, 1000}, {200, 0, 0, 0, 0},
+      {290, 1, 20, 10, 1000}, {310, 0, 0, 0, 0}, {400, 1, 20, 10, 1000} },
+    1800, {450} },
+  { "lossy-uplink",         // congested AP, slow DNS/NTP answers
+    { {0, 1, 150, 30, 500} },
+    1800, {300} },
+  { "drop-mid-upload",
+    { {0, 1, 10, 2, 200}, {603, 0, 0, 0, 0}, {900, 1, 10, 2, 200} },
+    1800, {600, 1000} },
+  { "highway",              // no known AP for the whole drive
+    { {0, 0, 0, 0, 0} },
+    4*3600, {} },
+};
+
+//----------------------------------------------------------------------------
+// build a day's worth of RMC lines to upload
+//----------------------------------------------------------------------------
+static void makeLogFile()
+{
+  fileSystem.format();
+  File f = fileSystem.open(LOGFN, FILE_WRITE);
+  char line[128];
+  for (int m = 0; m < 24*60; m++)
+  {
+    snprintf(line, sizeof(line),
+      "$GNRMC,%02d%02d00.000,A,4745.1234,N,12212.5678,W,0.12,0.00,151123,,,A*6F", m/60, m%60);
+    f.println(line);
+  }
+  f.close();
+}
+
+//----------------------------------------------------------------------------
+// run one scenario - the once-per-second part of loop() from GpsLogger.ino
+//----------------------------------------------------------------------------
+static void runScenario(const Scenario& sc)
+{
+  hostMicros = 0;
+  hostStats = HostNetStats();
+  WiFi = WiFiClass();
+  timeClient = NTPClient(ntpUDP);
+  hostNet.script(sc.phases, 12345);
+  makeLogFile();
+  rtc.setTime(00,00,00, 1, 1, 2023);
+  schedulerInit();
+  wifiInit();
+  ntpInit();
+
+  auto wall0 = std::chrono::steady_clock::now();
+
+  wifiConnect();
+  int ntpDone = false;
+  double ntpSyncSec = -1;
+  size_t nextUpload = 0;
+
+  // reconnect tracking
+  int apWasUp = hostNet.up();
+  int waitingReconnect = false;
+  uint64_t apUpAt = 0;
+  int reconnects = 0;
+  int missed = 0;
+  double reconnectSum = 0, reconnectMax = 0;
+
+  while (hostNet.secondsIn() < sc.durationSec)
+  {
+    delay(50); // high rate part of loop() - gps, telnet
+
+    if (secondDetector())
+    {
+      wifiService();
+
+      if (wifiIsConnected() && !ntpStarted() && (ntpAttempts == 0)) ntpStart();
+      ntpService();
+      if (!ntpDone && ntpComplete())
+      {
+        ntpDone = true;
+        ntpSyncSec = hostMicros / 1e6;
+      }
+
+      if ((nextUpload < sc.uploadAtSec.size()) &&
+          (hostNet.secondsIn() >= sc.uploadAtSec[nextUpload]) &&
+          wifiIsConnected())
+      {
+        nextUpload++;
+        ftpPut(LOGFN);
+      }
+    }
+
+    WiFi.sampleRadio();
+
+    int apUp = hostNet.up();
+    if (apUp && !apWasUp)
+    {
+      waitingReconnect = true;
+      apUpAt = hostMicros;
+    }
+    if (!apUp && apWasUp && waitingReconnect)
+    {
+      missed++;
+      waitingReconnect = false;
+    }
+    apWasUp = apUp;
+    if (waitingReconnect && wifiIsConnected())
+    {
+      double t = (hostMicros - apUpAt) / 1e6;
+      reconnects++;
+      reconnectSum += t;
+      if (t > reconnectMax) reconnectMax = t;
+      waitingReconnect = false;
+    }
+  }
+
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+  double virtSec = hostMicros / 1e6;
+
+  printf("%-16s", sc.name);
+  if (reconnects) printf(" %2d x %5.1f/%5.1fs", reconnects, reconnectSum / reconnects, reconnectMax);
+  else printf(" %15s", "-");
+  if (waitingReconnect) printf(" %6s", "STUCK");
+  else printf(" %6d", missed);
+  printf(" %7.0fs", hostStats.radioSearchUs / 1e6);
+  if (ntpSyncSec >= 0) printf(" %6.0fs", ntpSyncSec); else printf(" %7s", "never");
+  printf(" %4lu/%-4lu %5.0fs", hostStats.ntpAnswers, hostStats.ntpRequests, hostStats.ntpBlockedUs / 1e6);
+  if (hostStats.ftpSessions)
+    printf(" %lu(%lu) %7llu/%-7llu %6.1f",
+      hostStats.ftpSessions, hostStats.ftpFailed,
+      (unsigned long long)hostStats.ftpBytesDelivered, (unsigned long long)hostStats.ftpBytesOffered,
+      hostStats.ftpUs ? hostStats.ftpBytesDelivered / 1024.0 / (hostStats.ftpUs / 1e6) : 0.0);
+  else
+    printf(" %28s", "-");
+  printf(" %8.0fx\n", wallSec > 0 ? virtSec / wallSec : 0.0);
+}
+
+//----------------------------------------------------------------------------
+// HTTPS upload - nothing goes to a server the logger can't check
+//----------------------------------------------------------------------------
+class TlsCheckPeer : public HostPeer
+{
+public:
+  void onConnect() override { connects++; }
+  void onData(const uint8_t* data, size_t len) override { (void)data; bytes += len; }
+  void onClose() override {}
+  unsigned long connects = 0;
+  size_t bytes = 0;
+};
+
+struct TlsCase
+{
+  const char* name;
+  const char* caPem;   // NULL for no /ca.pem
+  const char* sha256;
+  int mayConnect;
+};
+
+static const TlsCase tlsCases[] = {
+  { "no ca.pem, no pin",         NULL, "", false },
+  { "unreadable ca.pem, no pin", "not a certificate\n", "", false },
+  { "pin only",                  NULL, "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff", true },
+  { "ca.pem only",               "-----BEGIN CERTIFICATE-----\nMIIB\n-----END CERTIFICATE-----\n", "", true },
+};
+
+static int tlsTrustCheck()
+{
+  int bad = 0;
+  printf("\nHTTPS upload, who the server is checked against:\n");
+  for (const TlsCase& tc : tlsCases)
+  {
+    hostMicros = 0;
+    hostStats = HostNetStats();
+    hostTls = HostTlsStats();
+    WiFi = WiFiClass();
+    hostNet.script({ {0, 1, 5, 0, 8000} }, 12345);
+    makeLogFile();
+    if (tc.caPem)
+    {
+      File f = fileSystem.open(TLS_CAFN, FILE_WRITE);
+      f.print(tc.caPem);
+      f.close();
+    }
+    strcpy(uploadSha256, tc.sha256);
+    wifiInit();
+    wifiConnect();
+    while (!wifiIsConnected() && (hostNet.secondsIn() < 60)) { delay(100); wifiService(); }
+
+    TlsCheckPeer peer;
+    hostPeer = &peer;
+    int ok = tlsPut(LOGFN);
+    hostPeer = nullptr;
+
+    int sent = (peer.connects > 0) || (peer.bytes > 0) || (hostStats.tcpBytesOut > 0);
+    int good = !ok && (hostTls.appWrites == 0) &&
+      (tc.mayConnect ? (peer.bytes == HOSTTLS_HELLO) : (!sent && (hostTls.setups == 0)));
+    printf("  %-26s connects %lu, bytes sent %4zu, requests %lu  %s\n",
+      tc.name, peer.connects, peer.bytes, hostTls.appWrites, good ? "ok" : "FAILED");
+    bad += !good;
+  }
+  return bad;
+}
+
+int main(int argc, char** argv)
+{
+  if ((argc > 1) && (strcmp(argv[1], "-v") == 0)) Serial.echo = true;
+
+  printf("%-16s %15s %6s %8s %7s %9s %6s %28s %9s\n",
+    "scenario", "reconnect", "missed", "search", "ntp", "ans/req", "block",
+    "upload sess bytes    kB/s", "speedup");
+  for (const Scenario& sc : scenarios) runScenario(sc);
+  return tlsTrustCheck() ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// The bulk NMEA parser (NmeaBulk.h) against rmcParse() / ggaParse() a line
+// at a time, over gigabytes of uploads
+//----------------------------------------------------------------------------
+// The corpus is the files named (a folder is read for every file under it,
+// each mmap'ed), or without any a built-in one of -mb MB in memory: what a
+// receiver at 1 Hz sends and the loggers upload with LOGALL - RMC, GGA,
+// GSA and three GSV a second, CRLF, the odd line with a bad checksum, cut
+// short or run into the next one, and the RMC before the first fix void.
+//
+// Each way goes over the corpus again and again until it has read -gb GB:
+//   reference   memchr() for the line end, the line copied out and
+//               terminated, rmcParse() then ggaParse() on it (what
+//               ingest-like tools do with NmeaService.h)
+//   scalar      NmeaBulk.h with plain C bitmaps and XOR
+//   sse4.2      NmeaBulk.h 16 bytes a compare
+//   avx2        NmeaBulk.h 32 bytes a compare
+// (the ones the CPU has), and is checked on its first pass against the
+// reference column for column: every RMC with a fix and a date, every
+// GGA with a time, fixed point values within 1 of the float ones rounded.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/nmeabench host/nmeabench.cpp
+//   host/nmeabench [file|folder ...] [-mb n] [-gb n]
+//
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "UploadFleet.h"
+#include "NmeaBulk.h"
+
+namespace fsys = std::filesystem;
+
+struct Span { const char* p; size_t len; };
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------------------------------
+// the built-in corpus
+//----------------------------------------------------------------------------
+static void addLine(std::string& out, const char* body)
+{
+  uint8_t sum = 0;
+  for (const char* c = body; *c; c++) sum ^= *c;
+  char line[200];
+  snprintf(line, sizeof(line), "$%s*%02X\r\n", body, sum);
+  out += line;
+}
+
+static std::string makeCorpus(size_t bytes)
+{
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> u(0, 1);
+  std::string out;
+  out.reserve(bytes + 4096);
+  long t = 1700006400L;
+  double lat = HOME_LAT, lon = HOME_LON, course = 0, mps = 0;
+  int warm = 0;
+  char body[160], la[24], lo[24];
+  while (out.size() < bytes)
+  {
+    // a run of driving, from cold now and then
+    if ((t % 3600) == 0) { warm = (u(rng) < 0.2) ? 0 : 30; course = u(rng) * 360; }
+    bool fix = (warm++ >= 30);
+    mps = std::max(0.0, std::min(30.0, mps + (u(rng) - 0.5) * 2));
+    course = fmod(course + (u(rng) - 0.5) * 10 + 360, 360);
+    lat += mps * cos(course * M_PI / 180) / 111320.0;
+    lon += mps * sin(course * M_PI / 180) / (111320.0 * cos(lat * M_PI / 180));
+    size_t start = out.size();
+
+    if (fix) out += fleetRmc(t, lat, lon, mps / 0.5144, course, true);
+    else
+    {
+      time_t tt = t;
+      struct tm tm;
+      gmtime_r(&tt, &tm);
+      snprintf(body, sizeof(body), "GNRMC,%02d%02d%02d.00,V,,,,,,,%s,,,N",
+               tm.tm_hour, tm.tm_min, tm.tm_sec, (warm < 10) ? "" : "181123");
+      addLine(out, body);
+    }
+    fleetDm(la, sizeof(la), lat, 2, 'N', 'S');
+    fleetDm(lo, sizeof(lo), lon, 3, 'E', 'W');
+    int sats = fix ? 6 + (int)(u(rng) * 10) : 0;
+    snprintf(body, sizeof(body), "GNGGA,%02ld%02ld%02ld.00,%s,%s,%d,%02d,%s,%.1f,M,-17.3,M,,",
+             (t / 3600) % 24, (t / 60) % 60, t % 60, fix ? la : ",", fix ? lo : ",", fix ? 1 : 0, sats,
+             fix ? (u(rng) < 0.5 ? "0.87" : "1.2") : "", fix ? 20 + u(rng) * 40 - 25 * (u(rng) < 0.05) : 0.0);
+    addLine(out, body);
+    snprintf(body, sizeof(body), "GNGSA,A,%d,05,12,15,18,20,25,29,,,,,,1.61,0.87,1.35,1", fix ? 3 : 1);
+    addLine(out, body);
+    for (int m = 1; m <= 3; m++)
+    {
+      snprintf(body, sizeof(body), "GPGSV,3,%d,11,%02d,%02d,%03d,%02d,%02d,%02d,%03d,%02d,%02d,%02d,%03d,,%02d,%02d,%03d,%02d",
+               m, m * 4, (int)(u(rng) * 90), (int)(u(rng) * 360), (int)(u(rng) * 50), m * 4 + 1, (int)(u(rng) * 90),
+               (int)(u(rng) * 360), (int)(u(rng) * 50), m * 4 + 2, (int)(u(rng) * 90), (int)(u(rng) * 360),
+               m * 4 + 3, (int)(u(rng) * 90), (int)(u(rng) * 360), (int)(u(rng) * 50));
+      addLine(out, body);
+    }
+    // the odd damaged line: a flipped byte, cut short, or run into the next
+    double d = u(rng);
+    if (d < 0.004) out[start + 8 + (size_t)(u(rng) * 30)] ^= 0x04;
+    else if (d < 0.006) out.erase(start + 20, out.find('\n', start) - start - 19);
+    t++;
+  }
+  return out;
+}
+
+//----------------------------------------------------------------------------
+// the reference
+//----------------------------------------------------------------------------
+static void referenceParse(const char* p, size_t len, NmeaColumns* c)
+{
+  char line[256];
+  GpsFix fix;
+  GpsGga gga;
+  const char* end = p + len;
+  while (p < end)
+  {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    const char* e = nl ? nl : end;
+    size_t n = e - p;
+    if (n && (p[n - 1] == '\r')) n--;
+    c->lines++;
+    if (n < sizeof(line))
+    {
+      memcpy(line, p, n);
+      line[n] = 0;
+      if (rmcParse(line, &fix))
+      {
+        if (fix.valid && fix.year)
+        {
+          c->rmcTime.push_back((int32_t)(fixEpoch(&fix) - SEG_EPOCH));
+          c->rmcLat.push_back((int32_t)lround(fix.lat * 1e6));
+          c->rmcLon.push_back((int32_t)lround(fix.lon * 1e6));
+          c->rmcSpeed.push_back((int32_t)lround(fix.speedKts * 100));
+          c->rmcCourse.push_back((int32_t)lround(fix.course * 100));
+        }
+      }
+      else if (ggaParse(line, &gga))
+      {
+        c->ggaTime.push_back(gga.hour * 3600 + gga.minute * 60 + (int)gga.second);
+        c->ggaQuality.push_back((uint8_t)gga.quality);
+        c->ggaSats.push_back((uint8_t)gga.sats);
+        c->ggaHdop.push_back((int32_t)lround(gga.hdop * 100));
+        c->ggaAlt.push_back((int32_t)lround(gga.alt * 10));
+      }
+      else if (nmeaIsType(line, "RMC") || nmeaIsType(line, "GGA")) c->bad++;
+      else c->other++;
+    }
+    else c->other++;
+    p = nl ? nl + 1 : end;
+  }
+}
+
+//----------------------------------------------------------------------------
+// checking and timing
+//----------------------------------------------------------------------------
+template <typename T>
+static long columnDiffs(const char* name, const std::vector<T>& a, const std::vector<T>& b, int tol)
+{
+  if (a.size() != b.size())
+  {
+    printf("  %s: %zu rows, reference %zu\n", name, a.size(), b.size());
+    return 1;
+  }
+  long diffs = 0;
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    if (abs((long)a[i] - (long)b[i]) > tol)
+    {
+      if (diffs++ < 3) printf("  %s row %zu: %ld, reference %ld\n", name, i, (long)a[i], (long)b[i]);
+    }
+  }
+  return diffs;
+}
+
+static long compare(const NmeaColumns& a, const NmeaColumns& r)
+{
+  long d = 0;
+  d += columnDiffs("rmc time", a.rmcTime, r.rmcTime, 0);
+  d += columnDiffs("rmc lat", a.rmcLat, r.rmcLat, 1);
+  d += columnDiffs("rmc lon", a.rmcLon, r.rmcLon, 1);
+  d += columnDiffs("rmc speed", a.rmcSpeed, r.rmcSpeed, 1);
+  d += columnDiffs("rmc course", a.rmcCourse, r.rmcCourse, 1);
+  d += columnDiffs("gga time", a.ggaTime, r.ggaTime, 0);
+  d += columnDiffs("gga quality", a.ggaQuality, r.ggaQuality, 0);
+  d += columnDiffs("gga sats", a.ggaSats, r.ggaSats, 0);
+  d += columnDiffs("gga hdop", a.ggaHdop, r.ggaHdop, 1);
+  d += columnDiffs("gga alt", a.ggaAlt, r.ggaAlt, 1);
+  if ((a.lines != r.lines) || (a.bad != r.bad) || (a.other != r.other))
+  {
+    printf("  lines %llu bad %llu other %llu, reference %llu %llu %llu\n",
+           (unsigned long long)a.lines, (unsigned long long)a.bad, (unsigned long long)a.other,
+           (unsigned long long)r.lines, (unsigned long long)r.bad, (unsigned long long)r.other);
+    d++;
+  }
+  return d;
+}
+
+// -1 the reference, else an NMEA_ way;  GB/s
+static double run(int how, const std::vector<Span>& corpus, size_t total, double gb, NmeaColumns* first)
+{
+  NmeaColumns c;
+  size_t done = 0;
+  double t0 = now();
+  for (int pass = 0; (pass == 0) || (done < gb * 1e9); pass++)
+  {
+    c.clear();
+    for (const Span& s : corpus)
+    {
+      if (how < 0) referenceParse(s.p, s.len, &c);
+      else nmeaBulkParseWith(how, s.p, s.len, &c);
+    }
+    done += total;
+    if (pass == 0) *first = c;
+  }
+  return done / (now() - t0) / 1e9;
+}
+
+static void addFile(const fsys::path& path, std::vector<Span>& corpus, size_t& total)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if ((fd < 0) || (fstat(fd, &st) != 0) || (st.st_size == 0)) { if (fd >= 0) close(fd); return; }
+  void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return;
+  madvise(m, st.st_size, MADV_SEQUENTIAL);
+  corpus.push_back({ (const char*)m, (size_t)st.st_size });
+  total += st.st_size;
+}
+
+int main(int argc, char** argv)
+{
+  double gb = 4;
+  size_t mb = 1024;
+  std::vector<Span> corpus;
+  size_t total = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-mb") && (i + 1 < argc)) mb = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-gb") && (i + 1 < argc)) gb = atof(argv[++i]);
+    else if (fsys::is_directory(argv[i]))
+    {
+      for (auto& e : fsys::recursive_directory_iterator(argv[i]))
+        if (e.is_regular_file()) addFile(e.path(), corpus, total);
+    }
+    else addFile(argv[i], corpus, total);
+  }
+  std::string built;
+  if (corpus.empty())
+  {
+    double t0 = now();
+    built = makeCorpus(mb << 20);
+    corpus.push_back({ built.data(), built.size() });
+    total = built.size();
+    printf("built-in corpus: %.1f MB in %.1f s\n", total / 1e6, now() - t0);
+  }
+  else printf("corpus: %zu files, %.1f MB\n", corpus.size(), total / 1e6);
+  if (!total) return 1;
+
+  NmeaColumns ref;
+  double refRate = run(-1, corpus, total, gb, &ref);
+  printf("%llu lines: %zu RMC fixes, %zu GGA, %llu RMC/GGA bad, %llu other\n",
+         (unsigned long long)ref.lines, ref.rmcTime.size(), ref.ggaTime.size(),
+         (unsigned long long)ref.bad, (unsigned long long)ref.other);
+  printf("\n%-10s %8s %8s %8s  %s\n", "", "GB/s", "ns/line", "x ref", "check");
+  printf("%-10s %8.3f %8.1f %8s  %s\n", "reference", refRate, 1.0 / (refRate * ref.lines / total), "1.00", "-");
+
+  int best = nmeaBulkBest(), failed = 0;
+  for (int how = NMEA_SCALAR; how <= best; how++)
+  {
+    NmeaColumns c;
+    double rate = run(how, corpus, total, gb, &c);
+    long d = compare(c, ref);
+    failed += (d != 0);
+    printf("%-10s %8.3f %8.1f %8.2f  %s\n", nmeaBulkName[how], rate, 1.0 / (rate * ref.lines / total),
+           rate / refRate, d ? "DIFFERS" : "ok");
+  }
+  return failed ? 1 : 0;
+}
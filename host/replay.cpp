@@ -0,0 +1,142 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Replay a recorded NMEA file through the logger pipeline on the PC
+//----------------------------------------------------------------------------
+// The recorded file is played by ReplayService.h (the same code behind the
+// telnet "replay" command) into the GPS serial port, and from there through
+// the firmware path:  gpsService() -> RMC select -> gpsLogLine() -> flush
+// to /location.log in the in-memory SPIFFS.
+//
+// At "max" speed this is a throughput benchmark of the ingest path;  with a
+// speed it runs on the virtual clock and reports how long the replay took.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/replay host/replay.cpp
+//   host/replay recorded.log [speed|max] [dec] [-o out.log]
+//
+// Every RMC line is logged (on the ESP32 it's once per minute) so the log
+// buffer and flush path get exercised at full rate.  -o writes the
+// resulting /location.log out to a file on the PC.
+//
+// A telnet log of "cap dump" (a raw capture) plays the same way, on the
+// capture's own microsecond timing at a speed, binary frames included.
+//
+#include <chrono>
+#include "HostArduino.h"
+
+ESP32Time rtc(-8*3600);
+fs::FS & fileSystem = SPIFFS;
+
+#define LOGFN "/location.log"
+#define REPLAYFN "/replay.log"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+
+#include "../FileSystemService.h"
+#include "../GpsService.h"
+#include "../GpsLogService.h"
+#include "../NmeaService.h"
+#include "../ReplayService.h"
+
+unsigned long replayBytes = 0;
+
+// replay target - loop the line back into the GPS serial input
+// ("!hex" from a capture dump is bytes as they came from the receiver)
+void replayOutput(const char* line)
+{
+  if (line[0] == '!')
+  {
+    for (const char* p = line + 1; isxdigit(p[0]) && isxdigit(p[1]); p += 2)
+    {
+      char hex[3] = { p[0], p[1], 0 };
+      char c = (char)strtol(hex, NULL, 16);
+      GPSPORT.feed(&c, 1);
+      replayBytes++;
+    }
+    return;
+  }
+  GPSPORT.feed(line, strlen(line));
+  GPSPORT.feed("\r\n", 2);
+  replayBytes += strlen(line) + 2;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s recorded.log [speed|max] [dec] [-o out.log]\n", argv[0]);
+    return 1;
+  }
+  int speed = 0;
+  int decoded = false;
+  const char* outfn = NULL;
+  for (int i = 2; i < argc; i++)
+  {
+    if (strcmp(argv[i], "dec") == 0) decoded = true;
+    else if (strcmp(argv[i], "max") == 0) speed = 0;
+    else if ((strcmp(argv[i], "-o") == 0) && (i+1 < argc)) outfn = argv[++i];
+    else speed = atoi(argv[i]);
+  }
+
+  if (!SPIFFS.load(REPLAYFN, argv[1]))
+  {
+    fprintf(stderr, "unable to read %s\n", argv[1]);
+    return 1;
+  }
+  size_t inBytes = SPIFFS.open(REPLAYFN).size();
+
+  rtc.setTime(00,00,00, 1, 1, 2023);
+  gpsInit(9600);
+  gpsLogInit();
+  char rmcbuf[128];
+  rmcbuf[0] = 0;
+  unsigned long lines = 0, rmcs = 0;
+
+  auto wall0 = std::chrono::steady_clock::now();
+  replayStart(REPLAYFN, speed, decoded);
+  while (replayIsActive() || GPSPORT.available())
+  {
+    // the high rate part of loop()
+    char* line = gpsService();
+    if (line != NULL)
+    {
+      lines++;
+      if (nmeaIsType(line, "RMC") || decoded)
+      {
+        rmcs++;
+        strncpy(rmcbuf, line, sizeof(rmcbuf)-1);
+        rmcbuf[sizeof(rmcbuf)-1] = 0;
+        gpsLogLine(rmcbuf);
+      }
+    }
+    if (!GPSPORT.available())
+    {
+      replayService();
+      // nothing due yet - skip the virtual clock ahead to the next line
+      if (replayIsActive() && !GPSPORT.available() && ((long)(millis() - replayDueMs) < 0))
+        hostMicros = (uint64_t)replayDueMs * 1000;
+    }
+  }
+  gpsLogFlush();
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+
+  File out = SPIFFS.open(LOGFN);
+  printf("input      %zu bytes, replayed %lu lines (%lu bytes)\n", inBytes, replayLines, replayBytes);
+  printf("pipeline   %lu lines, %lu RMC logged, %zu bytes in %s\n", lines, rmcs, out.size(), LOGFN);
+  if (speed > 0)
+    printf("virtual    %.1f s at %dx\n", hostMicros / 1e6, speed);
+  printf("wall       %.3f s, %.0f lines/s, %.1f MB/s\n",
+    wallSec, wallSec > 0 ? lines / wallSec : 0.0, wallSec > 0 ? replayBytes / 1e6 / wallSec : 0.0);
+
+  if (outfn)
+  {
+    FILE* fp = fopen(outfn, "wb");
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = out.read(buf, sizeof(buf))) > 0) fwrite(buf, 1, n, fp);
+    fclose(fp);
+  }
+  return 0;
+}
@@ -0,0 +1,400 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Track segments (TrackSegmentService.h) - size and query speed against
+// the row formats
+//----------------------------------------------------------------------------
+// The logged RMC lines (a recorded location.log, or a month of built-in
+// working days, a fix a minute) go through segAddRmc() with segFlush()
+// on each hour, as on the logger, into /track.seg on the in-memory
+// SPIFFS.  The same fixes are also kept as
+//   text        location.log itself
+//   row         a fixed 14 byte record per fix (time, lat, lon, speed)
+//   row delta   the same deltas and varints as the segments, but a fix
+//               after the other
+// Sizes are compared as they are and deflated (zlib, level 9), and every
+// segment column is decoded back and checked against the fixes.
+//
+// Then the queries, each answered every way and checked to agree:
+//   top speed, bounding box   over everything - segQuery() takes them
+//                             from the segment headers
+//   top speed, one day        a 24 h window from mid-morning, the two
+//                             segments on its edges get decoded
+//   mean speed                every value needed - only the speed column
+//                             decoded vs every field of row delta
+// in microseconds per query on this PC.
+//
+// Build and run (from the sketch folder), needs zlib1g-dev:
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/segbench host/segbench.cpp -lz
+//   host/segbench [location.log] [-days n]
+//
+#include <chrono>
+#include <random>
+#include <zlib.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+
+#define HOME_LAT (47.75206)
+#define HOME_LON (-122.20946)
+
+//----------------------------------------------------------------------------
+// the built-in month - a working day with some of it different every day
+//----------------------------------------------------------------------------
+struct Leg { double north, east, mps; long sec; }; // mps 0 = stopped for sec
+
+struct Pt { long t; double lat, lon, kts, course; };
+
+static std::vector<Leg> dayLegs(std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> u(0, 1);
+  std::vector<Leg> legs;
+  auto drive = [&](double n, double e, double mps) { legs.push_back({ n, e, mps, 0 }); };
+  auto stop = [&](double n, double e, long sec) { legs.push_back({ n, e, 0, sec }); };
+  stop(0, 0, (long)(6.5*3600 + u(rng) * 3600));                   // home overnight
+  drive(-800, 0, 9 + 3*u(rng));                                   // through town
+  stop(-800, 0, (long)(u(rng) * 90));                             // lights
+  drive(-800, 3000, 11 + 4*u(rng));
+  drive(-20000, 9000, 24 + 6*u(rng));                             // highway
+  if (u(rng) < 0.3) stop(-20000, 9000, (long)(300 + u(rng) * 900)); // traffic
+  drive(-21500, 9000, 8 + 4*u(rng));
+  stop(-21500, 9000, (long)(3.5*3600 + u(rng) * 1800));           // work
+  if (u(rng) < 0.5)                                               // lunch errand
+  {
+    double n = -21500 + (u(rng) - 0.5) * 6000, e = 9000 + (u(rng) - 0.5) * 6000;
+    drive(n, e, 10 + 5*u(rng));
+    stop(n, e, (long)(900 + u(rng) * 1800));
+    drive(-21500, 9000, 10 + 5*u(rng));
+  }
+  stop(-21500, 9000, (long)(3.5*3600 + u(rng) * 3600));           // work
+  drive(-20000, 9000, 8 + 4*u(rng));
+  drive(-800, 3000, 20 + 10*u(rng));
+  drive(-800, 0, 11 + 4*u(rng));
+  if (u(rng) < 0.3)                                               // evening errand
+  {
+    double n = -800 + (u(rng) - 0.5) * 8000, e = (u(rng) - 0.5) * 8000;
+    drive(n, e, 10 + 5*u(rng));
+    stop(n, e, (long)(1800 + u(rng) * 3600));
+    drive(-800, 0, 10 + 5*u(rng));
+  }
+  drive(0, 0, 9 + 3*u(rng));
+  return legs;
+}
+
+// a fix on each minute, with receiver noise
+static std::vector<Pt> makeDays(int days)
+{
+  std::mt19937 rng(7);
+  std::normal_distribution<double> noise(0, 1.5);
+  std::vector<Pt> fixes;
+  double mPerDeg = 6371000.0 * M_PI / 180.0;
+  double mPerDegLon = mPerDeg * cos(HOME_LAT * M_PI / 180);
+  long day0 = 1700006400L; // 2023/11/15
+  for (int d = 0; d < days; d++)
+  {
+    double n = 0, e = 0, course = 0;
+    long s = 0;
+    auto at = [&](double pn, double pe, double mps)
+    {
+      if ((s % 60) == 0)
+      {
+        double kts = mps > 0 ? (mps + noise(rng) * 0.2) / 0.5144 : fabs(noise(rng)) * 0.1;
+        fixes.push_back({ day0 + d * 86400L + s, HOME_LAT + (pn + noise(rng)) / mPerDeg,
+                          HOME_LON + (pe + noise(rng)) / mPerDegLon, kts, course });
+      }
+      s++;
+    };
+    for (const Leg& leg : dayLegs(rng))
+    {
+      double dn = leg.north - n, de = leg.east - e;
+      long sec = leg.mps > 0 ? (long)(sqrt(dn*dn + de*de) / leg.mps) : leg.sec;
+      if (leg.mps > 0) course = fmod(atan2(de, dn) * 180 / M_PI + 360, 360);
+      for (long i = 0; (i < sec) && (s < 86400); i++) at(n + dn * i / sec, e + de * i / sec, leg.mps);
+      n = leg.north; e = leg.east;
+    }
+    while (s < 86400) at(n, e, 0); // parked till midnight
+  }
+  return fixes;
+}
+
+static int dm(char* buf, int maxlen, double deg, int degDigits, char pos, char neg)
+{
+  double a = fabs(deg);
+  int d = (int)a;
+  long m = lround((a - d) * 6000000.0);
+  if (m >= 6000000L) { d++; m -= 6000000L; }
+  return snprintf(buf, maxlen, "%0*d%02ld.%05ld,%c", degDigits, d, m / 100000L, m % 100000L, (deg < 0) ? neg : pos);
+}
+
+static std::string rmcLine(const Pt& p)
+{
+  time_t t = p.t;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char lat[24], lon[24], body[160], line[176];
+  dm(lat, sizeof(lat), p.lat, 2, 'N', 'S');
+  dm(lon, sizeof(lon), p.lon, 3, 'E', 'W');
+  snprintf(body, sizeof(body), "GNRMC,%02d%02d%02d.00,A,%s,%s,%.3f,%.1f,%02d%02d%02d,,,A",
+    tm.tm_hour, tm.tm_min, tm.tm_sec, lat, lon, p.kts, p.course, tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+  uint8_t sum = 0;
+  for (const char* c = body; *c; c++) sum ^= *c;
+  snprintf(line, sizeof(line), "$%s*%02X", body, sum);
+  return line;
+}
+
+//----------------------------------------------------------------------------
+// the row formats
+//----------------------------------------------------------------------------
+#pragma pack(push, 1)
+struct Row { int32_t t, lat, lon; int16_t speed; };
+#pragma pack(pop)
+
+static size_t deflated(const uint8_t* p, size_t n)
+{
+  uLongf out = compressBound(n);
+  std::vector<uint8_t> buf(out);
+  compress2(buf.data(), &out, p, n, 9);
+  return out;
+}
+
+// every field of row delta, each fix to fn(t, lat, lon, speed)
+template <typename F> static void rowDeltaScan(const std::vector<uint8_t>& rd, F fn)
+{
+  const uint8_t* p = rd.data();
+  const uint8_t* end = p + rd.size();
+  int32_t v[SEG_COLS] = { 0, 0, 0, 0 };
+  while (p < end)
+  {
+    for (int c = 0; c < SEG_COLS; c++) v[c] += segGet(&p, end);
+    fn(v[0], v[1], v[2], v[3]);
+  }
+}
+
+template <typename F> static void textScan(const std::string& text, F fn)
+{
+  char line[256];
+  size_t at = 0;
+  while (at < text.size())
+  {
+    size_t eol = text.find('\r', at);
+    if (eol == std::string::npos) eol = text.size();
+    size_t len = eol - at;
+    if (len >= sizeof(line)) len = sizeof(line) - 1;
+    memcpy(line, text.data() + at, len);
+    line[len] = 0;
+    at = eol + 2;
+    GpsFix fix;
+    if (rmcParse(line, &fix) && fix.valid)
+      fn((int32_t)(fixEpoch(&fix) - SEG_EPOCH), (int32_t)lround(fix.lat * 1e6), (int32_t)lround(fix.lon * 1e6),
+         (int32_t)lround(fix.speedKts * 100));
+  }
+}
+
+template <typename F> static double usPer(int reps, F fn)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) fn();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+}
+
+static int agree = 0, disagree = 0;
+
+static void check(const char* what, long a, long b)
+{
+  if (a == b) agree++;
+  else { disagree++; printf("  %s differs: %ld vs %ld\n", what, a, b); }
+}
+
+int main(int argc, char** argv)
+{
+  const char* fn = NULL;
+  int days = 30;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-days") == 0) && (i + 1 < argc)) days = atoi(argv[++i]);
+    else fn = argv[i];
+  }
+
+  std::vector<std::string> lines;
+  if (fn)
+  {
+    FILE* fp = fopen(fn, "rb");
+    if (!fp) { perror(fn); return 1; }
+    char line[512];
+    while (fgets(line, sizeof(line), fp))
+    {
+      line[strcspn(line, "\r\n")] = 0;
+      if (nmeaIsType(line, "RMC")) lines.push_back(line);
+    }
+    fclose(fp);
+  }
+  else
+  {
+    for (const Pt& p : makeDays(days)) lines.push_back(rmcLine(p));
+  }
+
+  // the log, the segments (flushed each hour) and the row formats
+  std::string text;
+  std::vector<Row> rows;
+  std::vector<uint8_t> rowDelta;
+  int32_t prev[SEG_COLS] = { 0, 0, 0, 0 };
+  int lastHour = -1;
+  SPIFFS.remove(SEGFN);
+  segInit();
+  for (const std::string& l : lines)
+  {
+    GpsFix fix;
+    if (!rmcParse(l.c_str(), &fix) || !fix.valid) continue;
+    text += l + "\r\n";
+    if ((lastHour >= 0) && (fix.hour != lastHour)) segFlush();
+    lastHour = fix.hour;
+    segAddRmc(l.c_str());
+    Row r = { (int32_t)(fixEpoch(&fix) - SEG_EPOCH), (int32_t)lround(fix.lat * 1e6), (int32_t)lround(fix.lon * 1e6),
+              (int16_t)lround(fix.speedKts * 100) };
+    rows.push_back(r);
+    int32_t v[SEG_COLS] = { r.t, r.lat, r.lon, r.speed };
+    uint8_t b[SEG_COLS * SEG_VARINTMAX];
+    int n = 0;
+    for (int c = 0; c < SEG_COLS; c++) { n += segPut(b + n, v[c] - prev[c]); prev[c] = v[c]; }
+    rowDelta.insert(rowDelta.end(), b, b + n);
+  }
+  segFlush();
+  if (rows.empty()) { fprintf(stderr, "no fixes\n"); return 1; }
+
+  File file = SPIFFS.open(SEGFN, FILE_READ);
+  std::vector<uint8_t> seg(file.size());
+  file.read(seg.data(), seg.size());
+  file.close();
+
+  size_t nFix = rows.size();
+  printf("%s: %zu fixes, %lu segments\n\n", fn ? fn : "built-in working days", nFix, segWritten);
+  printf("%-12s %10s %8s %14s %8s\n", "format", "bytes", "B/fix", "deflated", "B/fix");
+  auto sizeRow = [&](const char* name, const uint8_t* p, size_t n)
+  {
+    size_t z = deflated(p, n);
+    printf("%-12s %10zu %8.2f %14zu %8.2f\n", name, n, (double)n / nFix, z, (double)z / nFix);
+  };
+  sizeRow("text", (const uint8_t*)text.data(), text.size());
+  sizeRow("row", (const uint8_t*)rows.data(), rows.size() * sizeof(Row));
+  sizeRow("row delta", rowDelta.data(), rowDelta.size());
+  sizeRow("segments", seg.data(), seg.size());
+
+  // every column back
+  {
+    static int32_t col[SEG_MAXFIXES];
+    size_t i0 = 0;
+    long bad = 0;
+    File f = SPIFFS.open(SEGFN, FILE_READ);
+    SegHeader h;
+    while (segReadHeader(f, &h))
+    {
+      for (int c = 0; c < SEG_COLS; c++)
+      {
+        segReadColumn(f, &h, c, col);
+        for (int i = 0; i < h.count; i++)
+        {
+          const Row& r = rows[i0 + i];
+          int32_t want = (c == SEG_TIME) ? r.t : (c == SEG_LAT) ? r.lat : (c == SEG_LON) ? r.lon : r.speed;
+          if (col[i] != want) bad++;
+        }
+      }
+      i0 += h.count;
+      segSkip(f, &h);
+    }
+    f.close();
+    printf("\nDecoded back: %zu of %zu fixes, %ld values wrong\n", i0, nFix, bad);
+    if ((i0 != nFix) || bad) disagree++;
+  }
+
+  // the queries
+  int reps = (nFix > 100000) ? 3 : 20;
+  int32_t tFirst = rows.front().t, tLast = rows.back().t;
+  int32_t w0 = tFirst + (tLast - tFirst) / 2 - ((tFirst + (tLast - tFirst) / 2) % 86400) + 10*3600 + 1800; // a day from 10:30
+  int32_t w1 = w0 + 86400 - 1;
+  printf("\n%-22s %12s %12s %12s %12s %9s %9s\n", "query (us)", "text", "row", "row delta", "segments", "vs text", "vs delta");
+
+  auto line = [&](const char* name, double t, double r, double rd, double s)
+  {
+    printf("%-22s %12.1f %12.1f %12.1f %12.1f %8.0fx %8.1fx\n", name, t, r, rd, s, t / s, rd / s);
+  };
+
+  // top speed, all
+  {
+    int32_t a = 0, b = 0, c = 0, lo, hi = 0;
+    double tt = usPer(reps, [&] { a = INT32_MIN; textScan(text, [&](int32_t, int32_t, int32_t, int32_t s) { if (s > a) a = s; }); });
+    double tr = usPer(reps, [&] { b = INT32_MIN; for (const Row& r : rows) if (r.speed > b) b = r.speed; });
+    double trd = usPer(reps, [&] { c = INT32_MIN; rowDeltaScan(rowDelta, [&](int32_t, int32_t, int32_t, int32_t s) { if (s > c) c = s; }); });
+    double ts = usPer(reps * 50, [&] { segQuery(SEG_SPEED, -SEG_ALL, SEG_ALL, &lo, &hi); });
+    line("top speed", tt, tr, trd, ts);
+    check("top speed text", a, hi); check("top speed row", b, hi); check("top speed row delta", c, hi);
+    printf("%-22s %.2f kts, segments from the header %lu, decoded %lu\n", "", hi / 100.0, segFromHeader, segDecoded);
+  }
+
+  // bounding box, all
+  {
+    int32_t box[4], rb[4], lo, hi, lo2, hi2;
+    auto reset = [](int32_t* b) { b[0] = b[2] = INT32_MAX; b[1] = b[3] = INT32_MIN; };
+    auto add = [](int32_t* b, int32_t lat, int32_t lon)
+    {
+      if (lat < b[0]) b[0] = lat;
+      if (lat > b[1]) b[1] = lat;
+      if (lon < b[2]) b[2] = lon;
+      if (lon > b[3]) b[3] = lon;
+    };
+    double tt = usPer(reps, [&] { reset(box); textScan(text, [&](int32_t, int32_t la, int32_t lo, int32_t) { add(box, la, lo); }); });
+    double tr = usPer(reps, [&] { reset(rb); for (const Row& r : rows) add(rb, r.lat, r.lon); });
+    int32_t rdb[4];
+    double trd = usPer(reps, [&] { reset(rdb); rowDeltaScan(rowDelta, [&](int32_t, int32_t la, int32_t lo, int32_t) { add(rdb, la, lo); }); });
+    double ts = usPer(reps * 50, [&] { segQuery(SEG_LAT, -SEG_ALL, SEG_ALL, &lo, &hi); segQuery(SEG_LON, -SEG_ALL, SEG_ALL, &lo2, &hi2); });
+    line("bounding box", tt, tr, trd, ts);
+    int32_t sb[4] = { lo, hi, lo2, hi2 };
+    for (int i = 0; i < 4; i++) { check("box text", box[i], sb[i]); check("box row", rb[i], sb[i]); check("box row delta", rdb[i], sb[i]); }
+  }
+
+  // top speed, one day
+  {
+    int32_t a = 0, b = 0, c = 0, lo, hi = 0;
+    double tt = usPer(reps, [&] { a = INT32_MIN; textScan(text, [&](int32_t t, int32_t, int32_t, int32_t s) { if ((t >= w0) && (t <= w1) && (s > a)) a = s; }); });
+    double tr = usPer(reps, [&] { b = INT32_MIN; for (const Row& r : rows) if ((r.t >= w0) && (r.t <= w1) && (r.speed > b)) b = r.speed; });
+    double trd = usPer(reps, [&] { c = INT32_MIN; rowDeltaScan(rowDelta, [&](int32_t t, int32_t, int32_t, int32_t s) { if ((t >= w0) && (t <= w1) && (s > c)) c = s; }); });
+    unsigned long n = 0;
+    double ts = usPer(reps * 50, [&] { n = segQuery(SEG_SPEED, w0, w1, &lo, &hi); });
+    line("top speed, one day", tt, tr, trd, ts);
+    if (n == 0) hi = INT32_MIN;
+    check("day speed text", a, hi); check("day speed row", b, hi); check("day speed row delta", c, hi);
+    printf("%-22s %lu fixes, segments from the header %lu, decoded %lu, skipped %lu\n", "", n, segFromHeader, segDecoded, segSkipped);
+  }
+
+  // mean speed - every value
+  {
+    long long a = 0, b = 0, c = 0, d = 0;
+    static int32_t col[SEG_MAXFIXES];
+    double tt = usPer(reps, [&] { a = 0; textScan(text, [&](int32_t, int32_t, int32_t, int32_t s) { a += s; }); });
+    double tr = usPer(reps, [&] { b = 0; for (const Row& r : rows) b += r.speed; });
+    double trd = usPer(reps, [&] { c = 0; rowDeltaScan(rowDelta, [&](int32_t, int32_t, int32_t, int32_t s) { c += s; }); });
+    double ts = usPer(reps, [&]
+    {
+      d = 0;
+      File f = SPIFFS.open(SEGFN, FILE_READ);
+      SegHeader h;
+      while (segReadHeader(f, &h))
+      {
+        segReadColumn(f, &h, SEG_SPEED, col);
+        for (int i = 0; i < h.count; i++) d += col[i];
+        segSkip(f, &h);
+      }
+      f.close();
+    });
+    line("mean speed", tt, tr, trd, ts);
+    check("mean text", a, d); check("mean row", b, d); check("mean row delta", c, d);
+    printf("%-22s %.2f kts, the speed column only\n", "", d / 100.0 / nFix);
+  }
+
+  printf("\nAnswers agree %d, differ %d\n", agree, disagree);
+  return disagree ? 1 : 0;
+}
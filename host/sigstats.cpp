@@ -0,0 +1,361 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Satellite signal statistics (GpsSignalService.h) - records checked
+// against a reference, and what the aggregation costs per line
+//----------------------------------------------------------------------------
+// NMEA goes through the real gpsService() -> signalLine(), with
+// signalMinute() on each minute of the fixes' time.  The interval records
+// that would go to /signal.log are printed and each one is checked
+// against a reference built the slow way (nmeaField() per field, every
+// C/N0 kept and sorted for the median).
+//
+// With no file it's a four hour sky:  GPS, GLONASS, Galileo and BeiDou
+// in NMEA 4.10 (GPS L5 and Galileo E5a as second signals, per system
+// $GNGSA with the system id), and after two hours the antenna goes bad -
+// C/N0 down 10 dB, the weak satellites lost.  Or a recorded NMEA file.
+//
+// Then the cost:  every line timed through signalLine(), against only
+// checking the checksum of the GSV/GSA lines (the least any use of them
+// would take), in ns per line on this PC.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/sigstats host/sigstats.cpp
+//   host/sigstats [recorded.log] [-v]
+//
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "HostArduino.h"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+#define SIGNALFN "/signal.log"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+#include "../GpsService.h"
+#include "../NmeaService.h"
+#include "../GpsSignalService.h"
+
+#define SIM_HOURS (4)
+#define SIM_FAULT_SEC (2*3600)   /* the antenna goes bad here */
+
+//----------------------------------------------------------------------------
+// the built-in sky
+//----------------------------------------------------------------------------
+struct SimSat { const char* talker; int prn; double elev0, rate; int base; int signal2; };
+
+static const std::vector<SimSat> sky = {
+  { "GP",  2, 60, 0.004, 46, 8 }, { "GP",  5, 35, 0.003, 42, 8 }, { "GP", 12, 15, 0.006, 34, 0 },
+  { "GP", 15, 70, 0.002, 47, 8 }, { "GP", 18, 25, 0.005, 39, 0 }, { "GP", 24, 45, 0.004, 44, 8 },
+  { "GP", 25, 10, 0.007, 30, 0 }, { "GP", 29, 55, 0.003, 45, 8 }, { "GP", 46, 30, 0.000, 38, 0 }, // SBAS
+  { "GL", 65, 50, 0.004, 43, 0 }, { "GL", 66, 20, 0.006, 36, 0 }, { "GL", 72, 65, 0.002, 45, 0 },
+  { "GL", 80, 12, 0.007, 31, 0 }, { "GL", 81, 40, 0.005, 41, 0 },
+  { "GA",  3, 55, 0.003, 44, 1 }, { "GA",  8, 30, 0.005, 40, 1 }, { "GA", 13, 18, 0.006, 35, 1 },
+  { "GA", 26, 62, 0.002, 46, 1 },
+  { "GB",  6, 48, 0.004, 42, 0 }, { "GB", 14, 22, 0.006, 36, 0 }, { "GB", 27, 66, 0.002, 45, 0 },
+  { "GB", 33, 35, 0.005, 40, 0 }, { "GB", 39, 14, 0.006, 32, 0 },
+};
+
+static std::string nmea(const char* body)
+{
+  uint8_t cs = 0;
+  for (const char* c = body; *c; c++) cs ^= *c;
+  char line[220];
+  snprintf(line, sizeof(line), "$%s*%02X", body, cs);
+  return line;
+}
+
+// one second of the receiver's output
+static std::vector<std::string> second(unsigned long sec, std::mt19937& rng)
+{
+  std::vector<std::string> out;
+  char body[200], t[16];
+  snprintf(t, sizeof(t), "%02lu%02lu%02lu.00", 9 + sec / 3600, (sec / 60) % 60, sec % 60);
+  int fault = sec >= SIM_FAULT_SEC;
+
+  // C/N0 per satellite this second, 0 = lost
+  std::vector<int> cn0(sky.size());
+  for (size_t i = 0; i < sky.size(); i++)
+  {
+    const SimSat& s = sky[i];
+    double elev = s.elev0 + 20 * sin(sec * s.rate / 60.0 + i);
+    int c = s.base + (int)((elev - s.elev0) / 8) + (int)(rng() % 5) - 2 - (fault ? 10 : 0);
+    cn0[i] = (c < 24) ? 0 : c;
+  }
+
+  snprintf(body, sizeof(body), "GNRMC,%s,A,4745.12336,N,12212.56760,W,0.02,,151123,,,A", t);
+  out.push_back(nmea(body));
+  snprintf(body, sizeof(body), "GNGGA,%s,4745.12336,N,12212.56760,W,1,12,0.9,52.0,M,-18.0,M,,", t);
+  out.push_back(nmea(body));
+
+  // GSA per system, the used satellites (tracked above 30) and the DOP
+  const char* talkers[4] = { "GP", "GL", "GA", "GB" };
+  int used = 0;
+  for (size_t i = 0; i < sky.size(); i++) used += (cn0[i] >= 30) && (sky[i].prn < 33 || sky[i].prn > 64);
+  double hdop = 0.7 + 4.0 / (used + 1), pdop = hdop * 1.6, vdop = hdop * 1.3;
+  for (int sys = 0; sys < 4; sys++)
+  {
+    int n = snprintf(body, sizeof(body), "GNGSA,A,3");
+    int k = 0;
+    for (size_t i = 0; i < sky.size(); i++)
+      if (!strcmp(sky[i].talker, talkers[sys]) && (cn0[i] >= 30) && (sky[i].prn < 33 || sky[i].prn > 64) && (k < 12))
+      {
+        n += snprintf(body + n, sizeof(body) - n, ",%02d", sky[i].prn);
+        k++;
+      }
+    for (; k < 12; k++) n += snprintf(body + n, sizeof(body) - n, ",");
+    snprintf(body + n, sizeof(body) - n, ",%.1f,%.1f,%.1f,%d", pdop, hdop, vdop, sys + 1);
+    out.push_back(nmea(body));
+  }
+
+  // GSV per system and signal, four satellites a message
+  for (int sys = 0; sys < 4; sys++)
+  {
+    for (int sig = 0; sig < 2; sig++)
+    {
+      std::vector<size_t> sats;
+      for (size_t i = 0; i < sky.size(); i++)
+        if (!strcmp(sky[i].talker, talkers[sys]) && ((sig == 0) || sky[i].signal2)) sats.push_back(i);
+      if (sats.empty()) continue;
+      int primary = (sys == 2) ? 7 : 1;
+      int signal = sig ? sky[sats[0]].signal2 : primary;
+      int msgs = (sats.size() + 3) / 4;
+      for (int m = 0; m < msgs; m++)
+      {
+        int n = snprintf(body, sizeof(body), "%sGSV,%d,%d,%02zu", talkers[sys], msgs, m + 1, sats.size());
+        for (size_t j = m * 4; (j < sats.size()) && (j < (size_t)m * 4 + 4); j++)
+        {
+          const SimSat& s = sky[sats[j]];
+          int c = sig ? (cn0[sats[j]] ? cn0[sats[j]] - 4 : 0) : cn0[sats[j]];
+          n += snprintf(body + n, sizeof(body) - n, ",%02d,%02d,%03d,", s.prn, (int)s.elev0, (int)(s.prn * 37) % 360);
+          if (c > 0) n += snprintf(body + n, sizeof(body) - n, "%02d", c);
+        }
+        snprintf(body + n, sizeof(body) - n, ",%d", signal);
+        out.push_back(nmea(body));
+      }
+    }
+  }
+  return out;
+}
+
+//----------------------------------------------------------------------------
+// the reference - nmeaField() per field, every C/N0 kept
+//----------------------------------------------------------------------------
+struct Reference
+{
+  std::vector<int> cn0;
+  std::map<int, std::pair<unsigned long, unsigned long>> viewTracked; // per cycle system
+  std::map<int, unsigned long> cycles;
+  std::map<int, std::pair<int, int>> cycle;
+  std::vector<int> usedPerEpoch;
+  int usedNow = 0;
+  bool inGsa = false;
+  std::vector<float> pdop, hdop, vdop;
+  unsigned long lines = 0;
+
+  static int sys(const char* line)
+  {
+    std::string t(line + 1, 2);
+    if (t == "GP") return 0;
+    if (t == "GL") return 1;
+    if (t == "GA") return 2;
+    if ((t == "GB") || (t == "BD")) return 3;
+    if (t == "GQ") return 4;
+    if (t == "GI") return 5;
+    return -1;
+  }
+
+  void epochDone()
+  {
+    if (inGsa) usedPerEpoch.push_back(usedNow);
+    inGsa = false;
+  }
+
+  void line(const char* l)
+  {
+    bool gsa = nmeaIsType(l, "GSA"), gsv = nmeaIsType(l, "GSV");
+    if (!gsa) epochDone();
+    if ((!gsa && !gsv) || !nmeaChecksumOk(l)) return;
+    lines++;
+    char f[16];
+    int nf = 0;
+    while (nmeaField(l, nf + 1, f, sizeof(f)) >= 0) nf++;
+    if (gsa)
+    {
+      if (!inGsa) usedNow = 0;
+      inGsa = true;
+      for (int i = 3; i <= 14; i++) if ((nmeaField(l, i, f, sizeof(f)) > 0) && (atoi(f) > 0)) usedNow++;
+      float d[3];
+      for (int i = 0; i < 3; i++) { nmeaField(l, 15 + i, f, sizeof(f)); d[i] = f[0] ? atof(f) : -1; }
+      if ((d[0] > 0) && (d[1] > 0) && (d[2] > 0) && (d[0] < 99)) { pdop.push_back(d[0]); hdop.push_back(d[1]); vdop.push_back(d[2]); }
+      return;
+    }
+    int s = sys(l);
+    int cs = (s < 0) ? 0 : s;
+    if ((nf - 3) % 4 == 1)
+    {
+      nmeaField(l, nf, f, sizeof(f));
+      if (f[0] && (atoi(f) != ((cs == 2) ? 7 : 1))) return;
+    }
+    nmeaField(l, 1, f, sizeof(f)); int total = atoi(f);
+    nmeaField(l, 2, f, sizeof(f)); int num = atoi(f);
+    if (num == 1) cycle[cs] = { 0, 0 };
+    for (int i = 0; i < (nf - 3) / 4; i++)
+    {
+      nmeaField(l, 4 + i*4, f, sizeof(f));
+      int prn = atoi(f);
+      if (prn <= 0) continue;
+      if ((s == 0 || s < 0) && !((prn <= 64) || (s < 0 && prn <= 96) || (prn >= 193 && prn <= 202))) continue;
+      cycle[cs].first++;
+      nmeaField(l, 7 + i*4, f, sizeof(f));
+      int c = atoi(f);
+      if (c <= 0) continue;
+      cycle[cs].second++;
+      cn0.push_back(std::min(c, 63));
+    }
+    if ((total > 0) && (num == total))
+    {
+      viewTracked[cs].first += cycle[cs].first;
+      viewTracked[cs].second += cycle[cs].second;
+      cycles[cs]++;
+    }
+  }
+
+  std::string record(const char* time)
+  {
+    if (lines == 0) return "";
+    epochDone();
+    std::sort(cn0.begin(), cn0.end());
+    int mn = cn0.empty() ? 0 : cn0.front(), md = cn0.empty() ? 0 : cn0[(cn0.size() - 1) / 2], mx = cn0.empty() ? 0 : cn0.back();
+    int umin = 99;
+    unsigned long usum = 0;
+    for (int u : usedPerEpoch) { umin = std::min(umin, u); usum += u; }
+    auto mean = [](const std::vector<float>& v) { float s = 0; for (float x : v) s += x; return v.empty() ? 0 : s / v.size(); };
+    char r[200];
+    int n = snprintf(r, sizeof(r), "%s,SIG,%d,%d,%d,%zu,%d,%.1f,%.1f,%.1f,%.1f,", time, mn, md, mx, cn0.size(),
+      usedPerEpoch.empty() ? 0 : umin, usedPerEpoch.empty() ? 0 : (float)usum / usedPerEpoch.size(),
+      mean(pdop), mean(hdop), mean(vdop));
+    const char letters[] = "GREBQS";
+    for (int s = 0; s < 6; s++)
+    {
+      if (!cycles[s]) continue;
+      n += snprintf(r + n, sizeof(r) - n, "%s%c%lu/%lu", (r[n-1] == ',') ? "" : " ", letters[s],
+        (viewTracked[s].second + cycles[s] / 2) / cycles[s], (viewTracked[s].first + cycles[s] / 2) / cycles[s]);
+    }
+    *this = Reference();
+    return r;
+  }
+};
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  const char* fn = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else fn = argv[i];
+  }
+
+  // all the lines, with the second of the run they belong to
+  std::vector<std::pair<long, std::string>> lines;
+  if (fn)
+  {
+    FILE* fp = fopen(fn, "rb");
+    if (!fp) { perror(fn); return 1; }
+    char line[512];
+    long sec = -1;
+    while (fgets(line, sizeof(line), fp))
+    {
+      line[strcspn(line, "\r\n")] = 0;
+      GpsFix fix;
+      if (rmcParse(line, &fix)) sec = fixDaySeconds(&fix);
+      if (sec >= 0) lines.push_back({ sec, line });
+    }
+    fclose(fp);
+  }
+  else
+  {
+    std::mt19937 rng(3);
+    for (unsigned long s = 0; s < SIM_HOURS * 3600UL; s++)
+      for (const std::string& l : second(s, rng)) lines.push_back({ (long)(9*3600 + s), l });
+  }
+  if (lines.empty()) { fprintf(stderr, "no lines\n"); return 1; }
+
+  printf("%s: %zu lines, a record every %d min\n", fn ? fn : "four hour sky, antenna bad after two",
+    lines.size(), sigIntervalMin);
+
+  // records, service vs reference
+  rtc.setTime(0, 0, 0, 15, 11, 2023);
+  unsigned long day = rtc.getEpoch();
+  gpsInit(9600);
+  signalInit();
+  Reference ref;
+  long lastMin = lines[0].first / 60;
+  int records = 0, match = 0;
+  for (size_t i = 0; i <= lines.size(); i++)
+  {
+    long min = (i < lines.size()) ? lines[i].first / 60 : lastMin + sigIntervalMin;
+    while (lastMin != min) // minute ticks
+    {
+      lastMin = (lastMin + 1) % 1440;
+      rtc.setTime(day + lastMin * 60, 0);
+      char t[32];
+      snprintf(t, sizeof(t), "%s", rtc.getTime("%Y/%m/%d,%H:%M:%S").c_str());
+      int before = sigRecordCount;
+      if ((sigMinutes + 1 >= sigIntervalMin))
+      {
+        std::string want = ref.record(t);
+        signalMinute();
+        if (sigRecordCount != before)
+        {
+          records++;
+          std::string got = sigRecords[sigRecordCount - 1];
+          if (got == want) match++;
+          else printf("  reference %s\n", want.c_str());
+          printf("  %s\n", got.c_str());
+        }
+      }
+      else signalMinute();
+      if (sigRecordCount == SIG_RECORDS) sigRecordCount = 0; // no flushing here
+    }
+    if (i == lines.size()) break;
+    const std::string& l = lines[i].second;
+    GPSPORT.feed(l.data(), l.size());
+    GPSPORT.feed("\r\n", 2);
+    while (GPSPORT.available())
+    {
+      char* line = gpsService();
+      if (line == NULL) continue;
+      signalLine(line);
+      ref.line(line);
+    }
+  }
+  printf("%d records, %d match the reference, GSV %lu GSA %lu bad %lu\n", records, match,
+    sigGsvLines, sigGsaLines, sigBadLines);
+
+  // the cost per line
+  std::vector<std::string> plain;
+  for (auto& p : lines) plain.push_back(p.second);
+  int reps = std::max(1, (int)(2000000 / plain.size()));
+  volatile unsigned long sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++)
+    for (const std::string& l : plain)
+    {
+      const char* c = l.c_str();
+      if ((c[3] == 'G') && (c[4] == 'S') && ((c[5] == 'V') || (c[5] == 'A'))) sink += nmeaChecksumOk(c);
+    }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; r++)
+    for (const std::string& l : plain) signalLine(l.c_str());
+  auto t2 = std::chrono::steady_clock::now();
+  double n = (double)reps * plain.size();
+  double floorNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+  double sigNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+  printf("cost per line: checksum only %.1f ns, signalLine() %.1f ns (%.2fx)\n", floorNs, sigNs, sigNs / floorNs);
+  return 0;
+}
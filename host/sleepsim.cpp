@@ -0,0 +1,359 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Parked deep sleep (SleepService.h) over a day - state carried through
+// the resets, log the same as staying awake
+//----------------------------------------------------------------------------
+// The logger's part of setup() and loop() that matters here - GPS input,
+// motion, scheduler, location log and the sleep service - runs on the
+// virtual clock against the simulated receiver of SimReceiver.h, once
+// staying awake (SLEEPAFTERMIN=0) and once deep sleeping when parked.
+//
+// A deep sleep here is a reset:  every global of those services goes back
+// to its initial value (all that's in RAM after one), the clock loses its
+// time, GPS bytes during the sleep go nowhere, then setup() runs with the
+// timer as the wake cause.  Right after sleepFastWake() every carried
+// value is checked against what it was going to sleep (the clock against
+// the epoch plus the timer, the statistics with the sleep added).
+//
+// Per receiver type it reports ESP32 awake hours, deep sleeps, fast wakes,
+// carried-state mismatches, and whether location.log came out identical
+// to the awake run.  Then the full-boot fallbacks:  power on, a bad CRC,
+// another layout and a bad journal length must not fast wake.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -o host/sleepsim host/sleepsim.cpp
+//   host/sleepsim [recorded.log] [-after min] [-v]
+//
+#include <algorithm>
+#include "HostArduino.h"
+
+#define GPSPORT Serial2
+#define GPSESP_RXD_PIN (16)
+#define GPSESP_TXD_PIN (17)
+#define LOGFN "/location.log"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+long baudRate = 9600;
+int ntpDone = false;
+char rmcbuf[128];
+
+static std::vector<std::string> events;
+void logMessage(char* msg)
+{
+  events.push_back(msg);
+  if (Serial.echo) Serial.println(msg);
+}
+
+#include "../GpsService.h"
+#include "../NmeaService.h"
+
+// only aidType is wanted from GpsAidService.h
+#define AIDTYPE_NONE  (0)
+#define AIDTYPE_UBX   (1)
+#define AIDTYPE_CASIC (2)
+#define AIDTYPE_PMTK  (3)
+int aidType = AIDTYPE_NONE;
+
+#include "../MotionService.h"
+#include "../SchedulerService.h"
+#include "../GpsLogService.h"
+#include "../SleepService.h"
+#include "SimReceiver.h"
+
+#define SIM_PARKMIN (10)
+#define SIM_WAKEMIN (5)
+
+//----------------------------------------------------------------------------
+// what went to sleep, to check against what woke up
+//----------------------------------------------------------------------------
+struct Carried
+{
+  unsigned long epoch;
+  int lastHr, lastDay, ntpDone;
+  long baudRate;
+  int aidType, parkMin, wakeMin, afterMin, motionState;
+  double parkLat, parkLon;
+  unsigned long motionSec[MOTION_STATES], motionBytes[MOTION_STATES];
+  unsigned long sleeps, wakes, wokeMoved, parkedSec, deepSleeps, fastWakes, sleptSec;
+  std::string rmc, journal;
+};
+
+static Carried snapshot(unsigned long sleepSec)
+{
+  Carried c;
+  c.epoch = rtc.getEpoch() + sleepSec;
+  c.lastHr = lastHr; c.lastDay = lastDay;
+  c.ntpDone = ntpDone;
+  c.baudRate = baudRate;
+  c.aidType = aidType;
+  c.parkMin = motionParkMin; c.wakeMin = motionWakeMin; c.afterMin = sleepAfterMin;
+  c.motionState = motionState;
+  c.parkLat = motionParkLat; c.parkLon = motionParkLon;
+  for (int i = 0; i < MOTION_STATES; i++)
+  {
+    c.motionSec[i] = motionSec[i] + (i == MOTION_PARKED ? sleepSec : 0);
+    c.motionBytes[i] = motionBytes[i];
+  }
+  c.sleeps = motionSleeps; c.wakes = motionWakes; c.wokeMoved = motionWokeMoved;
+  c.parkedSec = sleepParkedSec + sleepSec;
+  c.deepSleeps = sleepDeepSleeps;
+  c.fastWakes = sleepFastWakes + 1;
+  c.sleptSec = sleepSleptSec + sleepSec;
+  c.rmc = rmcbuf;
+  c.journal.assign(logbuffer, bufferWritePosition);
+  return c;
+}
+
+static int compare(const Carried& c)
+{
+  int bad = 0;
+  auto check = [&](bool ok, const char* what) { if (!ok) { bad++; if (Serial.echo) printf("  carried %s wrong\n", what); } };
+  check(rtc.getEpoch() == c.epoch, "clock");
+  check((lastSec == rtc.getSecond()) && (lastMin == rtc.getMinute()) && (lastHr == c.lastHr) && (lastDay == c.lastDay),
+    "scheduler");
+  check(ntpDone == c.ntpDone, "ntpDone");
+  check((baudRate == c.baudRate) && (aidType == c.aidType) && (motionParkMin == c.parkMin) &&
+        (motionWakeMin == c.wakeMin) && (sleepAfterMin == c.afterMin), "settings");
+  check((motionState == c.motionState) && (motionParkLat == c.parkLat) && (motionParkLon == c.parkLon), "motion state");
+  check(!memcmp(motionSec, c.motionSec, sizeof(motionSec)) && !memcmp(motionBytes, c.motionBytes, sizeof(motionBytes)),
+    "motion statistics");
+  check((motionSleeps == c.sleeps) && (motionWakes == c.wakes) && (motionWokeMoved == c.wokeMoved), "motion counts");
+  check((sleepParkedSec == c.parkedSec) && (sleepDeepSleeps == c.deepSleeps) && (sleepFastWakes == c.fastWakes) &&
+        (sleepSleptSec == c.sleptSec), "sleep statistics");
+  check(c.rmc == rmcbuf, "last RMC");
+  check(c.journal == std::string(logbuffer, bufferWritePosition), "journal");
+  return bad;
+}
+
+//----------------------------------------------------------------------------
+// a reset:  the C startup puts every global back to its initial value, the
+// clock is gone, the UART starts empty
+//----------------------------------------------------------------------------
+static void reset()
+{
+  lastSec = lastMin = lastHr = lastDay = -1;
+  ntpDone = false;
+  baudRate = 0;
+  aidType = AIDTYPE_NONE;
+  motionParkMin = 10;
+  motionWakeMin = 5;
+  sleepAfterMin = 20;
+  motionState = MOTION_STATIONARY;
+  motionApplied = -1;
+  motionStateSec = motionCondSec = 0;
+  motionFixSeen = motionFixValid = false;
+  motionKts = 0;
+  motionLat = motionLon = motionParkLat = motionParkLon = 0;
+  motionWakeAt = 0;
+  memset(motionSec, 0, sizeof(motionSec));
+  memset(motionBytes, 0, sizeof(motionBytes));
+  motionSleeps = motionWakes = motionWokeMoved = 0;
+  motionTxLen = motionTxPos = 0;
+  sleepChecking = false;
+  sleepParkedSec = sleepDeepSleeps = sleepFastWakes = sleepSleptSec = sleepWakeMs = 0;
+  memset(logbuffer, 0, sizeof(logbuffer));
+  bufferWritePosition = 0;
+  rmcbuf[0] = '\0';
+  rtc.setTime(0);
+  GPSPORT = HostSerial();
+  GPSPORT.keepTx = true;
+}
+
+//----------------------------------------------------------------------------
+// the sketch, as far as these services go
+//----------------------------------------------------------------------------
+static void setupFull(int type, int afterMin)
+{
+  reset();
+  rtc.setTime(00,00,00, 15, 11, 2023); // as if NTP had it, the track's day
+  baudRate = 9600;
+  aidType = type;
+  motionParkMin = SIM_PARKMIN; // the config file
+  motionWakeMin = SIM_WAKEMIN;
+  sleepAfterMin = afterMin;
+  schedulerInit();
+  gpsLogInit();
+  gpsInit(baudRate);
+}
+
+// false = it wasn't a fast wake (a full boot would follow)
+static bool setupFast(const Carried& expect, int& mismatches)
+{
+  if (!sleepFastWake()) return false;
+  mismatches += compare(expect);
+  gpsInit(baudRate);
+  motionSetState(MOTION_WAKING);
+  return true;
+}
+
+static void gpsLines()
+{
+  while (GPSPORT.available())
+  {
+    char* line = gpsService();
+    if (line == NULL) continue;
+    motionLine(line);
+    if ((line[1] == 'G') && (line[3] == 'R') && (line[4] == 'M') && (line[5] == 'C')) strcpy(rmcbuf, line);
+  }
+}
+
+static void timedTasks()
+{
+  if (minuteDetector())
+  {
+    if (!motionParked()) gpsLogLine(rmcbuf);
+  }
+  if (hourDetector()) gpsLogFlush();
+  dayDetector();
+}
+
+static void loopOnce()
+{
+  gpsLines();
+  motionTxService();
+  if (secondDetector())
+  {
+    motionService();
+    if (sleepChecking)
+    {
+      if (motionState == MOTION_PARKED) sleepEnter();
+      else if (motionState != MOTION_WAKING) sleepChecking = false; // setupResume()
+    }
+    else if (sleepWanted(true)) sleepEnter();
+    if (hostSleepStarted) return;
+  }
+  timedTasks();
+}
+
+//----------------------------------------------------------------------------
+// one receiver type over the track, awake or sleeping when parked
+//----------------------------------------------------------------------------
+struct Result
+{
+  std::string log;
+  unsigned long espAwakeMs = 0, deepSleeps = 0, fastWakes = 0, fullBoots = 0, events = 0;
+  int mismatches = 0;
+};
+
+static Result run(int type, const std::vector<Point>& track, int afterMin)
+{
+  Result r;
+  hostMicros = 0;
+  fileSystem.format();
+  events.clear();
+  hostWakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  hostSleepStarted = false;
+  memset(&sleepRtc, 0, sizeof(sleepRtc));
+  setupFull(type, afterMin);
+  r.fullBoots++;
+
+  SimReceiver rx;
+  rx.type = type;
+  rx.powerOn();
+
+  bool asleep = false;
+  uint64_t wakeAt = 0;
+  Carried expect;
+  // the track goes by the clock, going to sleep takes a moment too
+  for (unsigned long sec; (sec = hostMicros / 1000000) < track.size(); )
+  {
+    rx.tick(track[sec], sec);
+    if (asleep && (hostMicros >= wakeAt))
+    {
+      asleep = false;
+      reset();
+      hostWakeCause = ESP_SLEEP_WAKEUP_TIMER;
+      if (setupFast(expect, r.mismatches)) r.fastWakes++;
+      else { setupFull(type, afterMin); r.fullBoots++; }
+    }
+    if (!asleep)
+    {
+      r.espAwakeMs++;
+      loopOnce();
+      if (hostSleepStarted)
+      {
+        hostSleepStarted = false;
+        r.deepSleeps++;
+        expect = snapshot(hostSleepUs / 1000000);
+        asleep = true;
+        wakeAt = hostMicros + hostSleepUs;
+      }
+    }
+    if (!GPSPORT.txData.empty())
+    {
+      rx.fromLogger(GPSPORT.txData);
+      GPSPORT.txData.clear();
+    }
+    delay(1);
+  }
+  if (asleep) { reset(); hostWakeCause = ESP_SLEEP_WAKEUP_TIMER; setupFast(expect, r.mismatches); }
+  gpsLogFlush();
+  File f = fileSystem.open(LOGFN, FILE_READ);
+  while (f && f.available()) r.log += (char)f.read();
+  r.events = events.size();
+  return r;
+}
+
+//----------------------------------------------------------------------------
+// RTC state that must not fast wake
+//----------------------------------------------------------------------------
+static void fallbacks()
+{
+  struct Case { const char* name; int cause; void (*spoil)(); bool wake; };
+  static const Case cases[] = {
+    { "timer wake, good state",  ESP_SLEEP_WAKEUP_TIMER,     [](){},                                          true },
+    { "power on",                ESP_SLEEP_WAKEUP_UNDEFINED, [](){},                                          false },
+    { "journal byte flipped",    ESP_SLEEP_WAKEUP_TIMER,     [](){ sleepRtc.journal[5] ^= 1; },               false },
+    { "another layout",          ESP_SLEEP_WAKEUP_TIMER,     [](){ sleepRtc.size += 4; },                     false },
+    { "bad journal length",      ESP_SLEEP_WAKEUP_TIMER,     [](){ sleepRtc.journalLen = SLEEP_JOURNALMAX + 1;
+                                                                   sleepRtc.crc = sleepRtcCrc(); },           false },
+    { "never slept (zeroed)",    ESP_SLEEP_WAKEUP_TIMER,     [](){ memset(&sleepRtc, 0, sizeof(sleepRtc)); }, false },
+  };
+  int ok = 0;
+  for (const Case& c : cases)
+  {
+    setupFull(AIDTYPE_UBX, 20);
+    gpsLogLine("$GNRMC,120000.000,A,4745.1236,N,12212.5676,W,0.00,0.0,151123,,,A*5E");
+    sleepSave(300);
+    c.spoil();
+    reset();
+    hostWakeCause = (esp_sleep_wakeup_cause_t)c.cause;
+    bool woke = sleepFastWake();
+    ok += woke == c.wake;
+    printf("  %-26s %-10s %s\n", c.name, woke ? "fast wake" : "full boot", woke == c.wake ? "OK" : "WRONG");
+  }
+  printf("fallbacks %d/%d OK, RTC state %zu bytes\n", ok, (int)(sizeof(cases) / sizeof(cases[0])), sizeof(SleepRtc));
+}
+
+int main(int argc, char** argv)
+{
+  const char* fn = NULL;
+  int afterMin = 20;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else if ((strcmp(argv[i], "-after") == 0) && (i+1 < argc)) afterMin = atoi(argv[++i]);
+    else fn = argv[i];
+  }
+  std::vector<Point> track = fn ? readTrack(fn) : makeTrack();
+  if (track.empty()) { fprintf(stderr, "no fixes in %s\n", fn); return 1; }
+  printf("%s: %.1f hours, park after %d min, wake every %d min, deep sleep after %d min parked\n",
+    fn ? fn : "working day", track.size() / 3600.0, SIM_PARKMIN, SIM_WAKEMIN, afterMin);
+  printf("%-8s %9s %9s %7s %7s %6s %6s %10s %s\n", "receiver", "awake h", "sleep h", "sleeps", "fast", "full",
+    "wrong", "log lines", "log");
+  const char* names[] = { "default", "UBX", "CASIC", "PMTK" };
+  double days = track.size() / 86400.0;
+  for (int type = AIDTYPE_UBX; type <= AIDTYPE_PMTK; type++)
+  {
+    Result awake = run(type, track, 0);
+    Result sleep = run(type, track, afterMin);
+    unsigned long lines = std::count(sleep.log.begin(), sleep.log.end(), '\n');
+    printf("%-8s %9.1f %9.1f %7lu %7lu %6lu %6d %10lu %s\n", names[type], awake.espAwakeMs / 3.6e6 / days,
+      sleep.espAwakeMs / 3.6e6 / days, sleep.deepSleeps, sleep.fastWakes, sleep.fullBoots, sleep.mismatches,
+      lines, sleep.log == awake.log ? "identical" : "DIFFERENT");
+  }
+  fallbacks();
+  return 0;
+}
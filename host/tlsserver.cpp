@@ -0,0 +1,323 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Local HTTPS upload stand-in server, and full vs resumed handshake bench
+//----------------------------------------------------------------------------
+// Server mode - point the logger's UPLOADURL at it:
+//
+//   host/tlsserver [-p 8443] [-d outdir] [-cert cert.pem -key key.pem]
+//   UPLOADURL=https://<pc address>:8443/gpslogs/
+//
+// It prints its certificate's UPLOADSHA256= line for config.ini (the
+// logger won't send credentials to a server it can't check).
+// It accepts HTTPS PUTs, writes the body to outdir/<name>, answers
+// 201 Created, and prints for each connection whether the client resumed
+// its session and how many bytes / ms the handshake took.  Without -cert
+// a throw-away RSA-2048 self-signed certificate is made at start up.
+// TLS 1.2 only, like mbedtls 2.x on the ESP32;  session ID cache and
+// session tickets are both on.
+//
+// Bench mode - client and server both on this PC over loopback:
+//
+//   host/tlsserver -bench 50
+//
+// does 50 uploads offering the previous session and 50 without, and
+// prints mean handshake time and bytes for full and resumed handshakes.
+// Handshake bytes are the same on the ESP32;  the times are x86 times, the
+// ESP32 ones are in the event log ("TLS full handshake ... ms").
+//
+// Build (needs libssl-dev):
+//   g++ -std=c++17 -O2 -o host/tlsserver host/tlsserver.cpp -lssl -lcrypto -pthread
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+
+static double nowMs()
+{
+  return std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------------------------------
+// server side
+//----------------------------------------------------------------------------
+static SSL_CTX* makeServerCtx(const char* certfn, const char* keyfn)
+{
+  SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context(ctx, (const unsigned char*)"gpslogger", 9);
+
+  if (certfn && keyfn)
+  {
+    if ((SSL_CTX_use_certificate_chain_file(ctx, certfn) != 1) ||
+        (SSL_CTX_use_PrivateKey_file(ctx, keyfn, SSL_FILETYPE_PEM) != 1))
+    {
+      ERR_print_errors_fp(stderr);
+      exit(1);
+    }
+    return ctx;
+  }
+
+  // throw-away self-signed certificate
+  EVP_PKEY* key = EVP_RSA_gen(2048);
+  X509* cert = X509_new();
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 365L*24*3600);
+  X509_set_pubkey(cert, key);
+  X509_NAME* name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"gpslogger-standin", -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  X509_sign(cert, key, EVP_sha256());
+  SSL_CTX_use_certificate(ctx, cert);
+  SSL_CTX_use_PrivateKey(ctx, key);
+  X509_free(cert);
+  EVP_PKEY_free(key);
+  return ctx;
+}
+
+static int listenOn(int port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if ((bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) || (listen(fd, 16) < 0))
+  {
+    perror("listen");
+    exit(1);
+  }
+  return fd;
+}
+
+// read an HTTP request head, return the body bytes that came along with it
+static bool readHead(SSL* ssl, std::string& head, std::string& body)
+{
+  char buf[4096];
+  for (;;)
+  {
+    size_t eoh = head.find("\r\n\r\n");
+    if (eoh != std::string::npos)
+    {
+      body = head.substr(eoh + 4);
+      head.resize(eoh);
+      return true;
+    }
+    int n = SSL_read(ssl, buf, sizeof(buf));
+    if (n <= 0) return false;
+    head.append(buf, n);
+  }
+}
+
+static void serveOne(SSL_CTX* ctx, int fd, const char* outdir, bool quiet)
+{
+  SSL* ssl = SSL_new(ctx);
+  SSL_set_fd(ssl, fd);
+  double t0 = nowMs();
+  if (SSL_accept(ssl) != 1)
+  {
+    if (!quiet) ERR_print_errors_fp(stderr);
+    SSL_free(ssl);
+    close(fd);
+    return;
+  }
+  double ms = nowMs() - t0;
+  BIO* bio = SSL_get_rbio(ssl);
+  unsigned long hsIn = BIO_number_read(bio), hsOut = BIO_number_written(bio);
+
+  std::string head, body;
+  std::string name = "upload.log";
+  long contentLength = 0;
+  int status = 400;
+  if (readHead(ssl, head, body) && (head.compare(0, 4, "PUT ") == 0))
+  {
+    size_t sp = head.find(' ', 4);
+    std::string path = head.substr(4, sp - 4);
+    size_t slash = path.rfind('/');
+    if ((slash != std::string::npos) && (slash + 1 < path.size())) name = path.substr(slash + 1);
+    size_t cl = head.find("Content-Length:");
+    if (cl != std::string::npos) contentLength = atol(head.c_str() + cl + 15);
+
+    char buf[16384];
+    while ((long)body.size() < contentLength)
+    {
+      int n = SSL_read(ssl, buf, sizeof(buf));
+      if (n <= 0) break;
+      body.append(buf, n);
+    }
+    if ((long)body.size() >= contentLength)
+    {
+      std::string fn = std::string(outdir) + "/" + name;
+      FILE* fp = fopen(fn.c_str(), "wb");
+      if (fp)
+      {
+        fwrite(body.data(), 1, body.size(), fp);
+        fclose(fp);
+        status = 201;
+      }
+      else status = 500;
+    }
+  }
+  const char* reply = (status == 201) ? "HTTP/1.1 201 Created\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+                                      : "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  SSL_write(ssl, reply, strlen(reply));
+  SSL_shutdown(ssl);
+
+  if (!quiet)
+    printf("%s handshake %.1f ms, %lu bytes in, %lu bytes out, %s -> %d %s (%zu bytes)\n",
+      SSL_session_reused(ssl) ? "resumed" : "full   ", ms, hsIn, hsOut, SSL_get_cipher(ssl),
+      status, name.c_str(), body.size());
+  fflush(stdout);
+  SSL_free(ssl);
+  close(fd);
+}
+
+static void serve(SSL_CTX* ctx, int lfd, const char* outdir, int count, bool quiet)
+{
+  for (int i = 0; (count < 0) || (i < count); i++)
+  {
+    int fd = accept(lfd, NULL, NULL);
+    if (fd < 0) continue;
+    serveOne(ctx, fd, outdir, quiet);
+  }
+}
+
+//----------------------------------------------------------------------------
+// bench client - does what tlsPut() does on the ESP32
+//----------------------------------------------------------------------------
+struct HsStats { int n = 0; double ms = 0; unsigned long in = 0, out = 0; };
+
+static void benchUpload(SSL_CTX* ctx, int port, SSL_SESSION** session, const std::string& payload,
+                        HsStats& full, HsStats& resumed)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { perror("connect"); exit(1); }
+
+  SSL* ssl = SSL_new(ctx);
+  SSL_set_fd(ssl, fd);
+  if (*session) SSL_set_session(ssl, *session);
+  double t0 = nowMs();
+  if (SSL_connect(ssl) != 1) { ERR_print_errors_fp(stderr); exit(1); }
+  double ms = nowMs() - t0;
+  BIO* bio = SSL_get_rbio(ssl);
+  HsStats& st = SSL_session_reused(ssl) ? resumed : full;
+  st.n++;
+  st.ms += ms;
+  st.in += BIO_number_read(bio);
+  st.out += BIO_number_written(bio);
+
+  std::string req = "PUT /gpslogs/bench.log HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                    std::to_string(payload.size()) + "\r\nConnection: close\r\n\r\n";
+  SSL_write(ssl, req.data(), req.size());
+  SSL_write(ssl, payload.data(), payload.size());
+  char buf[256];
+  SSL_read(ssl, buf, sizeof(buf));
+
+  if (*session) SSL_SESSION_free(*session);
+  *session = SSL_get1_session(ssl);
+  SSL_shutdown(ssl);
+  SSL_free(ssl);
+  close(fd);
+}
+
+static void printStats(const char* what, const HsStats& st)
+{
+  if (st.n == 0) { printf("%-8s  -\n", what); return; }
+  printf("%-8s %4d  %8.2f ms  %6lu bytes in  %6lu bytes out\n",
+    what, st.n, st.ms / st.n, st.in / st.n, st.out / st.n);
+}
+
+static int bench(SSL_CTX* sctx, int port, int n, const char* outdir)
+{
+  int lfd = listenOn(port);
+  std::thread server(serve, sctx, lfd, outdir, 2*n, true);
+
+  SSL_CTX* cctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_max_proto_version(cctx, TLS1_2_VERSION);
+  SSL_CTX_set_session_cache_mode(cctx, SSL_SESS_CACHE_CLIENT);
+  std::string payload(24*60*70, 'x'); // a day of once-a-minute RMC lines
+
+  HsStats full, resumed, none, noneResumed;
+  SSL_SESSION* session = NULL;
+  for (int i = 0; i < n; i++) benchUpload(cctx, port, &session, payload, full, resumed);
+  for (int i = 0; i < n; i++)
+  {
+    SSL_SESSION* fresh = NULL;
+    benchUpload(cctx, port, &fresh, payload, none, noneResumed);
+    SSL_SESSION_free(fresh);
+  }
+  server.join();
+  close(lfd);
+  SSL_SESSION_free(session);
+
+  printf("offering the previous session (what tlsPut() does):\n");
+  printStats("full", full);
+  printStats("resumed", resumed);
+  printf("never offering a session:\n");
+  printStats("full", none);
+  if (full.n && resumed.n)
+    printf("resumed handshake: %.0f%% of the time, %.0f%% of the bytes of a full one\n",
+      100.0 * (resumed.ms / resumed.n) / (full.ms / full.n),
+      100.0 * ((resumed.in + resumed.out) / (double)resumed.n) / ((full.in + full.out) / (double)full.n));
+  SSL_CTX_free(cctx);
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  int port = 8443;
+  const char* outdir = ".";
+  const char* certfn = NULL;
+  const char* keyfn = NULL;
+  int benchN = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-p") == 0) && (i+1 < argc)) port = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-d") == 0) && (i+1 < argc)) outdir = argv[++i];
+    else if ((strcmp(argv[i], "-cert") == 0) && (i+1 < argc)) certfn = argv[++i];
+    else if ((strcmp(argv[i], "-key") == 0) && (i+1 < argc)) keyfn = argv[++i];
+    else if ((strcmp(argv[i], "-bench") == 0) && (i+1 < argc)) benchN = atoi(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [-p port] [-d outdir] [-cert cert.pem -key key.pem] [-bench n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  SSL_CTX* ctx = makeServerCtx(certfn, keyfn);
+  if (benchN > 0) return bench(ctx, port, benchN, outdir);
+
+  printf("HTTPS upload stand-in listening on port %d, writing to %s\n", port, outdir);
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int mdlen = 0;
+  X509_digest(SSL_CTX_get0_certificate(ctx), EVP_sha256(), md, &mdlen);
+  printf("UPLOADSHA256=");
+  for (unsigned int i = 0; i < mdlen; i++) printf("%02x", md[i]);
+  printf("\n");
+  fflush(stdout);
+  serve(ctx, listenOn(port), outdir, -1, false);
+  return 0;
+}
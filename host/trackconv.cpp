@@ -0,0 +1,495 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Batch track converter - stored logs to GPX, KML or GeoJSON, many files at
+// once
+//----------------------------------------------------------------------------
+// GPSBabel does a file a run;  a fleet's day is thousands.  This takes
+// every file named (folders for every file under them) and converts them
+// on a pool of threads, the biggest first, a file a thread at a time:
+//   NMEA        location.log, the uploads, any recorded NMEA - read a
+//               CONV_CHUNK at a time through NmeaBulk.h, the RMC with a
+//               fix and date the track points, the GGA of the same second
+//               their height
+//   .seg        TrackSegmentService.h segments (ingest.cpp, udpcollect.cpp,
+//               SegFiles.h), a segment at a time
+// Each thread writes through its own CONV_OUTBUF buffer straight to the
+// output file as it goes - nothing is built up in memory, whatever the
+// size of the input.  A gap of more than CONV_GAP seconds starts a new
+// track segment (<trkseg>, a Placemark, a Feature):
+//   gpx         <trk> of <trkseg> of <trkpt> with <ele> and <time>
+//   kml         a Placemark a segment, a LineString named by its start
+//   geojson     a FeatureCollection, a LineString Feature a segment, its
+//               start, end and fix count in the properties
+// Outputs go to <out>/ with the same relative path, the extension
+// changed.
+//
+// Without any inputs it makes a fleet's day - the logs ftpPut() leaves
+// once the overlaps are dropped (UploadFleet.h) and the segments of
+// segFleetGenerate() - and converts it to each format with 1, 2, 4 ... -t
+// threads, checking every file got every fix.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -pthread -o host/trackconv host/trackconv.cpp
+//   host/trackconv [file|folder ...] [-f gpx|kml|geojson] [-o outdir] [-t threads] [-loggers n] [-check]
+//
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "UploadFleet.h"
+#include "SegFiles.h"
+#include "NmeaBulk.h"
+
+namespace fsys = std::filesystem;
+
+#define CONV_CHUNK (1 << 20)          /* NMEA read this much at a time */
+#define CONV_OUTBUF (1 << 20)
+#define CONV_GAP (300)                /* seconds, a new segment after a longer gap */
+
+enum { FMT_GPX, FMT_KML, FMT_GEOJSON };
+static const char* fmtExt[] = { "gpx", "kml", "geojson" };
+
+//----------------------------------------------------------------------------
+// the writer
+//----------------------------------------------------------------------------
+struct Writer
+{
+  int fmt = FMT_GPX;
+  int fd = -1;
+  bool ok = true;
+  std::vector<char> buf;
+  size_t n = 0;
+  // the track so far
+  std::string name;
+  bool inSeg = false, firstSeg = true;
+  int32_t segStart = 0, lastT = 0, lastLat = 0, lastLon = 0, lastEle = 0;
+  bool lastHasEle = false;
+  long segFixes = 0, fixes = 0, segments = 0;
+  // ISO date of the day last written
+  int32_t dayKey = INT32_MIN;
+  char date[12];
+
+  Writer() : buf(CONV_OUTBUF + 512) {}
+
+  void flush()
+  {
+    const char* p = buf.data();
+    while (n > 0)
+    {
+      ssize_t w = write(fd, p, n);
+      if (w <= 0) { ok = false; break; }
+      p += w;
+      n -= w;
+    }
+    n = 0;
+  }
+  inline void room() { if (n >= CONV_OUTBUF) flush(); }
+  inline void put(const char* s, size_t len) { memcpy(&buf[n], s, len); n += len; }
+  inline void put(const char* s) { put(s, strlen(s)); }
+  void putText(const std::string& s) // XML / JSON safe enough for file names
+  {
+    for (char c : s)
+    {
+      if (c == '&') put("&amp;");
+      else if (c == '<') put("&lt;");
+      else if ((c == '"') || (c == '\\')) buf[n++] = '_';
+      else buf[n++] = c;
+      room();
+    }
+  }
+  inline void putInt(int64_t v)
+  {
+    char tmp[24];
+    int k = 0;
+    uint64_t u = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+    do { tmp[k++] = '0' + (u % 10); u /= 10; } while (u);
+    if (v < 0) buf[n++] = '-';
+    while (k) buf[n++] = tmp[--k];
+  }
+  inline void putFixed(int64_t v, int decimals, int64_t scale)
+  {
+    if (v < 0) { buf[n++] = '-'; v = -v; }
+    putInt(v / scale);
+    buf[n++] = '.';
+    int64_t frac = v % scale;
+    for (int i = decimals - 1; i >= 0; i--) { buf[n + i] = '0' + (frac % 10); frac /= 10; }
+    n += decimals;
+  }
+  // 2023-11-15T09:51:00Z
+  inline void putTime(int32_t t)
+  {
+    int32_t day = (t >= 0) ? t / 86400 : (t - 86399) / 86400, sec = t - day * 86400;
+    if (day != dayKey)
+    {
+      time_t tt = (time_t)day * 86400 + SEG_EPOCH;
+      struct tm tm;
+      gmtime_r(&tt, &tm);
+      snprintf(date, sizeof(date), "%04d-%02d-%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+      dayKey = day;
+    }
+    put(date, 10);
+    char hms[10] = { 'T', (char)('0' + sec / 36000), (char)('0' + sec / 3600 % 10), ':',
+                     (char)('0' + sec % 3600 / 600), (char)('0' + sec % 600 / 60), ':',
+                     (char)('0' + sec % 60 / 10), (char)('0' + sec % 10), 'Z' };
+    put(hms, 10);
+  }
+
+  bool open(const std::string& path, const std::string& trackName)
+  {
+    std::error_code ec;
+    fsys::create_directories(fsys::path(path).parent_path(), ec);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ok = (fd >= 0);
+    n = 0;
+    name = trackName;
+    inSeg = false;
+    firstSeg = true;
+    fixes = segments = 0;
+    if (!ok) return false;
+    if (fmt == FMT_GPX)
+    {
+      put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          "<gpx version=\"1.1\" creator=\"GpsLogger trackconv\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n<trk><name>");
+      putText(name);
+      put("</name>\n");
+    }
+    else if (fmt == FMT_KML)
+    {
+      put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document><name>");
+      putText(name);
+      put("</name>\n");
+    }
+    else put("{\"type\":\"FeatureCollection\",\"features\":[\n");
+    return true;
+  }
+
+  void point(int32_t lat, int32_t lon, bool hasEle, int32_t ele, int32_t t)
+  {
+    if (fmt == FMT_GPX)
+    {
+      put("<trkpt lat=\"");
+      putFixed(lat, 6, 1000000);
+      put("\" lon=\"");
+      putFixed(lon, 6, 1000000);
+      put("\">");
+      if (hasEle) { put("<ele>"); putFixed(ele, 1, 10); put("</ele>"); }
+      put("<time>");
+      putTime(t);
+      put("</time></trkpt>\n");
+    }
+    else
+    {
+      if (fmt == FMT_GEOJSON) put((segFixes > 0) ? ",[" : "[");
+      putFixed(lon, 6, 1000000);
+      buf[n++] = ',';
+      putFixed(lat, 6, 1000000);
+      if (hasEle) { buf[n++] = ','; putFixed(ele, 1, 10); }
+      put((fmt == FMT_GEOJSON) ? "]\n" : "\n");
+    }
+    room();
+  }
+
+  void segBegin(int32_t t)
+  {
+    if (fmt == FMT_GPX) put("<trkseg>\n");
+    else if (fmt == FMT_KML)
+    {
+      put("<Placemark><name>");
+      putTime(t);
+      put("</name><LineString><tessellate>1</tessellate><coordinates>\n");
+    }
+    else
+    {
+      if (!firstSeg) put(",\n");
+      put("{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[\n");
+    }
+    inSeg = true;
+    firstSeg = false;
+    segStart = t;
+    segFixes = 0;
+    segments++;
+  }
+
+  void segEnd()
+  {
+    if (!inSeg) return;
+    // a line needs two points:  a fix on its own is there twice
+    if ((segFixes == 1) && (fmt != FMT_GPX)) point(lastLat, lastLon, lastHasEle, lastEle, lastT);
+    if (fmt == FMT_GPX) put("</trkseg>\n");
+    else if (fmt == FMT_KML) put("</coordinates></LineString></Placemark>\n");
+    else
+    {
+      put("]},\"properties\":{\"name\":\"");
+      putText(name);
+      put("\",\"start\":\"");
+      putTime(segStart);
+      put("\",\"end\":\"");
+      putTime(lastT);
+      put("\",\"fixes\":");
+      putInt(segFixes);
+      put("}}");
+    }
+    inSeg = false;
+    room();
+  }
+
+  void fix(int32_t t, int32_t lat, int32_t lon, bool hasEle, int32_t ele)
+  {
+    if (inSeg && ((t - lastT > CONV_GAP) || (t < lastT))) segEnd();
+    if (!inSeg) segBegin(t);
+    point(lat, lon, hasEle, ele, t);
+    segFixes++;
+    fixes++;
+    lastT = t; lastLat = lat; lastLon = lon; lastEle = ele; lastHasEle = hasEle;
+  }
+
+  bool close()
+  {
+    segEnd();
+    if (fmt == FMT_GPX) put("</trk>\n</gpx>\n");
+    else if (fmt == FMT_KML) put("</Document>\n</kml>\n");
+    else put("\n]}\n");
+    flush();
+    if (fd >= 0) ok &= (::close(fd) == 0);
+    fd = -1;
+    return ok;
+  }
+};
+
+//----------------------------------------------------------------------------
+// the readers
+//----------------------------------------------------------------------------
+static void convertNmea(const char* p, size_t len, Writer& w, NmeaColumns& c)
+{
+  size_t at = 0;
+  while (at < len)
+  {
+    size_t end = std::min(len, at + CONV_CHUNK);
+    if (end < len)
+    {
+      const char* nl = (const char*)memrchr(p + at, '\n', end - at);
+      if (nl) end = nl - p + 1;
+    }
+    c.clear();
+    nmeaBulkParse(p + at, end - at, &c);
+    // the height from the GGA of the same second, both in time order
+    size_t g = 0, gn = c.ggaTime.size();
+    int32_t prevSec = -1;
+    for (size_t i = 0; i < c.rmcTime.size(); i++)
+    {
+      int32_t t = c.rmcTime[i], sec = t % 86400;
+      if (sec < prevSec) g = 0; // midnight
+      prevSec = sec;
+      while ((g < gn) && (c.ggaTime[g] < sec)) g++;
+      bool hasEle = (g < gn) && (c.ggaTime[g] == sec) && (c.ggaQuality[g] > 0);
+      w.fix(t, c.rmcLat[i], c.rmcLon[i], hasEle, hasEle ? c.ggaAlt[g] : 0);
+    }
+    at = end;
+  }
+}
+
+static bool convertSeg(SegFile& f, Writer& w)
+{
+  static thread_local int32_t col[SEG_COLS][SEG_MAXFIXES];
+  bool ok = segFileMap(f);
+  for (size_t i = 0; i < f.segs.size(); i++)
+  {
+    int count = segFileDecode(f, i, col);
+    for (int j = 0; j < count; j++) w.fix(col[SEG_TIME][j], col[SEG_LAT][j], col[SEG_LON][j], false, 0);
+  }
+  segFileUnmap(f);
+  return ok;
+}
+
+struct Job { std::string in, rel; size_t size; long fixes; bool ok; };
+
+static bool convertFile(Job& job, const std::string& outdir, Writer& w, NmeaColumns& c)
+{
+  fsys::path rel(job.rel);
+  std::string out = (fsys::path(outdir) / rel).replace_extension(fmtExt[w.fmt]).string();
+  std::string name = rel.replace_extension("").string();
+  if (!w.open(out, name)) return false;
+  bool ok = true;
+  if (fsys::path(job.in).extension() == ".seg")
+  {
+    SegFile f;
+    f.path = job.in;
+    ok = convertSeg(f, w);
+  }
+  else
+  {
+    int fd = ::open(job.in.c_str(), O_RDONLY);
+    struct stat st;
+    if ((fd >= 0) && (fstat(fd, &st) == 0) && (st.st_size > 0))
+    {
+      void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m != MAP_FAILED)
+      {
+        madvise(m, st.st_size, MADV_SEQUENTIAL);
+        convertNmea((const char*)m, st.st_size, w, c);
+        munmap(m, st.st_size);
+      }
+      else ok = false;
+    }
+    else ok = (fd >= 0);
+    if (fd >= 0) ::close(fd);
+  }
+  ok &= w.close();
+  job.fixes = w.fixes;
+  return ok;
+}
+
+static double convertAll(std::vector<Job>& jobs, int fmt, int threads, const std::string& outdir)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; i++)
+  {
+    pool.emplace_back([&]() {
+      Writer w;
+      NmeaColumns c;
+      w.fmt = fmt;
+      for (size_t j; (j = next++) < jobs.size();) jobs[j].ok = convertFile(jobs[j], outdir, w, c);
+    });
+  }
+  for (auto& t : pool) t.join();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//----------------------------------------------------------------------------
+// the check
+//----------------------------------------------------------------------------
+// the fixes rmcParse() would take from the file, or the segments hold
+static long expectedFixes(const Job& job)
+{
+  long n = 0;
+  if (fsys::path(job.in).extension() == ".seg")
+  {
+    SegFile f;
+    f.path = job.in;
+    segFileMap(f);
+    for (auto& s : f.segs) n += s.count;
+    segFileUnmap(f);
+    return n;
+  }
+  FILE* fp = fopen(job.in.c_str(), "rb");
+  if (!fp) return -1;
+  char line[256];
+  GpsFix fix;
+  while (fgets(line, sizeof(line), fp))
+  {
+    line[strcspn(line, "\r\n")] = 0;
+    if (rmcParse(line, &fix) && fix.valid && fix.year) n++;
+  }
+  fclose(fp);
+  return n;
+}
+
+static void addInput(std::vector<Job>& jobs, const std::string& arg)
+{
+  if (fsys::is_directory(arg))
+  {
+    for (auto& e : fsys::recursive_directory_iterator(arg))
+      if (e.is_regular_file())
+        jobs.push_back({ e.path().string(), fsys::relative(e.path(), arg).string(), (size_t)e.file_size(), 0, false });
+  }
+  else if (fsys::is_regular_file(arg))
+    jobs.push_back({ arg, fsys::path(arg).filename().string(), (size_t)fsys::file_size(arg), 0, false });
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<Job> jobs;
+  std::string outdir;
+  std::vector<int> fmts;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  int loggers = 1000;
+  bool checkIt = false, built = false;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) outdir = argv[++i];
+    else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) threads = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-loggers") == 0) && (i + 1 < argc)) loggers = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc))
+    {
+      const char* f = argv[++i];
+      for (int k = 0; k < 3; k++) if (strcmp(f, fmtExt[k]) == 0) fmts.push_back(k);
+    }
+    else if (strcmp(argv[i], "-check") == 0) checkIt = true;
+    else inputs.push_back(argv[i]);
+  }
+
+  if (inputs.empty())
+  {
+    // a fleet's day:  the uploads' logs rebuilt, and the same number of loggers' segments
+    std::string root = (fsys::temp_directory_path() / "trackconv-in").string();
+    fsys::remove_all(root);
+    auto t0 = std::chrono::steady_clock::now();
+    auto logs = fleetGenerate(root + "/uploads", loggers, 1);
+    fsys::remove_all(root + "/uploads");
+    fsys::create_directories(root + "/nmea");
+    for (auto& l : logs)
+    {
+      FILE* fp = fopen((root + "/nmea/" + l.first + ".log").c_str(), "wb");
+      if (fp) { fwrite(l.second.data(), 1, l.second.size(), fp); fclose(fp); }
+    }
+    segFleetGenerate(root + "/seg", loggers, 15);
+    printf("generated a day of %d loggers, NMEA logs and segments, into %s in %.1f s\n", loggers, root.c_str(),
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    inputs.push_back(root);
+    built = checkIt = true;
+    if (fmts.empty()) fmts = { FMT_GPX, FMT_KML, FMT_GEOJSON };
+  }
+  if (fmts.empty()) fmts.push_back(FMT_GPX);
+  if (outdir.empty()) outdir = (fsys::temp_directory_path() / "trackconv-out").string();
+  for (auto& in : inputs) addInput(jobs, in);
+  if (jobs.empty()) { printf("nothing to convert\n"); return 1; }
+  std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+  size_t bytes = 0;
+  for (auto& j : jobs) bytes += j.size;
+  printf("%zu files, %.1f MB, into %s (%u cores here)\n", jobs.size(), bytes / 1e6, outdir.c_str(),
+         std::thread::hardware_concurrency());
+
+  std::vector<long> expect;
+  if (checkIt) for (auto& j : jobs) expect.push_back(expectedFixes(j));
+
+  std::vector<int> counts;
+  if (built) for (int t = 1; t < threads; t *= 2) counts.push_back(t);
+  counts.push_back(threads);
+  printf("\n%-8s %8s %9s %10s %9s %10s %9s  %s\n", "format", "threads", "seconds", "files/s", "MB/s in", "M fixes/s", "MB out",
+         checkIt ? "check" : "");
+  int failed = 0;
+  for (int fmt : fmts)
+  {
+    for (int t : counts)
+    {
+      double sec = convertAll(jobs, fmt, t, outdir);
+      long fixes = 0, bad = 0, wrong = 0;
+      size_t out = 0;
+      for (size_t i = 0; i < jobs.size(); i++)
+      {
+        fixes += jobs[i].fixes;
+        bad += !jobs[i].ok;
+        if (checkIt && (jobs[i].fixes != expect[i])) wrong++;
+        std::error_code ec;
+        out += fsys::file_size((fsys::path(outdir) / jobs[i].rel).replace_extension(fmtExt[fmt]), ec);
+      }
+      failed += (bad + wrong) > 0;
+      char check[64] = "";
+      if (checkIt) snprintf(check, sizeof(check), "%s", wrong ? "FIX COUNTS DIFFER" : "every fix");
+      if (bad) snprintf(check + strlen(check), sizeof(check) - strlen(check), ", %ld failed", bad);
+      printf("%-8s %8d %9.2f %10.0f %9.1f %10.2f %9.1f  %s\n", fmtExt[fmt], t, sec, jobs.size() / sec,
+             bytes / sec / 1e6, fixes / sec / 1e6, out / 1e6, check);
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,467 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Fleet wide time merge - every logger's track segments into one time
+// ordered list of fixes
+//----------------------------------------------------------------------------
+// ingest.cpp and udpcollect.cpp leave one or more .seg files per logger
+// (the column segments of TrackSegmentService.h), each in time order but
+// covering any part of the day - a logger's uploads don't arrive in the
+// order it made them.  A fleet report wants them all as one list by time.
+// This merges them without ever holding more than a segment a file:
+//   map         every file mmap'ed and closed again straight away, so 10k
+//               inputs cost 10k mappings and no file descriptors;  only
+//               the SegHeaders are read, for each segment's first and last
+//               time and fix count (SegFiles.h)
+//   partition   the time line cut where the fix counts say, into 4 ranges
+//               a thread;  the threads take the ranges in turn
+//   merge       per range a loser tree over the files that have a segment
+//               in it, each file a cursor that starts on its first segment
+//               ending in the range (found from the headers, nothing
+//               decoded) and decodes a segment only when it's the tree's
+//               winner - till then the header's first time is its key.
+//               Ordered by time then logger;  the same logger and second
+//               from two uploads is one fix
+//   write       each range to a part file, then the parts one after the
+//               other into the output (copy_file_range)
+// The output is CSV, "unix,logger,lat,lon,kts".  The logger is the file's
+// folder under the root for <root>/<logger>/*.seg, else the file's name.
+//
+// Memory is a cursor (one decoded segment, 4 KB) a file a thread, however
+// many fixes there are.
+//
+// Without a folder it makes its own (segFleetGenerate()): -loggers loggers
+// each uploading their day in 4 files, in no order and overlapping a
+// little, 10k files by default, lowers its own open file limit to 64 and merges them, then
+// checks the output line for line against a sort of every fix.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -pthread -o host/trackmerge host/trackmerge.cpp
+//   host/trackmerge [root] [-o out.csv] [-t threads] [-loggers n] [-every s] [-check]
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "UploadFleet.h"
+#include "SegFiles.h"
+
+namespace fsys = std::filesystem;
+
+#define MERGE_RANGES (4)              /* time ranges a thread */
+#define MERGE_OUTBUF (1 << 20)
+
+struct Merge
+{
+  std::vector<std::string> loggers;
+  std::vector<SegFile> in;
+  std::vector<int32_t> bounds;        // range r is [bounds[r], bounds[r+1])
+  std::atomic<long> fixes{0}, repeats{0}, cursors{0}, decoded{0};
+  long bad = 0;
+  size_t segments = 0, bytes = 0;
+  double mapSec = 0, mergeSec = 0, concatSec = 0;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//----------------------------------------------------------------------------
+// the ranges
+//----------------------------------------------------------------------------
+// cut the time line into ranges of about the same number of fixes
+static void partition(Merge& m, int ranges)
+{
+  std::vector<std::pair<int32_t, int>> starts;
+  size_t total = 0;
+  for (auto& in : m.in)
+  {
+    for (auto& s : in.segs) { starts.push_back({ s.first, s.count }); total += s.count; }
+  }
+  std::sort(starts.begin(), starts.end());
+  m.bounds.clear();
+  m.bounds.push_back(INT32_MIN);
+  size_t seen = 0;
+  for (auto& s : starts)
+  {
+    seen += s.second;
+    if ((seen * ranges >= total * m.bounds.size()) && ((int)m.bounds.size() < ranges) && (s.first > m.bounds.back()))
+      m.bounds.push_back(s.first);
+  }
+  m.bounds.push_back(INT32_MAX);
+}
+
+//----------------------------------------------------------------------------
+// the loser tree
+//----------------------------------------------------------------------------
+#define KEY_END (~0ULL)
+
+struct Cursor
+{
+  const SegFile* in;
+  size_t seg, segEnd;                 // segments still to go in this range
+  int at, count;
+  bool decoded;
+  uint64_t key;                       // time (sign flipped) then logger, KEY_END when done
+  int32_t col[SEG_COLS][SEG_MAXFIXES];
+};
+
+static inline uint64_t makeKey(int32_t t, int logger)
+{
+  return ((uint64_t)((uint32_t)t ^ 0x80000000u) << 32) | (uint32_t)logger;
+}
+
+// node[0] the winner, node[1..k-1] the loser at each match;  leaf i sits
+// at k + i.  Index k is the "before everything" a new tree starts with.
+struct LoserTree
+{
+  int k;
+  std::vector<int> node;
+  const std::vector<Cursor>* cur;
+
+  bool less(int a, int b) const
+  {
+    if (a == k) return true;
+    if (b == k) return false;
+    uint64_t ka = (*cur)[a].key, kb = (*cur)[b].key;
+    return (ka < kb) || ((ka == kb) && (a < b));
+  }
+
+  void replay(int leaf)
+  {
+    int w = leaf;
+    for (int n = (leaf + k) >> 1; n > 0; n >>= 1)
+      if (less(node[n], w)) std::swap(node[n], w);
+    node[0] = w;
+  }
+
+  void init(const std::vector<Cursor>* c)
+  {
+    cur = c;
+    k = (int)c->size();
+    node.assign(std::max(k, 1), k);
+    for (int i = 0; i < k; i++) replay(i);
+  }
+};
+
+static void decodeSegment(Cursor& c)
+{
+  c.count = segFileDecode(*c.in, c.seg, c.col);
+  c.at = 0;
+  c.decoded = true;
+}
+
+// the cursor's next key in [t0, t1)
+static void nextKey(Cursor& c, int32_t t0, int32_t t1)
+{
+  for (;;)
+  {
+    if (c.decoded)
+    {
+      while ((c.at < c.count) && (c.col[SEG_TIME][c.at] < t0)) c.at++;
+      if (c.at < c.count)
+      {
+        int32_t t = c.col[SEG_TIME][c.at];
+        c.key = (t < t1) ? makeKey(t, c.in->logger) : KEY_END;
+        return;
+      }
+      c.seg++;
+      c.decoded = false;
+    }
+    if (c.seg >= c.segEnd) { c.key = KEY_END; return; }
+    c.key = makeKey(std::max(c.in->segs[c.seg].first, t0), c.in->logger);
+    return;
+  }
+}
+
+//----------------------------------------------------------------------------
+// output
+//----------------------------------------------------------------------------
+static inline char* putInt(char* p, int64_t v)
+{
+  char tmp[24];
+  int n = 0;
+  uint64_t u = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+  do { tmp[n++] = '0' + (u % 10); u /= 10; } while (u);
+  if (v < 0) *p++ = '-';
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+static inline char* putFixed(char* p, int64_t v, int decimals, int64_t scale)
+{
+  if (v < 0) { *p++ = '-'; v = -v; }
+  p = putInt(p, v / scale);
+  *p++ = '.';
+  int64_t frac = v % scale;
+  for (int i = decimals - 1; i >= 0; i--) { p[i] = '0' + (frac % 10); frac /= 10; }
+  return p + decimals;
+}
+
+static inline char* putFix(char* p, const Merge& m, int logger, const SegFix& f)
+{
+  p = putInt(p, (int64_t)f.t + SEG_EPOCH);
+  *p++ = ',';
+  const std::string& name = m.loggers[logger];
+  memcpy(p, name.data(), name.size());
+  p += name.size();
+  *p++ = ',';
+  p = putFixed(p, f.lat, 6, 1000000);
+  *p++ = ',';
+  p = putFixed(p, f.lon, 6, 1000000);
+  *p++ = ',';
+  p = putFixed(p, f.speed, 2, 100);
+  *p++ = '\n';
+  return p;
+}
+
+static std::string partName(const std::string& out, int r)
+{
+  return out + ".part" + std::to_string(r);
+}
+
+//----------------------------------------------------------------------------
+// the merge
+//----------------------------------------------------------------------------
+static bool mergeRange(Merge& m, int r, const std::string& out)
+{
+  int32_t t0 = m.bounds[r], t1 = m.bounds[r + 1];
+  std::vector<Cursor> cur;
+  for (auto& in : m.in)
+  {
+    // segments are in time order:  the first ending at or after t0, to the first starting at t1
+    auto b = std::partition_point(in.segs.begin(), in.segs.end(), [&](const SegRef& s) { return s.last < t0; });
+    auto e = std::partition_point(b, in.segs.end(), [&](const SegRef& s) { return s.first < t1; });
+    if (b == e) continue;
+    cur.emplace_back();
+    Cursor& c = cur.back();
+    c.in = &in;
+    c.seg = b - in.segs.begin();
+    c.segEnd = e - in.segs.begin();
+    c.decoded = false;
+    nextKey(c, t0, t1);
+  }
+  m.cursors += cur.size();
+  LoserTree tree;
+  tree.init(&cur);
+
+  FILE* fp = fopen(partName(out, r).c_str(), "wb");
+  if (!fp) return false;
+  std::vector<char> buf(MERGE_OUTBUF + 256);
+  char* p = buf.data();
+  char* full = buf.data() + MERGE_OUTBUF;
+  uint64_t lastKey = KEY_END;
+  long fixes = 0, repeats = 0, decoded = 0;
+  bool ok = true;
+  while (!cur.empty())
+  {
+    int w = tree.node[0];
+    Cursor& c = cur[w];
+    if (c.key == KEY_END) break;
+    if (!c.decoded)
+    {
+      // it has won on its header's first time, now it needs the fixes
+      decodeSegment(c);
+      decoded++;
+    }
+    else
+    {
+      if (c.key != lastKey)
+      {
+        SegFix f = { c.col[SEG_TIME][c.at], c.col[SEG_LAT][c.at], c.col[SEG_LON][c.at], c.col[SEG_SPEED][c.at] };
+        p = putFix(p, m, c.in->logger, f);
+        if (p >= full)
+        {
+          ok &= (fwrite(buf.data(), 1, p - buf.data(), fp) == (size_t)(p - buf.data()));
+          p = buf.data();
+        }
+        lastKey = c.key;
+        fixes++;
+      }
+      else repeats++;
+      c.at++;
+    }
+    nextKey(c, t0, t1);
+    tree.replay(w);
+  }
+  ok &= (fwrite(buf.data(), 1, p - buf.data(), fp) == (size_t)(p - buf.data()));
+  ok &= (fclose(fp) == 0);
+  m.fixes += fixes;
+  m.repeats += repeats;
+  m.decoded += decoded;
+  return ok;
+}
+
+static bool concatParts(const Merge& m, const std::string& out)
+{
+  int fd = open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  bool ok = (write(fd, "unix,logger,lat,lon,kts\n", 24) == 24);
+  for (size_t r = 0; r + 1 < m.bounds.size(); r++)
+  {
+    std::string part = partName(out, (int)r);
+    int in = open(part.c_str(), O_RDONLY);
+    if (in < 0) { ok = false; continue; }
+    ssize_t n;
+    while ((n = copy_file_range(in, NULL, fd, NULL, 1 << 30, 0)) > 0) {}
+    ok &= (n == 0);
+    close(in);
+    unlink(part.c_str());
+  }
+  ok &= (close(fd) == 0);
+  return ok;
+}
+
+static bool merge(Merge& m, int threads, const std::string& out)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (auto& in : m.in)
+  {
+    if (!segFileMap(in)) m.bad++;
+    m.segments += in.segs.size();
+    m.bytes += in.len;
+  }
+  partition(m, threads * MERGE_RANGES);
+  m.mapSec = secondsSince(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  int ranges = (int)m.bounds.size() - 1;
+  std::atomic<int> next{0};
+  std::atomic<bool> ok{true};
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; i++)
+  {
+    pool.emplace_back([&]() {
+      for (int r; (r = next++) < ranges;)
+        if (!mergeRange(m, r, out)) ok = false;
+    });
+  }
+  for (auto& t : pool) t.join();
+  m.mergeSec = secondsSince(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  if (!concatParts(m, out)) ok = false;
+  m.concatSec = secondsSince(t0);
+  for (auto& in : m.in) segFileUnmap(in);
+  return ok;
+}
+
+//----------------------------------------------------------------------------
+// the built-in fleet and the check
+//----------------------------------------------------------------------------
+struct RefFix { SegFix f; int logger; };
+
+static bool check(Merge& m, const std::string& out)
+{
+  std::vector<RefFix> all;
+  for (auto& in : m.in)
+  {
+    if (!segFileMap(in)) continue;
+    for (auto& s : in.segs)
+    {
+      Cursor c;
+      c.in = &in;
+      c.seg = &s - &in.segs[0];
+      decodeSegment(c);
+      for (int i = 0; i < c.count; i++)
+        all.push_back({ { c.col[0][i], c.col[1][i], c.col[2][i], c.col[3][i] }, in.logger });
+    }
+    segFileUnmap(in);
+  }
+  std::stable_sort(all.begin(), all.end(), [](const RefFix& a, const RefFix& b) {
+    return (a.f.t < b.f.t) || ((a.f.t == b.f.t) && (a.logger < b.logger));
+  });
+
+  FILE* fp = fopen(out.c_str(), "rb");
+  if (!fp) return false;
+  char got[256], want[256];
+  long lines = 0, diffs = 0;
+  if (!fgets(got, sizeof(got), fp)) got[0] = 0;
+  for (size_t i = 0; i < all.size(); i++)
+  {
+    if ((i > 0) && (all[i].f.t == all[i - 1].f.t) && (all[i].logger == all[i - 1].logger)) continue;
+    *putFix(want, m, all[i].logger, all[i].f) = 0;
+    if (!fgets(got, sizeof(got), fp)) got[0] = 0;
+    if (strcmp(got, want) != 0)
+    {
+      if (diffs++ < 3) printf("  line %ld: %s  want %s", lines + 2, got, want);
+    }
+    lines++;
+  }
+  if (fgets(got, sizeof(got), fp)) diffs++;
+  fclose(fp);
+  printf("check: %ld lines, %s\n", lines, diffs ? "DIFFERS from the sorted reference" : "same as a sort of every fix");
+  return diffs == 0;
+}
+
+int main(int argc, char** argv)
+{
+  std::string root, out;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  int loggers = 2500, every = 15;
+  bool checkIt = false;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) out = argv[++i];
+    else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) threads = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-loggers") == 0) && (i + 1 < argc)) loggers = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-every") == 0) && (i + 1 < argc)) every = std::max(1, atoi(argv[++i]));
+    else if (strcmp(argv[i], "-check") == 0) checkIt = true;
+    else root = argv[i];
+  }
+
+  bool built = root.empty();
+  if (built)
+  {
+    root = (fsys::temp_directory_path() / "trackmerge-in").string();
+    fsys::remove_all(root);
+    auto t0 = std::chrono::steady_clock::now();
+    segFleetGenerate(root, loggers, every);
+    printf("generated %d loggers x %d uploads into %s in %.1f s\n", loggers, SEGFLEET_UPLOADS, root.c_str(), secondsSince(t0));
+    checkIt = true;
+  }
+  if (out.empty()) out = (fsys::temp_directory_path() / "trackmerge.csv").string();
+
+  Merge m;
+  segFilesFind(root, m.in, m.loggers);
+  if (m.in.empty()) { printf("no .seg files under %s\n", root.c_str()); return 1; }
+
+  // the inputs are mapped, not held open:  show it with the limit well under their count
+  struct rlimit lim;
+  getrlimit(RLIMIT_NOFILE, &lim);
+  if (built)
+  {
+    struct rlimit low = lim;
+    low.rlim_cur = std::min<rlim_t>(lim.rlim_cur, 64 + 2 * threads);
+    setrlimit(RLIMIT_NOFILE, &low);
+    getrlimit(RLIMIT_NOFILE, &lim);
+  }
+  printf("%zu files from %zu loggers, open file limit %lu, %d threads (%u cores here)\n",
+         m.in.size(), m.loggers.size(), (unsigned long)lim.rlim_cur, threads, std::thread::hardware_concurrency());
+
+  bool ok = merge(m, threads, out);
+  long fixes = m.fixes;
+  double outMB = fsys::file_size(out) / 1e6;
+  printf("%zu segments, %.1f MB of .seg, %ld files unreadable\n", m.segments, m.bytes / 1e6, m.bad);
+  printf("map + headers %.2f s, merge %.2f s over %zu time ranges, parts joined %.2f s\n",
+         m.mapSec, m.mergeSec, m.bounds.size() - 1, m.concatSec);
+  printf("%ld fixes (%ld repeats dropped) to %s, %.1f MB, %.2f M fixes/s\n",
+         fixes, (long)m.repeats, out.c_str(), outMB, fixes / (m.mapSec + m.mergeSec + m.concatSec) / 1e6);
+  printf("%ld cursors over the ranges, %ld segments decoded, heap %.1f MB a thread at most\n",
+         (long)m.cursors, (long)m.decoded, m.in.size() * sizeof(Cursor) / 1e6);
+  if (!ok) { printf("merge failed writing %s\n", out.c_str()); return 1; }
+  if (checkIt && !check(m, out)) return 1;
+  return 0;
+}
@@ -0,0 +1,711 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Collector for the UDP fix telemetry (TelemetryProtocol.h) from a fleet,
+// and a load generator to point at it
+//----------------------------------------------------------------------------
+// Loggers with TELEMETRYSERVER=<this box>:5006 send a datagram per fix.
+//   receivers   -receivers threads, each its own socket on the port
+//               (SO_REUSEPORT, the kernel spreads the senders over them),
+//               COLL_BATCH datagrams a recvmmsg() call
+//   queues      each receiver has a single producer / single consumer
+//               lock-free ring to each writer;  the device id picks the
+//               writer, so a device is only ever seen by one writer and
+//               its state needs no locks.  A full ring drops, counted
+//   writers     -writers threads: per device the seq window and the fixes,
+//               appended to <out>/<device id>.seg as TrackSegmentService.h
+//               segments when SEG_MAXFIXES are buffered or the oldest is
+//               COLL_FLUSHSEC old (and at the end)
+// Loss per device from seq: the highest seen, and a bitmap of the
+// COLL_WINDOW before it - one arriving inside the window fills its gap
+// (late), or was there already (duplicate);  lost = the seqs from the
+// first to the highest never seen.  A new session (the logger rebooted or
+// woke from a deep sleep, seq from 0 again) closes the count so far and
+// starts a new window;  one from the session before that is too late.
+// The kernel's own drops on the sockets (SO_RXQ_OVFL) are reported too.
+//
+// -load host:port sends as -devices loggers (default 10000) for -rounds
+// rounds, a datagram per logger per round, at -pps (0 = flat out) from
+// -senders threads with sendmmsg(), skipping -drop % of the seqs, sending
+// -dup % twice and holding -late % back until after the next round;
+// -reboot % of the loggers restart half way, a new session from seq 0.
+// -bench runs the collector and the load in one process over loopback,
+// checks the collector's lost / duplicate / late counts against what the
+// load did and every fix against the .seg files, and reports datagrams
+// per second per core from the threads' CPU time.
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wno-write-strings -pthread -o host/udpcollect host/udpcollect.cpp
+//   host/udpcollect [-p 5006] [-o outdir] [-receivers n] [-writers n] [-sec n]
+//   host/udpcollect -load host:port [-devices n] [-rounds n] [-pps n] [-senders n] [-drop %] [-dup %] [-late %] [-reboot %]
+//   host/udpcollect -bench [the options of both]
+//
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "HostArduino.h"
+
+#define SEGFN "/track.seg"
+
+fs::FS & fileSystem = SPIFFS;
+
+#include "../NmeaService.h"
+#include "../TrackSegmentService.h"
+#include "../BatchProtocol.h"
+#include "../TelemetryProtocol.h"
+
+namespace fsys = std::filesystem;
+
+#define COLL_BATCH (64)              /* datagrams a recvmmsg() / sendmmsg() */
+#define COLL_RING (8192)             /* datagrams a receiver -> writer ring, a power of 2 */
+#define COLL_WINDOW (64)             /* seqs back a late one still fills its gap */
+#define COLL_FLUSHSEC (60)           /* longest a fix waits in a writer */
+#define COLL_RCVBUF (16 << 20)
+#define COLL_IDLEMS (100)            /* recvmmsg() timeout, to look at stop */
+
+static std::atomic<bool> stopping{false};
+
+static double threadCpu()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t hashId(const uint8_t* id)
+{
+  uint32_t h = 2166136261u; // FNV-1a
+  for (int i = 0; i < TEL_IDLEN; i++) h = (h ^ id[i]) * 16777619u;
+  return h;
+}
+
+//----------------------------------------------------------------------------
+// receiver -> writer ring, one producer and one consumer
+//----------------------------------------------------------------------------
+struct Datagram { uint16_t len; uint8_t data[TEL_MAXLEN]; };
+
+class SpscRing
+{
+public:
+  SpscRing() : slots(COLL_RING) {}
+
+  bool push(const uint8_t* p, int len)
+  {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == COLL_RING) return false;
+    Datagram& d = slots[h & (COLL_RING - 1)];
+    d.len = len;
+    memcpy(d.data, p, len);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // the oldest, or NULL;  release() it when done with
+  const Datagram* front()
+  {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return NULL;
+    return &slots[t & (COLL_RING - 1)];
+  }
+  void release() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+  std::vector<Datagram> slots;
+  alignas(64) std::atomic<uint32_t> head{0};
+  alignas(64) std::atomic<uint32_t> tail{0};
+};
+
+//----------------------------------------------------------------------------
+// the collector
+//----------------------------------------------------------------------------
+struct Device
+{
+  bool started = false;
+  uint32_t session = 0, oldSession = 0;
+  uint32_t first = 0, highest = 0;   // this session
+  uint64_t window = 0;               // bit n = highest - n seen
+  uint64_t sessionReceived = 0;
+  uint64_t lostBefore = 0;           // in the sessions before
+  uint64_t received = 0, dups = 0, late = 0, stale = 0, restarts = 0;
+  int count = 0;                     // fixes buffered
+  int32_t cols[SEG_COLS][SEG_MAXFIXES];
+  std::chrono::steady_clock::time_point oldest;
+};
+
+static uint64_t devLost(const Device& d)
+{
+  return d.lostBefore + (uint64_t)(d.highest - d.first) + 1 - d.sessionReceived;
+}
+
+struct WriterStats { uint64_t datagrams = 0, fixes = 0, bad = 0, segments = 0, bytes = 0; double cpu = 0, flushCpu = 0; };
+struct ReceiverStats { uint64_t datagrams = 0, calls = 0, ringDrops = 0, kernelDrops = 0; double cpu = 0; };
+
+class Collector
+{
+public:
+  Collector(int port, int receivers, int writers, const std::string& outdir)
+    : outdir(outdir), nrx(receivers), nwr(writers), rings(receivers * writers),
+      rxStats(receivers), wrStats(writers), devices(writers)
+  {
+    for (int r = 0; r < nrx; r++)
+    {
+      int fd = socket(AF_INET, SOCK_DGRAM, 0);
+      int on = 1, buf = COLL_RCVBUF;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+      setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+      struct timeval tv = { 0, COLL_IDLEMS * 1000 };
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      struct sockaddr_in a;
+      memset(&a, 0, sizeof(a));
+      a.sin_family = AF_INET;
+      a.sin_addr.s_addr = htonl(INADDR_ANY);
+      a.sin_port = htons(port);
+      if (bind(fd, (struct sockaddr*)&a, sizeof(a)) != 0) { perror("bind"); exit(1); }
+      if (port == 0) // the first picked one, the others share it
+      {
+        socklen_t len = sizeof(a);
+        getsockname(fd, (struct sockaddr*)&a, &len);
+        port = ntohs(a.sin_port);
+      }
+      socks.push_back(fd);
+    }
+    boundPort = port;
+    fsys::create_directories(outdir);
+  }
+
+  ~Collector() { for (int fd : socks) close(fd); }
+
+  int port() { return boundPort; }
+
+  void start()
+  {
+    for (int r = 0; r < nrx; r++) rxThreads.emplace_back([this, r] { receive(r); });
+    for (int w = 0; w < nwr; w++) wrThreads.emplace_back([this, w] { write(w); });
+  }
+
+  // stop once nothing has come in for quietMs;  the receivers first, then
+  // the writers empty the rings
+  void stop(int quietMs)
+  {
+    uint64_t last = ~0ULL;
+    while (quietMs > 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(quietMs));
+      uint64_t n = arrived;
+      if (n == last) break;
+      last = n;
+    }
+    rxDone = true;
+    for (std::thread& t : rxThreads) t.join();
+    wrDone = true;
+    for (std::thread& t : wrThreads) t.join();
+    rxThreads.clear();
+    wrThreads.clear();
+  }
+
+  void report(double sec);
+
+  std::string outdir;
+  int nrx, nwr, boundPort;
+  std::vector<int> socks;
+  std::vector<SpscRing> rings;                  // [receiver * nwr + writer]
+  std::vector<ReceiverStats> rxStats;
+  std::vector<WriterStats> wrStats;
+  std::vector<std::unordered_map<std::string, Device>> devices; // [writer]
+  std::vector<std::thread> rxThreads, wrThreads;
+  std::atomic<bool> rxDone{false}, wrDone{false};
+  std::atomic<uint64_t> arrived{0};
+
+private:
+  void receive(int r);
+  void write(int w);
+  void take(int w, const Datagram& d);
+  void flush(int w, const std::string& id, Device& dev);
+};
+
+void Collector::receive(int r)
+{
+  static thread_local uint8_t bufs[COLL_BATCH][TEL_MAXLEN + 1];
+  static thread_local char ctrl[COLL_BATCH][CMSG_SPACE(sizeof(uint32_t))];
+  struct mmsghdr msgs[COLL_BATCH];
+  struct iovec iov[COLL_BATCH];
+  ReceiverStats& st = rxStats[r];
+  while (!rxDone)
+  {
+    for (int i = 0; i < COLL_BATCH; i++)
+    {
+      iov[i].iov_base = bufs[i];
+      iov[i].iov_len = sizeof(bufs[i]);
+      memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_control = ctrl[i];
+      msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+    }
+    int n = recvmmsg(socks[r], msgs, COLL_BATCH, MSG_WAITFORONE, NULL);
+    if (n <= 0) continue; // timed out, look at rxDone
+    st.calls++;
+    for (int i = 0; i < n; i++)
+    {
+      int len = msgs[i].msg_len;
+      for (struct cmsghdr* c = CMSG_FIRSTHDR(&msgs[i].msg_hdr); c; c = CMSG_NXTHDR(&msgs[i].msg_hdr, c))
+        if ((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == SO_RXQ_OVFL))
+        {
+          uint32_t drops;
+          memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+          if (drops > st.kernelDrops) st.kernelDrops = drops;
+        }
+      if ((len < TEL_HDRLEN) || (len > TEL_MAXLEN)) continue; // not ours, not worth a ring slot
+      int w = hashId(&bufs[i][4]) % nwr;
+      if (!rings[r * nwr + w].push(bufs[i], len)) st.ringDrops++;
+    }
+    st.datagrams += n;
+    arrived += n;
+  }
+  st.cpu = threadCpu();
+}
+
+void Collector::write(int w)
+{
+  WriterStats& st = wrStats[w];
+  auto sweep = std::chrono::steady_clock::now();
+  for (;;)
+  {
+    bool any = false;
+    for (int r = 0; r < nrx; r++)
+    {
+      SpscRing& ring = rings[r * nwr + w];
+      for (int k = 0; k < COLL_BATCH; k++)
+      {
+        const Datagram* d = ring.front();
+        if (!d) break;
+        take(w, *d);
+        ring.release();
+        any = true;
+      }
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - sweep > std::chrono::seconds(1))
+    {
+      sweep = now;
+      for (auto& kv : devices[w])
+        if ((kv.second.count > 0) && (now - kv.second.oldest > std::chrono::seconds(COLL_FLUSHSEC)))
+          flush(w, kv.first, kv.second);
+    }
+    if (!any)
+    {
+      if (wrDone) break; // the receivers have stopped, and the rings are empty
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+  st.cpu = threadCpu();
+  for (auto& kv : devices[w]) flush(w, kv.first, kv.second);
+  st.flushCpu = threadCpu() - st.cpu;
+}
+
+void Collector::take(int w, const Datagram& d)
+{
+  WriterStats& st = wrStats[w];
+  char id[TEL_IDLEN + 1];
+  uint32_t session, seq;
+  TelFix fixes[TEL_MAXFIXES];
+  int n = telUnpack(d.data, d.len, id, &session, &seq, fixes);
+  if (n == 0) { st.bad++; return; }
+  st.datagrams++;
+  Device& dev = devices[w][id];
+
+  if (dev.started && (session != dev.session))
+  {
+    if (session == dev.oldSession) { dev.stale++; return; } // from before the restart
+    dev.lostBefore = devLost(dev);
+    dev.oldSession = dev.session;
+    dev.restarts++;
+    dev.started = false;
+  }
+  if (!dev.started)
+  {
+    dev.started = true;
+    dev.session = session;
+    dev.first = dev.highest = seq;
+    dev.window = 1;
+    dev.sessionReceived = 0;
+  }
+  else if ((int32_t)(seq - dev.highest) > 0)
+  {
+    uint32_t shift = seq - dev.highest;
+    dev.window = (shift >= COLL_WINDOW) ? 1 : (dev.window << shift) | 1;
+    dev.highest = seq;
+  }
+  else
+  {
+    uint32_t back = dev.highest - seq;
+    if ((back >= COLL_WINDOW) || ((int32_t)(seq - dev.first) < 0)) { dev.stale++; return; }
+    if (dev.window & (1ULL << back)) { dev.dups++; return; }
+    dev.window |= 1ULL << back;
+    dev.late++;
+  }
+  dev.received++;
+  dev.sessionReceived++;
+
+  for (int i = 0; i < n; i++)
+  {
+    if (dev.count >= SEG_MAXFIXES) flush(w, id, dev);
+    if (dev.count == 0) dev.oldest = std::chrono::steady_clock::now();
+    dev.cols[SEG_TIME][dev.count] = (int32_t)((long)fixes[i].t - SEG_EPOCH);
+    dev.cols[SEG_LAT][dev.count] = fixes[i].lat;
+    dev.cols[SEG_LON][dev.count] = fixes[i].lon;
+    dev.cols[SEG_SPEED][dev.count] = fixes[i].speed;
+    dev.count++;
+    st.fixes++;
+  }
+}
+
+// the buffered fixes as a segment on the end of <out>/<device id>.seg
+void Collector::flush(int w, const std::string& id, Device& dev)
+{
+  if (dev.count == 0) return;
+  uint8_t seg[sizeof(SegHeader) + SEG_COLS * SEG_MAXFIXES * SEG_VARINTMAX];
+  SegHeader h;
+  memset(&h, 0, sizeof(h));
+  h.magic = SEG_MAGIC;
+  h.count = dev.count;
+  int len = sizeof(h);
+  for (int c = 0; c < SEG_COLS; c++)
+  {
+    const int32_t* col = dev.cols[c];
+    h.minv[c] = h.maxv[c] = h.first[c] = col[0];
+    int start = len;
+    for (int i = 1; i < dev.count; i++)
+    {
+      if (col[i] < h.minv[c]) h.minv[c] = col[i];
+      if (col[i] > h.maxv[c]) h.maxv[c] = col[i];
+      len += segPut(seg + len, col[i] - col[i - 1]);
+    }
+    h.bytes[c] = len - start;
+  }
+  memcpy(seg, &h, sizeof(h));
+  std::string safe;
+  for (const char* p = id.c_str(); *p; p++) safe += (isalnum(*p) || (*p == '-') || (*p == '_')) ? *p : '_';
+  FILE* fp = fopen((outdir + "/" + safe + ".seg").c_str(), "ab");
+  if (fp)
+  {
+    fwrite(seg, 1, len, fp);
+    fclose(fp);
+    wrStats[w].segments++;
+    wrStats[w].bytes += len;
+  }
+  dev.count = 0;
+}
+
+void Collector::report(double sec)
+{
+  uint64_t got = 0, calls = 0, ringDrops = 0, kernelDrops = 0, taken = 0, fixes = 0, bad = 0, segs = 0, bytes = 0;
+  uint64_t lost = 0, dups = 0, late = 0, stale = 0, received = 0, restarts = 0;
+  size_t ndev = 0;
+  double rxCpu = 0, wrCpu = 0, flushCpu = 0;
+  for (auto& s : rxStats) { got += s.datagrams; calls += s.calls; ringDrops += s.ringDrops; kernelDrops += s.kernelDrops; rxCpu += s.cpu; }
+  for (auto& s : wrStats) { taken += s.datagrams; fixes += s.fixes; bad += s.bad; segs += s.segments; bytes += s.bytes; wrCpu += s.cpu; flushCpu += s.flushCpu; }
+  for (auto& m : devices)
+    for (auto& kv : m)
+    {
+      const Device& d = kv.second;
+      lost += devLost(d);
+      dups += d.dups; late += d.late; stale += d.stale; received += d.received; restarts += d.restarts;
+      ndev++;
+    }
+  printf("collector: %zu devices (%llu restarts), %llu datagrams in %.2f s (%.0f/s), %.1f a recvmmsg()\n",
+         ndev, (unsigned long long)restarts, (unsigned long long)got, sec, got / sec, calls ? (double)got / calls : 0.0);
+  printf("  lost %llu (%.3f%%), duplicate %llu, late %llu, too late %llu, bad %llu;  dropped here: ring %llu, kernel %llu\n",
+         (unsigned long long)lost, received + lost ? 100.0 * lost / (received + lost) : 0.0, (unsigned long long)dups,
+         (unsigned long long)late, (unsigned long long)stale, (unsigned long long)bad,
+         (unsigned long long)ringDrops, (unsigned long long)kernelDrops);
+  printf("  %llu fixes into %llu segments, %.1f MB, %.2f bytes a fix\n", (unsigned long long)fixes,
+         (unsigned long long)segs, bytes / 1e6, fixes ? (double)bytes / fixes : 0.0);
+  printf("  cpu: receivers %.2f s (%.0f datagrams/s a core), writers %.2f s (%.0f/s a core), %.0f/s a core for both;"
+         " the last flush %.2f s\n", rxCpu, rxCpu > 0 ? got / rxCpu : 0.0, wrCpu, wrCpu > 0 ? taken / wrCpu : 0.0,
+         rxCpu + wrCpu > 0 ? got / (rxCpu + wrCpu) : 0.0, flushCpu);
+}
+
+//----------------------------------------------------------------------------
+// the load
+//----------------------------------------------------------------------------
+struct LoadOptions
+{
+  std::string host = "127.0.0.1";
+  int port = TEL_PORT_DEFAULT;
+  int devices = 10000, rounds = 30, senders = 1;
+  double pps = 0, dropPct = 0.5, dupPct = 0.2, latePct = 0.5, rebootPct = 1;
+};
+
+struct LoadStats { uint64_t sent = 0, skipped = 0, dups = 0, late = 0, reboots = 0; double cpu = 0, sec = 0; };
+
+// devices d with d % senders == s, a datagram each per round
+static void loadSender(const LoadOptions& o, int s, struct sockaddr_in to, LoadStats* st)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int buf = 4 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+  std::mt19937 rng(100 + s);
+  std::uniform_real_distribution<double> u(0, 100);
+  std::vector<int> mine;
+  for (int d = s; d < o.devices; d += o.senders) mine.push_back(d);
+  struct Held { std::vector<uint8_t> dgram; int round, seq; size_t dev; };
+  std::vector<Held> held;                       // held back ones, out after the next round
+  std::vector<int> highest(mine.size(), -1);    // seq sent, per device
+  std::vector<bool> reboots(mine.size());       // half way through
+  for (size_t k = 0; k < mine.size(); k++) reboots[k] = u(rng) < o.rebootPct;
+  int half = o.rounds / 2;
+  std::vector<std::vector<uint8_t>> batch;
+  uint32_t t0 = 1700006400u;
+
+  auto sendBatch = [&]()
+  {
+    struct mmsghdr msgs[COLL_BATCH];
+    struct iovec iov[COLL_BATCH];
+    size_t at = 0;
+    while (at < batch.size())
+    {
+      int n = (int)std::min((size_t)COLL_BATCH, batch.size() - at);
+      for (int i = 0; i < n; i++)
+      {
+        iov[i].iov_base = batch[at + i].data();
+        iov[i].iov_len = batch[at + i].size();
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name = &to;
+        msgs[i].msg_hdr.msg_namelen = sizeof(to);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+      int sent = sendmmsg(fd, msgs, n, 0);
+      if (sent <= 0) { std::this_thread::yield(); continue; }
+      at += sent;
+      st->sent += sent;
+    }
+    batch.clear();
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  double perSender = o.pps / o.senders;
+  uint64_t queued = 0;
+  for (int round = 0; round < o.rounds; round++)
+  {
+    for (size_t k = 0; k < mine.size(); k++)
+    {
+      int d = mine[k];
+      char id[TEL_IDLEN + 1];
+      snprintf(id, sizeof(id), "gps-%012lX", 0x240ac4000000UL + d);
+      TelFix f;
+      f.t = t0 + round * 10;
+      f.lat = 47752060 + (d % 1000) * 100 + round * 7;
+      f.lon = -122209460 + (d / 1000) * 100 - round * 5;
+      f.speed = (d * 37 + round * 11) % 6000;
+      // a reboot:  seq from 0 again, in a new session
+      bool rebooted = reboots[k] && (round >= half);
+      int seq = rebooted ? round - half : round;
+      if (rebooted && (seq == 0)) { highest[k] = -1; st->reboots++; }
+      std::vector<uint8_t> dg(TEL_MAXLEN);
+      dg.resize(telPack(dg.data(), id, rebooted ? 2 : 1, seq, &f, 1));
+      // so every gap is between two that came, and nothing is held back over the reboot
+      bool edge = (round == 0) || (round == o.rounds - 1) || (reboots[k] && (round >= half - 1) && (round <= half));
+      double x = u(rng);
+      if (!edge && (x < o.dropPct)) { st->skipped++; continue; }
+      if (!edge && (x < o.dropPct + o.latePct)) { held.push_back({ dg, round, seq, k }); continue; }
+      batch.push_back(dg);
+      highest[k] = seq;
+      if (!edge && (x < o.dropPct + o.latePct + o.dupPct)) { batch.push_back(dg); st->dups++; }
+      queued++;
+      if (batch.size() >= COLL_BATCH) sendBatch();
+      if (perSender > 0)
+      {
+        double due = queued / perSender;
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (due > now) std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+      }
+    }
+    sendBatch();
+    // last round's late ones, now their next seq is out
+    for (size_t i = 0; i < held.size(); )
+    {
+      if (held[i].round < round)
+      {
+        // late only if a later seq got there first (it may have been skipped)
+        if (highest[held[i].dev] > held[i].seq) st->late++;
+        else highest[held[i].dev] = held[i].seq;
+        batch.push_back(held[i].dgram);
+        held.erase(held.begin() + i);
+      }
+      else i++;
+    }
+    sendBatch();
+  }
+  for (Held& h : held)
+  {
+    if (highest[h.dev] > h.seq) st->late++;
+    batch.push_back(h.dgram);
+  }
+  sendBatch();
+  st->sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  st->cpu = threadCpu();
+  close(fd);
+}
+
+static LoadStats runLoad(const LoadOptions& o)
+{
+  struct sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons(o.port);
+  struct hostent* he = gethostbyname(o.host.c_str());
+  if (!he) { printf("unknown host %s\n", o.host.c_str()); exit(1); }
+  memcpy(&to.sin_addr, he->h_addr_list[0], sizeof(to.sin_addr));
+
+  std::vector<LoadStats> stats(o.senders);
+  std::vector<std::thread> threads;
+  for (int s = 0; s < o.senders; s++) threads.emplace_back(loadSender, std::cref(o), s, to, &stats[s]);
+  for (std::thread& t : threads) t.join();
+  LoadStats all;
+  for (LoadStats& s : stats)
+  {
+    all.sent += s.sent; all.skipped += s.skipped; all.dups += s.dups; all.late += s.late; all.reboots += s.reboots;
+    all.cpu += s.cpu; all.sec = std::max(all.sec, s.sec);
+  }
+  printf("load: %d devices x %d rounds, %llu datagrams in %.2f s (%.0f/s, %.0f/s a core), skipped %llu, twice %llu, late %llu, rebooted %llu\n",
+         o.devices, o.rounds, (unsigned long long)all.sent, all.sec, all.sent / all.sec,
+         all.cpu > 0 ? all.sent / all.cpu : 0.0, (unsigned long long)all.skipped,
+         (unsigned long long)all.dups, (unsigned long long)all.late, (unsigned long long)all.reboots);
+  return all;
+}
+
+//----------------------------------------------------------------------------
+// -bench: the fixes in the .seg files against what was sent
+//----------------------------------------------------------------------------
+static uint64_t segFixesIn(const std::string& outdir, size_t* files)
+{
+  uint64_t n = 0;
+  *files = 0;
+  for (const fsys::directory_entry& e : fsys::directory_iterator(outdir))
+  {
+    if (e.path().extension() != ".seg") continue;
+    (*files)++;
+    FILE* fp = fopen(e.path().c_str(), "rb");
+    if (!fp) continue;
+    SegHeader h;
+    while (fread(&h, sizeof(h), 1, fp) == 1)
+    {
+      if ((h.magic != SEG_MAGIC) || (h.count == 0) || (h.count > SEG_MAXFIXES)) break;
+      int32_t vals[SEG_MAXFIXES];
+      std::vector<uint8_t> col;
+      for (int c = 0; c < SEG_COLS; c++)
+      {
+        col.resize(h.bytes[c]);
+        if (fread(col.data(), 1, h.bytes[c], fp) != h.bytes[c]) break;
+        segDecode(col.data(), h.bytes[c], h.first[c], h.count, vals);
+      }
+      n += h.count;
+    }
+    fclose(fp);
+  }
+  return n;
+}
+
+static void onSignal(int) { stopping = true; }
+
+int main(int argc, char** argv)
+{
+  int port = TEL_PORT_DEFAULT, receivers = 1, writers = 1, seconds = 0;
+  std::string outdir;
+  bool load = false, bench = false;
+  LoadOptions lo;
+  for (int i = 1; i < argc; i++)
+  {
+    bool more = (i + 1 < argc);
+    if ((strcmp(argv[i], "-p") == 0) && more) port = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-o") == 0) && more) outdir = argv[++i];
+    else if ((strcmp(argv[i], "-receivers") == 0) && more) receivers = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-writers") == 0) && more) writers = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-sec") == 0) && more) seconds = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-load") == 0) && more)
+    {
+      load = true;
+      std::string hp = argv[++i];
+      size_t colon = hp.rfind(':');
+      lo.host = hp.substr(0, colon);
+      if (colon != std::string::npos) lo.port = atoi(hp.c_str() + colon + 1);
+    }
+    else if (strcmp(argv[i], "-bench") == 0) bench = true;
+    else if ((strcmp(argv[i], "-devices") == 0) && more) lo.devices = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-rounds") == 0) && more) lo.rounds = std::max(2, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-pps") == 0) && more) lo.pps = atof(argv[++i]);
+    else if ((strcmp(argv[i], "-senders") == 0) && more) lo.senders = std::max(1, atoi(argv[++i]));
+    else if ((strcmp(argv[i], "-drop") == 0) && more) lo.dropPct = atof(argv[++i]);
+    else if ((strcmp(argv[i], "-dup") == 0) && more) lo.dupPct = atof(argv[++i]);
+    else if ((strcmp(argv[i], "-late") == 0) && more) lo.latePct = atof(argv[++i]);
+    else if ((strcmp(argv[i], "-reboot") == 0) && more) lo.rebootPct = atof(argv[++i]);
+    else { printf("unknown option %s\n", argv[i]); return 1; }
+  }
+
+  if (load && !bench)
+  {
+    runLoad(lo);
+    return 0;
+  }
+  if (outdir.empty()) outdir = bench ? (fsys::temp_directory_path() / "udpcollect-out").string() : ".";
+  if (bench) fsys::remove_all(outdir);
+
+  Collector coll(bench ? 0 : port, receivers, writers, outdir);
+  printf("collecting on udp port %d, %d receivers, %d writers, into %s (%u cores here)\n",
+         coll.port(), receivers, writers, outdir.c_str(), std::thread::hardware_concurrency());
+  auto t0 = std::chrono::steady_clock::now();
+  coll.start();
+  if (!bench)
+  {
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    while (!stopping && ((seconds == 0) || (std::chrono::steady_clock::now() - t0 < std::chrono::seconds(seconds))))
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    coll.stop(0);
+    coll.report(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return 0;
+  }
+
+  lo.port = coll.port();
+  LoadStats ls = runLoad(lo);
+  coll.stop(300);
+  coll.report(ls.sec);
+
+  // what should have come out, with nothing dropped on the way
+  uint64_t lost = 0, dups = 0, late = 0, stale = 0, restarts = 0, dropped = 0, received = 0;
+  for (auto& m : coll.devices)
+    for (auto& kv : m)
+    {
+      lost += devLost(kv.second);
+      dups += kv.second.dups;
+      late += kv.second.late;
+      stale += kv.second.stale;
+      restarts += kv.second.restarts;
+      received += kv.second.received;
+    }
+  for (auto& s : coll.rxStats) dropped += s.ringDrops + s.kernelDrops;
+  size_t files;
+  uint64_t written = segFixesIn(outdir, &files);
+  bool ok = (written == received) && (files == (size_t)lo.devices) && (restarts == ls.reboots) && (stale == 0);
+  if (dropped == 0) ok = ok && (lost == ls.skipped) && (dups == ls.dups) && (late == ls.late);
+  else ok = ok && (lost <= ls.skipped + dropped) && (lost >= ls.skipped);
+  printf("check: lost %llu vs skipped %llu, duplicate %llu vs %llu, late %llu vs %llu, restarts %llu vs %llu, too late %llu%s;"
+         "  %llu fixes in %zu .seg files - %s\n",
+         (unsigned long long)lost, (unsigned long long)ls.skipped, (unsigned long long)dups, (unsigned long long)ls.dups,
+         (unsigned long long)late, (unsigned long long)ls.late, (unsigned long long)restarts,
+         (unsigned long long)ls.reboots, (unsigned long long)stale,
+         dropped ? " (some dropped in this box, lost can only be more)" : "",
+         (unsigned long long)written, files, ok ? "as sent" : "NOT as sent");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,332 @@
+// Initial version 18-Oct-2026
+//----------------------------------------------------------------------------
+// Web dashboard (WebService.h) - browsers coming and going on another task
+//----------------------------------------------------------------------------
+// The real webEvent() / webService() / webCleanup() against a stand-in for
+// ESPAsyncWebServer's WebSocket.  As on the ESP32, connects and disconnects
+// come in on a second thread playing the AsyncTCP task, while the main
+// thread is loop():  webService() every 10 ms of virtual time with a new
+// fix every second, webCleanup() every second.
+//
+// The AsyncTCP thread opens browsers, closes them, carries out the closes
+// loop() asks for (full up, too slow) and now and then opens or closes a
+// burst of them at once, more than the event queue holds, so lost
+// connects and disconnects are exercised too.  Some browsers are slow:
+// their send queue is always full, so they miss every push and get closed.
+//
+// When the AsyncTCP side is done and has settled, checked:
+//   - every open browser has exactly one slot, no slot is stale or shared
+//   - every open browser got the full stats push (the "const" stat is
+//     only ever sent in full pushes) and the current fix
+//   - every slow browser was closed, no fast one was
+//
+// Build and run (from the sketch folder):
+//   g++ -std=c++17 -O2 -Wall -Wno-write-strings -pthread -o host/websim host/websim.cpp
+//   host/websim [ops] [-v]
+//
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "HostArduino.h"
+
+ESP32Time rtc(0);
+fs::FS & fileSystem = SPIFFS;
+
+void logMessage(char* msg) { Serial.println(msg); }
+
+//----------------------------------------------------------------------------
+// ESPAsyncWebServer stand-in - just what WebService.h calls
+//----------------------------------------------------------------------------
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+#define WS_DISCONNECTED (0)
+#define WS_CONNECTED    (1)
+#define WS_DISCONNECTING (2)
+
+class AsyncWebSocket;
+
+struct AsyncClient
+{
+  size_t space() { return 5744; }
+};
+
+class AsyncWebSocketClient
+{
+public:
+  AsyncWebSocketClient(uint32_t id, int slow) : ident(id), slow(slow) {}
+  uint32_t id() { return ident; }
+  int status() { return state; }
+  bool queueIsFull() { return slow; }
+  AsyncClient* client() { return &tcp; }
+  void text(const char* msg, size_t len)
+  {
+    if (state != WS_CONNECTED) sentClosed++;
+    std::string s(msg, len);
+    if (s.find("\"const\"") != std::string::npos) gotAll = true;
+    if (s.find("\"fix\"") != std::string::npos) gotFix = true;
+    messages++;
+  }
+  void close() { closeAsked = true; } // the AsyncTCP task does it
+
+  uint32_t ident;
+  int slow;
+  std::atomic<int> state { WS_CONNECTED };
+  std::atomic<bool> closeAsked { false };
+  std::atomic<bool> removed { false };   // cleanupClients() has dropped it
+  // loop() side only
+  bool gotAll = false, gotFix = false;
+  unsigned long messages = 0, sentClosed = 0;
+  AsyncClient tcp;
+};
+
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)> AwsEventHandler;
+
+class AsyncWebSocket
+{
+public:
+  AsyncWebSocket(const char* url) {}
+  void onEvent(AwsEventHandler h) { handler = h; }
+
+  AsyncWebSocketClient* client(uint32_t id)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& c : clients)
+      if ((c->id() == id) && !c->removed) return c.get();
+    return NULL;
+  }
+  size_t count()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n = 0;
+    for (auto& c : clients) n += (c->state == WS_CONNECTED);
+    return n;
+  }
+  void cleanupClients(uint16_t maxClients)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& c : clients)
+      if (c->state == WS_DISCONNECTED) c->removed = true;
+  }
+
+  // AsyncTCP side - clients are never freed here, so loop() can't be left
+  // holding a dangling pointer in the simulation
+  AsyncWebSocketClient* open(int slow)
+  {
+    AsyncWebSocketClient* c;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      clients.emplace_back(new AsyncWebSocketClient(++lastId, slow));
+      c = clients.back().get();
+    }
+    handler(this, c, WS_EVT_CONNECT, NULL, NULL, 0);
+    return c;
+  }
+  void drop(AsyncWebSocketClient* c)
+  {
+    c->state = WS_DISCONNECTED;
+    handler(this, c, WS_EVT_DISCONNECT, NULL, NULL, 0);
+  }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<AsyncWebSocketClient>> clients;
+  uint32_t lastId = 0;
+  AwsEventHandler handler;
+};
+
+class AsyncWebServerRequest
+{
+public:
+  void send(int code, const char* type, const char* body) {}
+};
+
+class AsyncStaticWebHandler
+{
+public:
+  AsyncStaticWebHandler& setDefaultFile(const char* fn) { return *this; }
+  AsyncStaticWebHandler& setCacheControl(const char* cc) { return *this; }
+};
+
+class AsyncWebServer
+{
+public:
+  AsyncWebServer(int port) {}
+  void addHandler(AsyncWebSocket* ws) {}
+  AsyncStaticWebHandler& serveStatic(const char* uri, fs::FS& fs, const char* path) { return statics; }
+  void onNotFound(std::function<void(AsyncWebServerRequest*)> fn) {}
+  void begin() {}
+  AsyncStaticWebHandler statics;
+};
+
+#include "../NmeaService.h"
+#include "../WebService.h"
+
+//----------------------------------------------------------------------------
+// the sketch's side
+//----------------------------------------------------------------------------
+static char simRmc[128];
+static unsigned long simFixes = 0;
+
+void webCollectStats()
+{
+  webStat("uptime", millis() / 1000);
+  webStat("fixes", simFixes);
+  webStat("const", 42); // never changes - only in full pushes
+}
+
+static void newFix()
+{
+  unsigned long s = millis() / 1000;
+  char body[96];
+  snprintf(body, sizeof(body), "GPRMC,%02lu%02lu%02lu.00,A,4745.%04lu,N,12212.5678,W,0.12,0.00,151123,,,A",
+    (s / 3600) % 24, (s / 60) % 60, s % 60, s % 10000);
+  uint8_t sum = 0;
+  for (char* p = body; *p; p++) sum ^= *p;
+  snprintf(simRmc, sizeof(simRmc), "$%s*%02X", body, sum);
+  simFixes++;
+}
+
+//----------------------------------------------------------------------------
+// the AsyncTCP task
+//----------------------------------------------------------------------------
+static std::atomic<bool> asyncDone { false };
+static unsigned long simOpened = 0, simBrowserClosed = 0, simBursts = 0;
+
+// carry out the closes loop() (or webEvent() itself) asked for
+static void asyncCloses()
+{
+  std::vector<AsyncWebSocketClient*> todo;
+  {
+    std::lock_guard<std::mutex> lock(webSocket.mutex);
+    for (auto& c : webSocket.clients)
+      if (c->closeAsked && (c->state == WS_CONNECTED)) todo.push_back(c.get());
+  }
+  for (AsyncWebSocketClient* c : todo) webSocket.drop(c);
+}
+
+static std::vector<AsyncWebSocketClient*> openClients()
+{
+  std::vector<AsyncWebSocketClient*> open;
+  std::lock_guard<std::mutex> lock(webSocket.mutex);
+  for (auto& c : webSocket.clients)
+    if ((c->state == WS_CONNECTED) && !c->closeAsked) open.push_back(c.get());
+  return open;
+}
+
+static void asyncTask(int ops, unsigned seed)
+{
+  std::mt19937 rng(seed);
+  for (int op = 0; op < ops; op++)
+  {
+    asyncCloses();
+    std::vector<AsyncWebSocketClient*> open = openClients();
+    int r = rng() % 100;
+    if (r < 3)
+    {
+      // burst - a page reload across a few tabs, or a proxy dropping them all
+      simBursts++;
+      if ((r < 1) && !open.empty())
+      {
+        for (AsyncWebSocketClient* c : open) { webSocket.drop(c); simBrowserClosed++; }
+      }
+      else
+      {
+        for (int i = 0; i < WEB_EVENTS + 4; i++) { webSocket.open(rng() % 5 == 0); simOpened++; }
+      }
+    }
+    else if ((r < 55) || open.empty())
+    {
+      webSocket.open(rng() % 5 == 0);
+      simOpened++;
+    }
+    else
+    {
+      webSocket.drop(open[rng() % open.size()]);
+      simBrowserClosed++;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(rng() % 400));
+  }
+  asyncDone = true;
+}
+
+//----------------------------------------------------------------------------
+// loop()
+//----------------------------------------------------------------------------
+static void loopOnce()
+{
+  delay(10);
+  if (millis() % 1000 == 0)
+  {
+    newFix();
+    webCleanup();
+  }
+  webService(simRmc);
+}
+
+int main(int argc, char** argv)
+{
+  int ops = 20000;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0) Serial.echo = true;
+    else ops = atoi(argv[i]);
+  }
+
+  newFix();
+  webInit();
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread async(asyncTask, ops, 4242);
+  unsigned long loops = 0;
+  while (!asyncDone)
+  {
+    loopOnce();
+    loops++;
+  }
+  async.join();
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  // settle - the AsyncTCP side carries out the last closes, loop() runs on
+  // until the slow browsers left have been closed
+  for (int s = 0; s < 2 * WEB_KICK_DROPS * WEB_STATS_MS / 1000 + 5; s++)
+  {
+    asyncCloses();
+    for (int i = 0; i < 100; i++) loopOnce();
+  }
+
+  // check
+  int bad = 0;
+  unsigned long open = 0, slowLeft = 0, fastClosed = 0, missingAll = 0, missingFix = 0, sentClosed = 0;
+  for (auto& c : webSocket.clients)
+  {
+    sentClosed += c->sentClosed;
+    int slots = 0;
+    for (int i = 0; i < WEB_MAX_CLIENTS; i++) slots += (webClientIds[i] == c->id());
+    if (c->state != WS_CONNECTED)
+    {
+      if (slots) { printf("  stale slot for closed browser %u\n", c->id()); bad++; }
+      continue;
+    }
+    open++;
+    if (slots != 1) { printf("  open browser %u has %d slots\n", c->id(), slots); bad++; }
+    if (c->slow) slowLeft++;
+    else
+    {
+      missingAll += !c->gotAll;
+      missingFix += !c->gotFix;
+    }
+  }
+  for (auto& c : webSocket.clients)
+    if (!c->slow && c->closeAsked && (c->messages > 0)) fastClosed++; // only a slot holder gets messages
+  if (open > WEB_MAX_CLIENTS) { printf("  %lu browsers open, %d slots\n", open, WEB_MAX_CLIENTS); bad++; }
+  if (slowLeft) { printf("  %lu slow browsers not closed\n", slowLeft); bad++; }
+  if (missingAll || missingFix) { printf("  %lu open browsers without the full stats, %lu without the fix\n", missingAll, missingFix); bad++; }
+  if (fastClosed) { printf("  %lu fast browsers closed as slow\n", fastClosed); bad++; }
+
+  printf("%d AsyncTCP ops in %.2fs, %lu loop() passes, %.0f virtual s\n", ops, wallSec, loops, millis() / 1000.0);
+  printf("browsers opened %lu, closed by the browser %lu, bursts %lu\n", simOpened, simBrowserClosed, simBursts);
+  printf("refused (full or queue full) %lu, closed slow %lu, pushes %lu, dropped %lu\n",
+    webRefused, webKicked, webPushes, webDropped);
+  printf("open at the end %lu, pushes that met a closing browser %lu (harmless)\n", open, sentClosed);
+  printf("%s\n", bad ? "FAILED" : "check: slots match the open browsers, full stats and fix to each - OK");
+  return bad ? 1 : 0;
+}